@@ -0,0 +1,124 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// CG_COUNT_ALLOCATIONSを定義したときだけグローバルのoperator newを置き換えて、確保のたびに数える
+// 数えるだけで確保自体はmalloc系にそのまま任せる
+
+namespace
+{
+	std::atomic<uint64_t> allocationCount = 0;
+	std::atomic<uint64_t> allocationBytes = 0;
+}
+
+AllocationCount GetAllocationCount()
+{
+	return { allocationCount.load(std::memory_order_relaxed), allocationBytes.load(std::memory_order_relaxed) };
+}
+
+#ifdef CG_COUNT_ALLOCATIONS
+namespace
+{
+	// 確保を数える
+	void CountAllocation(size_t size)
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	}
+
+	// 位置を揃えて確保する。0バイトでも有効なポインタを返す
+	void* AllocateAligned(size_t size, size_t alignment)
+	{
+#ifdef _WIN32
+		return _aligned_malloc(size != 0 ? size : 1, alignment);
+#else
+		// aligned_allocはサイズがalignmentの倍数である必要がある
+		size_t alignedSize = (size + alignment - 1) / alignment * alignment;
+		return std::aligned_alloc(alignment, alignedSize != 0 ? alignedSize : alignment);
+#endif
+	}
+
+	// AllocateAlignedで確保した領域を解放する
+	void FreeAligned(void* pointer)
+	{
+#ifdef _WIN32
+		_aligned_free(pointer);
+#else
+		std::free(pointer);
+#endif
+	}
+}
+
+void* operator new(size_t size)
+{
+	CountAllocation(size);
+	void* pointer = std::malloc(size != 0 ? size : 1);
+	if (!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	CountAllocation(size);
+	void* pointer = AllocateAligned(size, static_cast<size_t>(alignment));
+	if (!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	FreeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+	FreeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(pointer);
+}
+#endif
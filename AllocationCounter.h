@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+// CG_COUNT_ALLOCATIONSを定義したビルドでだけグローバルのoperator newを置き換えて数える
+// 置き換えると全ての確保に共有のカウンタへのアトミック演算が入り、デバッグCRTのヒープ検査も効かなくなるので既定では無効
+// 確保回数を計測するときはプロジェクトのプリプロセッサの定義に追加してビルドする。LoaderCheckのプロジェクトでは定義してある
+#ifdef CG_COUNT_ALLOCATIONS
+const bool kAllocationCountEnabled = true;
+#else
+const bool kAllocationCountEnabled = false;
+#endif
+
+///==========================================================
+/// operator newの呼び出し回数と確保したサイズの累計
+///==========================================================
+struct AllocationCount
+{
+	uint64_t count;		//!< 確保した回数
+	uint64_t bytes;		//!< 確保したサイズの合計(byte)
+};
+
+// プロセスが始まってからの累計を取得する。処理の前後の差を取ると、その間に確保した回数がわかる
+// 全スレッドの合計なので、測る間は他のスレッドで確保が起きないようにすること
+// kAllocationCountEnabledがfalseなら常に0を返す
+AllocationCount GetAllocationCount();
@@ -0,0 +1,150 @@
+#include "AssetRegistry.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include <cassert>
+
+AssetRegistry* AssetRegistry::GetInstance()
+{
+	static AssetRegistry instance;
+	return &instance;
+}
+
+std::string AssetRegistry::MakeKey(const std::string& filePath, const std::type_index& type)
+{
+	//1. 書き方が違っても同じファイルなら同じパスになるようにする
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(filePath, error);
+	std::string canonicalPath = error ? filePath : path.generic_string();
+
+	//2. 内容のハッシュ。サイズと更新時刻が変わっていなければ前回のものを使う
+	uintmax_t size = std::filesystem::file_size(path, error);
+	std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(path, error);
+	uint64_t hash = 0;
+	bool found = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = fileHashes_.find(canonicalPath);
+		if (it != fileHashes_.end() && it->second.size == size && it->second.lastWriteTime == lastWriteTime)
+		{
+			hash = it->second.hash;
+			found = true;
+		}
+	}
+	if (!found)
+	{
+		MappedFile file(canonicalPath);
+		assert(file.IsOpen());			// 開けなかったら止める
+		hash = HashBytes(file.GetData(), file.GetSize());
+		std::lock_guard<std::mutex> lock(mutex_);
+		fileHashes_[canonicalPath] = { size, lastWriteTime, hash };
+	}
+	return std::string(type.name()) + "|" + canonicalPath + "|" + std::to_string(hash);
+}
+
+std::shared_ptr<void> AssetRegistry::FindOrBeginLoad(const std::string& key)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		// 待っている間にAdvanceFrame()が項目を消すことがあるので、起きるたびに引き直す
+		Entry& entry = entries_[key];
+		if (std::shared_ptr<void> asset = entry.asset.lock())
+		{
+			++hitCount_;
+			return asset;
+		}
+		if (!entry.loading)
+		{
+			entry.loading = true;
+			++missCount_;
+			return nullptr;
+		}
+		// 他のスレッドが読み込み中なので、終わるのを待って結果を共有する
+		loadedCondition_.wait(lock);
+	}
+}
+
+void AssetRegistry::EndLoad(const std::string& key, const std::shared_ptr<void>& asset)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		Entry& entry = entries_[key];
+		entry.asset = asset;
+		entry.loading = false;
+	}
+	loadedCondition_.notify_all();
+}
+
+void AssetRegistry::DeferRelease(std::function<void()> release)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	pendingReleases_.push_back({ frame_ + kAssetReleaseLatencyFrames, std::move(release) });
+}
+
+void AssetRegistry::AdvanceFrame()
+{
+	//1. 待ち終わったものを取り出す。解放は別のアセットの解放を呼ぶことがあるのでロックの外で行う
+	std::vector<PendingRelease> releases;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		++frame_;
+		for (size_t i = 0; i < pendingReleases_.size();)
+		{
+			if (pendingReleases_[i].frame <= frame_)
+			{
+				releases.push_back(std::move(pendingReleases_[i]));
+				pendingReleases_[i] = std::move(pendingReleases_.back());
+				pendingReleases_.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+		releasedCount_ += releases.size();
+
+		//2. ハンドルが切れて読み込み中でもない項目を消す
+		std::erase_if(entries_, [](const auto& item) { return item.second.asset.expired() && !item.second.loading; });
+	}
+	for (PendingRelease& pending : releases)
+	{
+		pending.release();
+	}
+}
+
+void AssetRegistry::ReleaseAll()
+{
+	// 解放で新たに解放待ちが増えることがあるので、無くなるまで繰り返す
+	while (true)
+	{
+		std::vector<PendingRelease> releases;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			releases.swap(pendingReleases_);
+			releasedCount_ += releases.size();
+		}
+		if (releases.empty())
+		{
+			break;
+		}
+		for (PendingRelease& pending : releases)
+		{
+			pending.release();
+		}
+	}
+}
+
+AssetRegistryStatistics AssetRegistry::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	AssetRegistryStatistics statistics{};
+	statistics.hitCount = hitCount_;
+	statistics.missCount = missCount_;
+	for (const auto& [key, entry] : entries_)
+	{
+		statistics.liveCount += entry.asset.expired() ? 0 : 1;
+	}
+	statistics.pendingReleaseCount = static_cast<uint32_t>(pendingReleases_.size());
+	statistics.releasedCount = releasedCount_;
+	return statistics;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// 最後のハンドルが破棄されてから実際に解放するまでに待つフレーム数。GPUが使い終わるのを待つ
+const uint64_t kAssetReleaseLatencyFrames = 2;
+
+///==========================================================
+/// アセットの共有の統計
+///==========================================================
+struct AssetRegistryStatistics
+{
+	uint64_t hitCount;				//!< 読み込み済みのものを返した回数
+	uint64_t missCount;				//!< 読み込んだ回数
+	uint32_t liveCount;				//!< ハンドルが残っているアセットの数
+	uint32_t pendingReleaseCount;	//!< 解放待ちのアセットの数
+	uint64_t releasedCount;			//!< 解放したアセットの数
+};
+
+// 同じファイルから作るアセットを1つにまとめ、参照カウント付きのハンドルで共有する。複数のスレッドから使える
+class AssetRegistry
+{
+public:
+	// プロセス全体で共有するインスタンスを取得する
+	static AssetRegistry* GetInstance();
+
+	AssetRegistry() = default;
+	AssetRegistry(const AssetRegistry&) = delete;
+	AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+	// filePathのファイルからload()で作ったTを共有して返す
+	// 正規化したパスと内容のハッシュが同じTが残っていればloadは呼ばない。他のスレッドが読み込み中なら終わるのを待つ
+	// 最後のハンドルが破棄されると、kAssetReleaseLatencyFramesフレーム後のAdvanceFrame()で解放する
+	template <typename T, typename Func>
+	std::shared_ptr<T> Acquire(const std::string& filePath, Func&& load)
+	{
+		std::string key = MakeKey(filePath, typeid(T));
+		std::shared_ptr<void> asset = FindOrBeginLoad(key);
+		if (asset)
+		{
+			return std::static_pointer_cast<T>(asset);
+		}
+		// load()やnewが例外を投げても読み込み中の印を外し、待っているスレッドを起こす
+		struct LoadGuard
+		{
+			AssetRegistry* registry;
+			const std::string& key;
+			bool ended = false;
+			~LoadGuard()
+			{
+				if (!ended)
+				{
+					registry->EndLoad(key, nullptr);
+				}
+			}
+		} guard{ this, key };
+		std::shared_ptr<T> loaded(new T(load()), [this](T* value) { DeferRelease([value]() { delete value; }); });
+		guard.ended = true;
+		EndLoad(key, loaded);
+		return loaded;
+	}
+
+	// フレームを進め、待ち終わったアセットを解放する。GPUの完了を待った後に呼ぶ
+	void AdvanceFrame();
+	// 解放待ちのアセットを全て解放する。終了時にGPUの完了を待ってから呼ぶ
+	void ReleaseAll();
+	// 統計を取得する
+	AssetRegistryStatistics GetStatistics() const;
+
+private:
+	///==========================================================
+	/// 読み込んだアセット
+	///==========================================================
+	struct Entry
+	{
+		std::weak_ptr<void> asset;	//!< ハンドルが全て破棄されると切れる
+		bool loading = false;		//!< どこかのスレッドが読み込み中か
+	};
+
+	///==========================================================
+	/// ハッシュを計算し直さないために覚えておくファイルの状態
+	///==========================================================
+	struct FileHash
+	{
+		uintmax_t size;
+		std::filesystem::file_time_type lastWriteTime;
+		uint64_t hash;
+	};
+
+	///==========================================================
+	/// 解放待ちのアセット
+	///==========================================================
+	struct PendingRelease
+	{
+		uint64_t frame;						//!< 解放してよいフレーム
+		std::function<void()> release;
+	};
+
+	// 正規化したパスと内容のハッシュと型からキーを作る
+	std::string MakeKey(const std::string& filePath, const std::type_index& type);
+	// 残っていればそれを返す。無ければ読み込み中の印を付けてnullptrを返す
+	std::shared_ptr<void> FindOrBeginLoad(const std::string& key);
+	// 読み込んだアセットを登録し、待っているスレッドを起こす。失敗したときはassetをnullptrにして読み込み中の印だけ外す
+	void EndLoad(const std::string& key, const std::shared_ptr<void>& asset);
+	// 最後のハンドルが破棄されたアセットを解放待ちにする
+	void DeferRelease(std::function<void()> release);
+
+	std::unordered_map<std::string, Entry> entries_;
+	std::unordered_map<std::string, FileHash> fileHashes_;
+	std::vector<PendingRelease> pendingReleases_;
+	uint64_t frame_ = 0;
+	uint64_t hitCount_ = 0;
+	uint64_t missCount_ = 0;
+	uint64_t releasedCount_ = 0;
+	mutable std::mutex mutex_;
+	std::condition_variable loadedCondition_;
+};
@@ -0,0 +1,1469 @@
+#include "Benchmark.h"
+#include "AllocationCounter.h"
+#include "EntityWorld.h"
+#include "JobSystem.h"
+#include "MatrixMath.h"
+#include "MatrixPalette.h"
+#include "MeshCache.h"
+#include "ModelLoader.h"
+#include "QuaternionMath.h"
+#include "SceneGraph.h"
+#include "TransformBatch.h"
+#include "VectorMath.h"
+#include "Visibility.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	// 処理にかかった時間(秒)を計る
+	template <typename Func>
+	double MeasureSeconds(Func&& func)
+	{
+		auto start = std::chrono::steady_clock::now();
+		func();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	// 書き込み用のバッファに文字列を追加する
+	void Append(std::vector<char>& buffer, std::string_view text)
+	{
+		buffer.insert(buffer.end(), text.begin(), text.end());
+	}
+
+	// 書き込み用のバッファに実数を追加する
+	void AppendFloat(std::vector<char>& buffer, float value)
+	{
+		char text[32];
+		auto [ptr, ec] = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed, 6);
+		assert(ec == std::errc());
+		buffer.push_back(' ');
+		buffer.insert(buffer.end(), text, ptr);
+	}
+
+	// 書き込み用のバッファに「位置/UV/法線」(elementCountが2なら「位置/UV」)を追加する
+	void AppendFaceVertex(std::vector<char>& buffer, uint32_t index, int32_t elementCount)
+	{
+		char text[16];
+		auto [ptr, ec] = std::to_chars(text, text + sizeof(text), index);
+		assert(ec == std::errc());
+		buffer.push_back(' ');
+		for (int32_t element = 0; element < elementCount; ++element)
+		{
+			if (element != 0)
+			{
+				buffer.push_back('/');
+			}
+			buffer.insert(buffer.end(), text, ptr);
+		}
+	}
+
+	// 2つの境界ボリュームが一致するか
+	bool IsSameBoundingVolume(const BoundingVolume& a, const BoundingVolume& b)
+	{
+		return std::memcmp(&a, &b, sizeof(BoundingVolume)) == 0;
+	}
+
+	// 2つのサブメッシュが一致するか
+	bool IsSameSubmesh(const SubmeshData& a, const SubmeshData& b)
+	{
+		return a.name == b.name && a.indexStart == b.indexStart && a.indexCount == b.indexCount && a.materialIndex == b.materialIndex
+			&& IsSameBoundingVolume(a.bounds, b.bounds);
+	}
+
+	// 2つのマテリアルが一致するか
+	bool IsSameMaterial(const MaterialData& a, const MaterialData& b)
+	{
+		return a.name == b.name && a.textureFilePath == b.textureFilePath;
+	}
+
+	// 三角形を頂点の値で表して並べる。頂点やIndexの順番によらず比較できる
+	std::vector<std::array<uint32_t, 3>> CollectTriangles(const ModelData& modelData, const std::vector<uint32_t>& vertexIds)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+		triangles.reserve(modelData.indices.size() / 3);
+		for (size_t i = 0; i + 2 < modelData.indices.size(); i += 3)
+		{
+			std::array<uint32_t, 3> triangle = { vertexIds[modelData.indices[i]], vertexIds[modelData.indices[i + 1]], vertexIds[modelData.indices[i + 2]] };
+			// 巻き順を保ったまま、最小の番号が先頭になるように回す
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// 頂点の値ごとに番号を振る
+	std::vector<uint32_t> IdentifyVertices(const ModelData& modelData, std::unordered_map<std::string, uint32_t>& ids)
+	{
+		std::vector<uint32_t> vertexIds;
+		vertexIds.reserve(modelData.vertices.size());
+		for (const VertexData& vertex : modelData.vertices)
+		{
+			std::string key(reinterpret_cast<const char*>(&vertex), sizeof(VertexData));
+			vertexIds.push_back(ids.try_emplace(key, static_cast<uint32_t>(ids.size())).first->second);
+		}
+		return vertexIds;
+	}
+
+	// 2つのModelDataが完全に一致するか
+	bool IsSameModelData(const ModelData& a, const ModelData& b)
+	{
+		return a.vertices.size() == b.vertices.size()
+			&& std::memcmp(a.vertices.data(), b.vertices.data(), sizeof(VertexData) * a.vertices.size()) == 0
+			&& a.tangents.size() == b.tangents.size()
+			&& std::memcmp(a.tangents.data(), b.tangents.data(), sizeof(Vector4) * a.tangents.size()) == 0
+			&& a.indices == b.indices
+			&& std::equal(a.submeshes.begin(), a.submeshes.end(), b.submeshes.begin(), b.submeshes.end(), IsSameSubmesh)
+			&& std::equal(a.materials.begin(), a.materials.end(), b.materials.begin(), b.materials.end(), IsSameMaterial)
+			&& IsSameBoundingVolume(a.bounds, b.bounds);
+	}
+}
+
+void GenerateBenchmarkObj(const std::string& filePath, uint32_t triangleCount, bool writeNormals)
+{
+	// 1辺の四角形の数。四角形1つにつき三角形2つ
+	uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(triangleCount) / 2.0)));
+	if (gridSize == 0)
+	{
+		gridSize = 1;
+	}
+	uint32_t rowVertexCount = gridSize + 1;
+
+	std::ofstream file(filePath, std::ios::binary);
+	assert(file.is_open());
+	std::vector<char> buffer;
+	buffer.reserve(1 << 20);
+	// バッファがある程度たまったら書き出す
+	auto flush = [&]()
+		{
+			file.write(buffer.data(), buffer.size());
+			buffer.clear();
+		};
+
+	Append(buffer, "# benchmark grid\no Grid\n");
+	for (uint32_t y = 0; y < rowVertexCount; ++y)
+	{
+		for (uint32_t x = 0; x < rowVertexCount; ++x)
+		{
+			float u = float(x) / float(gridSize);
+			float v = float(y) / float(gridSize);
+			Append(buffer, "v");
+			AppendFloat(buffer, u * 2.0f - 1.0f);
+			AppendFloat(buffer, std::sin(u * 6.28f) * 0.1f);
+			AppendFloat(buffer, v * 2.0f - 1.0f);
+			Append(buffer, "\nvt");
+			AppendFloat(buffer, u);
+			AppendFloat(buffer, v);
+			if (writeNormals)
+			{
+				Append(buffer, "\nvn");
+				AppendFloat(buffer, 0.0f);
+				AppendFloat(buffer, 1.0f);
+				AppendFloat(buffer, 0.0f);
+			}
+			Append(buffer, "\n");
+			if (buffer.size() > (1 << 20) - 256)
+			{
+				flush();
+			}
+		}
+	}
+
+	uint32_t written = 0;
+	for (uint32_t y = 0; y < gridSize && written < triangleCount; ++y)
+	{
+		for (uint32_t x = 0; x < gridSize && written < triangleCount; ++x)
+		{
+			// 1始まりの頂点番号
+			uint32_t i0 = y * rowVertexCount + x + 1;
+			uint32_t i1 = i0 + 1;
+			uint32_t i2 = i0 + rowVertexCount;
+			uint32_t i3 = i2 + 1;
+			uint32_t triangles[2][3] = { { i0, i2, i1 }, { i1, i2, i3 } };
+			for (uint32_t t = 0; t < 2 && written < triangleCount; ++t, ++written)
+			{
+				Append(buffer, "f");
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					AppendFaceVertex(buffer, triangles[t][corner], writeNormals ? 3 : 2);
+				}
+				Append(buffer, "\n");
+			}
+			if (buffer.size() > (1 << 20) - 256)
+			{
+				flush();
+			}
+		}
+	}
+	flush();
+}
+
+ObjParseBenchmarkResult BenchmarkObjParse(uint32_t triangleCount)
+{
+	ObjParseBenchmarkResult result{};
+	result.triangleCount = triangleCount;
+
+	// 一時フォルダにObjを生成する
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_benchmark.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount);
+	result.fileSize = static_cast<size_t>(std::filesystem::file_size(directory / filename));
+
+	// 各方式で読み込む
+	ModelData streamModel;
+	ModelData mappedModel;
+	ModelData parallelModel;
+	result.streamSeconds = MeasureSeconds([&]() { streamModel = LoadObjFile(directory.string(), filename, ObjParseMode::Stream); });
+	result.mappedSeconds = MeasureSeconds([&]() { mappedModel = LoadObjFile(directory.string(), filename, ObjParseMode::Mapped); });
+	result.parallelSeconds = MeasureSeconds([&]() { parallelModel = LoadObjFile(directory.string(), filename, ObjParseMode::Parallel); });
+	result.threadCount = JobSystem::GetInstance()->GetThreadCount() + 1;
+
+	double megaBytes = double(result.fileSize) / (1024.0 * 1024.0);
+	result.streamMBPerSecond = megaBytes / result.streamSeconds;
+	result.mappedMBPerSecond = megaBytes / result.mappedSeconds;
+	result.parallelMBPerSecond = megaBytes / result.parallelSeconds;
+	result.identical = IsSameModelData(streamModel, mappedModel) && IsSameModelData(mappedModel, parallelModel);
+	result.vertexCount = mappedModel.vertices.size();
+	result.indexCount = mappedModel.indices.size();
+
+	std::filesystem::remove(directory / filename);
+	return result;
+}
+
+ModelStartupBenchmarkResult BenchmarkModelStartup(uint32_t triangleCount)
+{
+	ModelStartupBenchmarkResult result{};
+
+	// 一時フォルダにObjを生成する
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_startup_benchmark.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount);
+	result.fileSize = static_cast<size_t>(std::filesystem::file_size(directory / filename));
+	std::filesystem::path cachePath = GetMeshCachePath(directory.string(), filename);
+	std::filesystem::remove(cachePath);
+
+	// 各状態で読み込む
+	ModelData objModel;
+	ModelData coldModel;
+	ModelData warmModel;
+	result.objSeconds = MeasureSeconds([&]()
+		{
+			objModel = LoadObjFile(directory.string(), filename, ObjParseMode::Parallel);
+			OptimizeMesh(objModel);
+		});
+	result.cacheColdSeconds = MeasureSeconds([&]() { coldModel = LoadModel(directory.string(), filename); });
+	result.cacheWarmSeconds = MeasureSeconds([&]() { warmModel = LoadModel(directory.string(), filename); });
+	result.cacheSize = std::filesystem::exists(cachePath) ? static_cast<size_t>(std::filesystem::file_size(cachePath)) : 0;
+	result.identical = IsSameModelData(objModel, coldModel) && IsSameModelData(coldModel, warmModel);
+
+	std::filesystem::remove(cachePath);
+	std::filesystem::remove(directory / filename);
+	return result;
+}
+
+ObjStreamBenchmarkResult BenchmarkObjStream(uint32_t triangleCount, size_t memoryBudget)
+{
+	ObjStreamBenchmarkResult result{};
+
+	// 一時フォルダにObjを生成する
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_stream_benchmark.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount);
+	result.fileSize = static_cast<size_t>(std::filesystem::file_size(directory / filename));
+
+	// 受け取ったまとまりを確認するだけのシンクで読み込む
+	bool validIndices = true;
+	ObjStreamResult streamResult;
+	result.seconds = MeasureSeconds([&]()
+		{
+			streamResult = StreamObjFile(directory.string(), filename, memoryBudget, [&](const ObjStreamChunk& chunk)
+				{
+					for (uint32_t index : chunk.indices)
+					{
+						validIndices = validIndices && index < chunk.vertices.size();
+					}
+				});
+		});
+
+	result.MBPerSecond = double(result.fileSize) / (1024.0 * 1024.0) / result.seconds;
+	result.chunkCount = streamResult.chunkCount;
+	result.vertexCount = streamResult.vertexCount;
+	result.indexCount = streamResult.indexCount;
+	result.peakMemorySize = streamResult.peakMemorySize;
+	result.memoryBudget = streamResult.memoryBudget;
+	result.completed = streamResult.completed;
+	result.valid = validIndices && streamResult.completed && streamResult.indexCount == size_t(triangleCount) * 3;
+
+	std::filesystem::remove(directory / filename);
+	return result;
+}
+
+MeshOptimizeBenchmarkResult BenchmarkMeshOptimize(uint32_t triangleCount)
+{
+	MeshOptimizeBenchmarkResult result{};
+	result.triangleCount = triangleCount;
+
+	// 一時フォルダにObjを生成して読み込む
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_optimize_benchmark.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount);
+	ModelData original = LoadObjFile(directory.string(), filename, ObjParseMode::Parallel);
+	std::filesystem::remove(directory / filename);
+
+	// 最適化する
+	ModelData optimized = original;
+	result.seconds = MeasureSeconds([&]() { result.report = OptimizeMesh(optimized); });
+
+	// 並べ替えただけで三角形が増減していないか
+	std::unordered_map<std::string, uint32_t> ids;
+	std::vector<uint32_t> originalIds = IdentifyVertices(original, ids);
+	std::vector<uint32_t> optimizedIds = IdentifyVertices(optimized, ids);
+	result.sameTriangles = CollectTriangles(original, originalIds) == CollectTriangles(optimized, optimizedIds);
+	return result;
+}
+
+VertexQuantizeBenchmarkResult BenchmarkVertexQuantize(uint32_t triangleCount)
+{
+	VertexQuantizeBenchmarkResult result{};
+
+	// 一時フォルダにObjを生成して、実際に描画するのと同じく最適化まで行う
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_quantize_benchmark.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount);
+	ModelData modelData = LoadObjFile(directory.string(), filename, ObjParseMode::Parallel);
+	std::filesystem::remove(directory / filename);
+	OptimizeMesh(modelData);
+	result.vertexCount = modelData.vertices.size();
+
+	// 量子化して戻す
+	VertexQuantization quantization{};
+	std::vector<QuantizedVertexData> quantizedVertices;
+	result.seconds = MeasureSeconds([&]()
+		{
+			quantization = ComputeVertexQuantization(modelData.vertices);
+			quantizedVertices = QuantizeVertices(modelData.vertices, quantization);
+		});
+	result.error = MeasureQuantizationError(modelData.vertices, quantizedVertices, quantization);
+
+	// 位置とUVは1段階の半分(+floatの丸め)、法線は16bitの八面体で十分小さい角度を許容する
+	float positionExtent = std::fmax(quantization.positionExtent.x, std::fmax(quantization.positionExtent.y, quantization.positionExtent.z));
+	float texcoordExtent = std::fmax(quantization.texcoordMinExtent.z, quantization.texcoordMinExtent.w);
+	result.tolerance.position = positionExtent / 65535.0f * 0.5f * 1.01f + 1e-6f;
+	result.tolerance.texcoord = texcoordExtent / 65535.0f * 0.5f * 1.01f + 1e-6f;
+	result.tolerance.normalDegrees = 0.01f;
+	result.withinTolerance = result.error.position <= result.tolerance.position
+		&& result.error.texcoord <= result.tolerance.texcoord
+		&& result.error.normalDegrees <= result.tolerance.normalDegrees;
+
+	// 頂点バッファのサイズと、キャッシュミスした頂点だけ読むとしたときの帯域
+	VertexCacheStatistics statistics = AnalyzeVertexCache(modelData.indices, modelData.vertices.size());
+	size_t missCount = static_cast<size_t>(statistics.acmr * double(modelData.indices.size() / 3) + 0.5);
+	result.vertexBufferSize = sizeof(VertexData) * modelData.vertices.size();
+	result.quantizedBufferSize = sizeof(QuantizedVertexData) * quantizedVertices.size();
+	result.fetchedBytes = sizeof(VertexData) * missCount;
+	result.quantizedFetchedBytes = sizeof(QuantizedVertexData) * missCount;
+	return result;
+}
+
+MeshSimplifyBenchmarkResult BenchmarkMeshSimplify(uint32_t triangleCount)
+{
+	MeshSimplifyBenchmarkResult result{};
+
+	// 一時フォルダにObjを生成して、実際に描画するのと同じく最適化まで行う
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_simplify_benchmark.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount);
+	ModelData modelData = LoadObjFile(directory.string(), filename, ObjParseMode::Parallel);
+	std::filesystem::remove(directory / filename);
+	OptimizeMesh(modelData);
+	result.triangleCount = modelData.indices.size() / 3;
+
+	// LODの列を作る
+	MeshLodChain lodChain;
+	result.seconds = MeasureSeconds([&]() { lodChain = BuildMeshLodChain(modelData); });
+	result.MTrianglesPerSecond = double(result.triangleCount) / 1000000.0 / result.seconds;
+	result.lods = lodChain.lods;
+
+	// Indexが頂点を指していて、目標の割合まで減っているか
+	result.valid = lodChain.lods.size() == kDefaultLodRatios.size() + 1;
+	for (uint32_t index : lodChain.indices)
+	{
+		result.valid = result.valid && index < modelData.vertices.size();
+	}
+	for (size_t lod = 1; lod < lodChain.lods.size() && result.valid; ++lod)
+	{
+		size_t targetTriangleCount = static_cast<size_t>(double(result.triangleCount) * kDefaultLodRatios[lod - 1]);
+		result.valid = lodChain.lods[lod].triangleCount <= targetTriangleCount;
+	}
+	return result;
+}
+
+MeshletCullBenchmarkResult BenchmarkMeshletCull(uint32_t triangleCount)
+{
+	// 1回の判定は短いので、繰り返して平均を取る
+	const uint32_t kRepeatCount = 100;
+	MeshletCullBenchmarkResult result{};
+
+	// 一時フォルダにObjを生成して、実際に描画するのと同じく最適化まで行う
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_meshlet_benchmark.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount);
+	ModelData modelData = LoadObjFile(directory.string(), filename, ObjParseMode::Parallel);
+	std::filesystem::remove(directory / filename);
+	OptimizeMesh(modelData);
+	result.triangleCount = modelData.indices.size() / 3;
+
+	// メッシュレットを作る
+	MeshletData meshletData;
+	result.buildSeconds = MeasureSeconds([&]() { meshletData = BuildMeshlets(modelData.vertices, modelData.indices, modelData.batches); });
+	result.meshletCount = meshletData.meshlets.size();
+
+	// 格子の端から斜めに見下ろし、一部が画面外に出るようにする
+	Vector3 cameraPosition = { 0.6f, 0.8f, -1.6f };
+	Matrix4x4 cameraMatrix = MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { 0.5f, 0.3f, 0.0f }, cameraPosition);
+	Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f);
+	Vector4 planes[6];
+	ExtractFrustumPlanes(Multiply(InverseAffine(cameraMatrix), projectionMatrix), planes);
+
+	// 両方式で判定する
+	std::vector<uint32_t> scalarVisible;
+	std::vector<uint32_t> simdVisible;
+	MeshletCullStatistics scalarStatistics{};
+	result.scalarSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < kRepeatCount; ++i)
+			{
+				CullMeshlets(meshletData, planes, cameraPosition, MeshletCullMode::Scalar, scalarVisible, scalarStatistics);
+			}
+		}) / kRepeatCount;
+	result.simdSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < kRepeatCount; ++i)
+			{
+				CullMeshlets(meshletData, planes, cameraPosition, MeshletCullMode::Simd, simdVisible, result.statistics);
+			}
+		}) / kRepeatCount;
+
+	// 残ったメッシュレットを詰める時間も計る
+	std::vector<uint32_t> indices(modelData.indices.size());
+	std::vector<MaterialBatch> batches;
+	CompactMeshletIndices(meshletData, simdVisible, indices.data(), batches, result.statistics);
+	result.identical = scalarVisible == simdVisible
+		&& scalarStatistics.frustumCulledCount == result.statistics.frustumCulledCount
+		&& scalarStatistics.coneCulledCount == result.statistics.coneCulledCount;
+	return result;
+}
+
+TangentSpaceBenchmarkResult BenchmarkTangentSpace(uint32_t triangleCount)
+{
+	TangentSpaceBenchmarkResult result{};
+	JobSystem* jobSystem = JobSystem::GetInstance();
+	result.threadCount = jobSystem->GetThreadCount() + 1;
+
+	// 一時フォルダにvnの無いObjを生成して、両方式で読み込む。読み込み時に法線と接線が作られる
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_tangent_benchmark.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount, false);
+	ModelData mappedModel = LoadObjFile(directory.string(), filename, ObjParseMode::Mapped);
+	ModelData modelData = LoadObjFile(directory.string(), filename, ObjParseMode::Parallel);
+	std::filesystem::remove(directory / filename);
+	result.triangleCount = modelData.indices.size() / 3;
+	result.vertexCount = modelData.vertices.size();
+	result.identical = IsSameModelData(mappedModel, modelData);
+
+	// 位置でまとめて、1スレッドと並列で作り直す
+	std::vector<uint32_t> smoothingIds = WeldVertexPositions(modelData.vertices);
+	std::vector<VertexData> serialVertices = modelData.vertices;
+	std::vector<VertexData> parallelVertices = modelData.vertices;
+	std::vector<Vector4> serialTangents;
+	std::vector<Vector4> parallelTangents;
+	result.normalSerialSeconds = MeasureSeconds([&]() { GenerateNormals(serialVertices, modelData.indices, smoothingIds, NormalWeighting::Angle, nullptr); });
+	result.normalParallelSeconds = MeasureSeconds([&]() { GenerateNormals(parallelVertices, modelData.indices, smoothingIds, NormalWeighting::Angle, jobSystem); });
+	result.tangentSerialSeconds = MeasureSeconds([&]() { serialTangents = GenerateTangents(serialVertices, modelData.indices, nullptr); });
+	result.tangentParallelSeconds = MeasureSeconds([&]() { parallelTangents = GenerateTangents(parallelVertices, modelData.indices, jobSystem); });
+	result.MTrianglesPerSecond = double(result.triangleCount) / 1000000.0 / (result.normalParallelSeconds + result.tangentParallelSeconds);
+	result.identical = result.identical
+		&& std::memcmp(serialVertices.data(), parallelVertices.data(), sizeof(VertexData) * serialVertices.size()) == 0
+		&& std::memcmp(serialTangents.data(), parallelTangents.data(), sizeof(Vector4) * serialTangents.size()) == 0
+		&& std::memcmp(parallelVertices.data(), modelData.vertices.data(), sizeof(VertexData) * parallelVertices.size()) == 0;
+
+	// 格子はy = 0.1 * sin(6.28 * u)、x = 2u - 1の曲面。読み込みでxが反転している
+	const double kRadianToDegree = 180.0 / 3.14159265358979323846;
+	result.consistentHandedness = true;
+	for (size_t i = 0; i < parallelVertices.size(); ++i)
+	{
+		double u = parallelVertices[i].texcoord.x;
+		double slope = 0.1 * 6.28 * std::cos(6.28 * u);
+		double normal[3] = { slope * 0.5, 1.0, 0.0 };
+		double tangent[3] = { -2.0, slope, 0.0 };
+		double normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1]);
+		double tangentLength = std::sqrt(tangent[0] * tangent[0] + tangent[1] * tangent[1]);
+		const Vector3& n = parallelVertices[i].normal;
+		const Vector4& t = parallelTangents[i];
+		double normalCos = (n.x * normal[0] + n.y * normal[1] + n.z * normal[2]) / normalLength;
+		double tangentCos = (t.x * tangent[0] + t.y * tangent[1] + t.z * tangent[2]) / tangentLength;
+		result.maxNormalErrorDegrees = std::fmax(result.maxNormalErrorDegrees, static_cast<float>(std::acos(std::clamp(normalCos, -1.0, 1.0)) * kRadianToDegree));
+		result.maxTangentErrorDegrees = std::fmax(result.maxTangentErrorDegrees, static_cast<float>(std::acos(std::clamp(tangentCos, -1.0, 1.0)) * kRadianToDegree));
+		result.consistentHandedness = result.consistentHandedness && t.w == parallelTangents[0].w;
+	}
+	return result;
+}
+
+ObjAllocationBenchmarkResult BenchmarkObjAllocation(uint32_t triangleCount)
+{
+	ObjAllocationBenchmarkResult result{};
+	result.triangleCount = triangleCount;
+	result.counted = kAllocationCountEnabled;
+
+	// 一時フォルダにObjを生成する。2倍の三角形数のものも作って、確保回数が増えないことを確かめる
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string filename = "cg_allocation_benchmark.obj";
+	std::string doubleFilename = "cg_allocation_benchmark_double.obj";
+	GenerateBenchmarkObj((directory / filename).string(), triangleCount);
+	GenerateBenchmarkObj((directory / doubleFilename).string(), triangleCount * 2);
+
+	// 読み込みの前後で確保の累計の差を取る。ワーカースレッドで起きた確保も含む
+	auto measure = [&](const std::string& name, ObjParseMode mode, ModelData& modelData, double* seconds)
+		{
+			AllocationCount before = GetAllocationCount();
+			double elapsed = MeasureSeconds([&]() { modelData = LoadObjFile(directory.string(), name, mode); });
+			AllocationCount after = GetAllocationCount();
+			if (seconds)
+			{
+				*seconds = elapsed;
+			}
+			return AllocationCount{ after.count - before.count, after.bytes - before.bytes };
+		};
+	ModelData streamModel;
+	ModelData mappedModel;
+	ModelData parallelModel;
+	ModelData doubleModel;
+	AllocationCount stream = measure(filename, ObjParseMode::Stream, streamModel, &result.streamSeconds);
+	AllocationCount mapped = measure(filename, ObjParseMode::Mapped, mappedModel, &result.mappedSeconds);
+	AllocationCount parallel = measure(filename, ObjParseMode::Parallel, parallelModel, nullptr);
+	AllocationCount mappedDouble = measure(doubleFilename, ObjParseMode::Mapped, doubleModel, nullptr);
+	std::filesystem::remove(directory / filename);
+	std::filesystem::remove(directory / doubleFilename);
+
+	result.streamAllocations = stream.count;
+	result.mappedAllocations = mapped.count;
+	result.parallelAllocations = parallel.count;
+	result.mappedDoubleAllocations = mappedDouble.count;
+	result.streamBytes = stream.bytes;
+	result.mappedBytes = mapped.bytes;
+	result.independentOfSize = result.counted && mapped.count == mappedDouble.count;
+	result.identical = IsSameModelData(streamModel, mappedModel) && IsSameModelData(mappedModel, parallelModel);
+	return result;
+}
+
+namespace
+{
+	// 倍精度の4x4行列
+	struct Matrix4x4Double
+	{
+		double m[4][4];
+	};
+
+	// 倍精度で行列の積を求める
+	Matrix4x4Double MultiplyDouble(const Matrix4x4& m1, const Matrix4x4& m2)
+	{
+		Matrix4x4Double result{};
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				for (int k = 0; k < 4; k++)
+				{
+					result.m[i][j] += double(m1.m[i][k]) * double(m2.m[k][j]);
+				}
+			}
+		}
+		return result;
+	}
+
+	// 倍精度で逆行列を求める。部分ピボット選択付きのGauss-Jordan法
+	Matrix4x4Double InverseDouble(const Matrix4x4& matrix)
+	{
+		double work[4][8]{};
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				work[i][j] = matrix.m[i][j];
+			}
+			work[i][4 + i] = 1.0;
+		}
+		for (int column = 0; column < 4; column++)
+		{
+			int pivot = column;
+			for (int i = column + 1; i < 4; i++)
+			{
+				pivot = std::fabs(work[i][column]) > std::fabs(work[pivot][column]) ? i : pivot;
+			}
+			std::swap(work[column], work[pivot]);
+			double inversePivot = 1.0 / work[column][column];
+			for (int j = 0; j < 8; j++)
+			{
+				work[column][j] *= inversePivot;
+			}
+			for (int i = 0; i < 4; i++)
+			{
+				double factor = i != column ? work[i][column] : 0.0;
+				for (int j = 0; j < 8; j++)
+				{
+					work[i][j] -= factor * work[column][j];
+				}
+			}
+		}
+		Matrix4x4Double result{};
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				result.m[i][j] = work[i][4 + j];
+			}
+		}
+		return result;
+	}
+
+	// 倍精度の結果との差を、結果の最大要素のFLT_EPSILON単位で求める
+	float MatrixError(const Matrix4x4& matrix, const Matrix4x4Double& reference)
+	{
+		double maxElement = 0.0;
+		double maxDifference = 0.0;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				maxElement = std::fmax(maxElement, std::fabs(reference.m[i][j]));
+				maxDifference = std::fmax(maxDifference, std::fabs(double(matrix.m[i][j]) - reference.m[i][j]));
+			}
+		}
+		return static_cast<float>(maxDifference / (maxElement * double(FLT_EPSILON)));
+	}
+}
+
+MatrixMathBenchmarkResult BenchmarkMatrixMath(uint32_t matrixCount)
+{
+	MatrixMathBenchmarkResult result{};
+	result.matrixCount = matrixCount;
+
+	//1. 拡大率0.5～2倍、任意の回転、±10の平行移動のアフィン変換と、それに透視投影を掛けた行列を作る
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> scaleDistribution(0.5f, 2.0f);
+	std::uniform_real_distribution<float> angleDistribution(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> translateDistribution(-10.0f, 10.0f);
+	Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f);
+	std::vector<Matrix4x4> affineMatrices(matrixCount);
+	std::vector<Matrix4x4> projectedMatrices(matrixCount);
+	for (uint32_t i = 0; i < matrixCount; ++i)
+	{
+		Vector3 scale = { scaleDistribution(random), scaleDistribution(random), scaleDistribution(random) };
+		Vector3 rotate = { angleDistribution(random), angleDistribution(random), angleDistribution(random) };
+		Vector3 translate = { translateDistribution(random), translateDistribution(random), translateDistribution(random) };
+		affineMatrices[i] = MakeAffineMatrix(scale, rotate, translate);
+		projectedMatrices[i] = MultiplyScalar(affineMatrices[i], projectionMatrix);
+	}
+
+	//2. 各方式で計算する。隣の行列との積を取る
+	std::vector<Matrix4x4> multiplyScalarResults(matrixCount);
+	std::vector<Matrix4x4> multiplyResults(matrixCount);
+	std::vector<Matrix4x4> inverseScalarResults(matrixCount);
+	std::vector<Matrix4x4> inverseResults(matrixCount);
+	std::vector<Matrix4x4> inverseAffineResults(matrixCount);
+	result.multiplyScalarSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < matrixCount; ++i)
+			{
+				multiplyScalarResults[i] = MultiplyScalar(affineMatrices[i], projectedMatrices[matrixCount - 1 - i]);
+			}
+		});
+	result.multiplySeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < matrixCount; ++i)
+			{
+				multiplyResults[i] = Multiply(affineMatrices[i], projectedMatrices[matrixCount - 1 - i]);
+			}
+		});
+	result.inverseScalarSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < matrixCount; ++i)
+			{
+				inverseScalarResults[i] = InverseScalar(projectedMatrices[i]);
+			}
+		});
+	result.inverseSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < matrixCount; ++i)
+			{
+				inverseResults[i] = Inverse(projectedMatrices[i]);
+			}
+		});
+	result.inverseAffineSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < matrixCount; ++i)
+			{
+				inverseAffineResults[i] = InverseAffine(affineMatrices[i]);
+			}
+		});
+
+	//3. 倍精度で計算した結果との差を調べる
+	for (uint32_t i = 0; i < matrixCount; ++i)
+	{
+		Matrix4x4Double product = MultiplyDouble(affineMatrices[i], projectedMatrices[matrixCount - 1 - i]);
+		Matrix4x4Double inverse = InverseDouble(projectedMatrices[i]);
+		Matrix4x4Double inverseAffine = InverseDouble(affineMatrices[i]);
+		result.multiplyScalarError = std::fmax(result.multiplyScalarError, MatrixError(multiplyScalarResults[i], product));
+		result.multiplyError = std::fmax(result.multiplyError, MatrixError(multiplyResults[i], product));
+		result.inverseScalarError = std::fmax(result.inverseScalarError, MatrixError(inverseScalarResults[i], inverse));
+		result.inverseError = std::fmax(result.inverseError, MatrixError(inverseResults[i], inverse));
+		result.inverseAffineError = std::fmax(result.inverseAffineError, MatrixError(inverseAffineResults[i], inverseAffine));
+	}
+
+	// 積は足す順番がスカラー版と同じなので、FMAを使わなければ誤差も同じになる。FMAの丸めの差の分だけ許容する
+	// 逆行列は計算の順番が違うので、スカラー版の誤差の2倍までを許容する。透視投影を含む行列は条件数が大きく、スカラー版でも誤差が大きい
+	const float kAffineInverseTolerance = 16.0f;
+	result.withinTolerance = result.multiplyError <= result.multiplyScalarError + 1.0f
+		&& result.inverseError <= result.inverseScalarError * 2.0f
+		&& result.inverseAffineError <= kAffineInverseTolerance;
+	return result;
+}
+
+AffineMatrixBenchmarkResult BenchmarkAffineMatrix(uint32_t transformCount)
+{
+	AffineMatrixBenchmarkResult result{};
+	result.transformCount = transformCount;
+
+	//1. 拡大率0.5～2倍、±2πの回転、±10の平行移動のTransformを作る
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> scaleDistribution(0.5f, 2.0f);
+	std::uniform_real_distribution<float> angleDistribution(-6.2831853f, 6.2831853f);
+	std::uniform_real_distribution<float> translateDistribution(-10.0f, 10.0f);
+	std::vector<Transform> transforms(transformCount);
+	TransformSoA transformSoA;
+	ResizeTransforms(transformSoA, transformCount);
+	for (uint32_t i = 0; i < transformCount; ++i)
+	{
+		transforms[i].scale = { scaleDistribution(random), scaleDistribution(random), scaleDistribution(random) };
+		transforms[i].rotate = { angleDistribution(random), angleDistribution(random), angleDistribution(random) };
+		transforms[i].translate = { translateDistribution(random), translateDistribution(random), translateDistribution(random) };
+		SetTransform(transformSoA, i, transforms[i]);
+	}
+
+	//2. 各方式で作る
+	std::vector<Matrix4x4> chainedMatrices(transformCount);
+	std::vector<Matrix4x4> closedFormMatrices(transformCount);
+	std::vector<Matrix4x4> batchMatrices(transformCount);
+	result.chainedSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < transformCount; ++i)
+			{
+				chainedMatrices[i] = MakeAffineMatrixChained(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+			}
+		});
+	result.closedFormSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < transformCount; ++i)
+			{
+				closedFormMatrices[i] = MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+			}
+		});
+	result.batchSeconds = MeasureSeconds([&]() { MakeAffineMatrices(transformSoA, 0, transformCount, batchMatrices.data()); });
+
+	//3. 掛け合わせて作った結果との差を調べる。掛ける順番と丸めが違うだけなので数epsに収まる
+	auto maxDifference = [](const Matrix4x4& matrix, const Matrix4x4& reference)
+		{
+			float maxElement = 0.0f;
+			float difference = 0.0f;
+			for (int row = 0; row < 4; row++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					maxElement = std::fmax(maxElement, std::fabs(reference.m[row][column]));
+					difference = std::fmax(difference, std::fabs(matrix.m[row][column] - reference.m[row][column]));
+				}
+			}
+			return difference / (maxElement * FLT_EPSILON);
+		};
+	for (uint32_t i = 0; i < transformCount; ++i)
+	{
+		result.closedFormError = std::fmax(result.closedFormError, maxDifference(closedFormMatrices[i], chainedMatrices[i]));
+		result.batchError = std::fmax(result.batchError, maxDifference(batchMatrices[i], chainedMatrices[i]));
+	}
+	const float kAffineMatrixTolerance = 8.0f;
+	result.withinTolerance = result.closedFormError <= kAffineMatrixTolerance && result.batchError <= kAffineMatrixTolerance;
+	return result;
+}
+
+VectorBatchBenchmarkResult BenchmarkVectorBatch(uint32_t pointCount)
+{
+	VectorBatchBenchmarkResult result{};
+	result.pointCount = pointCount;
+
+	//1. ±10の範囲のランダムな点と、アフィン変換と透視投影の行列を作る
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+	std::vector<Vector3> points(pointCount);
+	std::vector<float> pointX(pointCount);
+	std::vector<float> pointY(pointCount);
+	std::vector<float> pointZ(pointCount);
+	for (uint32_t i = 0; i < pointCount; ++i)
+	{
+		points[i] = { distribution(random), distribution(random), distribution(random) };
+		pointX[i] = points[i].x;
+		pointY[i] = points[i].y;
+		pointZ[i] = points[i].z;
+	}
+	Matrix4x4 worldMatrix = MakeAffineMatrix({ 1.5f, 0.8f, 1.2f }, { 0.3f, 1.1f, -0.4f }, { 2.0f, -3.0f, 25.0f });
+	Matrix4x4 viewProjection = Multiply(worldMatrix, MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f));
+
+	//2. 各方式で変換する
+	std::vector<Vector3> scalarResults(pointCount);
+	std::vector<Vector3> affineResults(pointCount);
+	std::vector<Vector3> perspectiveScalarResults(pointCount);
+	std::vector<Vector3> perspectiveResults(pointCount);
+	std::vector<float> soaX(pointCount);
+	std::vector<float> soaY(pointCount);
+	std::vector<float> soaZ(pointCount);
+	std::vector<Vector4> projectResults(pointCount);
+	std::vector<Vector3> vectorResults(pointCount);
+	double scalarSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < pointCount; ++i)
+			{
+				scalarResults[i] = Transforms(points[i], worldMatrix);
+			}
+		});
+	for (uint32_t i = 0; i < pointCount; ++i)
+	{
+		perspectiveScalarResults[i] = Transforms(points[i], viewProjection);
+	}
+	double affineSeconds = MeasureSeconds([&]() { TransformPoints(points, worldMatrix, affineResults); });
+	double perspectiveSeconds = MeasureSeconds([&]() { TransformPoints(points, viewProjection, perspectiveResults); });
+	double soaSeconds = MeasureSeconds([&]() { TransformPoints(ConstVector3SoASpan{ pointX, pointY, pointZ }, worldMatrix, Vector3SoASpan{ soaX, soaY, soaZ }); });
+	double projectSeconds = MeasureSeconds([&]() { ProjectPoints(points, viewProjection, projectResults); });
+	double vectorSeconds = MeasureSeconds([&]() { TransformVectors(points, worldMatrix, vectorResults); });
+	std::vector<Vector3> normalizeScalarResults = points;
+	std::vector<Vector3> normalizeResults = points;
+	double normalizeScalarSeconds = MeasureSeconds([&]()
+		{
+			for (Vector3& vector : normalizeScalarResults)
+			{
+				vector = Nomalize(vector);
+			}
+		});
+	double normalizeSeconds = MeasureSeconds([&]() { NormalizeMany(normalizeResults); });
+
+	double megaPoints = double(pointCount) / 1000000.0;
+	result.scalarMPointsPerSecond = megaPoints / scalarSeconds;
+	result.affineMPointsPerSecond = megaPoints / affineSeconds;
+	result.perspectiveMPointsPerSecond = megaPoints / perspectiveSeconds;
+	result.soaMPointsPerSecond = megaPoints / soaSeconds;
+	result.projectMPointsPerSecond = megaPoints / projectSeconds;
+	result.vectorMPointsPerSecond = megaPoints / vectorSeconds;
+	result.normalizeScalarMPointsPerSecond = megaPoints / normalizeScalarSeconds;
+	result.normalizeMPointsPerSecond = megaPoints / normalizeSeconds;
+
+	//3. 1点ずつの計算との差を、基準の長さに対する比で調べる。FMAを使うと丸めが変わるので数eps程度の差が出る
+	auto relativeError = [](const Vector3& value, const Vector3& reference)
+		{
+			float length = std::fmax(Length(reference), 1.0f);
+			return Length(Subtract(value, reference)) / length;
+		};
+	for (uint32_t i = 0; i < pointCount; ++i)
+	{
+		Vector3 projected = { projectResults[i].x / projectResults[i].w, projectResults[i].y / projectResults[i].w, projectResults[i].z / projectResults[i].w };
+		Vector3 vector = Subtract(Transforms(points[i], worldMatrix), Transforms({ 0.0f, 0.0f, 0.0f }, worldMatrix));
+		float error = relativeError(affineResults[i], scalarResults[i]);
+		error = std::fmax(error, relativeError({ soaX[i], soaY[i], soaZ[i] }, scalarResults[i]));
+		error = std::fmax(error, relativeError(perspectiveResults[i], perspectiveScalarResults[i]));
+		error = std::fmax(error, relativeError(projected, perspectiveScalarResults[i]));
+		error = std::fmax(error, relativeError(vectorResults[i], vector));
+		error = std::fmax(error, relativeError(normalizeResults[i], normalizeScalarResults[i]));
+		result.maxRelativeError = std::fmax(result.maxRelativeError, error);
+	}
+	const float kVectorBatchTolerance = 1.0e-5f;
+	result.withinTolerance = result.maxRelativeError <= kVectorBatchTolerance;
+	return result;
+}
+
+QuaternionBenchmarkResult BenchmarkQuaternion(uint32_t objectCount)
+{
+	QuaternionBenchmarkResult result{};
+	result.objectCount = objectCount;
+
+	//1. ランダムな2つのキーの姿勢を持つオブジェクトを作る。クォータニオンはキーを作るときに1回だけ変換しておく
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> scaleDistribution(0.5f, 2.0f);
+	std::uniform_real_distribution<float> angleDistribution(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> translateDistribution(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> timeDistribution(0.0f, 1.0f);
+	std::vector<Transform> transforms(objectCount);
+	std::vector<Vector3> eulerKeys(objectCount);
+	std::vector<Quaternion> quaternionKeys[2] = { std::vector<Quaternion>(objectCount), std::vector<Quaternion>(objectCount) };
+	std::vector<float> times(objectCount);
+	for (uint32_t i = 0; i < objectCount; ++i)
+	{
+		Transform& transform = transforms[i];
+		transform.scale = { scaleDistribution(random), scaleDistribution(random), scaleDistribution(random) };
+		transform.rotate = { angleDistribution(random), angleDistribution(random), angleDistribution(random) };
+		transform.translate = { translateDistribution(random), translateDistribution(random), translateDistribution(random) };
+		transform.rotation = MakeQuaternionFromEuler(transform.rotate);
+		eulerKeys[i] = { angleDistribution(random), angleDistribution(random), angleDistribution(random) };
+		quaternionKeys[0][i] = transform.rotation;
+		quaternionKeys[1][i] = MakeQuaternionFromEuler(eulerKeys[i]);
+		times[i] = timeDistribution(random);
+	}
+
+	//2. 今の姿勢からワールド行列を作る
+	std::vector<Matrix4x4> eulerMatrices(objectCount);
+	std::vector<Matrix4x4> quaternionMatrices(objectCount);
+	result.eulerMatrixSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				eulerMatrices[i] = MakeWorldMatrix(transforms[i]);
+			}
+		});
+	for (Transform& transform : transforms)
+	{
+		transform.useQuaternion = true;
+	}
+	result.quaternionMatrixSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				quaternionMatrices[i] = MakeWorldMatrix(transforms[i]);
+			}
+		});
+
+	//3. 2つのキーの間を補間してワールド行列を作る。オイラー角の線形補間は一定の角速度にならず、軸もずれる
+	std::vector<Matrix4x4> sampledMatrices(objectCount);
+	std::vector<Quaternion> slerpResults(objectCount);
+	result.eulerSampleSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				const Vector3& from = transforms[i].rotate;
+				const Vector3& to = eulerKeys[i];
+				float t = times[i];
+				Vector3 rotate = { from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t, from.z + (to.z - from.z) * t };
+				sampledMatrices[i] = MakeAffineMatrix(transforms[i].scale, rotate, transforms[i].translate);
+			}
+		});
+	result.nlerpSampleSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				Quaternion rotation = Nlerp(quaternionKeys[0][i], quaternionKeys[1][i], times[i]);
+				sampledMatrices[i] = MakeAffineMatrixQuaternion(transforms[i].scale, rotation, transforms[i].translate);
+			}
+		});
+	result.slerpSampleSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				slerpResults[i] = Slerp(quaternionKeys[0][i], quaternionKeys[1][i], times[i]);
+				sampledMatrices[i] = MakeAffineMatrixQuaternion(transforms[i].scale, slerpResults[i], transforms[i].translate);
+			}
+		});
+
+	//4. 積をスカラー版とSIMD版で求める
+	std::vector<Quaternion> scalarProducts(objectCount);
+	std::vector<Quaternion> products(objectCount);
+	result.multiplyScalarSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				scalarProducts[i] = MultiplyScalar(quaternionKeys[0][i], quaternionKeys[1][i]);
+			}
+		});
+	result.multiplySeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				products[i] = Multiply(quaternionKeys[0][i], quaternionKeys[1][i]);
+			}
+		});
+
+	//5. 結果を確かめる。slerpでは始点からの角度が補間の割合に比例する
+	float maxProductError = 0.0f;
+	for (uint32_t i = 0; i < objectCount; ++i)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				result.maxMatrixError = std::fmax(result.maxMatrixError, std::fabs(eulerMatrices[i].m[row][column] - quaternionMatrices[i].m[row][column]));
+			}
+		}
+		const Quaternion& from = quaternionKeys[0][i];
+		const Quaternion& to = quaternionKeys[1][i];
+		float totalAngle = 2.0f * std::acos(std::fmin(std::fabs(Dot(from, to)), 1.0f));
+		float sampledAngle = 2.0f * std::acos(std::fmin(std::fabs(Dot(from, slerpResults[i])), 1.0f));
+		result.maxSlerpAngleError = std::fmax(result.maxSlerpAngleError, std::fabs(sampledAngle - totalAngle * times[i]));
+		maxProductError = std::fmax(maxProductError, std::fabs(Dot(scalarProducts[i], products[i]) - 1.0f));
+	}
+	const float kMatrixTolerance = 1.0e-5f;
+	// acosは1の近くで精度が落ちるので、角度の許容誤差は大きめにとる
+	const float kAngleTolerance = 4.0e-3f;
+	result.withinTolerance = result.maxMatrixError <= kMatrixTolerance * 4.0f && result.maxSlerpAngleError <= kAngleTolerance && maxProductError <= kMatrixTolerance;
+	return result;
+}
+
+VisibilityBenchmarkResult BenchmarkVisibility(uint32_t boundsCount)
+{
+	const uint32_t kFrameCount = 8;
+	VisibilityBenchmarkResult result{};
+	result.boundsCount = boundsCount;
+	result.identical = true;
+
+	//1. 大きさ1の立方体をランダムな姿勢で周りにばらまく
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> positionDistribution(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> scaleDistribution(0.5f, 3.0f);
+	std::uniform_real_distribution<float> angleDistribution(-3.14159265f, 3.14159265f);
+	BoundingVolume unitCube = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f }, { 0.0f, 0.0f, 0.0f }, 0.8660254f };
+	std::vector<Matrix4x4> worldMatrices(boundsCount);
+	for (Matrix4x4& worldMatrix : worldMatrices)
+	{
+		float scale = scaleDistribution(random);
+		Vector3 rotate = { angleDistribution(random), angleDistribution(random), angleDistribution(random) };
+		Vector3 translate = { positionDistribution(random), positionDistribution(random), positionDistribution(random) };
+		worldMatrix = MakeAffineMatrix(Vector3{ scale, scale, scale }, rotate, translate);
+	}
+	CullBoundsSoA bounds;
+	ResizeCullBounds(bounds, boundsCount);
+	std::vector<uint32_t> visibleIndices[3];
+	for (std::vector<uint32_t>& indices : visibleIndices)
+	{
+		indices.resize(bounds.sphereX.size());
+	}
+
+	//2. 毎フレーム境界を移し直し、カメラを回しながら全方式で判定する
+	Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f);
+	for (uint32_t frame = 0; frame < kFrameCount; ++frame)
+	{
+		result.updateSeconds += MeasureSeconds([&]()
+			{
+				for (uint32_t i = 0; i < boundsCount; ++i)
+				{
+					SetCullBounds(bounds, i, unitCube, worldMatrices[i]);
+				}
+			});
+		Matrix4x4 cameraMatrix = MakeAffineMatrix(Vector3{ 1.0f, 1.0f, 1.0f }, Vector3{ 0.1f, 0.785398f * float(frame), 0.0f }, Vector3{ 0.0f, 0.0f, 0.0f });
+		Vector4 planes[6];
+		ExtractFrustumPlanes(Multiply(InverseAffine(cameraMatrix), projectionMatrix), planes);
+		for (CullShape shape : { CullShape::Sphere, CullShape::Aabb })
+		{
+			uint32_t visibleCounts[3] = {};
+			for (uint32_t mode = 0; mode < 3; ++mode)
+			{
+				double seconds = MeasureSeconds([&]() { visibleCounts[mode] = CullVisible(planes, bounds, shape, VisibilityCullMode(mode), visibleIndices[mode].data()); });
+				(shape == CullShape::Sphere ? result.sphereSeconds : result.aabbSeconds)[mode] += seconds;
+			}
+			for (uint32_t mode = 1; mode < 3; ++mode)
+			{
+				result.identical = result.identical && visibleCounts[mode] == visibleCounts[0]
+					&& std::equal(visibleIndices[mode].begin(), visibleIndices[mode].begin() + visibleCounts[0], visibleIndices[0].begin());
+			}
+			(shape == CullShape::Sphere ? result.sphereVisibleCount : result.aabbVisibleCount) = visibleCounts[0];
+		}
+	}
+
+	//3. 1フレームあたりにする
+	result.updateSeconds /= kFrameCount;
+	for (uint32_t mode = 0; mode < 3; ++mode)
+	{
+		result.sphereSeconds[mode] /= kFrameCount;
+		result.aabbSeconds[mode] /= kFrameCount;
+	}
+	return result;
+}
+
+MatrixPaletteBenchmarkResult BenchmarkMatrixPalette(uint32_t objectCount)
+{
+	MatrixPaletteBenchmarkResult result{};
+	result.objectCount = objectCount;
+	JobSystem* jobSystem = JobSystem::GetInstance();
+	result.threadCount = jobSystem->GetThreadCount() + 1;
+
+	//1. ランダムな姿勢のオブジェクトを置く。半分はクォータニオンで回す
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> scaleDistribution(0.5f, 2.0f);
+	std::uniform_real_distribution<float> angleDistribution(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> positionDistribution(-50.0f, 50.0f);
+	std::vector<Transform> transforms(objectCount);
+	for (uint32_t i = 0; i < objectCount; ++i)
+	{
+		Transform& transform = transforms[i];
+		transform.scale = { scaleDistribution(random), scaleDistribution(random), scaleDistribution(random) };
+		transform.rotate = { angleDistribution(random), angleDistribution(random), angleDistribution(random) };
+		transform.translate = { positionDistribution(random), positionDistribution(random), positionDistribution(random) };
+		transform.rotation = MakeQuaternionFromEuler(transform.rotate);
+		transform.useQuaternion = (i & 1) != 0;
+	}
+	Matrix4x4 cameraMatrix = MakeAffineMatrix(Vector3{ 1.0f, 1.0f, 1.0f }, Vector3{ 0.3f, 0.0f, 0.0f }, Vector3{ 0.0f, 20.0f, -80.0f });
+	Matrix4x4 viewMatrix = InverseAffine(cameraMatrix);
+	Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 200.0f);
+
+	//2. 今までのフレームの処理と同じく、1つずつビュー * 射影から掛ける
+	std::vector<TransfomationMatrix> chainPalette(objectCount);
+	result.chainSeconds = MeasureSeconds([&]()
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				Matrix4x4 worldMatrix = MakeWorldMatrix(transforms[i]);
+				chainPalette[i].WVP = Multiply(worldMatrix, Multiply(viewMatrix, projectionMatrix));
+				chainPalette[i].World = worldMatrix;
+			}
+		});
+
+	//3. ビュー * 射影を1回だけ求め、1スレッドと並列で求める
+	std::vector<TransfomationMatrix> serialPalette(objectCount);
+	std::vector<TransfomationMatrix> parallelPalette(objectCount);
+	result.serialSeconds = MeasureSeconds([&]()
+		{
+			BuildMatrixPalette(transforms, Multiply(viewMatrix, projectionMatrix), serialPalette.data(), nullptr);
+		});
+	result.parallelSeconds = MeasureSeconds([&]()
+		{
+			BuildMatrixPalette(transforms, Multiply(viewMatrix, projectionMatrix), parallelPalette.data(), jobSystem);
+		});
+
+	//4. 掛ける順番が変わるので、1つずつ掛けたものとは誤差の範囲で一致する
+	result.identical = std::memcmp(serialPalette.data(), parallelPalette.data(), sizeof(TransfomationMatrix) * objectCount) == 0;
+	for (uint32_t i = 0; i < objectCount; ++i)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				result.maxError = std::fmax(result.maxError, std::fabs(chainPalette[i].WVP.m[row][column] - serialPalette[i].WVP.m[row][column]));
+			}
+		}
+	}
+	return result;
+}
+
+SceneGraphBenchmarkResult BenchmarkSceneGraph(uint32_t nodeCount, uint32_t frameCount)
+{
+	SceneGraphBenchmarkResult result{};
+	result.nodeCount = nodeCount;
+	result.changedCount = std::max(nodeCount / 100, 1u);
+	result.frameCount = frameCount;
+
+	//1. キャラクターの骨のように、100ノードごとに1つの根を持つ木を作る。親は同じ木の前のノードから選ぶ
+	const uint32_t kNodesPerTree = 100;
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> angleDistribution(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> positionDistribution(-1.0f, 1.0f);
+	SceneGraph dirtyGraph;
+	for (uint32_t node = 0; node < nodeCount; ++node)
+	{
+		uint32_t treeStart = node - node % kNodesPerTree;
+		uint32_t parent = node == treeStart ? kSceneNodeNoParent : std::uniform_int_distribution<uint32_t>(treeStart, node - 1)(random);
+		Transform local{ {1.0f,1.0f,1.0f},{angleDistribution(random),angleDistribution(random),angleDistribution(random)},{positionDistribution(random),positionDistribution(random),positionDistribution(random)} };
+		AddSceneNode(dirtyGraph, parent, local);
+	}
+	SceneGraph fullGraph = dirtyGraph;
+	SceneGraphStatistics statistics{};
+	UpdateSceneGraph(dirtyGraph, SceneGraphUpdateMode::Full, statistics);
+	UpdateSceneGraph(fullGraph, SceneGraphUpdateMode::Full, statistics);
+
+	//2. 毎フレーム同じノードを同じように書き換え、変わった分だけ求め直す方と全て求め直す方を比べる
+	std::uniform_int_distribution<uint32_t> nodeDistribution(0, nodeCount - 1);
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		for (uint32_t i = 0; i < result.changedCount; ++i)
+		{
+			uint32_t node = nodeDistribution(random);
+			Transform local{ {1.0f,1.0f,1.0f},{angleDistribution(random),angleDistribution(random),angleDistribution(random)},{positionDistribution(random),positionDistribution(random),positionDistribution(random)} };
+			SetLocalTransform(dirtyGraph, node, local);
+			SetLocalTransform(fullGraph, node, local);
+		}
+		UpdateSceneGraph(dirtyGraph, SceneGraphUpdateMode::Dirty, statistics);
+		result.dirtySeconds += statistics.updateSeconds;
+		result.averageUpdatedCount += statistics.updatedCount;
+		result.averageVisitedCount += statistics.visitedCount;
+		UpdateSceneGraph(fullGraph, SceneGraphUpdateMode::Full, statistics);
+		result.fullSeconds += statistics.updateSeconds;
+	}
+	if (frameCount != 0)
+	{
+		result.dirtySeconds /= frameCount;
+		result.fullSeconds /= frameCount;
+		result.averageUpdatedCount /= frameCount;
+		result.averageVisitedCount /= frameCount;
+	}
+
+	//3. 同じ計算を同じ順で行うので、ワールド行列はビット単位で一致する
+	result.identical = std::memcmp(dirtyGraph.worldMatrices.data(), fullGraph.worldMatrices.data(), sizeof(Matrix4x4) * nodeCount) == 0;
+	return result;
+}
+
+namespace
+{
+	///==========================================================
+	/// コンポーネントをオブジェクトごとに別々の場所に確保し、ポインタで持つオブジェクト
+	///==========================================================
+	struct ScatteredRenderObject
+	{
+		Transform* transform;
+		Matrix4x4* worldMatrix;
+		MeshRef* mesh;
+		MaterialRef* material;
+		BoundingVolume* bounds;
+	};
+
+	///==========================================================
+	/// LRUのセットアソシアティブキャッシュの模型。アクセスの順番からミスの数を数える
+	///==========================================================
+	struct CacheModel
+	{
+		uint32_t setCount;				//!< セット数(2の累乗)
+		uint32_t wayCount;				//!< 1セットのライン数
+		std::vector<uintptr_t> tags;	//!< セットごとにwayCount個並べたラインの番号
+		std::vector<uint64_t> lastUses;	//!< 最後に使った時刻。0なら空
+		uint64_t time;
+		uint64_t missCount;
+	};
+
+	// capacityバイト、wayCountウェイのキャッシュの模型を作る
+	CacheModel MakeCacheModel(size_t capacity, uint32_t wayCount)
+	{
+		const size_t kCacheLineSize = 64;
+		CacheModel cache{};
+		cache.setCount = uint32_t(capacity / kCacheLineSize / wayCount);
+		cache.wayCount = wayCount;
+		cache.tags.resize(size_t(cache.setCount) * wayCount);
+		cache.lastUses.resize(size_t(cache.setCount) * wayCount);
+		return cache;
+	}
+
+	// [address, address + size)が掛かるラインを順に読み、無ければ一番古いラインと入れ替える
+	void AccessCache(CacheModel& cache, const void* address, size_t size)
+	{
+		const size_t kCacheLineSize = 64;
+		uintptr_t begin = reinterpret_cast<uintptr_t>(address) / kCacheLineSize;
+		uintptr_t end = (reinterpret_cast<uintptr_t>(address) + size - 1) / kCacheLineSize;
+		for (uintptr_t line = begin; line <= end; ++line)
+		{
+			size_t setStart = size_t(line & (cache.setCount - 1)) * cache.wayCount;
+			size_t victim = setStart;
+			bool hit = false;
+			for (size_t way = setStart; way < setStart + cache.wayCount; ++way)
+			{
+				if (cache.lastUses[way] != 0 && cache.tags[way] == line)
+				{
+					victim = way;
+					hit = true;
+					break;
+				}
+				if (cache.lastUses[way] < cache.lastUses[victim])
+				{
+					victim = way;
+				}
+			}
+			cache.missCount += hit ? 0 : 1;
+			cache.tags[victim] = line;
+			cache.lastUses[victim] = ++cache.time;
+		}
+	}
+}
+
+EntityWorldBenchmarkResult BenchmarkEntityWorld(uint32_t entityCount, uint32_t frameCount)
+{
+	EntityWorldBenchmarkResult result{};
+	result.entityCount = entityCount;
+	result.frameCount = frameCount;
+
+	//1. 同じ中身のオブジェクトを、アーキタイプの列と、番号をばらばらにしたプールの2通りで持つ
+	// プールはオブジェクトごとにnewした状態を真似て、コンポーネントごとに別の順番で並べる
+	const uint32_t kLodCount = 4;
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> angleDistribution(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> positionDistribution(-500.0f, 500.0f);
+	BoundingVolume bounds{ {-1.0f,-1.0f,-1.0f},{1.0f,1.0f,1.0f},{0.0f,0.0f,0.0f},1.7320508f };
+	EntityWorld world;
+	std::vector<Transform> transformPool(entityCount);
+	std::vector<Matrix4x4> worldMatrixPool(entityCount);
+	std::vector<MeshRef> meshPool(entityCount);
+	std::vector<MaterialRef> materialPool(entityCount);
+	std::vector<BoundingVolume> boundsPool(entityCount);
+	std::vector<uint32_t> slots[5];
+	for (std::vector<uint32_t>& slot : slots)
+	{
+		slot.resize(entityCount);
+		for (uint32_t i = 0; i < entityCount; ++i)
+		{
+			slot[i] = i;
+		}
+		std::shuffle(slot.begin(), slot.end(), random);
+	}
+	std::vector<ScatteredRenderObject> objects(entityCount);
+	const uint32_t kComponentMask = kComponentTransform | kComponentWorldMatrix | kComponentMesh | kComponentMaterial | kComponentBounds;
+	for (uint32_t i = 0; i < entityCount; ++i)
+	{
+		Transform transform{ {1.0f,1.0f,1.0f},{angleDistribution(random),angleDistribution(random),angleDistribution(random)},{positionDistribution(random),positionDistribution(random),positionDistribution(random)} };
+		MeshRef mesh{ uint32_t(random() % kLodCount) };
+		MaterialRef material{ uint32_t(random() % 2) };
+
+		uint32_t entity = CreateEntity(world, kComponentMask);
+		GetTransform(world, entity) = transform;
+		GetMesh(world, entity) = mesh;
+		GetMaterial(world, entity) = material;
+		GetBounds(world, entity) = bounds;
+
+		ScatteredRenderObject& object = objects[i];
+		object.transform = &transformPool[slots[0][i]];
+		object.worldMatrix = &worldMatrixPool[slots[1][i]];
+		object.mesh = &meshPool[slots[2][i]];
+		object.material = &materialPool[slots[3][i]];
+		object.bounds = &boundsPool[slots[4][i]];
+		*object.transform = transform;
+		*object.mesh = mesh;
+		*object.material = material;
+		*object.bounds = bounds;
+	}
+	Matrix4x4 cameraMatrix = MakeAffineMatrix(Vector3{ 1.0f, 1.0f, 1.0f }, Vector3{ 0.0f, 0.0f, 0.0f }, Vector3{ 0.0f, 0.0f, -600.0f });
+	Matrix4x4 viewProjection = Multiply(InverseAffine(cameraMatrix), MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 1200.0f));
+
+	//2. 毎フレーム、ワールド行列を求めてから描画パケットを取り出す。カリングと書き込みは同じ処理を使う
+	RenderExtraction extraction{};
+	std::vector<TransfomationMatrix> archetypePalette(entityCount);
+	std::vector<TransfomationMatrix> scatteredPalette(entityCount);
+	CullBoundsSoA scatteredCullBounds;
+	std::vector<uint32_t> scatteredVisible;
+	std::vector<DrawPacket> scatteredPackets;
+	Vector4 planes[6];
+	ExtractFrustumPlanes(viewProjection, planes);
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		result.archetypeUpdateSeconds += MeasureSeconds([&]() { UpdateEntityWorldMatrices(world, nullptr); });
+		result.archetypeExtractSeconds += MeasureSeconds([&]()
+			{
+				ExtractDrawPackets(world, viewProjection, extraction, archetypePalette.data(), entityCount, nullptr);
+			});
+
+		result.scatteredUpdateSeconds += MeasureSeconds([&]()
+			{
+				for (const ScatteredRenderObject& object : objects)
+				{
+					*object.worldMatrix = MakeWorldMatrix(*object.transform);
+				}
+			});
+		result.scatteredExtractSeconds += MeasureSeconds([&]()
+			{
+				ResizeCullBounds(scatteredCullBounds, entityCount);
+				for (uint32_t i = 0; i < entityCount; ++i)
+				{
+					SetCullBounds(scatteredCullBounds, i, *objects[i].bounds, *objects[i].worldMatrix);
+				}
+				scatteredVisible.resize(scatteredCullBounds.sphereX.size());
+				uint32_t visibleCount = CullVisible(planes, scatteredCullBounds, CullShape::Sphere, VisibilityCullMode::Avx, scatteredVisible.data());
+				scatteredPackets.clear();
+				for (uint32_t i = 0; i < visibleCount; ++i)
+				{
+					const ScatteredRenderObject& object = objects[scatteredVisible[i]];
+					scatteredPackets.push_back({ (uint64_t(object.mesh->lodLevel) << 32) | object.material->useModelMaterial, 0, scatteredVisible[i] });
+				}
+				std::stable_sort(scatteredPackets.begin(), scatteredPackets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.sortKey < b.sortKey; });
+				for (uint32_t i = 0; i < scatteredPackets.size(); ++i)
+				{
+					TransfomationMatrix record;
+					record.World = *objects[scatteredPackets[i].row].worldMatrix;
+					record.WVP = Multiply(record.World, viewProjection);
+					scatteredPalette[i] = record;
+				}
+			});
+	}
+	if (frameCount != 0)
+	{
+		result.archetypeUpdateSeconds /= frameCount;
+		result.scatteredUpdateSeconds /= frameCount;
+		result.archetypeExtractSeconds /= frameCount;
+		result.scatteredExtractSeconds /= frameCount;
+	}
+	result.visibleCount = extraction.visibleCount;
+	result.batchCount = uint32_t(extraction.batches.size());
+	result.identical = extraction.visibleCount == scatteredPackets.size() &&
+		std::memcmp(archetypePalette.data(), scatteredPalette.data(), sizeof(TransfomationMatrix) * extraction.visibleCount) == 0;
+
+	//3. 1フレームで読み書きするコンポーネントを同じ順番でキャッシュの模型に通し、ミスの数を数える
+	// 作業用の配列とパレットはどちらも同じなので除く。模型は2MB、16ウェイ
+	if (entityCount != 0)
+	{
+		const size_t kCacheCapacity = 2 * 1024 * 1024;
+		const uint32_t kCacheWayCount = 16;
+		CacheModel archetypeCache = MakeCacheModel(kCacheCapacity, kCacheWayCount);
+		for (const Archetype& archetype : world.archetypes)
+		{
+			for (size_t row = 0; row < archetype.entities.size(); ++row)
+			{
+				AccessCache(archetypeCache, &archetype.transforms[row], sizeof(Transform));
+				AccessCache(archetypeCache, &archetype.worldMatrices[row], sizeof(Matrix4x4));
+			}
+		}
+		for (const Archetype& archetype : world.archetypes)
+		{
+			for (size_t row = 0; row < archetype.entities.size(); ++row)
+			{
+				AccessCache(archetypeCache, &archetype.bounds[row], sizeof(BoundingVolume));
+				AccessCache(archetypeCache, &archetype.worldMatrices[row], sizeof(Matrix4x4));
+			}
+		}
+		for (const DrawPacket& packet : extraction.packets)
+		{
+			const Archetype& archetype = world.archetypes[packet.archetype];
+			AccessCache(archetypeCache, &archetype.meshes[packet.row], sizeof(MeshRef));
+			AccessCache(archetypeCache, &archetype.materials[packet.row], sizeof(MaterialRef));
+		}
+		for (const DrawPacket& packet : extraction.packets)
+		{
+			AccessCache(archetypeCache, &world.archetypes[packet.archetype].worldMatrices[packet.row], sizeof(Matrix4x4));
+		}
+		result.archetypeMissesPerEntity = double(archetypeCache.missCount) / entityCount;
+
+		CacheModel scatteredCache = MakeCacheModel(kCacheCapacity, kCacheWayCount);
+		for (const ScatteredRenderObject& object : objects)
+		{
+			AccessCache(scatteredCache, &object, sizeof(ScatteredRenderObject));
+			AccessCache(scatteredCache, object.transform, sizeof(Transform));
+			AccessCache(scatteredCache, object.worldMatrix, sizeof(Matrix4x4));
+		}
+		for (const ScatteredRenderObject& object : objects)
+		{
+			AccessCache(scatteredCache, &object, sizeof(ScatteredRenderObject));
+			AccessCache(scatteredCache, object.bounds, sizeof(BoundingVolume));
+			AccessCache(scatteredCache, object.worldMatrix, sizeof(Matrix4x4));
+		}
+		for (uint32_t i = 0; i < extraction.visibleCount; ++i)
+		{
+			const ScatteredRenderObject& object = objects[scatteredVisible[i]];
+			AccessCache(scatteredCache, &object, sizeof(ScatteredRenderObject));
+			AccessCache(scatteredCache, object.mesh, sizeof(MeshRef));
+			AccessCache(scatteredCache, object.material, sizeof(MaterialRef));
+		}
+		for (const DrawPacket& packet : scatteredPackets)
+		{
+			AccessCache(scatteredCache, &objects[packet.row], sizeof(ScatteredRenderObject));
+			AccessCache(scatteredCache, objects[packet.row].worldMatrix, sizeof(Matrix4x4));
+		}
+		result.scatteredMissesPerEntity = double(scatteredCache.missCount) / entityCount;
+	}
+	return result;
+}
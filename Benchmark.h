@@ -0,0 +1,336 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Meshlet.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshTangentSpace.h"
+#include "VertexQuantizer.h"
+
+///==========================================================
+/// Obj読み込みのベンチマーク結果
+///==========================================================
+struct ObjParseBenchmarkResult
+{
+	size_t fileSize;			//!< 生成したObjのサイズ(byte)
+	uint32_t triangleCount;		//!< 三角形数
+	double streamSeconds;		//!< 従来方式の読み込み時間
+	double mappedSeconds;		//!< メモリマップ方式の読み込み時間
+	double parallelSeconds;		//!< 並列方式の読み込み時間
+	double streamMBPerSecond;	//!< 従来方式のスループット
+	double mappedMBPerSecond;	//!< メモリマップ方式のスループット
+	double parallelMBPerSecond;	//!< 並列方式のスループット
+	uint32_t threadCount;		//!< 並列方式で使ったスレッド数(呼び出し元を含む)
+	bool identical;				//!< 全方式のModelDataが一致したか
+	size_t vertexCount;			//!< 重複を除いた頂点数
+	size_t indexCount;			//!< Index数(重複を除く前の頂点数)
+};
+
+// ベンチマーク用に格子状の三角形を並べたObjファイルを生成する。writeNormalsがfalseならvnを書かない
+void GenerateBenchmarkObj(const std::string& filePath, uint32_t triangleCount, bool writeNormals = true);
+
+// 生成したObjを各方式で読み込み、MB/sを計測する
+ObjParseBenchmarkResult BenchmarkObjParse(uint32_t triangleCount);
+
+///==========================================================
+/// モデル読み込みの起動時間のベンチマーク結果
+///==========================================================
+struct ModelStartupBenchmarkResult
+{
+	size_t fileSize;			//!< 生成したObjのサイズ(byte)
+	size_t cacheSize;			//!< キャッシュのサイズ(byte)
+	double objSeconds;			//!< キャッシュを使わずにObjを読んだ時間
+	double cacheColdSeconds;	//!< キャッシュが無い状態の時間(Objを読んでキャッシュを書き出す)
+	double cacheWarmSeconds;	//!< キャッシュがある状態の時間
+	bool identical;				//!< 全ての結果が一致したか
+};
+
+// 生成したObjを、キャッシュ無し・キャッシュ作成・キャッシュ有りで読み込み、時間を計測する
+ModelStartupBenchmarkResult BenchmarkModelStartup(uint32_t triangleCount);
+
+///==========================================================
+/// ストリーミング読み込みのベンチマーク結果
+///==========================================================
+struct ObjStreamBenchmarkResult
+{
+	size_t fileSize;			//!< 生成したObjのサイズ(byte)
+	double seconds;				//!< 読み込み時間
+	double MBPerSecond;			//!< スループット
+	size_t chunkCount;			//!< シンクに渡されたまとまりの数
+	size_t vertexCount;			//!< シンクに渡された頂点の合計
+	size_t indexCount;			//!< シンクに渡されたIndexの合計
+	size_t peakMemorySize;		//!< 作業メモリの最大(byte)
+	size_t memoryBudget;		//!< メモリの上限(byte)
+	bool completed;				//!< 上限に収まったまま最後まで読めたか
+	bool valid;					//!< 全ての三角形が届き、Indexがまとまりの中を指していたか
+};
+
+// 生成したObjをメモリ上限付きでストリーミング読み込みし、上限に収まったまま最後まで読めるかを確認する
+ObjStreamBenchmarkResult BenchmarkObjStream(uint32_t triangleCount, size_t memoryBudget);
+
+///==========================================================
+/// メッシュ最適化のベンチマーク結果
+///==========================================================
+struct MeshOptimizeBenchmarkResult
+{
+	size_t triangleCount;		//!< 三角形数
+	double seconds;				//!< 最適化にかかった時間
+	MeshOptimizeReport report;	//!< 最適化前後の頂点キャッシュの効率
+	bool sameTriangles;			//!< 並べ替えの前後で三角形の集合が変わっていないか
+};
+
+// 生成したObjを読み込み、頂点キャッシュの最適化の前後でACMR/ATVRを比較する
+MeshOptimizeBenchmarkResult BenchmarkMeshOptimize(uint32_t triangleCount);
+
+///==========================================================
+/// 頂点の量子化のベンチマーク結果
+///==========================================================
+struct VertexQuantizeBenchmarkResult
+{
+	size_t vertexCount;					//!< 頂点数
+	double seconds;						//!< 量子化にかかった時間
+	VertexQuantizationError error;		//!< 量子化して戻したときの誤差
+	VertexQuantizationError tolerance;	//!< 許容する誤差。位置とUVは1段階の半分
+	bool withinTolerance;				//!< 誤差が許容範囲に収まったか
+	size_t vertexBufferSize;			//!< VertexDataの頂点バッファのサイズ(byte)
+	size_t quantizedBufferSize;			//!< 量子化した頂点バッファのサイズ(byte)
+	size_t fetchedBytes;				//!< 1回の描画で読む頂点のバイト数の見積もり(キャッシュミス数×サイズ)
+	size_t quantizedFetchedBytes;		//!< 量子化した場合の1回の描画で読む頂点のバイト数の見積もり
+};
+
+// 生成したObjを読み込んで頂点を量子化し、往復の誤差と頂点の帯域を比較する
+VertexQuantizeBenchmarkResult BenchmarkVertexQuantize(uint32_t triangleCount);
+
+///==========================================================
+/// メッシュの簡略化(LODの生成)のベンチマーク結果
+///==========================================================
+struct MeshSimplifyBenchmarkResult
+{
+	size_t triangleCount;		//!< 元の三角形数
+	double seconds;				//!< LODの列を作るのにかかった時間
+	double MTrianglesPerSecond;	//!< 元の三角形数で見た処理速度(百万三角形/秒)
+	std::vector<MeshLod> lods;	//!< 各LODの三角形数と誤差
+	bool valid;					//!< 各LODのIndexが頂点の範囲内で、三角形数が目標以下に減っているか
+};
+
+// 生成したObjを読み込み、既定の割合でLODの列を作る時間を計測する
+MeshSimplifyBenchmarkResult BenchmarkMeshSimplify(uint32_t triangleCount);
+
+///==========================================================
+/// メッシュレットのカリングのベンチマーク結果
+///==========================================================
+struct MeshletCullBenchmarkResult
+{
+	size_t triangleCount;				//!< 三角形数
+	size_t meshletCount;				//!< メッシュレット数
+	double buildSeconds;				//!< メッシュレットを作るのにかかった時間
+	double scalarSeconds;				//!< 1つずつ判定したときの1回あたりの時間
+	double simdSeconds;					//!< SSEで4つずつ判定したときの1回あたりの時間
+	MeshletCullStatistics statistics;	//!< SSEで判定したときの統計
+	bool identical;						//!< 両方式で残ったメッシュレットが一致したか
+};
+
+// 生成したObjからメッシュレットを作り、斜め上から見たときのカリングを両方式で計測する
+MeshletCullBenchmarkResult BenchmarkMeshletCull(uint32_t triangleCount);
+
+///==========================================================
+/// 法線と接線の生成のベンチマーク結果
+///==========================================================
+struct TangentSpaceBenchmarkResult
+{
+	size_t triangleCount;			//!< 三角形数
+	size_t vertexCount;				//!< 頂点数
+	double normalSerialSeconds;		//!< 1スレッドで法線を作った時間
+	double normalParallelSeconds;	//!< JobSystemで法線を作った時間
+	double tangentSerialSeconds;	//!< 1スレッドで接線を作った時間
+	double tangentParallelSeconds;	//!< JobSystemで接線を作った時間
+	double MTrianglesPerSecond;		//!< 並列で法線と接線を作る処理速度(百万三角形/秒)
+	uint32_t threadCount;			//!< 並列で使ったスレッド数(呼び出し元を含む)
+	float maxNormalErrorDegrees;	//!< 格子の曲面の解析的な法線との最大の角度差(度)
+	float maxTangentErrorDegrees;	//!< 解析的なdP/duとの最大の角度差(度)
+	bool consistentHandedness;		//!< 全ての接線のwが同じ向きか
+	bool identical;					//!< 1スレッドと並列、Mappedと並列の読み込みで結果が一致したか
+};
+
+// vnの無いObjを生成して読み込み、法線と接線を1スレッドと並列で作り直して時間と精度を計測する
+TangentSpaceBenchmarkResult BenchmarkTangentSpace(uint32_t triangleCount);
+
+///==========================================================
+/// Obj読み込み中のヒープ確保のベンチマーク結果
+///==========================================================
+struct ObjAllocationBenchmarkResult
+{
+	uint32_t triangleCount;				//!< 三角形数
+	uint64_t streamAllocations;			//!< 従来方式の確保回数
+	uint64_t mappedAllocations;			//!< メモリマップ方式の確保回数
+	uint64_t parallelAllocations;		//!< 並列方式の確保回数
+	uint64_t mappedDoubleAllocations;	//!< 三角形数を2倍にしたときのメモリマップ方式の確保回数
+	uint64_t streamBytes;				//!< 従来方式で確保したサイズの合計(byte)
+	uint64_t mappedBytes;				//!< メモリマップ方式で確保したサイズの合計(byte)
+	double streamSeconds;				//!< 従来方式の読み込み時間
+	double mappedSeconds;				//!< メモリマップ方式の読み込み時間
+	bool counted;						//!< 確保を数えるビルドか。falseなら回数とサイズは全て0
+	bool independentOfSize;				//!< メモリマップ方式の確保回数が三角形数によらず同じか
+	bool identical;						//!< 全方式のModelDataが一致したか
+};
+
+// 生成したObjを各方式で読み込み、その間のoperator newの回数とサイズを計測する
+// 回数はCG_COUNT_ALLOCATIONSを定義したビルドでだけ数える
+ObjAllocationBenchmarkResult BenchmarkObjAllocation(uint32_t triangleCount);
+
+///==========================================================
+/// 行列の積と逆行列のベンチマーク結果
+///==========================================================
+struct MatrixMathBenchmarkResult
+{
+	uint32_t matrixCount;				//!< 計算した行列の数
+	double multiplyScalarSeconds;		//!< スカラー版の積の時間
+	double multiplySeconds;				//!< SIMD版の積の時間
+	double inverseScalarSeconds;		//!< スカラー版の逆行列の時間
+	double inverseSeconds;				//!< SIMD版の逆行列の時間
+	double inverseAffineSeconds;		//!< アフィン変換に限った逆行列の時間
+	float multiplyScalarError;			//!< スカラー版の積の誤差(結果の最大要素のFLT_EPSILON単位)
+	float multiplyError;				//!< SIMD版の積の誤差
+	float inverseScalarError;			//!< スカラー版の逆行列の誤差
+	float inverseError;					//!< SIMD版の逆行列の誤差
+	float inverseAffineError;			//!< アフィン変換に限った逆行列の誤差
+	bool withinTolerance;				//!< SIMD版の誤差が許容範囲に収まったか
+};
+
+// ランダムなアフィン変換と透視投影を掛けた行列で、スカラー版とSIMD版の時間と倍精度の計算との誤差を計測する
+MatrixMathBenchmarkResult BenchmarkMatrixMath(uint32_t matrixCount);
+
+///==========================================================
+/// アフィン変換行列の構築のベンチマーク結果
+///==========================================================
+struct AffineMatrixBenchmarkResult
+{
+	uint32_t transformCount;		//!< Transformの数
+	double chainedSeconds;			//!< 各行列を掛け合わせて作った時間
+	double closedFormSeconds;		//!< 展開した式で1個ずつ作った時間
+	double batchSeconds;			//!< 成分ごとに並べて4個ずつ作った時間
+	float closedFormError;			//!< 展開した式と掛け合わせた結果の差(最大要素のFLT_EPSILON単位)
+	float batchError;				//!< 4個ずつ作った結果と掛け合わせた結果の差
+	bool withinTolerance;			//!< 差が許容範囲に収まったか
+};
+
+// ランダムなTransformからワールド行列を各方式で作り、時間と結果の差を計測する
+AffineMatrixBenchmarkResult BenchmarkAffineMatrix(uint32_t transformCount);
+
+///==========================================================
+/// 点とベクトルをまとめて変換するベンチマーク結果
+///==========================================================
+struct VectorBatchBenchmarkResult
+{
+	uint32_t pointCount;					//!< 点の数
+	double scalarMPointsPerSecond;			//!< 1点ずつTransformsを呼んだときの処理速度(百万点/秒)
+	double affineMPointsPerSecond;			//!< TransformPoints(AoS、アフィン変換)の処理速度
+	double perspectiveMPointsPerSecond;		//!< TransformPoints(AoS、wで割る)の処理速度
+	double soaMPointsPerSecond;				//!< TransformPoints(SoA、アフィン変換)の処理速度
+	double projectMPointsPerSecond;			//!< ProjectPoints(AoS)の処理速度
+	double vectorMPointsPerSecond;			//!< TransformVectors(AoS)の処理速度
+	double normalizeScalarMPointsPerSecond;	//!< 1個ずつNomalizeを呼んだときの処理速度
+	double normalizeMPointsPerSecond;		//!< NormalizeMany(AoS)の処理速度
+	float maxRelativeError;					//!< 1点ずつの計算との最大の相対誤差
+	bool withinTolerance;					//!< 誤差が許容範囲に収まったか
+};
+
+// ランダムな点を各方式で変換し、処理速度と1点ずつの計算との差を計測する
+VectorBatchBenchmarkResult BenchmarkVectorBatch(uint32_t pointCount);
+
+///==========================================================
+/// クォータニオンとオイラー角のベンチマーク結果
+///==========================================================
+struct QuaternionBenchmarkResult
+{
+	uint32_t objectCount;				//!< オブジェクトの数
+	double eulerMatrixSeconds;			//!< オイラー角からワールド行列を作った時間
+	double quaternionMatrixSeconds;		//!< クォータニオンからワールド行列を作った時間
+	double eulerSampleSeconds;			//!< オイラー角を線形補間してワールド行列を作った時間
+	double nlerpSampleSeconds;			//!< クォータニオンを正規化線形補間してワールド行列を作った時間
+	double slerpSampleSeconds;			//!< クォータニオンを球面線形補間してワールド行列を作った時間
+	double multiplyScalarSeconds;		//!< スカラー版でクォータニオンを掛けた時間
+	double multiplySeconds;				//!< SIMD版でクォータニオンを掛けた時間
+	float maxMatrixError;				//!< オイラー角とクォータニオンのワールド行列の要素の最大の差
+	float maxSlerpAngleError;			//!< slerpの途中の角度と、補間の割合の比例からの最大のずれ(ラジアン)
+	bool withinTolerance;				//!< 差が許容範囲に収まったか
+};
+
+// ランダムな姿勢のオブジェクトでワールド行列の構築とキーの間の補間をオイラー角とクォータニオンで比べる
+QuaternionBenchmarkResult BenchmarkQuaternion(uint32_t objectCount);
+
+///==========================================================
+/// 視錐台カリングのベンチマーク結果。時間は1フレームあたり
+///==========================================================
+struct VisibilityBenchmarkResult
+{
+	uint32_t boundsCount;				//!< 判定した境界の数
+	double updateSeconds;				//!< 境界をワールド空間に移した時間
+	double sphereSeconds[3];			//!< 境界球の判定時間。VisibilityCullModeの順
+	double aabbSeconds[3];				//!< AABBの判定時間。VisibilityCullModeの順
+	uint32_t sphereVisibleCount;		//!< 最後のフレームで境界球が残った数
+	uint32_t aabbVisibleCount;			//!< 最後のフレームでAABBが残った数
+	bool identical;						//!< 全ての方式で残った番号が一致したか
+};
+
+// ランダムに置いたboundsCount個のオブジェクトを、向きを変えながら数フレーム分カリングして全方式で計測する
+VisibilityBenchmarkResult BenchmarkVisibility(uint32_t boundsCount);
+
+///==========================================================
+/// オブジェクトごとの行列を求めるベンチマーク結果
+///==========================================================
+struct MatrixPaletteBenchmarkResult
+{
+	uint32_t objectCount;		//!< オブジェクトの数
+	uint32_t threadCount;		//!< 並列で使ったスレッド数(呼び出し元を含む)
+	double chainSeconds;		//!< 1つずつワールド * (ビュー * 射影)を掛けた時間
+	double serialSeconds;		//!< ビュー * 射影を1回だけ求め、1スレッドで求めた時間
+	double parallelSeconds;		//!< JobSystemで並列に求めた時間
+	float maxError;				//!< 1つずつ掛けたWVPとの要素の最大の差
+	bool identical;				//!< 1スレッドと並列で結果が一致したか
+};
+
+// ランダムに置いたobjectCount個のTransformからワールド行列とWVP行列を求める時間を比べる
+MatrixPaletteBenchmarkResult BenchmarkMatrixPalette(uint32_t objectCount);
+
+///==========================================================
+/// シーングラフの更新の計測結果
+///==========================================================
+struct SceneGraphBenchmarkResult
+{
+	uint32_t nodeCount;			//!< ノード数
+	uint32_t changedCount;		//!< 1フレームで書き換えたノード数
+	uint32_t frameCount;		//!< 計測したフレーム数
+	double averageUpdatedCount;	//!< 1フレームで求め直した平均のノード数(子孫を含む)
+	double averageVisitedCount;	//!< 1フレームで調べた平均のノード数
+	double dirtySeconds;		//!< 変わったノードだけを求め直したときの1フレームの平均時間
+	double fullSeconds;			//!< 全てのノードを求め直したときの1フレームの平均時間
+	bool identical;				//!< 両方のワールド行列が一致したか
+};
+
+// 100ノードずつの階層をnodeCount個分作り、毎フレーム1%のノードを動かして更新の時間を比べる
+SceneGraphBenchmarkResult BenchmarkSceneGraph(uint32_t nodeCount, uint32_t frameCount);
+
+///==========================================================
+/// エンティティの並べ方による更新と描画の取り出しの計測結果
+///==========================================================
+struct EntityWorldBenchmarkResult
+{
+	uint32_t entityCount;			//!< エンティティ数
+	uint32_t frameCount;			//!< 計測したフレーム数
+	uint32_t visibleCount;			//!< 視錐台に入った数
+	uint32_t batchCount;			//!< LODとマテリアルでまとめた描画の数
+	double archetypeUpdateSeconds;	//!< アーキタイプの列を前から読んでワールド行列を求めた時間(1フレームの平均)
+	double scatteredUpdateSeconds;	//!< オブジェクトごとにばらばらに置いたコンポーネントをポインタで辿った時間
+	double archetypeExtractSeconds;	//!< アーキタイプから描画パケットを作った時間
+	double scatteredExtractSeconds;	//!< ばらばらのコンポーネントから描画パケットを作った時間
+	double archetypeMissesPerEntity;	//!< キャッシュの模型で数えた1フレームのミスの数(1エンティティあたり)
+	double scatteredMissesPerEntity;
+	bool identical;					//!< 両方で書き込んだパレットが一致したか
+};
+
+// ランダムに置いたentityCount個のオブジェクトを、アーキタイプの列と、オブジェクトごとにばらばらに確保したコンポーネントで持ち
+// 毎フレームのワールド行列の更新と描画パケットの取り出しの時間と、同じ順番で読んだときのキャッシュミスの数を比べる
+EntityWorldBenchmarkResult BenchmarkEntityWorld(uint32_t entityCount, uint32_t frameCount);
@@ -0,0 +1,146 @@
+#include "BoundingVolume.h"
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace
+{
+	// 2点の距離の2乗
+	float DistanceSquared(const Vector4& a, const Vector4& b)
+	{
+		float x = a.x - b.x;
+		float y = a.y - b.y;
+		float z = a.z - b.z;
+		return x * x + y * y + z * z;
+	}
+
+	// 頂点の番号を引く。vertexIndicesが無ければ並び順そのまま
+	uint32_t GetVertexIndex(const uint32_t* vertexIndices, size_t i)
+	{
+		return vertexIndices ? vertexIndices[i] : static_cast<uint32_t>(i);
+	}
+
+	BoundingVolume ComputeBoundingVolumeImpl(const std::vector<VertexData>& vertices, const uint32_t* vertexIndices, size_t count)
+	{
+		BoundingVolume volume{};
+		if (count == 0)
+		{
+			return volume;
+		}
+
+		//1. AABB。positionは16byteなので1頂点を1回で読み、xyzwをまとめて比べる。2系統に分けて依存を減らす
+		__m128 first = _mm_loadu_ps(&vertices[GetVertexIndex(vertexIndices, 0)].position.x);
+		__m128 minimum[2] = { first, first };
+		__m128 maximum[2] = { first, first };
+		size_t i = 1;
+		for (; i + 1 < count; i += 2)
+		{
+			__m128 a = _mm_loadu_ps(&vertices[GetVertexIndex(vertexIndices, i)].position.x);
+			__m128 b = _mm_loadu_ps(&vertices[GetVertexIndex(vertexIndices, i + 1)].position.x);
+			minimum[0] = _mm_min_ps(minimum[0], a);
+			maximum[0] = _mm_max_ps(maximum[0], a);
+			minimum[1] = _mm_min_ps(minimum[1], b);
+			maximum[1] = _mm_max_ps(maximum[1], b);
+		}
+		if (i < count)
+		{
+			__m128 a = _mm_loadu_ps(&vertices[GetVertexIndex(vertexIndices, i)].position.x);
+			minimum[0] = _mm_min_ps(minimum[0], a);
+			maximum[0] = _mm_max_ps(maximum[0], a);
+		}
+		alignas(16) float boundsMin[4];
+		alignas(16) float boundsMax[4];
+		_mm_store_ps(boundsMin, _mm_min_ps(minimum[0], minimum[1]));
+		_mm_store_ps(boundsMax, _mm_max_ps(maximum[0], maximum[1]));
+		volume.boundsMin = { boundsMin[0], boundsMin[1], boundsMin[2] };
+		volume.boundsMax = { boundsMax[0], boundsMax[1], boundsMax[2] };
+
+		//2. 各軸で一番端にある頂点を集め、一番離れた組を最初の球にする
+		uint32_t extremes[6];
+		for (uint32_t& extreme : extremes)
+		{
+			extreme = GetVertexIndex(vertexIndices, 0);
+		}
+		for (size_t v = 1; v < count; ++v)
+		{
+			uint32_t index = GetVertexIndex(vertexIndices, v);
+			const Vector4& position = vertices[index].position;
+			const float components[3] = { position.x, position.y, position.z };
+			for (int32_t axis = 0; axis < 3; ++axis)
+			{
+				const Vector4& low = vertices[extremes[axis * 2]].position;
+				const Vector4& high = vertices[extremes[axis * 2 + 1]].position;
+				if (components[axis] < (&low.x)[axis])
+				{
+					extremes[axis * 2] = index;
+				}
+				if (components[axis] > (&high.x)[axis])
+				{
+					extremes[axis * 2 + 1] = index;
+				}
+			}
+		}
+		int32_t bestAxis = 0;
+		float bestDistanceSquared = -1.0f;
+		for (int32_t axis = 0; axis < 3; ++axis)
+		{
+			float distanceSquared = DistanceSquared(vertices[extremes[axis * 2]].position, vertices[extremes[axis * 2 + 1]].position);
+			if (distanceSquared > bestDistanceSquared)
+			{
+				bestDistanceSquared = distanceSquared;
+				bestAxis = axis;
+			}
+		}
+		const Vector4& low = vertices[extremes[bestAxis * 2]].position;
+		const Vector4& high = vertices[extremes[bestAxis * 2 + 1]].position;
+		double centerX = (double(low.x) + high.x) * 0.5;
+		double centerY = (double(low.y) + high.y) * 0.5;
+		double centerZ = (double(low.z) + high.z) * 0.5;
+		double radius = std::sqrt(double(bestDistanceSquared)) * 0.5;
+
+		//3. 外にある頂点が見つかるたびに、その点を含むように球を広げる
+		for (size_t v = 0; v < count; ++v)
+		{
+			const Vector4& position = vertices[GetVertexIndex(vertexIndices, v)].position;
+			double x = position.x - centerX;
+			double y = position.y - centerY;
+			double z = position.z - centerZ;
+			double distanceSquared = x * x + y * y + z * z;
+			if (distanceSquared > radius * radius)
+			{
+				double distance = std::sqrt(distanceSquared);
+				double newRadius = (radius + distance) * 0.5;
+				double shift = (newRadius - radius) / distance;
+				centerX += x * shift;
+				centerY += y * shift;
+				centerZ += z * shift;
+				radius = newRadius;
+			}
+		}
+
+		//4. Ritterの球とAABBの中心の球で、実際に全ての頂点が入る半径を測り直し、小さい方を使う
+		Vector4 centers[2] = {
+			{ float(centerX), float(centerY), float(centerZ), 1.0f },
+			{ (volume.boundsMin.x + volume.boundsMax.x) * 0.5f, (volume.boundsMin.y + volume.boundsMax.y) * 0.5f, (volume.boundsMin.z + volume.boundsMax.z) * 0.5f, 1.0f } };
+		float radiusSquared[2] = { 0.0f, 0.0f };
+		for (size_t v = 0; v < count; ++v)
+		{
+			const Vector4& position = vertices[GetVertexIndex(vertexIndices, v)].position;
+			radiusSquared[0] = std::fmax(radiusSquared[0], DistanceSquared(position, centers[0]));
+			radiusSquared[1] = std::fmax(radiusSquared[1], DistanceSquared(position, centers[1]));
+		}
+		int32_t best = radiusSquared[0] <= radiusSquared[1] ? 0 : 1;
+		volume.sphereCenter = { centers[best].x, centers[best].y, centers[best].z };
+		volume.sphereRadius = std::sqrt(radiusSquared[best]);
+		return volume;
+	}
+}
+
+BoundingVolume ComputeBoundingVolume(const std::vector<VertexData>& vertices, const uint32_t* vertexIndices, size_t count)
+{
+	return ComputeBoundingVolumeImpl(vertices, vertexIndices, count);
+}
+
+BoundingVolume ComputeBoundingVolume(const std::vector<VertexData>& vertices)
+{
+	return ComputeBoundingVolumeImpl(vertices, nullptr, vertices.size());
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3.h"
+#include "VertexData.h"
+
+///==========================================================
+/// 境界ボリューム。AABBと境界球をまとめて持つ
+///==========================================================
+struct BoundingVolume
+{
+	Vector3 boundsMin;		//!< AABBの最小
+	Vector3 boundsMax;		//!< AABBの最大
+	Vector3 sphereCenter;	//!< 境界球の中心
+	float sphereRadius;		//!< 境界球の半径
+};
+
+// vertexIndicesが指す頂点の境界ボリュームを求める。重複していてもよい。空なら全て0
+// AABBはSSEで4成分まとめて最小・最大を取り、境界球は軸方向の端の点から始めるRitterの方式で求める
+BoundingVolume ComputeBoundingVolume(const std::vector<VertexData>& vertices, const uint32_t* vertexIndices, size_t count);
+
+// 全ての頂点の境界ボリュームを求める
+BoundingVolume ComputeBoundingVolume(const std::vector<VertexData>& vertices);
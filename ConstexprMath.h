@@ -0,0 +1,154 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+// コンパイル時にも計算できる三角関数と平方根
+// std::sin等はconstexprではないので、定数式の中では級数とニュートン法で求め、実行時はstdの関数をそのまま使う
+// 計算は倍精度で行うので、floatに丸めた結果はstdの関数とほぼ一致する
+
+namespace ConstexprMathDetail
+{
+	constexpr double kPi = 3.14159265358979323846;
+
+	// 角度を[-π/2, π/2]に折り返す。cosの符号が反転したらflipをtrueにする
+	constexpr double ReduceAngle(double radian, bool& flip)
+	{
+		//1. 2πの倍数を引いて[-π, π]にする
+		double turns = radian / (2.0 * kPi);
+		long long turnCount = static_cast<long long>(turns >= 0.0 ? turns + 0.5 : turns - 0.5);
+		double x = radian - static_cast<double>(turnCount) * 2.0 * kPi;
+
+		//2. sin(π - x) = sin(x)、cos(π - x) = -cos(x)で[-π/2, π/2]に折り返す
+		flip = false;
+		if (x > kPi / 2.0)
+		{
+			x = kPi - x;
+			flip = true;
+		}
+		else if (x < -kPi / 2.0)
+		{
+			x = -kPi - x;
+			flip = true;
+		}
+		return x;
+	}
+
+	// [-π/2, π/2]でのsinのテイラー級数
+	constexpr double SinSeries(double x)
+	{
+		double x2 = x * x;
+		double term = x;
+		double sum = x;
+		for (int n = 1; n < 11; ++n)
+		{
+			term *= -x2 / static_cast<double>((2 * n) * (2 * n + 1));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// [-π/2, π/2]でのcosのテイラー級数
+	constexpr double CosSeries(double x)
+	{
+		double x2 = x * x;
+		double term = 1.0;
+		double sum = 1.0;
+		for (int n = 1; n < 11; ++n)
+		{
+			term *= -x2 / static_cast<double>((2 * n - 1) * (2 * n));
+			sum += term;
+		}
+		return sum;
+	}
+}
+
+// コンパイル時に計算できるsin
+constexpr float ConstexprSin(float radian)
+{
+	bool flip = false;
+	double x = ConstexprMathDetail::ReduceAngle(radian, flip);
+	return static_cast<float>(ConstexprMathDetail::SinSeries(x));
+}
+
+// コンパイル時に計算できるcos
+constexpr float ConstexprCos(float radian)
+{
+	bool flip = false;
+	double x = ConstexprMathDetail::ReduceAngle(radian, flip);
+	double cos = ConstexprMathDetail::CosSeries(x);
+	return static_cast<float>(flip ? -cos : cos);
+}
+
+// コンパイル時に計算できるtan
+constexpr float ConstexprTan(float radian)
+{
+	bool flip = false;
+	double x = ConstexprMathDetail::ReduceAngle(radian, flip);
+	double cos = ConstexprMathDetail::CosSeries(x);
+	return static_cast<float>(ConstexprMathDetail::SinSeries(x) / (flip ? -cos : cos));
+}
+
+// コンパイル時に計算できる平方根。負の値はNaNにする
+constexpr float ConstexprSqrt(float value)
+{
+	if (value < 0.0f)
+	{
+		return std::numeric_limits<float>::quiet_NaN();
+	}
+	if (value == 0.0f || value == std::numeric_limits<float>::infinity())
+	{
+		return value;
+	}
+	double x = value;
+	double estimate = x > 1.0 ? x : 1.0;
+	for (int i = 0; i < 128; ++i)
+	{
+		double next = 0.5 * (estimate + x / estimate);
+		if (next == estimate)
+		{
+			break;
+		}
+		estimate = next;
+	}
+	return static_cast<float>(estimate);
+}
+
+// 定数式の中ならConstexpr版、実行時はstdの関数で求める
+constexpr float Sin(float radian)
+{
+	return std::is_constant_evaluated() ? ConstexprSin(radian) : std::sin(radian);
+}
+
+constexpr float Cos(float radian)
+{
+	return std::is_constant_evaluated() ? ConstexprCos(radian) : std::cos(radian);
+}
+
+constexpr float Tan(float radian)
+{
+	return std::is_constant_evaluated() ? ConstexprTan(radian) : std::tan(radian);
+}
+
+constexpr float Sqrt(float value)
+{
+	return std::is_constant_evaluated() ? ConstexprSqrt(value) : std::sqrt(value);
+}
+
+// 差がtolerance以下ならtrue
+constexpr bool NearlyEqual(float a, float b, float tolerance)
+{
+	float difference = a - b;
+	return (difference < 0.0f ? -difference : difference) <= tolerance;
+}
+
+// コンパイル時の確認
+static_assert(NearlyEqual(ConstexprSin(0.5235987756f), 0.5f, 1.0e-6f));
+static_assert(NearlyEqual(ConstexprSin(-3.0f), -0.14112000806f, 1.0e-6f));
+static_assert(NearlyEqual(ConstexprSin(10.0f), -0.54402111088f, 1.0e-6f));
+static_assert(NearlyEqual(ConstexprCos(1.0471975512f), 0.5f, 1.0e-6f));
+static_assert(NearlyEqual(ConstexprCos(3.0f), -0.98999249660f, 1.0e-6f));
+static_assert(NearlyEqual(ConstexprTan(0.7853981634f), 1.0f, 1.0e-6f));
+static_assert(NearlyEqual(ConstexprTan(0.225f), 0.22887537f, 1.0e-6f));
+static_assert(ConstexprSqrt(4.0f) == 2.0f);
+static_assert(NearlyEqual(ConstexprSqrt(2.0f), 1.41421356f, 1.0e-6f));
@@ -0,0 +1,333 @@
+#include "EntityWorld.h"
+#include "MatrixMath.h"
+#include "MatrixPalette.h"
+#include "QuaternionMath.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	// マスクが同じアーキタイプを探し、無ければ作る
+	uint32_t FindOrCreateArchetype(EntityWorld& world, uint32_t componentMask)
+	{
+		for (uint32_t i = 0; i < world.archetypes.size(); ++i)
+		{
+			if (world.archetypes[i].componentMask == componentMask)
+			{
+				return i;
+			}
+		}
+		Archetype archetype;
+		archetype.componentMask = componentMask;
+		world.archetypes.push_back(std::move(archetype));
+		return static_cast<uint32_t>(world.archetypes.size() - 1);
+	}
+
+	// 持っている列の末尾に初期値を追加し、その行の番号を返す
+	uint32_t AppendRow(Archetype& archetype, uint32_t entity)
+	{
+		uint32_t row = static_cast<uint32_t>(archetype.entities.size());
+		archetype.entities.push_back(entity);
+		if (archetype.componentMask & kComponentTransform)
+		{
+			archetype.transforms.push_back({ {1.0f,1.0f,1.0f},{0.0f,0.0f,0.0f},{0.0f,0.0f,0.0f} });
+		}
+		if (archetype.componentMask & kComponentWorldMatrix)
+		{
+			archetype.worldMatrices.push_back(MakeIdentity());
+		}
+		if (archetype.componentMask & kComponentMesh)
+		{
+			archetype.meshes.push_back({ 0 });
+		}
+		if (archetype.componentMask & kComponentMaterial)
+		{
+			archetype.materials.push_back({ 0 });
+		}
+		if (archetype.componentMask & kComponentBounds)
+		{
+			archetype.bounds.push_back({});
+		}
+		if (archetype.componentMask & kComponentSceneNode)
+		{
+			archetype.sceneNodes.push_back({ kInvalidSceneNode });
+		}
+		return row;
+	}
+
+	// 列のrow番目を最後の要素で埋めて詰める
+	template<typename T>
+	void SwapRemove(std::vector<T>& column, uint32_t row)
+	{
+		if (column.empty())
+		{
+			return;
+		}
+		column[row] = column.back();
+		column.pop_back();
+	}
+
+	// 行を消し、最後の行を移したエンティティの場所を直す
+	void RemoveRow(EntityWorld& world, uint32_t archetypeIndex, uint32_t row)
+	{
+		Archetype& archetype = world.archetypes[archetypeIndex];
+		uint32_t movedEntity = archetype.entities.back();
+		SwapRemove(archetype.entities, row);
+		SwapRemove(archetype.transforms, row);
+		SwapRemove(archetype.worldMatrices, row);
+		SwapRemove(archetype.meshes, row);
+		SwapRemove(archetype.materials, row);
+		SwapRemove(archetype.bounds, row);
+		SwapRemove(archetype.sceneNodes, row);
+		world.locations[movedEntity].row = row;
+	}
+
+	// 生きているエンティティの場所を取得する
+	const EntityLocation& GetLocation(const EntityWorld& world, uint32_t entity)
+	{
+		assert(entity < world.locations.size());
+		const EntityLocation& location = world.locations[entity];
+		assert(location.archetype != kInvalidEntity);
+		return location;
+	}
+
+	// エンティティの行と、その行のcomponentの列を取得する
+	template<typename T>
+	T& GetComponent(EntityWorld& world, uint32_t entity, uint32_t component, std::vector<T> Archetype::* column)
+	{
+		const EntityLocation& location = GetLocation(world, entity);
+		Archetype& archetype = world.archetypes[location.archetype];
+		assert(archetype.componentMask & component);
+		(void)component;
+		return (archetype.*column)[location.row];
+	}
+
+	// [begin, end)行のワールド行列を求める
+	void UpdateWorldMatrixRange(Archetype& archetype, size_t begin, size_t end)
+	{
+		const Transform* transforms = archetype.transforms.data();
+		Matrix4x4* worldMatrices = archetype.worldMatrices.data();
+		for (size_t row = begin; row < end; ++row)
+		{
+			worldMatrices[row] = MakeWorldMatrix(transforms[row]);
+		}
+	}
+}
+
+uint32_t CreateEntity(EntityWorld& world, uint32_t componentMask)
+{
+	uint32_t entity;
+	if (!world.freeEntities.empty())
+	{
+		entity = world.freeEntities.back();
+		world.freeEntities.pop_back();
+	}
+	else
+	{
+		entity = static_cast<uint32_t>(world.locations.size());
+		world.locations.push_back({ kInvalidEntity, 0 });
+	}
+	uint32_t archetypeIndex = FindOrCreateArchetype(world, componentMask);
+	world.locations[entity] = { archetypeIndex, AppendRow(world.archetypes[archetypeIndex], entity) };
+	++world.entityCount;
+	return entity;
+}
+
+void DestroyEntity(EntityWorld& world, uint32_t entity)
+{
+	EntityLocation location = GetLocation(world, entity);
+	RemoveRow(world, location.archetype, location.row);
+	world.locations[entity] = { kInvalidEntity, 0 };
+	world.freeEntities.push_back(entity);
+	--world.entityCount;
+}
+
+void SetEntityComponents(EntityWorld& world, uint32_t entity, uint32_t componentMask)
+{
+	EntityLocation location = GetLocation(world, entity);
+	if (world.archetypes[location.archetype].componentMask == componentMask)
+	{
+		return;
+	}
+
+	//1. 移す先に行を作る。アーキタイプを追加すると参照が無効になるので、作ってから両方を取り直す
+	uint32_t newArchetypeIndex = FindOrCreateArchetype(world, componentMask);
+	uint32_t newRow = AppendRow(world.archetypes[newArchetypeIndex], entity);
+	Archetype& oldArchetype = world.archetypes[location.archetype];
+	Archetype& newArchetype = world.archetypes[newArchetypeIndex];
+
+	//2. 両方にあるコンポーネントを写す
+	uint32_t sharedMask = oldArchetype.componentMask & componentMask;
+	if (sharedMask & kComponentTransform)
+	{
+		newArchetype.transforms[newRow] = oldArchetype.transforms[location.row];
+	}
+	if (sharedMask & kComponentWorldMatrix)
+	{
+		newArchetype.worldMatrices[newRow] = oldArchetype.worldMatrices[location.row];
+	}
+	if (sharedMask & kComponentMesh)
+	{
+		newArchetype.meshes[newRow] = oldArchetype.meshes[location.row];
+	}
+	if (sharedMask & kComponentMaterial)
+	{
+		newArchetype.materials[newRow] = oldArchetype.materials[location.row];
+	}
+	if (sharedMask & kComponentBounds)
+	{
+		newArchetype.bounds[newRow] = oldArchetype.bounds[location.row];
+	}
+	if (sharedMask & kComponentSceneNode)
+	{
+		newArchetype.sceneNodes[newRow] = oldArchetype.sceneNodes[location.row];
+	}
+
+	//3. 元の行を消す
+	RemoveRow(world, location.archetype, location.row);
+	world.locations[entity] = { newArchetypeIndex, newRow };
+}
+
+Transform& GetTransform(EntityWorld& world, uint32_t entity)
+{
+	return GetComponent(world, entity, kComponentTransform, &Archetype::transforms);
+}
+
+Matrix4x4& GetWorldMatrix(EntityWorld& world, uint32_t entity)
+{
+	return GetComponent(world, entity, kComponentWorldMatrix, &Archetype::worldMatrices);
+}
+
+MeshRef& GetMesh(EntityWorld& world, uint32_t entity)
+{
+	return GetComponent(world, entity, kComponentMesh, &Archetype::meshes);
+}
+
+MaterialRef& GetMaterial(EntityWorld& world, uint32_t entity)
+{
+	return GetComponent(world, entity, kComponentMaterial, &Archetype::materials);
+}
+
+BoundingVolume& GetBounds(EntityWorld& world, uint32_t entity)
+{
+	return GetComponent(world, entity, kComponentBounds, &Archetype::bounds);
+}
+
+SceneNodeRef& GetSceneNode(EntityWorld& world, uint32_t entity)
+{
+	return GetComponent(world, entity, kComponentSceneNode, &Archetype::sceneNodes);
+}
+
+void UpdateEntityWorldMatrices(EntityWorld& world, JobSystem* jobSystem)
+{
+	const uint32_t kRequiredMask = kComponentTransform | kComponentWorldMatrix;
+	for (Archetype& archetype : world.archetypes)
+	{
+		if ((archetype.componentMask & kRequiredMask) != kRequiredMask)
+		{
+			continue;
+		}
+		ParallelForRange(jobSystem, archetype.entities.size(), [&](size_t begin, size_t end)
+			{
+				UpdateWorldMatrixRange(archetype, begin, end);
+			});
+	}
+}
+
+void CopySceneGraphWorldMatrices(EntityWorld& world, const SceneGraph& sceneGraph)
+{
+	const uint32_t kRequiredMask = kComponentSceneNode | kComponentWorldMatrix;
+	for (Archetype& archetype : world.archetypes)
+	{
+		if ((archetype.componentMask & kRequiredMask) != kRequiredMask)
+		{
+			continue;
+		}
+		for (size_t row = 0; row < archetype.entities.size(); ++row)
+		{
+			uint32_t node = archetype.sceneNodes[row].node;
+			if (node == kInvalidSceneNode)
+			{
+				continue;
+			}
+			assert(node < sceneGraph.worldMatrices.size());
+			archetype.worldMatrices[row] = sceneGraph.worldMatrices[node];
+		}
+	}
+}
+
+void ExtractDrawPackets(const EntityWorld& world, const Matrix4x4& viewProjection, RenderExtraction& extraction, TransfomationMatrix* palette, uint32_t paletteCapacity, JobSystem* jobSystem)
+{
+	const uint32_t kRequiredMask = kComponentWorldMatrix | kComponentMesh | kComponentMaterial;
+	extraction.packets.clear();
+	extraction.batches.clear();
+	extraction.entityCount = 0;
+	extraction.visibleCount = 0;
+	Vector4 planes[6];
+	ExtractFrustumPlanes(viewProjection, planes);
+
+	//1. アーキタイプごとに、視錐台に入った行をパケットにする。境界が無ければ全ての行を使う
+	for (uint32_t archetypeIndex = 0; archetypeIndex < world.archetypes.size(); ++archetypeIndex)
+	{
+		const Archetype& archetype = world.archetypes[archetypeIndex];
+		if ((archetype.componentMask & kRequiredMask) != kRequiredMask)
+		{
+			continue;
+		}
+		uint32_t rowCount = static_cast<uint32_t>(archetype.entities.size());
+		extraction.entityCount += rowCount;
+		if (archetype.componentMask & kComponentBounds)
+		{
+			ResizeCullBounds(extraction.cullBounds, rowCount);
+			for (uint32_t row = 0; row < rowCount; ++row)
+			{
+				SetCullBounds(extraction.cullBounds, row, archetype.bounds[row], archetype.worldMatrices[row]);
+			}
+			extraction.visibleRows.resize(extraction.cullBounds.sphereX.size());
+			rowCount = CullVisible(planes, extraction.cullBounds, CullShape::Sphere, VisibilityCullMode::Avx, extraction.visibleRows.data());
+		}
+		else
+		{
+			extraction.visibleRows.resize(rowCount);
+			for (uint32_t row = 0; row < rowCount; ++row)
+			{
+				extraction.visibleRows[row] = row;
+			}
+		}
+		for (uint32_t i = 0; i < rowCount; ++i)
+		{
+			uint32_t row = extraction.visibleRows[i];
+			uint64_t sortKey = (uint64_t(archetype.meshes[row].lodLevel) << 32) | archetype.materials[row].useModelMaterial;
+			extraction.packets.push_back({ sortKey, archetypeIndex, row });
+		}
+	}
+
+	//2. 同じLODとマテリアルが続くように並べる。同じキーの中では元の順番を保つ
+	std::stable_sort(extraction.packets.begin(), extraction.packets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.sortKey < b.sortKey; });
+
+	//3. 並べた順にワールド行列を集め、パレットへ書き込む
+	// 列をまたいで読むのは手元の配列への詰め直しだけにし、アップロードヒープへは前から続けて書く
+	uint32_t packetCount = static_cast<uint32_t>(std::min(extraction.packets.size(), size_t(paletteCapacity)));
+	extraction.worldMatrices.resize(packetCount);
+	ParallelForRange(jobSystem, packetCount, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const DrawPacket& packet = extraction.packets[i];
+				extraction.worldMatrices[i] = world.archetypes[packet.archetype].worldMatrices[packet.row];
+			}
+		});
+	BuildMatrixPalette(std::span<const Matrix4x4>(extraction.worldMatrices), viewProjection, palette, jobSystem);
+
+	//4. キーが変わるところで描画の単位を区切る
+	for (uint32_t i = 0; i < packetCount; ++i)
+	{
+		uint64_t sortKey = extraction.packets[i].sortKey;
+		if (extraction.batches.empty() || extraction.packets[i - 1].sortKey != sortKey)
+		{
+			extraction.batches.push_back({ uint32_t(sortKey >> 32), uint32_t(sortKey & 0xFFFFFFFFu), i, 0 });
+		}
+		++extraction.batches.back().instanceCount;
+	}
+	extraction.visibleCount = packetCount;
+}
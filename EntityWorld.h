@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BoundingVolume.h"
+#include "JobSystem.h"
+#include "Matrix4x4.h"
+#include "SceneGraph.h"
+#include "Transform.h"
+#include "TransformationMatrix.h"
+#include "Visibility.h"
+
+// コンポーネントの種類。エンティティはこれを組み合わせたマスクを持ち、同じマスクのものが1つのアーキタイプにまとまる
+const uint32_t kComponentTransform = 1u << 0;		// Transform。ワールド行列をここから求める
+const uint32_t kComponentWorldMatrix = 1u << 1;		// Matrix4x4。描画に使うワールド行列
+const uint32_t kComponentMesh = 1u << 2;			// MeshRef
+const uint32_t kComponentMaterial = 1u << 3;		// MaterialRef
+const uint32_t kComponentBounds = 1u << 4;			// BoundingVolume(モデル空間)。あれば視錐台カリングする
+const uint32_t kComponentSceneNode = 1u << 5;		// SceneNodeRef。ワールド行列をシーングラフから写す
+
+// 存在しないエンティティ・アーキタイプの番号
+const uint32_t kInvalidEntity = UINT32_MAX;
+// まだシーングラフのノードを指していないSceneNodeRefの番号
+const uint32_t kInvalidSceneNode = UINT32_MAX;
+
+///==========================================================
+/// 描画するメッシュのLOD。MeshLodChain::lodsの番号
+///==========================================================
+struct MeshRef
+{
+	uint32_t lodLevel;
+};
+
+///==========================================================
+/// 使うテクスチャの選び方
+///==========================================================
+struct MaterialRef
+{
+	uint32_t useModelMaterial;	//!< 0ならuvChecker、1ならサブメッシュごとのモデルのマテリアル
+};
+
+///==========================================================
+/// ワールド行列を読むシーングラフのノード
+///==========================================================
+struct SceneNodeRef
+{
+	uint32_t node;		//!< 作った直後はkInvalidSceneNode
+};
+
+///==========================================================
+/// 同じコンポーネントの組み合わせを持つエンティティの表。行がエンティティ、列がコンポーネント
+/// 持っていないコンポーネントの列は空のまま。各列は行の番号で引き、隙間なく詰めてある
+///==========================================================
+struct Archetype
+{
+	uint32_t componentMask;						//!< 持っているコンポーネント
+	std::vector<uint32_t> entities;				//!< 行のエンティティ
+	std::vector<Transform> transforms;
+	std::vector<Matrix4x4> worldMatrices;
+	std::vector<MeshRef> meshes;
+	std::vector<MaterialRef> materials;
+	std::vector<BoundingVolume> bounds;
+	std::vector<SceneNodeRef> sceneNodes;
+};
+
+///==========================================================
+/// エンティティがどのアーキタイプの何行目にあるか
+///==========================================================
+struct EntityLocation
+{
+	uint32_t archetype;		//!< 破棄済みならkInvalidEntity
+	uint32_t row;
+};
+
+///==========================================================
+/// エンティティとアーキタイプをまとめたもの
+///==========================================================
+struct EntityWorld
+{
+	std::vector<Archetype> archetypes;
+	std::vector<EntityLocation> locations;	//!< エンティティの番号で引く
+	std::vector<uint32_t> freeEntities;		//!< 破棄して再利用できる番号
+	uint32_t entityCount = 0;				//!< 生きているエンティティの数
+};
+
+///==========================================================
+/// 描画パケット。並べ替えてから行列を書き込む
+///==========================================================
+struct DrawPacket
+{
+	uint64_t sortKey;		//!< 上位32bitがLOD、下位32bitがMaterialRef::useModelMaterial
+	uint32_t archetype;		//!< 行列を読むアーキタイプ
+	uint32_t row;			//!< 行列を読む行
+};
+
+///==========================================================
+/// 同じLODとマテリアルの選び方で続けて並んだインスタンス。1回のインスタンス描画にあたる
+///==========================================================
+struct DrawBatch
+{
+	uint32_t lodLevel;
+	uint32_t useModelMaterial;
+	uint32_t firstInstance;		//!< パレットの最初の番号
+	uint32_t instanceCount;
+};
+
+///==========================================================
+/// 描画用の取り出しの結果と作業領域。毎フレーム使い回す
+///==========================================================
+struct RenderExtraction
+{
+	CullBoundsSoA cullBounds;				//!< アーキタイプごとに詰め直す境界
+	std::vector<uint32_t> visibleRows;		//!< 視錐台に入った行
+	std::vector<DrawPacket> packets;		//!< LODとマテリアルの順に並べたパケット
+	std::vector<Matrix4x4> worldMatrices;	//!< パケットの順に集めたワールド行列
+	std::vector<DrawBatch> batches;			//!< 描画の単位
+	uint32_t entityCount;					//!< 描画できるコンポーネントを持っていたエンティティ数
+	uint32_t visibleCount;					//!< パレットに書き込んだ数
+};
+
+// componentMaskのコンポーネントを持つエンティティを作り、番号を返す。中身は単位行列などで初期化する
+uint32_t CreateEntity(EntityWorld& world, uint32_t componentMask);
+
+// エンティティを破棄する。同じアーキタイプの最後の行がその場所に移る
+void DestroyEntity(EntityWorld& world, uint32_t entity);
+
+// コンポーネントの組み合わせを変え、別のアーキタイプに移す。両方にあるコンポーネントは引き継ぐ
+void SetEntityComponents(EntityWorld& world, uint32_t entity, uint32_t componentMask);
+
+// エンティティのコンポーネントを取得する。持っていなければassertで止まる
+Transform& GetTransform(EntityWorld& world, uint32_t entity);
+Matrix4x4& GetWorldMatrix(EntityWorld& world, uint32_t entity);
+MeshRef& GetMesh(EntityWorld& world, uint32_t entity);
+MaterialRef& GetMaterial(EntityWorld& world, uint32_t entity);
+BoundingVolume& GetBounds(EntityWorld& world, uint32_t entity);
+SceneNodeRef& GetSceneNode(EntityWorld& world, uint32_t entity);
+
+// TransformとWorldMatrixを持つアーキタイプの列を前から読み、ワールド行列を求める。jobSystemがあれば区間に分けて並列に求める
+void UpdateEntityWorldMatrices(EntityWorld& world, JobSystem* jobSystem);
+
+// SceneNodeとWorldMatrixを持つアーキタイプに、シーングラフのワールド行列を写す
+// ノードがkInvalidSceneNodeの行はワールド行列をそのままにする。それ以外はシーングラフにあるノードであること
+void CopySceneGraphWorldMatrices(EntityWorld& world, const SceneGraph& sceneGraph);
+
+// WorldMatrix, Mesh, Materialを持つエンティティを描画パケットにし、LODとマテリアルの順に並べてpaletteに行列を書き込む
+// Boundsも持つアーキタイプは境界球で視錐台カリングする。paletteCapacityを超えた分は捨てる
+// jobSystemがあればパレットへの書き込みを区間に分けて並列に行う
+void ExtractDrawPackets(const EntityWorld& world, const Matrix4x4& viewProjection, RenderExtraction& extraction, TransfomationMatrix* palette, uint32_t paletteCapacity, JobSystem* jobSystem);
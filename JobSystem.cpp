@@ -0,0 +1,130 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+	// ParallelForで呼び出し元とワーカーが共有する状態
+	struct ParallelForState
+	{
+		std::function<void(size_t, size_t, size_t)> func;
+		size_t count = 0;
+		size_t chunkCount = 0;
+		std::atomic<size_t> nextChunk = 0;
+		std::atomic<size_t> finishedChunks = 0;
+		std::mutex mutex;
+		std::condition_variable condition;
+
+		// 残っているチャンクを取り出して処理する
+		void Run()
+		{
+			for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+			{
+				size_t begin = count * chunk / chunkCount;
+				size_t end = count * (chunk + 1) / chunkCount;
+				func(chunk, begin, end);
+				if (++finishedChunks == chunkCount)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					condition.notify_all();
+				}
+			}
+		}
+	};
+}
+
+JobSystem* JobSystem::GetInstance()
+{
+	static JobSystem instance;
+	return &instance;
+}
+
+JobSystem::JobSystem(uint32_t threadCount)
+{
+	if (threadCount == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+	for (uint32_t i = 0; i < threadCount; ++i)
+	{
+		workers_.emplace_back([this]() { WorkerLoop(); });
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	condition_.notify_all();
+	for (std::thread& worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t chunkCount, const std::function<void(size_t, size_t, size_t)>& func)
+{
+	if (count == 0 || chunkCount == 0)
+	{
+		return;
+	}
+	if (chunkCount > count)
+	{
+		chunkCount = count;
+	}
+	// 1つしかなければそのまま実行する
+	if (chunkCount == 1)
+	{
+		func(0, 0, count);
+		return;
+	}
+
+	// ワーカーが遅れて起動しても参照できるように共有ポインタで持つ
+	auto state = std::make_shared<ParallelForState>();
+	state->func = func;
+	state->count = count;
+	state->chunkCount = chunkCount;
+
+	size_t helperCount = std::min<size_t>(workers_.size(), chunkCount - 1);
+	for (size_t i = 0; i < helperCount; ++i)
+	{
+		Enqueue([state]() { state->Run(); });
+	}
+
+	// 呼び出し元も処理に参加する。ワーカー上から呼ばれても詰まらない
+	state->Run();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->condition.wait(lock, [&]() { return state->finishedChunks == state->chunkCount; });
+}
+
+void JobSystem::Enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push(std::move(job));
+	}
+	condition_.notify_one();
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+			if (stop_ && jobs_.empty())
+			{
+				return;
+			}
+			job = std::move(jobs_.front());
+			jobs_.pop();
+		}
+		job();
+	}
+}
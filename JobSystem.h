@@ -0,0 +1,78 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ワーカースレッドでジョブを実行するスレッドプール
+class JobSystem
+{
+public:
+	// プロセス全体で共有するインスタンスを取得する
+	static JobSystem* GetInstance();
+
+	// threadCountが0の場合はコア数-1個のワーカーを作る
+	explicit JobSystem(uint32_t threadCount = 0);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// ジョブを投げる。結果はfutureで受け取る
+	template <typename Func>
+	auto Submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<Func>>;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+		std::future<Result> future = task->get_future();
+		Enqueue([task]() { (*task)(); });
+		return future;
+	}
+
+	// [0, count)をchunkCount個に分割し、func(chunkIndex, begin, end)を並列に実行する
+	// 呼び出したスレッドも処理に参加し、すべて終わるまで戻らない
+	void ParallelFor(size_t count, size_t chunkCount, const std::function<void(size_t, size_t, size_t)>& func);
+
+	// ワーカースレッドの数
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+private:
+	void Enqueue(std::function<void()> job);
+	void WorkerLoop();
+
+	std::vector<std::thread> workers_;
+	std::queue<std::function<void()>> jobs_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	bool stop_ = false;
+};
+
+// 1スレッドあたりの分割数。偏りが出てもワーカーが遊ばないように多めに分ける
+const size_t kParallelChunksPerThread = 4;
+// 1つの区間の最小の数。少ない数を分けるとジョブを投げる手間の方が大きくなる
+const size_t kParallelMinChunkSize = 256;
+
+// [0, count)をminChunkSize以上ずつの区間に分けてfunc(begin, end)を実行する
+// jobSystemが無いか区間が1つにしかならなければ、ジョブを投げずに呼び出したスレッドで実行する
+template <typename Func>
+void ParallelForRange(JobSystem* jobSystem, size_t count, const Func& func, size_t minChunkSize = kParallelMinChunkSize)
+{
+	size_t chunkCount = jobSystem ? (jobSystem->GetThreadCount() + 1) * kParallelChunksPerThread : 1;
+	size_t maxChunkCount = (count + minChunkSize - 1) / minChunkSize;
+	chunkCount = chunkCount < maxChunkCount ? chunkCount : maxChunkCount;
+	if (chunkCount <= 1)
+	{
+		func(size_t(0), count);
+		return;
+	}
+	jobSystem->ParallelFor(count, chunkCount, [&](size_t, size_t begin, size_t end)
+		{
+			func(begin, end);
+		});
+}
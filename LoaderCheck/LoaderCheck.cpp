@@ -0,0 +1,405 @@
+// ModelLoaderの読み込みでのヒープ確保の回数と、ストリーミング読み込みの結果とメモリの使用量を確かめるコンソールツール
+// 確保を数えるにはCG_COUNT_ALLOCATIONSの定義が要るので、LoaderCheck.vcxprojでは全ての構成で定義している
+// Windowsに依存しないので、Linuxでは次のようにビルドできる
+//   g++ -std=c++20 -O2 -pthread -DCG_COUNT_ALLOCATIONS -I.. LoaderCheck.cpp ../ModelLoader.cpp ../MappedFile.cpp ../JobSystem.cpp ../MonotonicArena.cpp ../AllocationCounter.cpp ../MeshTangentSpace.cpp ../BoundingVolume.cpp -o LoaderCheck
+//
+// 使い方
+//   LoaderCheck    Mapped/Parallelの確保回数を数え、上限を超えたかファイルの大きさで変わったら失敗(終了コード1)にする
+//                  続けて、ストリーミング読み込みの結果がLoadObjFileと面の頂点ごとに一致するかを確かめる
+//   LoaderCheck --stream fileSizeMB [--budget MB]
+//                  fileSizeMB程度のObjを一時フォルダに生成してストリーミング読み込みし、
+//                  物理メモリの増加の最大がbudget(既定16MB)を超えたら失敗(終了コード1)にする。例: --stream 4096 --budget 16
+#include "AllocationCounter.h"
+#include "JobSystem.h"
+#include "ModelLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <psapi.h>
+#endif
+
+namespace
+{
+	// 確保回数を数えるObjの1辺の四角形の数。大きい方は縦を2倍にして三角形の数を2倍にする
+	const uint32_t kAllocationGridSize = 64;
+
+	// Mappedで法線の有るObjを1回読み込むときに許す確保の回数
+	// 要素を数えてから解析中の一時領域を1つのアリーナにまとめて確保するので、回数はファイルの大きさによらない
+	// 1回にならないのは、出力のModelDataが別々のvectorを持つのと、読み込んだ後の処理がそれぞれ作業用の配列を確保するため
+	//   解析: ファイルのパス、チャンクの配列、アリーナ(ブロックの表と本体)、o/g/usemtlの区切り                   5
+	//   出力: vertices、indices、tangents、materials、submeshes、materialBatches                                  6
+	//   接線の生成: 面の接線、角度、点ごとの隣接表(2)、書き込み位置                                               5
+	//   サブメッシュの作成: 区切りをまとめた配列、マテリアル名の表(2)、マテリアルの順、並べ替えの作業用          5
+	// 計21回。標準ライブラリによってはコンテナの確保の仕方が違うので、少し余裕を持たせる
+	const uint64_t kMappedAllocationLimit = 24;
+	// 法線を作るときに増える確保の回数
+	//   平滑化の番号(並べ替えの順と番号)、面の法線、角度、点ごとの隣接表(2)、書き込み位置、点ごとの合計         8
+	const uint64_t kGeneratedNormalAllocationLimit = 8;
+	// Parallelで1回のParallelForに増える確保の回数(共有の状態とジョブの関数)。これとは別にワーカー1つにつき1回ジョブを積む
+	const uint64_t kAllocationsPerParallelFor = 2;
+	// Parallelの1回の読み込みでのParallelForの回数の上限
+	// 数える、解析する、頂点を作る、法線の生成(2)、接線の生成(2)
+	const uint64_t kParallelForLimit = 7;
+
+	// ストリーミング読み込みの結果を比べるObjの1辺の四角形の数
+	const uint32_t kStreamCheckGridSize = 200;
+	// ストリーミング読み込みの結果を比べるときのメモリの上限(byte)。小さい方はまとまりが多く分かれ、窓も最小になる
+	const size_t kStreamCheckBudgets[] = { 512 * 1024, 4 * 1024 * 1024 };
+	// 大きなファイルのストリーミング読み込みで生成するObjの横の四角形の数
+	const uint32_t kStreamGridWidth = 1024;
+	// 大きなファイルのストリーミング読み込みのメモリの上限の既定値(MB)
+	const size_t kDefaultStreamBudgetMB = 16;
+
+	///==========================================================
+	/// 書き出す格子状のObjの設定
+	///==========================================================
+	struct GridObjDesc
+	{
+		uint32_t width;			//!< 横の四角形の数
+		uint32_t height;		//!< 縦の四角形の数
+		bool writeNormals;		//!< vnを書くか。falseなら読み込み時に作らせる
+		bool mixedFaces;		//!< 行ごとに平滑化グループ(s 1 / s 2 / s off)を変え、奇数行は相対指定で書き、途中でマテリアルを変えるか
+	};
+
+	// 格子状のObjを書き出す。mixedFacesならマテリアルのファイルも同じフォルダに書き出す
+	// 大きなファイルも作れるように、バッファがたまるたびに書き出す
+	void WriteGridObj(const std::filesystem::path& path, const GridObjDesc& desc)
+	{
+		std::ofstream file(path, std::ios::binary);
+		std::string buffer;
+		char line[160];
+		auto append = [&](const char* text)
+			{
+				buffer += text;
+				if (buffer.size() > (1 << 20))
+				{
+					file.write(buffer.data(), buffer.size());
+					buffer.clear();
+				}
+			};
+
+		append("# loader check grid\n");
+		if (desc.mixedFaces)
+		{
+			std::filesystem::path materialPath = path;
+			materialPath.replace_extension(".mtl");
+			std::ofstream materialFile(materialPath, std::ios::binary);
+			materialFile << "newmtl A\nnewmtl B\n";
+			std::snprintf(line, sizeof(line), "mtllib %s\n", materialPath.filename().string().c_str());
+			append(line);
+		}
+		append("o Grid\n");
+
+		//1. 頂点。起伏を付けて、法線を作ったときに向きがばらつくようにする
+		uint32_t rowVertexCount = desc.width + 1;
+		for (uint32_t y = 0; y <= desc.height; ++y)
+		{
+			for (uint32_t x = 0; x <= desc.width; ++x)
+			{
+				float u = float(x) / float(desc.width);
+				float v = float(y) / float(desc.height);
+				std::snprintf(line, sizeof(line), "v %g %g %g\nvt %g %g\n", u * 2.0f - 1.0f, std::sin(u * 12.0f) * std::cos(v * 7.0f) * 0.2f, v * 2.0f - 1.0f, u, v);
+				append(line);
+				if (desc.writeNormals)
+				{
+					append("vn 0 1 0\n");
+				}
+			}
+		}
+
+		//2. 面。四角形1つにつき三角形2つ
+		long long vertexCount = static_cast<long long>(rowVertexCount) * (desc.height + 1);
+		for (uint32_t y = 0; y < desc.height; ++y)
+		{
+			if (desc.mixedFaces)
+			{
+				const char* smoothingGroups[] = { "s 1\n", "s 2\n", "s off\n" };
+				append(y == 0 ? "usemtl A\n" : y == desc.height / 2 ? "usemtl B\n" : "");
+				append(smoothingGroups[y % 3]);
+			}
+			// 奇数行は相対指定にする。頂点を全て書いた後なので、-1が最後の頂点
+			long long offset = desc.mixedFaces && (y % 2) == 1 ? -(vertexCount + 1) : 0;
+			for (uint32_t x = 0; x < desc.width; ++x)
+			{
+				long long i0 = static_cast<long long>(y) * rowVertexCount + x + 1 + offset;
+				long long i1 = i0 + 1;
+				long long i2 = i0 + rowVertexCount;
+				long long i3 = i2 + 1;
+				long long triangles[2][3] = { { i0, i2, i1 }, { i1, i2, i3 } };
+				for (const long long* triangle : triangles)
+				{
+					if (desc.writeNormals)
+					{
+						std::snprintf(line, sizeof(line), "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n", triangle[0], triangle[0], triangle[0],
+							triangle[1], triangle[1], triangle[1], triangle[2], triangle[2], triangle[2]);
+					}
+					else
+					{
+						std::snprintf(line, sizeof(line), "f %lld/%lld %lld/%lld %lld/%lld\n", triangle[0], triangle[0], triangle[1], triangle[1], triangle[2], triangle[2]);
+					}
+					append(line);
+				}
+			}
+		}
+		file.write(buffer.data(), buffer.size());
+	}
+
+	// WriteGridObjで書き出したファイルを消す
+	void RemoveGridObj(const std::filesystem::path& path)
+	{
+		std::filesystem::path materialPath = path;
+		materialPath.replace_extension(".mtl");
+		std::filesystem::remove(path);
+		std::filesystem::remove(materialPath);
+	}
+
+	// 読み込みの間の確保の回数を数える
+	uint64_t CountLoadAllocations(const std::string& directoryPath, const std::string& filename, ObjParseMode mode)
+	{
+		uint64_t before = GetAllocationCount().count;
+		ModelData modelData = LoadObjFile(directoryPath, filename, mode);
+		uint64_t after = GetAllocationCount().count;
+		return after - before;
+	}
+
+	// Mapped/Parallelの確保回数が上限以内で、ファイルの大きさによらないことを確かめる。失敗した数を返す
+	int CheckAllocations()
+	{
+		if (!kAllocationCountEnabled)
+		{
+			std::fprintf(stderr, "CG_COUNT_ALLOCATIONS is not defined\n");
+			return 1;
+		}
+
+		// ワーカーを作るときの確保を含めないように、先に共有のJobSystemを作っておく
+		// Parallelはさらに、ParallelForごとの確保と、チャンクごとのo/g/usemtlの区切りの分だけ増える
+		uint64_t threadCount = JobSystem::GetInstance()->GetThreadCount();
+		uint64_t parallelExtra = kParallelForLimit * (kAllocationsPerParallelFor + threadCount) + (threadCount + 1) * 4;
+
+		std::filesystem::path directory = std::filesystem::temp_directory_path();
+		std::string directoryPath = directory.string();
+		int failureCount = 0;
+		std::printf("%-10s %-8s %8s %8s %8s\n", "mode", "normals", "N", "2N", "limit");
+		for (bool writeNormals : { true, false })
+		{
+			std::string filename = writeNormals ? "cg_loader_check.obj" : "cg_loader_check_nonormal.obj";
+			std::string doubleFilename = writeNormals ? "cg_loader_check_double.obj" : "cg_loader_check_nonormal_double.obj";
+			WriteGridObj(directory / filename, { kAllocationGridSize, kAllocationGridSize, writeNormals, false });
+			WriteGridObj(directory / doubleFilename, { kAllocationGridSize, kAllocationGridSize * 2, writeNormals, false });
+			for (ObjParseMode mode : { ObjParseMode::Mapped, ObjParseMode::Parallel })
+			{
+				uint64_t count = CountLoadAllocations(directoryPath, filename, mode);
+				uint64_t doubleCount = CountLoadAllocations(directoryPath, doubleFilename, mode);
+				uint64_t limit = kMappedAllocationLimit + (writeNormals ? 0 : kGeneratedNormalAllocationLimit) + (mode == ObjParseMode::Parallel ? parallelExtra : 0);
+				// Parallelは分割の数がファイルの大きさで変わりうるので、上限だけを確かめる
+				bool passed = count <= limit && doubleCount <= limit && (mode != ObjParseMode::Mapped || count == doubleCount);
+				failureCount += passed ? 0 : 1;
+				std::printf("%-10s %-8s %8llu %8llu %8llu%s\n", mode == ObjParseMode::Mapped ? "Mapped" : "Parallel", writeNormals ? "yes" : "no",
+					static_cast<unsigned long long>(count), static_cast<unsigned long long>(doubleCount), static_cast<unsigned long long>(limit), passed ? "" : "  FAILED");
+			}
+			RemoveGridObj(directory / filename);
+			RemoveGridObj(directory / doubleFilename);
+		}
+		return failureCount;
+	}
+
+	// ストリーミング読み込みが、同じファイルをLoadObjFileで読んだ結果と面の頂点ごとに一致するかを確かめる
+	// まとまりの境目でも法線が同じになるか(全体の面から作られているか)をここで確かめる
+	bool CheckStreamMatchesLoad(const std::string& directoryPath, const std::string& filename, size_t memoryBudget, size_t& chunkCount)
+	{
+		ModelData modelData = LoadObjFile(directoryPath, filename, ObjParseMode::Mapped);
+		size_t corner = 0;
+		size_t submeshIndex = 0;
+		bool same = true;
+		ObjStreamResult result = StreamObjFile(directoryPath, filename, memoryBudget, [&](const ObjStreamChunk& chunk)
+			{
+				same = same && chunk.vertices.size() <= 0xFFFF;
+				for (uint32_t index : chunk.indices)
+				{
+					if (index >= chunk.vertices.size() || corner >= modelData.indices.size())
+					{
+						same = false;
+						continue;
+					}
+					while (corner >= modelData.submeshes[submeshIndex].indexStart + modelData.submeshes[submeshIndex].indexCount)
+					{
+						++submeshIndex;
+					}
+					const VertexData& expected = modelData.vertices[modelData.indices[corner]];
+					const VertexData& actual = chunk.vertices[index];
+					// 法線は足す順番と式の細部が違うので、誤差を許す
+					const float kNormalTolerance = 1e-4f;
+					same = same && chunk.materialIndex == modelData.submeshes[submeshIndex].materialIndex
+						&& std::memcmp(&expected.position, &actual.position, sizeof(Vector4)) == 0
+						&& std::memcmp(&expected.texcoord, &actual.texcoord, sizeof(Vector2)) == 0
+						&& std::fabs(expected.normal.x - actual.normal.x) <= kNormalTolerance
+						&& std::fabs(expected.normal.y - actual.normal.y) <= kNormalTolerance
+						&& std::fabs(expected.normal.z - actual.normal.z) <= kNormalTolerance;
+					++corner;
+				}
+			});
+		chunkCount = result.chunkCount;
+		return same && result.completed && corner == modelData.indices.size() && result.peakMemorySize <= memoryBudget;
+	}
+
+	// 法線の有無と面の種類を変えたObjで、ストリーミング読み込みとLoadObjFileの結果を比べる。失敗した数を返す
+	int CheckStreamResults()
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path();
+		std::string directoryPath = directory.string();
+		std::string filename = "cg_loader_check_stream.obj";
+		const GridObjDesc kDescs[] = {
+			{ kStreamCheckGridSize, kStreamCheckGridSize, true, false },
+			{ kStreamCheckGridSize, kStreamCheckGridSize, false, false },
+			{ kStreamCheckGridSize, kStreamCheckGridSize, false, true },
+			{ kStreamCheckGridSize, kStreamCheckGridSize, true, true },
+		};
+		int failureCount = 0;
+		std::printf("\n%-8s %-8s %10s %8s\n", "normals", "faces", "budget", "chunks");
+		for (const GridObjDesc& desc : kDescs)
+		{
+			WriteGridObj(directory / filename, desc);
+			for (size_t memoryBudget : kStreamCheckBudgets)
+			{
+				size_t chunkCount = 0;
+				bool passed = CheckStreamMatchesLoad(directoryPath, filename, memoryBudget, chunkCount);
+				failureCount += passed ? 0 : 1;
+				std::printf("%-8s %-8s %9zuK %8zu%s\n", desc.writeNormals ? "yes" : "no", desc.mixedFaces ? "mixed" : "plain", memoryBudget / 1024, chunkCount, passed ? "" : "  FAILED");
+			}
+			RemoveGridObj(directory / filename);
+		}
+		return failureCount;
+	}
+
+	///==========================================================
+	/// プロセスが使っている物理メモリ
+	///==========================================================
+	struct ProcessMemory
+	{
+		size_t current;		//!< 今の使用量(byte)
+		size_t peak;		//!< 最大の使用量(byte)
+	};
+
+	// プロセスの物理メモリの使用量を取得する
+	ProcessMemory GetProcessMemory()
+	{
+		ProcessMemory memory{};
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		memory.current = counters.WorkingSetSize;
+		memory.peak = counters.PeakWorkingSetSize;
+#else
+		// VmRSSが今の使用量、VmHWMが最大の使用量(kB)
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line))
+		{
+			size_t kiloBytes = static_cast<size_t>(std::atoll(line.c_str() + line.find(':') + 1));
+			if (line.rfind("VmRSS:", 0) == 0)
+			{
+				memory.current = kiloBytes * 1024;
+			}
+			else if (line.rfind("VmHWM:", 0) == 0)
+			{
+				memory.peak = kiloBytes * 1024;
+			}
+		}
+#endif
+		return memory;
+	}
+
+	// 最大の使用量を今の使用量に戻す。戻せない環境では何もしないので、それまでの最大が残る
+	void ResetPeakProcessMemory()
+	{
+#ifndef _WIN32
+		std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+	}
+
+	// fileSizeMB程度のObjを生成してストリーミング読み込みし、物理メモリの増加の最大がmemoryBudget以内かを確かめる
+	// 法線を書かないので、法線の集計も含めて確かめる。一時フォルダにObjと同じくらいの空きが2つ分要る
+	bool CheckStreamMemory(size_t fileSizeMB, size_t memoryBudget)
+	{
+		//1. 少しだけ書いて1行あたりのサイズを測り、目的のサイズになる行数を決める
+		std::filesystem::path directory = std::filesystem::temp_directory_path();
+		std::string filename = "cg_loader_check_large.obj";
+		WriteGridObj(directory / filename, { kStreamGridWidth, 16, false, false });
+		size_t rowSize = static_cast<size_t>(std::filesystem::file_size(directory / filename)) / 16;
+		uint32_t height = static_cast<uint32_t>(std::max<size_t>(fileSizeMB * 1024 * 1024 / rowSize, 1));
+		WriteGridObj(directory / filename, { kStreamGridWidth, height, false, false });
+		size_t fileSize = static_cast<size_t>(std::filesystem::file_size(directory / filename));
+
+		//2. 物理メモリの最大を測りながら読む。シンクは受け取ったものを確かめるだけにする
+		bool validIndices = true;
+		ResetPeakProcessMemory();
+		ProcessMemory before = GetProcessMemory();
+		auto start = std::chrono::steady_clock::now();
+		ObjStreamResult result = StreamObjFile(directory.string(), filename, memoryBudget, [&](const ObjStreamChunk& chunk)
+			{
+				validIndices = validIndices && chunk.vertices.size() <= 0xFFFF;
+				for (uint32_t index : chunk.indices)
+				{
+					validIndices = validIndices && index < chunk.vertices.size();
+				}
+			});
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		ProcessMemory after = GetProcessMemory();
+		RemoveGridObj(directory / filename);
+
+		//3. 増えた分を上限と比べる
+		size_t growth = after.peak > before.current ? after.peak - before.current : 0;
+		size_t triangleCount = size_t(kStreamGridWidth) * height * 2;
+		bool passed = result.completed && validIndices && result.indexCount == triangleCount * 3 && growth <= memoryBudget;
+		const double kMB = 1024.0 * 1024.0;
+		std::printf("file %.1f MB, %zu triangles, %.1f s (%.1f MB/s), %zu chunks, spill %.1f MB\n", double(fileSize) / kMB, triangleCount, seconds,
+			double(fileSize) / kMB / seconds, result.chunkCount, double(result.spillSize) / kMB);
+		std::printf("budget %.2f MB, allocated %.2f MB, measured peak growth %.2f MB%s\n", double(memoryBudget) / kMB, double(result.peakMemorySize) / kMB,
+			double(growth) / kMB, passed ? "" : "  FAILED");
+		return passed;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	//1. 引数を読む
+	size_t streamFileSizeMB = 0;
+	size_t memoryBudgetMB = kDefaultStreamBudgetMB;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--stream") == 0 && i + 1 < argc)
+		{
+			streamFileSizeMB = static_cast<size_t>(std::atoll(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+		{
+			memoryBudgetMB = static_cast<size_t>(std::atoll(argv[++i]));
+		}
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--stream fileSizeMB [--budget MB]]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	//2. 大きなファイルのストリーミング読み込みは、それだけを行う。他の確認で増えた物理メモリの最大を含めないため
+	if (streamFileSizeMB != 0)
+	{
+		return CheckStreamMemory(streamFileSizeMB, memoryBudgetMB * 1024 * 1024) ? 0 : 1;
+	}
+
+	//3. 確保の回数と、ストリーミング読み込みの結果を確かめる
+	int failureCount = CheckAllocations();
+	failureCount += CheckStreamResults();
+	return failureCount == 0 ? 0 : 1;
+}
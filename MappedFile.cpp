@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+	//ファイルを読み取り専用で開く。先頭から順に読むのでSequentialScanを指定
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	file_ = file;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		return;
+	}
+	size_ = static_cast<size_t>(fileSize.QuadPart);
+	isOpen_ = true;
+
+	//サイズ0のファイルはマップできないので空のまま扱う
+	if (size_ == 0)
+	{
+		return;
+	}
+
+	//ファイル全体をマップする
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		isOpen_ = false;
+		return;
+	}
+	mapping_ = mapping;
+	data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data_ == nullptr)
+	{
+		isOpen_ = false;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (data_)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_)
+	{
+		CloseHandle(mapping_);
+	}
+	if (file_)
+	{
+		CloseHandle(file_);
+	}
+}
+#else
+// Windows以外ではmmapでマップする。コンソールのツールをLinuxでもビルドできるようにするため
+// file_にはファイル記述子+1を入れる。0(nullptr)を開いていない印に使うため
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+	//ファイルを読み取り専用で開く
+	int file = open(filePath.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return;
+	}
+	file_ = reinterpret_cast<void*>(static_cast<intptr_t>(file) + 1);
+
+	struct stat status{};
+	if (fstat(file, &status) != 0)
+	{
+		return;
+	}
+	size_ = static_cast<size_t>(status.st_size);
+	isOpen_ = true;
+
+	//サイズ0のファイルはマップできないので空のまま扱う
+	if (size_ == 0)
+	{
+		return;
+	}
+
+	//ファイル全体をマップする。先頭から順に読むので先読みを促す
+	void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+	if (data == MAP_FAILED)
+	{
+		isOpen_ = false;
+		return;
+	}
+	madvise(data, size_, MADV_SEQUENTIAL);
+	data_ = static_cast<const char*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data_)
+	{
+		munmap(const_cast<char*>(data_), size_);
+	}
+	if (file_)
+	{
+		close(static_cast<int>(reinterpret_cast<intptr_t>(file_) - 1));
+	}
+}
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// 読み取り専用でメモリマップしたファイル。寿命が尽きたらマップを解除する
+class MappedFile
+{
+public:
+	MappedFile(const std::string& filePath);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// ファイルを開けたか
+	bool IsOpen() const { return isOpen_; }
+	// ファイルの先頭アドレス。空のファイルの場合はnullptr
+	const char* GetData() const { return data_; }
+	// ファイルのサイズ(byte)
+	size_t GetSize() const { return size_; }
+private:
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+	bool isOpen_ = false;
+};
@@ -0,0 +1,383 @@
+// MatrixMath.h / VectorMath.h / QuaternionMath.h のマイクロベンチマーク
+// Windowsに依存しないので、Visual StudioではMathBenchmark.vcxproj、Linuxでは次のようにビルドできる
+//   g++ -std=c++20 -O2 -I.. MathBenchmark.cpp ../VectorMath.cpp ../TransformBatch.cpp -o MathBenchmark
+//   (AVX2の経路を計測するときは -mavx2 -mfma を付ける)
+//
+// 使い方
+//   MathBenchmark                         結果を表示する
+//   MathBenchmark --record baseline.txt   結果を基準として保存する
+//   MathBenchmark --compare baseline.txt [--threshold 20]
+//                                         基準より threshold(%) 以上遅くなった計測があれば失敗(終了コード1)にする
+// 基準は計測した環境でしか意味が無いので、比べるときは同じ環境で保存したものを使う
+#include "MatrixMath.h"
+#include "QuaternionMath.h"
+#include "TransformBatch.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// 冷えた状態を作るために、計測の前に書き込んでキャッシュから追い出すサイズ
+	const size_t kEvictBytes = 64u * 1024u * 1024u;
+	// 計測を繰り返す回数。割り込みなどで遅くなった分を除くため、一番速いものを使う
+	const int kSampleCount = 7;
+	// 基準より遅かった処理を測り直す回数
+	const int kRetryCount = 2;
+	// 温まった状態で計測するときに使う要素数。入力と出力がL1に収まる程度にする
+	const size_t kWarmMatrixCount = 128;
+	const size_t kWarmVectorCount = 1024;
+	// 冷えた状態で計測するときに使う要素数。入力と出力が最終キャッシュより大きくなるようにする
+	const size_t kColdMatrixCount = size_t(1) << 18;
+	const size_t kColdVectorCount = size_t(1) << 21;
+
+	///==========================================================
+	/// キャッシュラインの境界に揃えて確保するアロケータ
+	/// 確保した場所によってラインをまたぐ読み込みの数が変わり、実行ごとに結果がぶれるのを防ぐ
+	///==========================================================
+	template <typename T>
+	struct CacheLineAllocator
+	{
+		using value_type = T;
+		static constexpr std::align_val_t kAlignment{ 64 };
+		CacheLineAllocator() = default;
+		template <typename U>
+		CacheLineAllocator(const CacheLineAllocator<U>&) {}
+		T* allocate(size_t count) { return static_cast<T*>(::operator new(count * sizeof(T), kAlignment)); }
+		void deallocate(T* pointer, size_t) { ::operator delete(pointer, kAlignment); }
+		template <typename U>
+		bool operator==(const CacheLineAllocator<U>&) const { return true; }
+	};
+	template <typename T>
+	using AlignedVector = std::vector<T, CacheLineAllocator<T>>;
+
+	///==========================================================
+	/// 計測する処理。runは先頭からcount個を処理する
+	///==========================================================
+	struct MathKernel
+	{
+		const char* name;						//!< 処理の名前
+		const char* variant;					//!< 実装の種類
+		size_t warmCount;						//!< 温まった状態で使う要素数
+		size_t coldCount;						//!< 冷えた状態で使う要素数
+		std::function<void(size_t)> run;		//!< count個を処理する
+	};
+
+	///==========================================================
+	/// 1つの計測結果
+	///==========================================================
+	struct MathBenchmarkResult
+	{
+		std::string key;			//!< 名前/種類/キャッシュの状態
+		double nanosecondsPerOp;	//!< 1回あたりの時間(ns)
+	};
+
+	///==========================================================
+	/// 計測に使う入力と出力。冷えた状態の要素数分を確保する
+	///==========================================================
+	struct MathBenchmarkData
+	{
+		AlignedVector<Matrix4x4> matricesA;
+		AlignedVector<Matrix4x4> matricesB;
+		AlignedVector<Matrix4x4> matrixResults;
+		AlignedVector<Vector3> scales;
+		AlignedVector<Vector3> rotates;
+		AlignedVector<Vector3> translates;
+		TransformSoA transforms;
+		AlignedVector<Quaternion> quaternionsA;
+		AlignedVector<Quaternion> quaternionsB;
+		AlignedVector<Quaternion> quaternionResults;
+		AlignedVector<Vector3> points;
+		AlignedVector<Vector3> pointResults;
+		AlignedVector<float> pointX;
+		AlignedVector<float> pointY;
+		AlignedVector<float> pointZ;
+		AlignedVector<float> resultX;
+		AlignedVector<float> resultY;
+		AlignedVector<float> resultZ;
+		Matrix4x4 pointMatrix;
+	};
+
+	// 入力をランダムに作る。行列は逆行列を持つアフィン変換にする
+	void CreateData(MathBenchmarkData& data)
+	{
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> scaleDistribution(0.5f, 2.0f);
+		std::uniform_real_distribution<float> angleDistribution(-3.14159265f, 3.14159265f);
+		std::uniform_real_distribution<float> positionDistribution(-10.0f, 10.0f);
+		auto randomVector = [&](std::uniform_real_distribution<float>& distribution) { return Vector3{ distribution(random), distribution(random), distribution(random) }; };
+
+		//1. 行列とTransform
+		data.matricesA.resize(kColdMatrixCount);
+		data.matricesB.resize(kColdMatrixCount);
+		data.matrixResults.resize(kColdMatrixCount);
+		data.scales.resize(kColdMatrixCount);
+		data.rotates.resize(kColdMatrixCount);
+		data.translates.resize(kColdMatrixCount);
+		data.quaternionsA.resize(kColdMatrixCount);
+		data.quaternionsB.resize(kColdMatrixCount);
+		data.quaternionResults.resize(kColdMatrixCount);
+		ResizeTransforms(data.transforms, kColdMatrixCount);
+		for (size_t i = 0; i < kColdMatrixCount; ++i)
+		{
+			data.scales[i] = randomVector(scaleDistribution);
+			data.rotates[i] = randomVector(angleDistribution);
+			data.translates[i] = randomVector(positionDistribution);
+			data.matricesA[i] = MakeAffineMatrix(data.scales[i], data.rotates[i], data.translates[i]);
+			data.matricesB[i] = MakeAffineMatrix(randomVector(scaleDistribution), randomVector(angleDistribution), randomVector(positionDistribution));
+			SetTransform(data.transforms, i, { data.scales[i], data.rotates[i], data.translates[i] });
+			data.quaternionsA[i] = MakeQuaternionFromEuler(data.rotates[i]);
+			data.quaternionsB[i] = MakeQuaternionFromEuler(randomVector(angleDistribution));
+		}
+
+		//2. 点
+		data.points.resize(kColdVectorCount);
+		data.pointResults.resize(kColdVectorCount);
+		data.pointX.resize(kColdVectorCount);
+		data.pointY.resize(kColdVectorCount);
+		data.pointZ.resize(kColdVectorCount);
+		data.resultX.resize(kColdVectorCount);
+		data.resultY.resize(kColdVectorCount);
+		data.resultZ.resize(kColdVectorCount);
+		for (size_t i = 0; i < kColdVectorCount; ++i)
+		{
+			data.points[i] = randomVector(positionDistribution);
+			data.pointX[i] = data.points[i].x;
+			data.pointY[i] = data.points[i].y;
+			data.pointZ[i] = data.points[i].z;
+		}
+		data.pointMatrix = MakeAffineMatrix({ 1.5f, 0.8f, 1.2f }, { 0.3f, 1.1f, -0.4f }, { 2.0f, -3.0f, 25.0f });
+	}
+
+	// 計測する処理を並べる。scalarはSIMDを使わない実装、simd/batch/soaはまとめて処理する実装
+	std::vector<MathKernel> CreateKernels(MathBenchmarkData& data)
+	{
+		std::vector<MathKernel> kernels;
+		auto addMatrix = [&](const char* name, const char* variant, std::function<void(size_t)> run) { kernels.push_back({ name, variant, kWarmMatrixCount, kColdMatrixCount, std::move(run) }); };
+		auto addVector = [&](const char* name, const char* variant, std::function<void(size_t)> run) { kernels.push_back({ name, variant, kWarmVectorCount, kColdVectorCount, std::move(run) }); };
+
+		//1. 行列
+		addMatrix("Multiply", "scalar", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = MultiplyScalar(data.matricesA[i], data.matricesB[i]); } });
+		addMatrix("Multiply", "simd", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = Multiply(data.matricesA[i], data.matricesB[i]); } });
+		addMatrix("Inverse", "scalar", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = InverseScalar(data.matricesA[i]); } });
+		addMatrix("Inverse", "simd", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = Inverse(data.matricesA[i]); } });
+		addMatrix("InverseAffine", "scalar", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = InverseAffineScalar(data.matricesA[i]); } });
+		addMatrix("InverseAffine", "simd", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = InverseAffine(data.matricesA[i]); } });
+		addMatrix("MakeAffineMatrix", "chained", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = MakeAffineMatrixChained(data.scales[i], data.rotates[i], data.translates[i]); } });
+		addMatrix("MakeAffineMatrix", "scalar", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = MakeAffineMatrix(data.scales[i], data.rotates[i], data.translates[i]); } });
+		addMatrix("MakeAffineMatrix", "batch", [&](size_t count) { MakeAffineMatrices(data.transforms, 0, count, data.matrixResults.data()); });
+		addMatrix("MakeAffineMatrix", "quaternion", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.matrixResults[i] = MakeAffineMatrixQuaternion(data.scales[i], data.quaternionsA[i], data.translates[i]); } });
+
+		//2. クォータニオン
+		addMatrix("QuaternionMultiply", "scalar", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.quaternionResults[i] = MultiplyScalar(data.quaternionsA[i], data.quaternionsB[i]); } });
+		addMatrix("QuaternionMultiply", "simd", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.quaternionResults[i] = Multiply(data.quaternionsA[i], data.quaternionsB[i]); } });
+		addMatrix("Slerp", "scalar", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.quaternionResults[i] = Slerp(data.quaternionsA[i], data.quaternionsB[i], 0.3f); } });
+
+		//3. ベクトル
+		addVector("Transforms", "scalar", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.pointResults[i] = Transforms(data.points[i], data.pointMatrix); } });
+		addVector("Transforms", "batch", [&](size_t count) { TransformPoints(std::span<const Vector3>(data.points.data(), count), data.pointMatrix, std::span<Vector3>(data.pointResults.data(), count)); });
+		addVector("Transforms", "soa", [&](size_t count)
+			{
+				ConstVector3SoASpan points = { { data.pointX.data(), count }, { data.pointY.data(), count }, { data.pointZ.data(), count } };
+				Vector3SoASpan results = { { data.resultX.data(), count }, { data.resultY.data(), count }, { data.resultZ.data(), count } };
+				TransformPoints(points, data.pointMatrix, results);
+			});
+		addVector("Nomalize", "scalar", [&](size_t count) { for (size_t i = 0; i < count; ++i) { data.pointResults[i] = Nomalize(data.points[i]); } });
+		addVector("Nomalize", "batch", [&](size_t count)
+			{
+				// その場で書き換えるので、入力を結果に写してから正規化する。写す時間も含む
+				std::copy(data.points.begin(), data.points.begin() + count, data.pointResults.begin());
+				NormalizeMany(std::span<Vector3>(data.pointResults.data(), count));
+			});
+		addVector("Nomalize", "soa", [&](size_t count)
+			{
+				std::copy(data.pointX.begin(), data.pointX.begin() + count, data.resultX.begin());
+				std::copy(data.pointY.begin(), data.pointY.begin() + count, data.resultY.begin());
+				std::copy(data.pointZ.begin(), data.pointZ.begin() + count, data.resultZ.begin());
+				NormalizeMany(Vector3SoASpan{ { data.resultX.data(), count }, { data.resultY.data(), count }, { data.resultZ.data(), count } });
+			});
+		return kernels;
+	}
+
+	// キャッシュを追い出す。書き込んだ値を使わないと消されるので合計を返す
+	unsigned EvictCache(std::vector<unsigned char>& evictBuffer)
+	{
+		unsigned sum = 0;
+		for (size_t i = 0; i < evictBuffer.size(); i += 64)
+		{
+			evictBuffer[i] = static_cast<unsigned char>(evictBuffer[i] + 1);
+			sum += evictBuffer[i];
+		}
+		return sum;
+	}
+
+	double NowSeconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// 1つの処理を温まった状態と冷えた状態で計測し、一番速かったものを1回あたりの時間にする
+	// resultsには温まった状態、冷えた状態の順に入れる
+	void MeasureKernel(const MathKernel& kernel, std::vector<unsigned char>& evictBuffer, unsigned& evictSum, MathBenchmarkResult results[2])
+	{
+		//1. 温まった状態。少ない要素を繰り返して、冷えた状態と同じ回数だけ処理する
+		size_t repeatCount = kernel.coldCount / kernel.warmCount;
+		kernel.run(kernel.warmCount);
+		std::vector<double> samples(kSampleCount);
+		for (double& sample : samples)
+		{
+			double start = NowSeconds();
+			for (size_t repeat = 0; repeat < repeatCount; ++repeat)
+			{
+				kernel.run(kernel.warmCount);
+			}
+			sample = (NowSeconds() - start) / double(repeatCount * kernel.warmCount);
+		}
+		results[0] = { std::string(kernel.name) + "/" + kernel.variant + "/warm", *std::min_element(samples.begin(), samples.end()) * 1.0e9 };
+
+		//2. 冷えた状態。毎回キャッシュを追い出してから全ての要素を1回だけ処理する
+		for (double& sample : samples)
+		{
+			evictSum += EvictCache(evictBuffer);
+			double start = NowSeconds();
+			kernel.run(kernel.coldCount);
+			sample = (NowSeconds() - start) / double(kernel.coldCount);
+		}
+		results[1] = { std::string(kernel.name) + "/" + kernel.variant + "/cold", *std::min_element(samples.begin(), samples.end()) * 1.0e9 };
+	}
+
+	// 基準より threshold(%) 以上遅いか。基準に無ければ比べない
+	bool IsRegressed(const MathBenchmarkResult& result, const std::vector<MathBenchmarkResult>& baseline, double thresholdPercent)
+	{
+		auto it = std::find_if(baseline.begin(), baseline.end(), [&](const MathBenchmarkResult& entry) { return entry.key == result.key; });
+		return it != baseline.end() && result.nanosecondsPerOp > it->nanosecondsPerOp * (1.0 + thresholdPercent / 100.0);
+	}
+
+	// 基準のファイルを読む。1行に「名前/種類/キャッシュの状態 ns」が並ぶ
+	bool LoadBaseline(const char* path, std::vector<MathBenchmarkResult>& baseline)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+		MathBenchmarkResult entry;
+		while (file >> entry.key >> entry.nanosecondsPerOp)
+		{
+			baseline.push_back(entry);
+		}
+		return true;
+	}
+
+	bool SaveBaseline(const char* path, const std::vector<MathBenchmarkResult>& results)
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+		for (const MathBenchmarkResult& result : results)
+		{
+			file << result.key << ' ' << result.nanosecondsPerOp << '\n';
+		}
+		return static_cast<bool>(file);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	//1. 引数を読む
+	const char* recordPath = nullptr;
+	const char* comparePath = nullptr;
+	double thresholdPercent = 20.0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+		{
+			recordPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+		{
+			comparePath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+		{
+			thresholdPercent = std::atof(argv[++i]);
+		}
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--record file] [--compare file [--threshold percent]]\n", argv[0]);
+			return 2;
+		}
+	}
+	std::vector<MathBenchmarkResult> baseline;
+	if (comparePath && !LoadBaseline(comparePath, baseline))
+	{
+		std::fprintf(stderr, "cannot read baseline %s\n", comparePath);
+		return 2;
+	}
+
+	//2. 全ての処理を計測する
+	MathBenchmarkData data;
+	CreateData(data);
+	std::vector<MathKernel> kernels = CreateKernels(data);
+	std::vector<unsigned char> evictBuffer(kEvictBytes);
+	unsigned evictSum = 0;
+	std::vector<MathBenchmarkResult> results;
+	for (const MathKernel& kernel : kernels)
+	{
+		// 基準より遅かったときは、たまたま遅かっただけかもしれないので測り直して速い方を使う
+		MathBenchmarkResult kernelResults[2];
+		MeasureKernel(kernel, evictBuffer, evictSum, kernelResults);
+		for (int retry = 0; retry < kRetryCount && (IsRegressed(kernelResults[0], baseline, thresholdPercent) || IsRegressed(kernelResults[1], baseline, thresholdPercent)); ++retry)
+		{
+			MathBenchmarkResult retryResults[2];
+			MeasureKernel(kernel, evictBuffer, evictSum, retryResults);
+			for (int i = 0; i < 2; ++i)
+			{
+				kernelResults[i].nanosecondsPerOp = std::min(kernelResults[i].nanosecondsPerOp, retryResults[i].nanosecondsPerOp);
+			}
+		}
+		results.insert(results.end(), kernelResults, kernelResults + 2);
+	}
+
+	//3. 表示し、基準があれば比べる
+	int regressionCount = 0;
+	std::printf("%-36s %12s %14s %10s\n", "kernel", "ns/op", "Mops/s", "baseline");
+	for (const MathBenchmarkResult& result : results)
+	{
+		std::printf("%-36s %12.3f %14.2f", result.key.c_str(), result.nanosecondsPerOp, 1.0e3 / result.nanosecondsPerOp);
+		auto it = std::find_if(baseline.begin(), baseline.end(), [&](const MathBenchmarkResult& entry) { return entry.key == result.key; });
+		if (it != baseline.end())
+		{
+			double changePercent = (result.nanosecondsPerOp / it->nanosecondsPerOp - 1.0) * 100.0;
+			bool regressed = IsRegressed(result, baseline, thresholdPercent);
+			regressionCount += regressed ? 1 : 0;
+			std::printf(" %+9.1f%%%s", changePercent, regressed ? "  REGRESSION" : "");
+		}
+		std::printf("\n");
+	}
+	// 結果を使わないと計測した処理ごと消されることがあるので、出力の一部を表示しておく
+	std::printf("checksum %.3f %.3f %.3f (%u)\n", data.matrixResults[1].m[3][0], data.pointResults[1].x, data.resultX[1] + data.quaternionResults[1].w, evictSum & 1u);
+
+	if (recordPath && !SaveBaseline(recordPath, results))
+	{
+		std::fprintf(stderr, "cannot write baseline %s\n", recordPath);
+		return 2;
+	}
+	if (regressionCount != 0)
+	{
+		std::printf("%d kernel(s) slower than the baseline by more than %.1f%%\n", regressionCount, thresholdPercent);
+		return 1;
+	}
+	return 0;
+}
@@ -2,6 +2,7 @@
 /// <summary>
 /// 4x4行列
 /// </summary>
-struct Matrix4x4 final {
+/// 各行をSIMDレジスタにそのまま読み込めるように16byteに揃える
+struct alignas(16) Matrix4x4 final {
 	float m[4][4];
 };
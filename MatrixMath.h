@@ -1,11 +1,26 @@
 #pragma once
 
+#include "ConstexprMath.h"
 #include "Matrix4x4.h"
 #include "Vector3.h"
+#include <cassert>
 #include <cmath>
+#include <type_traits>
+
+// 使える命令セットに合わせて行列の積と逆行列をSIMDで計算する。どちらも無ければスカラー版を使う
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MATRIX_MATH_SSE
+#include <emmintrin.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+#elif defined(_M_ARM64) || defined(__ARM_NEON)
+#define MATRIX_MATH_NEON
+#include <arm_neon.h>
+#endif
 
 //行列の加法
-static Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2)
+static constexpr Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2)
 {
 	Matrix4x4 result{};
 	for (int i = 0; i < 4; i++)
@@ -19,7 +34,7 @@ static Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2)
 }
 
 //行列の減法
-static Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2)
+static constexpr Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2)
 {
 	Matrix4x4 result{};
 	for (int i = 0; i < 4; i++)
@@ -32,8 +47,8 @@ static Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2)
 	return result;
 }
 
-//行列の積
-static Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2)
+//行列の積(スカラー版)。SIMD版の結果を確かめる基準にも使う
+static constexpr Matrix4x4 MultiplyScalar(const Matrix4x4& m1, const Matrix4x4& m2)
 {
 	Matrix4x4 result{};
 	for (int i = 0; i < 4; i++)
@@ -49,8 +64,8 @@ static Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2)
 	return result;
 }
 
-//逆行列
-static Matrix4x4 Inverse(const Matrix4x4& matrix)
+//逆行列(スカラー版)。余因子展開で求める。SIMD版の結果を確かめる基準にも使う
+static constexpr Matrix4x4 InverseScalar(const Matrix4x4& matrix)
 {
 	Matrix4x4 result{};
 
@@ -83,8 +98,248 @@ static Matrix4x4 Inverse(const Matrix4x4& matrix)
 	return result;
 }
 
+#if defined(MATRIX_MATH_SSE)
+namespace MatrixSimd
+{
+	// 2x2行列を(m00, m01, m10, m11)の順に1つのレジスタに入れて扱う
+
+	// 2x2行列の積 a * b
+	inline __m128 Multiply2x2(__m128 a, __m128 b)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+			_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+	}
+
+	// 2x2行列の余因子行列との積 adj(a) * b
+	inline __m128 AdjugateMultiply2x2(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+			_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+	}
+
+	// 2x2行列と余因子行列の積 a * adj(b)
+	inline __m128 MultiplyAdjugate2x2(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+			_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+	}
+
+	// xyzの外積。wは0になる
+	inline __m128 Cross3(__m128 a, __m128 b)
+	{
+		__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+		return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+}
+#endif
+
+//行列の積。行ベクトルの規約なので、m1の後にm2を適用する変換になる
+static constexpr Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2)
+{
+	if (std::is_constant_evaluated())
+	{
+		return MultiplyScalar(m1, m2);
+	}
+#if defined(MATRIX_MATH_SSE) && defined(__AVX__)
+	// 結果の2行分を256bitで同時に求める。m1の要素を各行の半分に、m2の行を両方の半分に並べる
+	Matrix4x4 result;
+	__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[0]));
+	__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[1]));
+	__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[2]));
+	__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[3]));
+	for (int i = 0; i < 4; i += 2)
+	{
+		__m256 a = _mm256_loadu_ps(m1.m[i]);
+		__m256 row = _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+		_mm256_storeu_ps(result.m[i], row);
+	}
+	return result;
+#elif defined(MATRIX_MATH_SSE)
+	// 結果のi行目は、m1のi行目の各要素でm2の各行を重み付けした和
+	Matrix4x4 result;
+	__m128 b0 = _mm_load_ps(m2.m[0]);
+	__m128 b1 = _mm_load_ps(m2.m[1]);
+	__m128 b2 = _mm_load_ps(m2.m[2]);
+	__m128 b3 = _mm_load_ps(m2.m[3]);
+	for (int i = 0; i < 4; i++)
+	{
+		__m128 a = _mm_load_ps(m1.m[i]);
+		__m128 row = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+		_mm_store_ps(result.m[i], row);
+	}
+	return result;
+#elif defined(MATRIX_MATH_NEON)
+	Matrix4x4 result;
+	float32x4_t b0 = vld1q_f32(m2.m[0]);
+	float32x4_t b1 = vld1q_f32(m2.m[1]);
+	float32x4_t b2 = vld1q_f32(m2.m[2]);
+	float32x4_t b3 = vld1q_f32(m2.m[3]);
+	for (int i = 0; i < 4; i++)
+	{
+		float32x4_t a = vld1q_f32(m1.m[i]);
+		float32x4_t row = vmulq_laneq_f32(b0, a, 0);
+		row = vfmaq_laneq_f32(row, b1, a, 1);
+		row = vfmaq_laneq_f32(row, b2, a, 2);
+		row = vfmaq_laneq_f32(row, b3, a, 3);
+		vst1q_f32(result.m[i], row);
+	}
+	return result;
+#else
+	return MultiplyScalar(m1, m2);
+#endif
+}
+
+//逆行列。2x2のブロックに分けて求めるので、割り算は行列式の逆数の1回だけで済む
+static constexpr Matrix4x4 Inverse(const Matrix4x4& matrix)
+{
+	if (std::is_constant_evaluated())
+	{
+		return InverseScalar(matrix);
+	}
+#if defined(MATRIX_MATH_SSE)
+	using namespace MatrixSimd;
+	__m128 row0 = _mm_load_ps(matrix.m[0]);
+	__m128 row1 = _mm_load_ps(matrix.m[1]);
+	__m128 row2 = _mm_load_ps(matrix.m[2]);
+	__m128 row3 = _mm_load_ps(matrix.m[3]);
+
+	//1. 左上A、右上B、左下C、右下Dの2x2行列に分ける
+	__m128 a = _mm_movelh_ps(row0, row1);
+	__m128 b = _mm_movehl_ps(row1, row0);
+	__m128 c = _mm_movelh_ps(row2, row3);
+	__m128 d = _mm_movehl_ps(row3, row2);
+
+	//2. 各ブロックの行列式(|A|, |B|, |C|, |D|)
+	__m128 determinants = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2, 0, 2, 0))));
+	__m128 determinantA = _mm_shuffle_ps(determinants, determinants, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 determinantB = _mm_shuffle_ps(determinants, determinants, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 determinantC = _mm_shuffle_ps(determinants, determinants, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 determinantD = _mm_shuffle_ps(determinants, determinants, _MM_SHUFFLE(3, 3, 3, 3));
+
+	//3. 逆行列を|M|で割る前の各ブロックの余因子行列を求める
+	__m128 adjugateDC = AdjugateMultiply2x2(d, c);
+	__m128 adjugateAB = AdjugateMultiply2x2(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(determinantD, a), Multiply2x2(b, adjugateDC));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(determinantA, d), Multiply2x2(c, adjugateAB));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(determinantB, c), MultiplyAdjugate2x2(d, adjugateAB));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(determinantC, b), MultiplyAdjugate2x2(a, adjugateDC));
+
+	//4. |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+	__m128 trace = _mm_mul_ps(adjugateAB, _mm_shuffle_ps(adjugateDC, adjugateDC, _MM_SHUFFLE(3, 1, 2, 0)));
+	trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(2, 3, 0, 1)));
+	trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 determinant = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(determinantA, determinantD), _mm_mul_ps(determinantB, determinantC)), trace);
+
+	//5. 余因子行列にするための符号を付けて|M|で割り、並べ替えて書き込む
+	__m128 inverseDeterminant = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), determinant);
+	x = _mm_mul_ps(x, inverseDeterminant);
+	y = _mm_mul_ps(y, inverseDeterminant);
+	z = _mm_mul_ps(z, inverseDeterminant);
+	w = _mm_mul_ps(w, inverseDeterminant);
+	Matrix4x4 result;
+	_mm_store_ps(result.m[0], _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_store_ps(result.m[1], _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_store_ps(result.m[2], _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_store_ps(result.m[3], _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+	return result;
+#else
+	return InverseScalar(matrix);
+#endif
+}
+
+//アフィン変換の逆行列(スカラー版)
+static constexpr Matrix4x4 InverseAffineScalar(const Matrix4x4& matrix)
+{
+	const float(*m)[4] = matrix.m;
+	float column[3][3] = {
+		{ m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0] },
+		{ m[2][1] * m[0][2] - m[2][2] * m[0][1], m[2][2] * m[0][0] - m[2][0] * m[0][2], m[2][0] * m[0][1] - m[2][1] * m[0][0] },
+		{ m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0] },
+	};
+	float inverseDeterminant = 1.0f / (m[0][0] * column[0][0] + m[0][1] * column[0][1] + m[0][2] * column[0][2]);
+	Matrix4x4 result{};
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			result.m[i][j] = column[j][i] * inverseDeterminant;
+		}
+	}
+	for (int j = 0; j < 3; j++)
+	{
+		result.m[3][j] = -(m[3][0] * result.m[0][j] + m[3][1] * result.m[1][j] + m[3][2] * result.m[2][j]);
+	}
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+//アフィン変換の逆行列。4列目が(0,0,0,1)の行列に限る
+//左上3x3の逆行列は行の外積を行列式で割ったもの、平行移動はそれを掛けて符号を反転したものになる
+static constexpr Matrix4x4 InverseAffine(const Matrix4x4& matrix)
+{
+	assert(matrix.m[0][3] == 0.0f && matrix.m[1][3] == 0.0f && matrix.m[2][3] == 0.0f && matrix.m[3][3] == 1.0f);
+	if (std::is_constant_evaluated())
+	{
+		return InverseAffineScalar(matrix);
+	}
+#if defined(MATRIX_MATH_SSE)
+	using namespace MatrixSimd;
+	__m128 row0 = _mm_load_ps(matrix.m[0]);
+	__m128 row1 = _mm_load_ps(matrix.m[1]);
+	__m128 row2 = _mm_load_ps(matrix.m[2]);
+	__m128 translate = _mm_load_ps(matrix.m[3]);
+
+	//1. 外積の各列が逆行列の列になる
+	__m128 column0 = Cross3(row1, row2);
+	__m128 column1 = Cross3(row2, row0);
+	__m128 column2 = Cross3(row0, row1);
+	__m128 determinant = _mm_mul_ps(row0, column0);
+	determinant = _mm_add_ps(determinant, _mm_shuffle_ps(determinant, determinant, _MM_SHUFFLE(2, 3, 0, 1)));
+	determinant = _mm_add_ps(_mm_shuffle_ps(determinant, determinant, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(determinant, determinant, _MM_SHUFFLE(2, 2, 2, 2)));
+	__m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+	column0 = _mm_mul_ps(column0, inverseDeterminant);
+	column1 = _mm_mul_ps(column1, inverseDeterminant);
+	column2 = _mm_mul_ps(column2, inverseDeterminant);
+
+	//2. 列を行に並べ替える。4列目は0になる
+	__m128 zero = _mm_setzero_ps();
+	__m128 low01 = _mm_unpacklo_ps(column0, column1);
+	__m128 high01 = _mm_unpackhi_ps(column0, column1);
+	__m128 low2 = _mm_unpacklo_ps(column2, zero);
+	__m128 high2 = _mm_unpackhi_ps(column2, zero);
+	__m128 inverse0 = _mm_movelh_ps(low01, low2);
+	__m128 inverse1 = _mm_movehl_ps(low2, low01);
+	__m128 inverse2 = _mm_movelh_ps(high01, high2);
+
+	//3. 平行移動は-translate * 左上3x3の逆行列。4列目は1にする
+	__m128 inverseTranslate = _mm_mul_ps(_mm_shuffle_ps(translate, translate, _MM_SHUFFLE(0, 0, 0, 0)), inverse0);
+	inverseTranslate = _mm_add_ps(inverseTranslate, _mm_mul_ps(_mm_shuffle_ps(translate, translate, _MM_SHUFFLE(1, 1, 1, 1)), inverse1));
+	inverseTranslate = _mm_add_ps(inverseTranslate, _mm_mul_ps(_mm_shuffle_ps(translate, translate, _MM_SHUFFLE(2, 2, 2, 2)), inverse2));
+	inverseTranslate = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), inverseTranslate);
+
+	Matrix4x4 result;
+	_mm_store_ps(result.m[0], inverse0);
+	_mm_store_ps(result.m[1], inverse1);
+	_mm_store_ps(result.m[2], inverse2);
+	_mm_store_ps(result.m[3], inverseTranslate);
+	return result;
+#else
+	return InverseAffineScalar(matrix);
+#endif
+}
+
 //転置行列
-static Matrix4x4 Transpose(const Matrix4x4& m)
+static constexpr Matrix4x4 Transpose(const Matrix4x4& m)
 {
 	Matrix4x4 result{};
 	for (int i = 0; i < 4; i++)
@@ -98,7 +353,7 @@ static Matrix4x4 Transpose(const Matrix4x4& m)
 }
 
 //単位行列
-static Matrix4x4 MakeIdentity()
+static constexpr Matrix4x4 MakeIdentity()
 {
 	Matrix4x4 result{};
 	for (int i = 0; i < 4; i++)
@@ -119,7 +374,7 @@ static Matrix4x4 MakeIdentity()
 }
 
 //拡大縮小行列
-static Matrix4x4 MakeScaleMatrix(const Vector3& scale)
+static constexpr Matrix4x4 MakeScaleMatrix(const Vector3& scale)
 {
 	Matrix4x4 result{};
 	result.m[0][0] = scale.x;
@@ -130,46 +385,46 @@ static Matrix4x4 MakeScaleMatrix(const Vector3& scale)
 }
 
 //X軸の回転行列
-static Matrix4x4 MakeRotateXMatrix(float radian)
+static constexpr Matrix4x4 MakeRotateXMatrix(float radian)
 {
 	Matrix4x4 result{};
 	result.m[0][0] = 1.0f;
-	result.m[1][1] = std::cos(radian);
-	result.m[1][2] = std::sin(radian);
-	result.m[2][1] = -std::sin(radian);
-	result.m[2][2] = std::cos(radian);
+	result.m[1][1] = Cos(radian);
+	result.m[1][2] = Sin(radian);
+	result.m[2][1] = -Sin(radian);
+	result.m[2][2] = Cos(radian);
 	result.m[3][3] = 1.0f;
 	return result;
 }
 
 //Y軸の回転行列
-static Matrix4x4 MakeRotateYMatrix(float radian)
+static constexpr Matrix4x4 MakeRotateYMatrix(float radian)
 {
 	Matrix4x4 result{};
-	result.m[0][0] = std::cos(radian);
-	result.m[0][2] = -std::sin(radian);
+	result.m[0][0] = Cos(radian);
+	result.m[0][2] = -Sin(radian);
 	result.m[1][1] = 1.0f;
-	result.m[2][0] = std::sin(radian);
-	result.m[2][2] = std::cos(radian);
+	result.m[2][0] = Sin(radian);
+	result.m[2][2] = Cos(radian);
 	result.m[3][3] = 1.0f;
 	return result;
 }
 
 //Z軸の回転行列
-static Matrix4x4 MakeRotateZMatrix(float radian)
+static constexpr Matrix4x4 MakeRotateZMatrix(float radian)
 {
 	Matrix4x4 result{};
-	result.m[0][0] = std::cos(radian);
-	result.m[0][1] = std::sin(radian);
-	result.m[1][0] = -std::sin(radian);
-	result.m[1][1] = std::cos(radian);
+	result.m[0][0] = Cos(radian);
+	result.m[0][1] = Sin(radian);
+	result.m[1][0] = -Sin(radian);
+	result.m[1][1] = Cos(radian);
 	result.m[2][2] = 1.0f;
 	result.m[3][3] = 1.0f;
 	return result;
 }
 
 //平行移動行列
-static Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
+static constexpr Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
 {
 	Matrix4x4 result{};
 	for (int i = 0; i < 4; i++)
@@ -192,18 +447,49 @@ static Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
 	return result;
 }
 
-//三次元アフィン変換行列
-static Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& radian, const Vector3& translate)
+//三次元アフィン変換行列(各行列を掛け合わせて作る版)。直接求める版の結果を確かめる基準に使う
+static constexpr Matrix4x4 MakeAffineMatrixChained(const Vector3& scale, const Vector3& radian, const Vector3& translate)
 {
 	return  Multiply(MakeScaleMatrix(scale), Multiply(Multiply(MakeRotateXMatrix(radian.x), Multiply(MakeRotateYMatrix(radian.y), MakeRotateZMatrix(radian.z))), MakeTranslateMatrix(translate)));
 }
 
+//三次元アフィン変換行列。拡大縮小 * X回転 * Y回転 * Z回転 * 平行移動を展開した式で直接求める
+//sin/cosは各軸1回ずつで、4列目は(0,0,0,1)になる
+static constexpr Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& radian, const Vector3& translate)
+{
+	float sinX = Sin(radian.x);
+	float cosX = Cos(radian.x);
+	float sinY = Sin(radian.y);
+	float cosY = Cos(radian.y);
+	float sinZ = Sin(radian.z);
+	float cosZ = Cos(radian.z);
+
+	Matrix4x4 result;
+	result.m[0][0] = scale.x * (cosY * cosZ);
+	result.m[0][1] = scale.x * (cosY * sinZ);
+	result.m[0][2] = scale.x * -sinY;
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = scale.y * (sinX * sinY * cosZ - cosX * sinZ);
+	result.m[1][1] = scale.y * (sinX * sinY * sinZ + cosX * cosZ);
+	result.m[1][2] = scale.y * (sinX * cosY);
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = scale.z * (cosX * sinY * cosZ + sinX * sinZ);
+	result.m[2][1] = scale.z * (cosX * sinY * sinZ - sinX * cosZ);
+	result.m[2][2] = scale.z * (cosX * cosY);
+	result.m[2][3] = 0.0f;
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
 //透視投影行列
-static Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip)
+static constexpr Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip)
 {
 	Matrix4x4 result{};
-	result.m[0][0] = 1.0f / aspectRatio * 1.0f / tanf(fovY / 2.0f);
-	result.m[1][1] = 1.0f / tanf(fovY / 2.0f);
+	result.m[0][0] = 1.0f / aspectRatio * 1.0f / Tan(fovY / 2.0f);
+	result.m[1][1] = 1.0f / Tan(fovY / 2.0f);
 	result.m[2][2] = farClip / (farClip - nearClip);
 	result.m[2][3] = 1.0f;
 	result.m[3][2] = -farClip * nearClip / (farClip - nearClip);
@@ -211,7 +497,7 @@ static Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float n
 }
 
 //正射影行列
-static Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip)
+static constexpr Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip)
 {
 	Matrix4x4 result{};
 	result.m[0][0] = 2 / (right - left);
@@ -225,7 +511,7 @@ static Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, floa
 }
 
 //ビューポート変換行列
-static Matrix4x4 MakeViewportMatrix(float left, float top, float width, float height, float minDepth, float maxDepth)
+static constexpr Matrix4x4 MakeViewportMatrix(float left, float top, float width, float height, float minDepth, float maxDepth)
 {
 	Matrix4x4 result{};
 	result.m[0][0] = width / 2.0f;
@@ -237,3 +523,38 @@ static Matrix4x4 MakeViewportMatrix(float left, float top, float width, float he
 	result.m[3][3] = 1.0f;
 	return result;
 }
+
+//各要素の差がtolerance以下ならtrue
+static constexpr bool NearlyEqual(const Matrix4x4& m1, const Matrix4x4& m2, float tolerance)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			if (!NearlyEqual(m1.m[i][j], m2.m[i][j], tolerance))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// コンパイル時の確認
+namespace MatrixMathStaticTest
+{
+	constexpr Matrix4x4 kAffine = MakeAffineMatrix({ 1.5f, 0.5f, 2.0f }, { 0.3f, -1.2f, 2.5f }, { 4.0f, -5.0f, 6.0f });
+	constexpr Matrix4x4 kProjection = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f);
+	constexpr Matrix4x4 kOrthographic = MakeOrthographicMatrix(0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 100.0f);
+
+	static_assert(NearlyEqual(Multiply(MakeIdentity(), kAffine), kAffine, 0.0f));
+	static_assert(NearlyEqual(Transpose(Transpose(kProjection)), kProjection, 0.0f));
+	static_assert(NearlyEqual(Add(kAffine, Subtract(kProjection, kAffine)), kProjection, 1.0e-6f));
+	static_assert(NearlyEqual(kAffine, MakeAffineMatrixChained({ 1.5f, 0.5f, 2.0f }, { 0.3f, -1.2f, 2.5f }, { 4.0f, -5.0f, 6.0f }), 1.0e-6f));
+	static_assert(NearlyEqual(Multiply(kAffine, InverseAffine(kAffine)), MakeIdentity(), 1.0e-5f));
+	static_assert(NearlyEqual(Multiply(kAffine, Inverse(kAffine)), MakeIdentity(), 1.0e-5f));
+	static_assert(NearlyEqual(Multiply(kProjection, Inverse(kProjection)), MakeIdentity(), 1.0e-5f));
+	static_assert(InverseAffine(MakeTranslateMatrix({ 1.0f, 2.0f, 3.0f })).m[3][2] == -3.0f);
+	static_assert(kOrthographic.m[0][0] == 2.0f / 1280.0f && kOrthographic.m[1][1] == -2.0f / 720.0f && kOrthographic.m[3][0] == -1.0f && kOrthographic.m[3][1] == 1.0f);
+	static_assert(NearlyEqual(kProjection.m[1][1], 4.3691902f, 1.0e-5f));
+}
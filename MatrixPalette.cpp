@@ -0,0 +1,47 @@
+#include "MatrixPalette.h"
+#include "MatrixMath.h"
+#include "QuaternionMath.h"
+
+namespace
+{
+	// [begin, end)番目の行列を求める
+	void BuildMatrixPaletteRange(const Transform* transforms, size_t begin, size_t end, const Matrix4x4& viewProjection, TransfomationMatrix* palette)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			// アップロードヒープは書き込み結合メモリなので、手元で1件分を作ってからまとめて書き込む
+			TransfomationMatrix record;
+			record.World = MakeWorldMatrix(transforms[i]);
+			record.WVP = Multiply(record.World, viewProjection);
+			palette[i] = record;
+		}
+	}
+
+	// [begin, end)番目の求め済みのワールド行列からWVP行列を求める
+	void BuildMatrixPaletteRange(const Matrix4x4* worldMatrices, size_t begin, size_t end, const Matrix4x4& viewProjection, TransfomationMatrix* palette)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			TransfomationMatrix record;
+			record.World = worldMatrices[i];
+			record.WVP = Multiply(record.World, viewProjection);
+			palette[i] = record;
+		}
+	}
+}
+
+void BuildMatrixPalette(std::span<const Transform> transforms, const Matrix4x4& viewProjection, TransfomationMatrix* palette, JobSystem* jobSystem)
+{
+	ParallelForRange(jobSystem, transforms.size(), [&](size_t begin, size_t end)
+		{
+			BuildMatrixPaletteRange(transforms.data(), begin, end, viewProjection, palette);
+		});
+}
+
+void BuildMatrixPalette(std::span<const Matrix4x4> worldMatrices, const Matrix4x4& viewProjection, TransfomationMatrix* palette, JobSystem* jobSystem)
+{
+	ParallelForRange(jobSystem, worldMatrices.size(), [&](size_t begin, size_t end)
+		{
+			BuildMatrixPaletteRange(worldMatrices.data(), begin, end, viewProjection, palette);
+		});
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include "JobSystem.h"
+#include "Matrix4x4.h"
+#include "Transform.h"
+#include "TransformationMatrix.h"
+
+// transformsのワールド行列とWVP行列を求め、paletteの同じ番号に書き込む
+// viewProjectionはビュー行列と射影行列を呼び出し側で1回だけ掛けておいたもの
+// paletteにはMapしたアップロードヒープ(StructuredBuffer)をそのまま渡せる。1件ずつ前から書き、読み戻さない
+// jobSystemがあれば区間に分けて並列に求める
+void BuildMatrixPalette(std::span<const Transform> transforms, const Matrix4x4& viewProjection, TransfomationMatrix* palette, JobSystem* jobSystem);
+
+// 求め済みのワールド行列(シーングラフのworldMatricesなど)からWVP行列を求め、paletteの同じ番号に書き込む
+void BuildMatrixPalette(std::span<const Matrix4x4> worldMatrices, const Matrix4x4& viewProjection, TransfomationMatrix* palette, JobSystem* jobSystem);
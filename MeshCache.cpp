@@ -0,0 +1,334 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "ModelLoader.h"
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	// 'MESH'
+	const uint32_t kMeshCacheMagic = 0x4853454D;
+
+	// 64bitの値を混ぜる
+	uint64_t Mix(uint64_t value)
+	{
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDull;
+		value ^= value >> 33;
+		value *= 0xC4CEB9FE1A85EC53ull;
+		value ^= value >> 33;
+		return value;
+	}
+
+	// 8の倍数に切り上げる
+	uint64_t AlignUp(uint64_t value)
+	{
+		return (value + 7) & ~uint64_t(7);
+	}
+
+	// 指定した位置まで0で埋める
+	void PadTo(std::ofstream& file, uint64_t offset)
+	{
+		static const char kZero[8]{};
+		uint64_t current = static_cast<uint64_t>(file.tellp());
+		assert(current <= offset && offset - current < sizeof(kZero));
+		file.write(kZero, static_cast<std::streamsize>(offset - current));
+	}
+
+	// offsetからelementSizeのものをcount個並べた領域がsize以内に収まるか
+	// 壊れたヘッダで足し算や掛け算が桁あふれして通ってしまわないように、残りの大きさと比べる
+	bool FitsIn(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t size)
+	{
+		return offset <= size && count <= (size - offset) / elementSize;
+	}
+
+	// 文字列領域から文字列を取り出す。範囲外ならfalse
+	bool ReadString(const char* data, const MeshCacheHeader& header, uint32_t offset, uint32_t length, std::string& text)
+	{
+		// 文字列領域は[stringOffset, vertexOffset)。ヘッダの確認でvertexOffset <= fileSizeは済んでいる
+		if (header.stringOffset > header.vertexOffset || !FitsIn(offset, length, 1, header.vertexOffset - header.stringOffset))
+		{
+			return false;
+		}
+		text.assign(data + header.stringOffset + offset, length);
+		return true;
+	}
+
+	// Objがmtllibで参照するmtlの内容とサイズを1つのハッシュにまとめる。参照が無ければ0
+	// マテリアル名とテクスチャのパスはmtlから作られるので、mtlを書き換えたときもキャッシュを作り直すためにキーに含める
+	uint64_t HashMaterialLibraries(const std::string& directoryPath, const char* data, size_t size)
+	{
+		uint64_t hash = 0;
+		const char* end = data + size;
+		for (const char* line = data; line < end;)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+			lineEnd = lineEnd ? lineEnd : end;
+			const char* p = line;
+			while (p < lineEnd && (*p == ' ' || *p == '\t'))
+			{
+				++p;
+			}
+			if (lineEnd - p > 6 && std::memcmp(p, "mtllib", 6) == 0 && (p[6] == ' ' || p[6] == '\t'))
+			{
+				//1. ModelLoaderと同じく、空白の後の1語をファイル名にする
+				p += 6;
+				while (p < lineEnd && (*p == ' ' || *p == '\t'))
+				{
+					++p;
+				}
+				const char* nameEnd = p;
+				while (nameEnd < lineEnd && *nameEnd != ' ' && *nameEnd != '\t' && *nameEnd != '\r')
+				{
+					++nameEnd;
+				}
+
+				//2. 内容とサイズを混ぜる。開けなければ無いことを表す値にする
+				MappedFile library(directoryPath + "/" + std::string(p, nameEnd));
+				uint64_t libraryHash = library.IsOpen() ? HashBytes(library.GetData(), library.GetSize()) : 0;
+				uint64_t librarySize = library.IsOpen() ? library.GetSize() : UINT64_MAX;
+				hash = Mix(hash ^ libraryHash ^ Mix(librarySize));
+			}
+			line = lineEnd + 1;
+		}
+		return hash;
+	}
+
+	// 文字列領域に文字列を追加し、位置を返す
+	uint32_t AppendString(std::string& strings, const std::string& text)
+	{
+		uint32_t offset = static_cast<uint32_t>(strings.size());
+		strings += text;
+		return offset;
+	}
+}
+
+uint64_t HashBytes(const void* data, size_t size)
+{
+	// 8byteずつ4系統で混ぜてから1つにまとめる
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t lanes[4] = { 0x9E3779B97F4A7C15ull, 0xBF58476D1CE4E5B9ull, 0x94D049BB133111EBull, 0x2545F4914F6CDD1Dull };
+	size_t blockCount = size / 32;
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		for (size_t lane = 0; lane < 4; ++lane)
+		{
+			uint64_t value;
+			std::memcpy(&value, bytes + block * 32 + lane * 8, sizeof(value));
+			lanes[lane] = (lanes[lane] ^ value) * 0x9FB21C651E98DF25ull;
+			lanes[lane] = (lanes[lane] << 31) | (lanes[lane] >> 33);
+		}
+	}
+	uint64_t hash = Mix(lanes[0]) ^ Mix(lanes[1] + 1) ^ Mix(lanes[2] + 2) ^ Mix(lanes[3] + 3);
+	// 残りは1byteずつ
+	for (size_t i = blockCount * 32; i < size; ++i)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+	}
+	return Mix(hash ^ size);
+}
+
+std::string GetMeshCachePath(const std::string& directoryPath, const std::string& filename)
+{
+	return directoryPath + "/" + filename + ".meshcache";
+}
+
+bool ReadMeshCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, ModelData& modelData)
+{
+	//1. キャッシュをマップしてヘッダを確認する
+	MappedFile file(cachePath);
+	if (!file.IsOpen() || file.GetSize() < sizeof(MeshCacheHeader))
+	{
+		return false;
+	}
+	const char* data = file.GetData();
+	MeshCacheHeader header{};
+	std::memcpy(&header, data, sizeof(header));
+	if (header.magic != kMeshCacheMagic || header.formatVersion != kMeshCacheFormatVersion || header.loaderVersion != kObjLoaderVersion
+		|| header.sourceHash != sourceHash || header.sourceSize != sourceSize
+		|| header.vertexStride != sizeof(VertexData) || header.fileSize != file.GetSize())
+	{
+		return false;
+	}
+	// 各領域がファイルに収まっているか
+	if (!FitsIn(header.submeshOffset, header.submeshCount, sizeof(MeshCacheSubmesh), header.fileSize)
+		|| !FitsIn(header.materialOffset, header.materialCount, sizeof(MeshCacheMaterial), header.fileSize)
+		|| !FitsIn(header.vertexOffset, header.vertexCount, sizeof(VertexData), header.fileSize)
+		|| !FitsIn(header.indexOffset, header.indexCount, sizeof(uint32_t), header.fileSize)
+		|| (header.tangentOffset != 0 && !FitsIn(header.tangentOffset, header.vertexCount, sizeof(Vector4), header.fileSize)))
+	{
+		return false;
+	}
+
+	//2. サブメッシュとマテリアルの参照を読む
+	modelData = ModelData{};
+	modelData.submeshes.resize(header.submeshCount);
+	for (uint32_t i = 0; i < header.submeshCount; ++i)
+	{
+		MeshCacheSubmesh submesh{};
+		std::memcpy(&submesh, data + header.submeshOffset + sizeof(MeshCacheSubmesh) * i, sizeof(submesh));
+		if (uint64_t(submesh.indexStart) + submesh.indexCount > header.indexCount || submesh.materialIndex >= header.materialCount
+			|| !ReadString(data, header, submesh.nameOffset, submesh.nameLength, modelData.submeshes[i].name))
+		{
+			return false;
+		}
+		modelData.submeshes[i].indexStart = submesh.indexStart;
+		modelData.submeshes[i].indexCount = submesh.indexCount;
+		modelData.submeshes[i].materialIndex = submesh.materialIndex;
+		modelData.submeshes[i].bounds = submesh.bounds;
+	}
+	modelData.materials.resize(header.materialCount);
+	for (uint32_t i = 0; i < header.materialCount; ++i)
+	{
+		MeshCacheMaterial material{};
+		std::memcpy(&material, data + header.materialOffset + sizeof(MeshCacheMaterial) * i, sizeof(material));
+		if (!ReadString(data, header, material.nameOffset, material.nameLength, modelData.materials[i].name)
+			|| !ReadString(data, header, material.textureFilePathOffset, material.textureFilePathLength, modelData.materials[i].textureFilePath))
+		{
+			return false;
+		}
+	}
+	BuildMaterialBatches(modelData);
+	modelData.bounds = { header.boundsMin, header.boundsMax, header.sphereCenter, header.sphereRadius };
+
+	//3. 頂点とIndexは字句解析せずにそのままコピーする
+	modelData.vertices.resize(header.vertexCount);
+	std::memcpy(modelData.vertices.data(), data + header.vertexOffset, sizeof(VertexData) * header.vertexCount);
+	modelData.indices.resize(header.indexCount);
+	std::memcpy(modelData.indices.data(), data + header.indexOffset, sizeof(uint32_t) * header.indexCount);
+	// 範囲外の頂点を指すIndexはGPUに渡せないので、キャッシュを捨ててObjから読み直させる
+	for (uint32_t index : modelData.indices)
+	{
+		if (index >= header.vertexCount)
+		{
+			modelData = ModelData{};
+			return false;
+		}
+	}
+	if (header.tangentOffset != 0)
+	{
+		modelData.tangents.resize(header.vertexCount);
+		std::memcpy(modelData.tangents.data(), data + header.tangentOffset, sizeof(Vector4) * header.vertexCount);
+	}
+	return true;
+}
+
+void WriteMeshCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, const ModelData& modelData)
+{
+	//1. 各領域の位置を決める
+	MeshCacheHeader header{};
+	header.magic = kMeshCacheMagic;
+	header.formatVersion = kMeshCacheFormatVersion;
+	header.loaderVersion = kObjLoaderVersion;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.boundsMin = modelData.bounds.boundsMin;
+	header.boundsMax = modelData.bounds.boundsMax;
+	header.sphereCenter = modelData.bounds.sphereCenter;
+	header.sphereRadius = modelData.bounds.sphereRadius;
+	header.vertexStride = sizeof(VertexData);
+	header.vertexCount = modelData.vertices.size();
+	header.indexCount = modelData.indices.size();
+	header.submeshCount = static_cast<uint32_t>(modelData.submeshes.size());
+	header.materialCount = static_cast<uint32_t>(modelData.materials.size());
+
+	// 名前とパスは文字列領域にまとめる
+	std::string strings;
+	std::vector<MeshCacheSubmesh> submeshes;
+	submeshes.reserve(modelData.submeshes.size());
+	for (const SubmeshData& submesh : modelData.submeshes)
+	{
+		uint32_t nameOffset = AppendString(strings, submesh.name);
+		submeshes.push_back({ submesh.indexStart, submesh.indexCount, submesh.materialIndex, nameOffset, static_cast<uint32_t>(submesh.name.size()), 0, submesh.bounds });
+	}
+	std::vector<MeshCacheMaterial> materials;
+	materials.reserve(modelData.materials.size());
+	for (const MaterialData& material : modelData.materials)
+	{
+		uint32_t nameOffset = AppendString(strings, material.name);
+		uint32_t pathOffset = AppendString(strings, material.textureFilePath);
+		materials.push_back({ nameOffset, static_cast<uint32_t>(material.name.size()), pathOffset, static_cast<uint32_t>(material.textureFilePath.size()) });
+	}
+
+	header.submeshOffset = AlignUp(sizeof(MeshCacheHeader));
+	header.materialOffset = AlignUp(header.submeshOffset + sizeof(MeshCacheSubmesh) * header.submeshCount);
+	header.stringOffset = AlignUp(header.materialOffset + sizeof(MeshCacheMaterial) * header.materialCount);
+	header.vertexOffset = AlignUp(header.stringOffset + strings.size());
+	header.indexOffset = AlignUp(header.vertexOffset + sizeof(VertexData) * header.vertexCount);
+	header.fileSize = header.indexOffset + sizeof(uint32_t) * header.indexCount;
+	// 接線は頂点と同じ数だけあるときだけ書く
+	bool hasTangents = !modelData.tangents.empty() && modelData.tangents.size() == modelData.vertices.size();
+	if (hasTangents)
+	{
+		header.tangentOffset = AlignUp(header.fileSize);
+		header.fileSize = header.tangentOffset + sizeof(Vector4) * header.vertexCount;
+	}
+
+	//2. 一時ファイルに書いてから置き換え、書きかけのキャッシュを読まないようにする
+	std::string temporaryPath = cachePath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		PadTo(file, header.submeshOffset);
+		file.write(reinterpret_cast<const char*>(submeshes.data()), static_cast<std::streamsize>(sizeof(MeshCacheSubmesh) * submeshes.size()));
+		PadTo(file, header.materialOffset);
+		file.write(reinterpret_cast<const char*>(materials.data()), static_cast<std::streamsize>(sizeof(MeshCacheMaterial) * materials.size()));
+		PadTo(file, header.stringOffset);
+		file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+		PadTo(file, header.vertexOffset);
+		file.write(reinterpret_cast<const char*>(modelData.vertices.data()), static_cast<std::streamsize>(sizeof(VertexData) * header.vertexCount));
+		PadTo(file, header.indexOffset);
+		file.write(reinterpret_cast<const char*>(modelData.indices.data()), static_cast<std::streamsize>(sizeof(uint32_t) * header.indexCount));
+		if (hasTangents)
+		{
+			PadTo(file, header.tangentOffset);
+			file.write(reinterpret_cast<const char*>(modelData.tangents.data()), static_cast<std::streamsize>(sizeof(Vector4) * header.vertexCount));
+		}
+		if (!file.good())
+		{
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, cachePath, error);
+}
+
+ModelData LoadModel(const std::string& directoryPath, const std::string& filename)
+{
+	//1. 元のObjと、それが参照するmtlの内容からキーを作る
+	uint64_t sourceHash = 0;
+	uint64_t sourceSize = 0;
+	{
+		MappedFile source(directoryPath + "/" + filename);
+		assert(source.IsOpen());			// 開けなかったら止める
+		sourceHash = HashBytes(source.GetData(), source.GetSize());
+		sourceSize = source.GetSize();
+		uint64_t materialHash = HashMaterialLibraries(directoryPath, source.GetData(), source.GetSize());
+		if (materialHash != 0)
+		{
+			sourceHash = Mix(sourceHash ^ materialHash);
+		}
+	}
+
+	//2. キャッシュが使えればそれを返す
+	ModelData modelData;
+	std::string cachePath = GetMeshCachePath(directoryPath, filename);
+	if (ReadMeshCache(cachePath, sourceHash, sourceSize, modelData))
+	{
+		return modelData;
+	}
+
+	//3. 使えなければObjを読み、頂点キャッシュ向けに並べ替えてからキャッシュを書き出す
+	modelData = LoadObjFile(directoryPath, filename, ObjParseMode::Parallel);
+	OptimizeMesh(modelData);
+	WriteMeshCache(cachePath, sourceHash, sourceSize, modelData);
+	return modelData;
+}
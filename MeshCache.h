@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "ModelData.h"
+#include "Vector3.h"
+
+// キャッシュファイルのフォーマットのバージョン。レイアウトを変えたら上げる
+const uint32_t kMeshCacheFormatVersion = 4;
+// Objローダーのバージョン。同じObjから作られるModelDataが変わる修正をしたら上げる
+const uint32_t kObjLoaderVersion = 4;
+
+///==========================================================
+/// メッシュキャッシュのヘッダ。ファイルの先頭に置く
+///==========================================================
+struct MeshCacheHeader
+{
+	uint32_t magic;				//!< 'MESH'
+	uint32_t formatVersion;		//!< kMeshCacheFormatVersion
+	uint32_t loaderVersion;		//!< kObjLoaderVersion
+	uint32_t submeshCount;		//!< サブメッシュの数
+	uint64_t sourceHash;		//!< 元のObjと、それが参照するmtlの内容のハッシュ
+	uint64_t sourceSize;		//!< 元のObjのサイズ(byte)
+	Vector3 boundsMin;			//!< AABBの最小
+	uint32_t materialCount;		//!< マテリアルの数
+	Vector3 boundsMax;			//!< AABBの最大
+	uint32_t vertexStride;		//!< sizeof(VertexData)
+	Vector3 sphereCenter;		//!< 境界球の中心
+	float sphereRadius;			//!< 境界球の半径
+	uint64_t vertexCount;		//!< 頂点数
+	uint64_t indexCount;		//!< Index数
+	uint64_t submeshOffset;		//!< サブメッシュ表の位置(byte)
+	uint64_t materialOffset;	//!< マテリアル表の位置(byte)
+	uint64_t stringOffset;		//!< 文字列領域の位置(byte)
+	uint64_t vertexOffset;		//!< 頂点の位置(byte)
+	uint64_t indexOffset;		//!< Indexの位置(byte)
+	uint64_t tangentOffset;		//!< 接線の位置(byte)。頂点と同じ数だけ並ぶ。無ければ0
+	uint64_t fileSize;			//!< ファイル全体のサイズ(byte)
+};
+
+///==========================================================
+/// サブメッシュ表の要素。名前は文字列領域を指す
+///==========================================================
+struct MeshCacheSubmesh
+{
+	uint32_t indexStart;		//!< 最初のIndexの位置
+	uint32_t indexCount;		//!< Index数
+	uint32_t materialIndex;		//!< マテリアル表の番号
+	uint32_t nameOffset;		//!< 文字列領域の先頭からの位置
+	uint32_t nameLength;		//!< 文字数
+	uint32_t reserved;
+	BoundingVolume bounds;		//!< サブメッシュの境界
+};
+
+///==========================================================
+/// マテリアル表の要素。名前とテクスチャのパスは文字列領域を指す
+///==========================================================
+struct MeshCacheMaterial
+{
+	uint32_t nameOffset;			//!< 文字列領域の先頭からの位置
+	uint32_t nameLength;			//!< 文字数
+	uint32_t textureFilePathOffset;	//!< 文字列領域の先頭からの位置
+	uint32_t textureFilePathLength;	//!< 文字数
+};
+
+// バイト列のハッシュを求める。キャッシュのキーに使う
+uint64_t HashBytes(const void* data, size_t size);
+
+// Objファイルに対応するキャッシュファイルのパス
+std::string GetMeshCachePath(const std::string& directoryPath, const std::string& filename);
+
+// キャッシュを読み込む。無い、壊れている、元のObjやローダーと合わない場合はfalseを返す
+bool ReadMeshCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, ModelData& modelData);
+
+// キャッシュを書き出す
+void WriteMeshCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, const ModelData& modelData);
+
+// モデルを読み込む。有効なキャッシュがあればそれを使い、なければObjを読み込んで最適化し、キャッシュを書き出す
+ModelData LoadModel(const std::string& directoryPath, const std::string& filename);
@@ -0,0 +1,282 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	// 並べ替えで想定するキャッシュ(LRU)のサイズ
+	const uint32_t kOptimizeCacheSize = 32;
+	// キャッシュ内の位置によるスコアの減衰
+	const float kCacheDecayPower = 1.5f;
+	// 直前の三角形の頂点のスコア。続けて使うと三角形の並びが細長くなるので少し下げる
+	const float kLastTriangleScore = 0.75f;
+	// 残りの三角形が少ない頂点を優先して使い切る
+	const float kValenceBoostScale = 2.0f;
+	const float kValenceBoostPower = 0.5f;
+
+	// スコアの表を引く範囲。これより多くの三角形から使われる頂点は同じ値にする
+	const uint32_t kMaxValenceTableSize = 64;
+
+	///==========================================================
+	/// 頂点のスコアの表。powを毎回呼ばないように先に計算しておく
+	///==========================================================
+	struct VertexScoreTable
+	{
+		float cache[kOptimizeCacheSize];		// キャッシュ内の位置によるスコア
+		float valence[kMaxValenceTableSize];	// 残りの三角形数によるスコア
+	};
+
+	const VertexScoreTable& GetVertexScoreTable()
+	{
+		static const VertexScoreTable table = []()
+			{
+				VertexScoreTable result{};
+				for (uint32_t position = 0; position < kOptimizeCacheSize; ++position)
+				{
+					if (position < 3)
+					{
+						result.cache[position] = kLastTriangleScore;
+					}
+					else
+					{
+						float scale = 1.0f / float(kOptimizeCacheSize - 3);
+						result.cache[position] = std::pow(1.0f - float(position - 3) * scale, kCacheDecayPower);
+					}
+				}
+				for (uint32_t valence = 1; valence < kMaxValenceTableSize; ++valence)
+				{
+					result.valence[valence] = kValenceBoostScale * std::pow(float(valence), -kValenceBoostPower);
+				}
+				return result;
+			}();
+		return table;
+	}
+
+	// 頂点のスコアを求める
+	float ComputeVertexScore(const VertexScoreTable& table, int32_t cachePosition, uint32_t remainingTriangles)
+	{
+		// もう使われない頂点
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+		float score = cachePosition >= 0 ? table.cache[cachePosition] : 0.0f;
+		score += table.valence[remainingTriangles < kMaxValenceTableSize ? remainingTriangles : kMaxValenceTableSize - 1];
+		return score;
+	}
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStatistics statistics{};
+	if (indices.empty() || vertexCount == 0)
+	{
+		return statistics;
+	}
+
+	// 各頂点がキャッシュに入った時刻。今の時刻との差がcacheSize以上なら追い出されている
+	std::vector<uint64_t> timestamps(vertexCount, 0);
+	uint64_t time = uint64_t(cacheSize) + 1;
+	size_t missCount = 0;
+	for (uint32_t index : indices)
+	{
+		assert(index < vertexCount);
+		if (time - timestamps[index] > cacheSize)
+		{
+			timestamps[index] = time++;
+			++missCount;
+		}
+	}
+
+	statistics.acmr = double(missCount) / double(indices.size() / 3);
+	statistics.atvr = double(missCount) / double(vertexCount);
+	return statistics;
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	//1. 頂点ごとに、それを使う三角形の一覧を作る
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		assert(indices[i] < vertexCount);
+		++remainingTriangles[indices[i]];
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingTriangles[vertex];
+	}
+	std::vector<uint32_t> adjacency(indexCount);
+	{
+		std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	//2. 初期のスコアを求める
+	const VertexScoreTable& scoreTable = GetVertexScoreTable();
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		vertexScores[vertex] = ComputeVertexScore(scoreTable, -1, remainingTriangles[vertex]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	int64_t bestTriangle = -1;
+	float bestScore = -1.0f;
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		const uint32_t* corner = indices + triangle * 3;
+		triangleScores[triangle] = vertexScores[corner[0]] + vertexScores[corner[1]] + vertexScores[corner[2]];
+		if (triangleScores[triangle] > bestScore)
+		{
+			bestScore = triangleScores[triangle];
+			bestTriangle = static_cast<int64_t>(triangle);
+		}
+	}
+
+	//3. スコアが最も高い三角形を出力し、キャッシュと周りのスコアを更新していく
+	std::vector<uint32_t> output;
+	output.reserve(indexCount);
+	uint32_t cache[kOptimizeCacheSize + 3];
+	uint32_t cacheCount = 0;
+	size_t scanPosition = 0;	// キャッシュ内に候補が無いときに未出力の三角形を探す位置
+	while (bestTriangle >= 0)
+	{
+		size_t triangle = static_cast<size_t>(bestTriangle);
+		const uint32_t* corner = indices + triangle * 3;
+		emitted[triangle] = 1;
+		output.insert(output.end(), corner, corner + 3);
+
+		// 使い終わった三角形を頂点の一覧から外す。一覧の有効な範囲は先頭からremainingTriangles個
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			uint32_t vertex = corner[i];
+			uint32_t* list = adjacency.data() + adjacencyOffsets[vertex];
+			uint32_t count = remainingTriangles[vertex];
+			for (uint32_t j = 0; j < count; ++j)
+			{
+				if (list[j] == triangle)
+				{
+					list[j] = list[count - 1];
+					break;
+				}
+			}
+			--remainingTriangles[vertex];
+		}
+
+		// 出力した三角形の頂点を先頭にしてキャッシュを作り直す
+		uint32_t newCache[kOptimizeCacheSize + 3];
+		uint32_t newCacheCount = 0;
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			newCache[newCacheCount++] = corner[i];
+		}
+		for (uint32_t i = 0; i < cacheCount; ++i)
+		{
+			uint32_t vertex = cache[i];
+			if (vertex != corner[0] && vertex != corner[1] && vertex != corner[2])
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+
+		// キャッシュに触れた頂点(追い出されたものを含む)のスコアと、その三角形のスコアを更新する
+		for (uint32_t i = 0; i < newCacheCount; ++i)
+		{
+			uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < kOptimizeCacheSize ? static_cast<int32_t>(i) : -1;
+			vertexScores[vertex] = ComputeVertexScore(scoreTable, cachePositions[vertex], remainingTriangles[vertex]);
+		}
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for (uint32_t i = 0; i < newCacheCount; ++i)
+		{
+			uint32_t vertex = newCache[i];
+			const uint32_t* list = adjacency.data() + adjacencyOffsets[vertex];
+			for (uint32_t j = 0; j < remainingTriangles[vertex]; ++j)
+			{
+				uint32_t neighbor = list[j];
+				const uint32_t* neighborCorner = indices + size_t(neighbor) * 3;
+				float score = vertexScores[neighborCorner[0]] + vertexScores[neighborCorner[1]] + vertexScores[neighborCorner[2]];
+				triangleScores[neighbor] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = neighbor;
+				}
+			}
+		}
+		cacheCount = newCacheCount < kOptimizeCacheSize ? newCacheCount : kOptimizeCacheSize;
+		std::copy(newCache, newCache + cacheCount, cache);
+
+		// キャッシュ内の頂点で続けられなければ、未出力の三角形から選び直す
+		if (bestTriangle < 0)
+		{
+			while (scanPosition < triangleCount && emitted[scanPosition])
+			{
+				++scanPosition;
+			}
+			if (scanPosition < triangleCount)
+			{
+				bestTriangle = static_cast<int64_t>(scanPosition);
+			}
+		}
+	}
+
+	assert(output.size() == triangleCount * 3);
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeVertexFetch(ModelData& modelData)
+{
+	// 最初に参照された順に新しい番号を振る。どこからも参照されない頂点は捨てる
+	std::vector<uint32_t> remap(modelData.vertices.size(), UINT32_MAX);
+	std::vector<VertexData> vertices;
+	std::vector<Vector4> tangents;
+	vertices.reserve(modelData.vertices.size());
+	tangents.reserve(modelData.tangents.size());
+	for (uint32_t& index : modelData.indices)
+	{
+		if (remap[index] == UINT32_MAX)
+		{
+			remap[index] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(modelData.vertices[index]);
+			// 接線は頂点と同じ順に並べる
+			if (!modelData.tangents.empty())
+			{
+				tangents.push_back(modelData.tangents[index]);
+			}
+		}
+		index = remap[index];
+	}
+	modelData.vertices = std::move(vertices);
+	modelData.tangents = std::move(tangents);
+}
+
+MeshOptimizeReport OptimizeMesh(ModelData& modelData)
+{
+	MeshOptimizeReport report{};
+	report.before = AnalyzeVertexCache(modelData.indices, modelData.vertices.size());
+
+	// サブメッシュをまたいで三角形を動かすとマテリアルが変わるので、範囲ごとに並べ替える
+	for (const SubmeshData& submesh : modelData.submeshes)
+	{
+		OptimizeVertexCache(modelData.indices.data() + submesh.indexStart, submesh.indexCount, modelData.vertices.size());
+	}
+	OptimizeVertexFetch(modelData);
+
+	report.after = AnalyzeVertexCache(modelData.indices, modelData.vertices.size());
+	return report;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+// 統計を取るときに想定する頂点キャッシュ(FIFO)のサイズ
+const uint32_t kVertexCacheSimulationSize = 16;
+
+///==========================================================
+/// 頂点キャッシュの効率
+///==========================================================
+struct VertexCacheStatistics
+{
+	double acmr;	//!< 三角形あたりのキャッシュミス数(ACMR)。0.5～3.0で小さいほど良い
+	double atvr;	//!< 頂点あたりのキャッシュミス数(ATVR)。1.0が理想
+};
+
+///==========================================================
+/// 最適化前後の頂点キャッシュの効率
+///==========================================================
+struct MeshOptimizeReport
+{
+	VertexCacheStatistics before;	//!< 最適化前
+	VertexCacheStatistics after;	//!< 最適化後
+};
+
+// FIFOの頂点キャッシュをシミュレーションして効率を求める
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = kVertexCacheSimulationSize);
+
+// 頂点キャッシュに乗りやすいように[indices, indices + indexCount)の三角形を並べ替える(Forsythの方式)
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Indexから参照される順に頂点を並べ替え、頂点の読み込みをメモリ上で連続させる
+void OptimizeVertexFetch(ModelData& modelData);
+
+// サブメッシュごとに三角形を並べ替えてから頂点を並べ替える。サブメッシュの範囲は変わらない
+MeshOptimizeReport OptimizeMesh(ModelData& modelData);
@@ -0,0 +1,392 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+	// 1回のパスで縮約を試す候補の割合。安い方から順に試し、残りは次のパスで評価し直す
+	const size_t kPassCandidateDivisor = 3;
+
+	///==========================================================
+	/// 二次誤差。平面までの距離の2乗の和を表す対称行列(4x4)の上三角
+	///==========================================================
+	struct Quadric
+	{
+		double a00, a01, a02, a03;
+		double a11, a12, a13;
+		double a22, a23;
+		double a33;
+	};
+
+	void AddQuadric(Quadric& result, const Quadric& other)
+	{
+		result.a00 += other.a00; result.a01 += other.a01; result.a02 += other.a02; result.a03 += other.a03;
+		result.a11 += other.a11; result.a12 += other.a12; result.a13 += other.a13;
+		result.a22 += other.a22; result.a23 += other.a23;
+		result.a33 += other.a33;
+	}
+
+	// 平面ax+by+cz+d=0の二次誤差を作る
+	Quadric MakePlaneQuadric(double a, double b, double c, double d)
+	{
+		return { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+	}
+
+	// 位置pでの誤差
+	double EvaluateQuadric(const Quadric& q, const Vector4& p)
+	{
+		double x = p.x, y = p.y, z = p.z;
+		double result = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z + q.a33
+			+ 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z + q.a03 * x + q.a13 * y + q.a23 * z);
+		// 丸めで負にならないようにする
+		return result > 0.0 ? result : 0.0;
+	}
+
+	// 三角形の(正規化していない)法線
+	Vector3 TriangleNormal(const Vector4& p0, const Vector4& p1, const Vector4& p2)
+	{
+		Vector3 e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+		Vector3 e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+		return { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+	}
+
+	// 辺の縮約の候補。uをvに縮約する
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	// 位置が同じで属性が違う頂点(UVの継ぎ目など)に印を付ける
+	void MarkSeamVertices(const std::vector<VertexData>& vertices, std::vector<uint8_t>& locked)
+	{
+		struct PositionKey
+		{
+			uint32_t x, y, z;
+			bool operator==(const PositionKey& other) const = default;
+		};
+		struct PositionKeyHash
+		{
+			size_t operator()(const PositionKey& key) const
+			{
+				uint64_t hash = key.x * 0x9E3779B97F4A7C15ull;
+				hash = (hash ^ (hash >> 29) ^ key.y) * 0xBF58476D1CE4E5B9ull;
+				hash = (hash ^ (hash >> 31) ^ key.z) * 0x94D049BB133111EBull;
+				return static_cast<size_t>(hash ^ (hash >> 32));
+			}
+		};
+		std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstVertex;
+		firstVertex.reserve(vertices.size());
+		for (uint32_t i = 0; i < vertices.size(); ++i)
+		{
+			PositionKey key{};
+			std::memcpy(&key.x, &vertices[i].position.x, sizeof(float));
+			std::memcpy(&key.y, &vertices[i].position.y, sizeof(float));
+			std::memcpy(&key.z, &vertices[i].position.z, sizeof(float));
+			auto [it, inserted] = firstVertex.try_emplace(key, i);
+			if (!inserted)
+			{
+				locked[it->second] = 1;
+				locked[i] = 1;
+			}
+		}
+	}
+
+	// 1つの三角形にしか使われていない辺(穴の縁)の頂点に印を付ける
+	void MarkBorderVertices(const std::vector<uint32_t>& indices, std::vector<uint8_t>& locked)
+	{
+		// 向きを無視した辺を並べて数える
+		std::vector<uint64_t> edges;
+		edges.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t a = indices[i + corner];
+				uint32_t b = indices[i + (corner + 1) % 3];
+				edges.push_back(a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		for (size_t i = 0; i < edges.size();)
+		{
+			size_t end = i + 1;
+			while (end < edges.size() && edges[end] == edges[i])
+			{
+				++end;
+			}
+			if (end - i == 1)
+			{
+				locked[edges[i] >> 32] = 1;
+				locked[edges[i] & 0xFFFFFFFFu] = 1;
+			}
+			i = end;
+		}
+	}
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float& error)
+{
+	std::vector<uint32_t> result(indices, indices + indexCount);
+	error = 0.0f;
+	if (result.size() <= targetIndexCount)
+	{
+		return result;
+	}
+	size_t vertexCount = vertices.size();
+
+	//1. 動かしてはいけない頂点に印を付ける
+	std::vector<uint8_t> locked(vertexCount, 0);
+	MarkSeamVertices(vertices, locked);
+	MarkBorderVertices(result, locked);
+
+	//2. 各頂点に、周りの三角形の平面の二次誤差を集める
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		const Vector4& p0 = vertices[result[i]].position;
+		Vector3 normal = TriangleNormal(p0, vertices[result[i + 1]].position, vertices[result[i + 2]].position);
+		double length = std::sqrt(double(normal.x) * normal.x + double(normal.y) * normal.y + double(normal.z) * normal.z);
+		if (length <= 0.0)
+		{
+			continue;
+		}
+		double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+		Quadric plane = MakePlaneQuadric(a, b, c, -(a * p0.x + b * p0.y + c * p0.z));
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			AddQuadric(quadrics[result[i + corner]], plane);
+		}
+	}
+
+	//3. 目標の数になるまで、誤差の小さい辺から縮約していく
+	std::vector<uint32_t> remap(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; ++i)
+	{
+		remap[i] = i;
+	}
+	std::vector<uint8_t> touched(vertexCount, 0);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	double maxCost = 0.0;
+	while (result.size() > targetIndexCount)
+	{
+		// 頂点からその三角形を引けるようにする
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result)
+		{
+			++adjacencyOffsets[index + 1];
+		}
+		for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+		}
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < result.size(); ++i)
+			{
+				adjacency[cursor[result[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		// 各辺について、誤差の小さい向きの縮約を候補にする。縁以外の辺は2つの三角形に逆向きで現れるのでa<bの方だけ見る
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t a = result[i + corner];
+				uint32_t b = result[i + (corner + 1) % 3];
+				if (a > b)
+				{
+					continue;
+				}
+				Quadric sum = quadrics[a];
+				AddQuadric(sum, quadrics[b]);
+				double costAB = locked[a] ? -1.0 : EvaluateQuadric(sum, vertices[b].position);
+				double costBA = locked[b] ? -1.0 : EvaluateQuadric(sum, vertices[a].position);
+				if (costAB >= 0.0 && (costBA < 0.0 || costAB <= costBA))
+				{
+					collapses.push_back({ a, b, costAB });
+				}
+				else if (costBA >= 0.0)
+				{
+					collapses.push_back({ b, a, costBA });
+				}
+			}
+		}
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		// 安い方から一部だけ並べる
+		size_t candidateCount = std::max<size_t>(collapses.size() / kPassCandidateDivisor, 1);
+		auto byCost = [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; };
+		std::nth_element(collapses.begin(), collapses.begin() + (candidateCount - 1), collapses.end(), byCost);
+		std::sort(collapses.begin(), collapses.begin() + candidateCount, byCost);
+
+		// 同じパスでは周りの三角形が変わった頂点を使わないようにして、隣接情報を作り直さずに縮約する
+		size_t neededTriangles = (result.size() - targetIndexCount + 2) / 3;
+		size_t removedTriangles = 0;
+		std::fill(touched.begin(), touched.end(), 0);
+		for (size_t candidate = 0; candidate < candidateCount && removedTriangles < neededTriangles; ++candidate)
+		{
+			const Collapse& collapse = collapses[candidate];
+			uint32_t from = collapse.from;
+			uint32_t to = collapse.to;
+			if (touched[from] || touched[to])
+			{
+				continue;
+			}
+
+			// 縮約で裏返る三角形があればやめる
+			bool flipped = false;
+			size_t collapsedTriangles = 0;
+			const Vector4& target = vertices[to].position;
+			for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1] && !flipped; ++a)
+			{
+				const uint32_t* corner = result.data() + size_t(adjacency[a]) * 3;
+				if (corner[0] == to || corner[1] == to || corner[2] == to)
+				{
+					++collapsedTriangles;
+					continue;
+				}
+				Vector4 before[3] = { vertices[corner[0]].position, vertices[corner[1]].position, vertices[corner[2]].position };
+				Vector4 after[3] = { before[0], before[1], before[2] };
+				for (size_t k = 0; k < 3; ++k)
+				{
+					if (corner[k] == from)
+					{
+						after[k] = target;
+					}
+				}
+				Vector3 n0 = TriangleNormal(before[0], before[1], before[2]);
+				Vector3 n1 = TriangleNormal(after[0], after[1], after[2]);
+				flipped = n0.x * n1.x + n0.y * n1.y + n0.z * n1.z <= 0.0f;
+			}
+			if (flipped)
+			{
+				continue;
+			}
+
+			// 縮約する。周りの頂点は同じパスではもう使わない
+			remap[from] = to;
+			AddQuadric(quadrics[to], quadrics[from]);
+			for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; ++a)
+			{
+				const uint32_t* corner = result.data() + size_t(adjacency[a]) * 3;
+				touched[corner[0]] = 1;
+				touched[corner[1]] = 1;
+				touched[corner[2]] = 1;
+			}
+			removedTriangles += collapsedTriangles;
+			maxCost = std::max(maxCost, collapse.cost);
+		}
+		if (removedTriangles == 0)
+		{
+			// これ以上減らせない
+			break;
+		}
+
+		// Indexを付け替え、潰れた三角形を消す
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t a = remap[result[i]];
+			uint32_t b = remap[result[i + 1]];
+			uint32_t c = remap[result[i + 2]];
+			if (a != b && b != c && c != a)
+			{
+				result[writeIndex++] = a;
+				result[writeIndex++] = b;
+				result[writeIndex++] = c;
+			}
+		}
+		result.resize(writeIndex);
+		for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			remap[vertex] = static_cast<uint32_t>(vertex);
+		}
+	}
+
+	// 二次誤差は距離の2乗の和なので、平方根を距離の見積もりにする
+	error = static_cast<float>(std::sqrt(maxCost));
+	return result;
+}
+
+MeshLodChain BuildMeshLodChain(const ModelData& modelData, std::span<const float> ratios)
+{
+	MeshLodChain lodChain{};
+
+	//1. 境界球は読み込み時に求めたものを使う
+	lodChain.boundingCenter = modelData.bounds.sphereCenter;
+	lodChain.boundingRadius = modelData.bounds.sphereRadius;
+
+	//2. LOD0は元のメッシュそのまま
+	lodChain.indices = modelData.indices;
+	lodChain.lods.push_back({ modelData.batches, static_cast<uint32_t>(modelData.indices.size() / 3), 0.0f });
+
+	//3. 1つ前のLODを描画単位ごとに簡略化していく
+	for (float ratio : ratios)
+	{
+		const MeshLod& previous = lodChain.lods.back();
+		MeshLod lod{};
+		lod.error = previous.error;
+		for (size_t batchIndex = 0; batchIndex < previous.batches.size(); ++batchIndex)
+		{
+			const MaterialBatch& previousBatch = previous.batches[batchIndex];
+			size_t originalIndexCount = modelData.batches[batchIndex].indexCount;
+			size_t targetIndexCount = static_cast<size_t>(double(originalIndexCount / 3) * ratio) * 3;
+			float error = 0.0f;
+			std::vector<uint32_t> indices = SimplifyMesh(modelData.vertices, lodChain.indices.data() + previousBatch.indexStart, previousBatch.indexCount, targetIndexCount, error);
+			OptimizeVertexCache(indices.data(), indices.size(), modelData.vertices.size());
+
+			// 誤差は段を重ねるごとに積み上がるので足しておく
+			lod.error = std::max(lod.error, previous.error + error);
+			lod.batches.push_back({ static_cast<uint32_t>(lodChain.indices.size()), static_cast<uint32_t>(indices.size()), previousBatch.materialIndex });
+			lod.triangleCount += static_cast<uint32_t>(indices.size() / 3);
+			lodChain.indices.insert(lodChain.indices.end(), indices.begin(), indices.end());
+		}
+		// 継ぎ目や縁ばかりでこれ以上減らせなければ、同じ内容のLODは作らない
+		if (lod.triangleCount >= previous.triangleCount)
+		{
+			lodChain.indices.resize(lodChain.indices.size() - size_t(lod.triangleCount) * 3);
+			break;
+		}
+		lodChain.lods.push_back(lod);
+	}
+	return lodChain;
+}
+
+float ComputeProjectedRadius(float radius, float distance, float fovY, float viewportHeight)
+{
+	// カメラが球の中にある場合は画面いっぱいとみなす
+	if (distance <= radius)
+	{
+		return viewportHeight;
+	}
+	// 射影行列のm[1][1] = 1/tan(fovY/2)を使い、NDCの高さ2をviewportHeightに合わせる
+	return radius / (distance * std::tan(fovY * 0.5f)) * viewportHeight * 0.5f;
+}
+
+uint32_t SelectMeshLod(const MeshLodChain& lodChain, float distance, float scale, float fovY, float viewportHeight, float errorPixels)
+{
+	// 粗い方から、誤差を画面に投影してerrorPixels以下に収まるものを探す
+	for (size_t lod = lodChain.lods.size(); lod-- > 1;)
+	{
+		float projectedError = ComputeProjectedRadius(lodChain.lods[lod].error * scale, distance, fovY, viewportHeight);
+		if (distance > lodChain.boundingRadius * scale && projectedError <= errorPixels)
+		{
+			return static_cast<uint32_t>(lod);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "ModelData.h"
+#include "Vector3.h"
+
+// 既定のLODの三角形数の割合(LOD0に対する割合)
+constexpr std::array<float, 3> kDefaultLodRatios = { 0.5f, 0.25f, 0.125f };
+// 既定の許容する画面上の誤差(ピクセル)。これ以下に収まる一番粗いLODを選ぶ
+const float kDefaultLodErrorPixels = 1.0f;
+
+///==========================================================
+/// LOD1段分の描画単位
+///==========================================================
+struct MeshLod
+{
+	std::vector<MaterialBatch> batches;	//!< MeshLodChain::indicesの範囲。マテリアルはModelDataと同じ
+	uint32_t triangleCount;				//!< 三角形数
+	float error;						//!< LOD0からの形状の誤差の見積もり(モデル空間の距離)
+};
+
+///==========================================================
+/// LODの列。頂点はModelDataのものを共有し、Indexだけ段ごとに持つ
+///==========================================================
+struct MeshLodChain
+{
+	std::vector<uint32_t> indices;		//!< 全LODのIndexを連結したもの。先頭がLOD0
+	std::vector<MeshLod> lods;			//!< lods[0]は元のメッシュ
+	Vector3 boundingCenter;				//!< 境界球の中心(モデル空間)
+	float boundingRadius;				//!< 境界球の半径(モデル空間)
+};
+
+// [indices, indices + indexCount)の三角形を二次誤差(QEM)で辺を縮約してtargetIndexCount以下まで減らす
+// 頂点は移動させず既存の頂点へ縮約するので、UVや法線はそのまま残る。UVの継ぎ目と穴の縁の頂点は動かさない
+// errorにはこの簡略化の誤差の見積もり(モデル空間の距離)が入る
+std::vector<uint32_t> SimplifyMesh(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float& error);
+
+// マテリアルごとの描画単位を保ったまま、ratiosの割合でLODの列を作る。それ以上減らせなくなったらそこで打ち切る
+MeshLodChain BuildMeshLodChain(const ModelData& modelData, std::span<const float> ratios = kDefaultLodRatios);
+
+// 境界球の画面上の半径(ピクセル)を求める。fovYとviewportHeightはMakePerspectiveFovMatrixに渡すものと同じ
+float ComputeProjectedRadius(float radius, float distance, float fovY, float viewportHeight);
+
+// 画面上の誤差がerrorPixels以下になる一番粗いLODを選ぶ。scaleはワールド変換の最大の拡大率
+uint32_t SelectMeshLod(const MeshLodChain& lodChain, float distance, float scale, float fovY, float viewportHeight, float errorPixels = kDefaultLodErrorPixels);
@@ -0,0 +1,312 @@
+#include "MeshTangentSpace.h"
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <emmintrin.h>
+
+namespace
+{
+	// これより短いベクトルは向きが決まらないものとして扱う
+	const float kMinLength = 1e-12f;
+
+	// 頂点の位置を読む。wは0にする
+	__m128 LoadPosition(const VertexData& vertex)
+	{
+		return _mm_and_ps(_mm_loadu_ps(&vertex.position.x), _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+	}
+
+	// xyzの内積。wは0であること
+	float Dot3(__m128 a, __m128 b)
+	{
+		__m128 product = _mm_mul_ps(a, b);
+		__m128 sum = _mm_add_ps(product, _mm_movehl_ps(product, product));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+		return _mm_cvtss_f32(sum);
+	}
+
+	// xyzの外積。wは0になる
+	__m128 Cross3(__m128 a, __m128 b)
+	{
+		__m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+		return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	// 三角形の3つの角の大きさ。|e1×e2|は3つの角で共通なので、atan2(|外積|, 内積)で求める
+	void ComputeCornerAngles(__m128 e1, __m128 e2, __m128 e3, float crossLength, float* angles)
+	{
+		angles[0] = std::atan2(crossLength, Dot3(e1, e2));
+		angles[1] = std::atan2(crossLength, -Dot3(e1, e3));
+		angles[2] = std::atan2(crossLength, Dot3(e2, e3));
+	}
+
+	///==========================================================
+	/// 点ごとに、その点を使う三角形の角(3 * 三角形番号 + 角)を並べた表
+	///==========================================================
+	struct CornerAdjacency
+	{
+		std::vector<uint32_t> offsets;	//!< 点ごとの先頭の位置。点の数 + 1個
+		std::vector<uint32_t> corners;	//!< 角の番号。点ごとに角の番号の小さい順に並ぶ
+	};
+
+	// 角から点への対応(keys[indices[角]])から表を作る。kKeepVertexNormalの点は除く
+	// 角の番号の順に詰めるので、点ごとの集計の順番は分割の仕方によらず決まる
+	CornerAdjacency BuildCornerAdjacency(const std::vector<uint32_t>& indices, const uint32_t* keys, size_t keyCount)
+	{
+		CornerAdjacency adjacency;
+		adjacency.offsets.assign(keyCount + 1, 0);
+		for (uint32_t index : indices)
+		{
+			uint32_t key = keys ? keys[index] : index;
+			if (key != kKeepVertexNormal)
+			{
+				++adjacency.offsets[key + 1];
+			}
+		}
+		for (size_t i = 0; i < keyCount; ++i)
+		{
+			adjacency.offsets[i + 1] += adjacency.offsets[i];
+		}
+		adjacency.corners.resize(adjacency.offsets[keyCount]);
+		std::vector<uint32_t> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (size_t corner = 0; corner < indices.size(); ++corner)
+		{
+			uint32_t key = keys ? keys[indices[corner]] : indices[corner];
+			if (key != kKeepVertexNormal)
+			{
+				adjacency.corners[cursors[key]++] = static_cast<uint32_t>(corner);
+			}
+		}
+		return adjacency;
+	}
+
+	// 単位法線に直交する単位ベクトルを1つ作る(Duffらの方式)
+	Vector4 MakePerpendicular(const Vector3& normal, float handedness)
+	{
+		float sign = std::copysign(1.0f, normal.z);
+		float a = -1.0f / (sign + normal.z);
+		float b = normal.x * normal.y * a;
+		return { 1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x, handedness };
+	}
+}
+
+std::vector<uint32_t> WeldVertexPositions(const std::vector<VertexData>& vertices)
+{
+	// 位置のビット列をキーにする。-0と+0は同じ位置として扱う
+	struct PositionKey
+	{
+		uint32_t bits[3];
+		bool operator==(const PositionKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+	};
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			uint64_t hash = key.bits[0] * 0x9E3779B97F4A7C15ull;
+			hash = (hash ^ (hash >> 29) ^ key.bits[1]) * 0xBF58476D1CE4E5B9ull;
+			hash = (hash ^ (hash >> 31) ^ key.bits[2]) * 0x94D049BB133111EBull;
+			return static_cast<size_t>(hash ^ (hash >> 32));
+		}
+	};
+
+	std::unordered_map<PositionKey, uint32_t, PositionKeyHash> ids;
+	ids.reserve(vertices.size());
+	std::vector<uint32_t> smoothingIds;
+	smoothingIds.reserve(vertices.size());
+	for (const VertexData& vertex : vertices)
+	{
+		float position[3] = { vertex.position.x + 0.0f, vertex.position.y + 0.0f, vertex.position.z + 0.0f };
+		PositionKey key{};
+		std::memcpy(key.bits, position, sizeof(key.bits));
+		smoothingIds.push_back(ids.try_emplace(key, static_cast<uint32_t>(ids.size())).first->second);
+	}
+	return smoothingIds;
+}
+
+void GenerateNormals(std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& smoothingIds,
+	NormalWeighting weighting, JobSystem* jobSystem)
+{
+	//1. 点の数を数える
+	uint32_t idCount = 0;
+	for (uint32_t id : smoothingIds)
+	{
+		if (id != kKeepVertexNormal && id >= idCount)
+		{
+			idCount = id + 1;
+		}
+	}
+	if (idCount == 0)
+	{
+		return;
+	}
+
+	//2. 三角形ごとに単位法線と各角の重みを求める。頂点には書き込まないので競合しない
+	size_t triangleCount = indices.size() / 3;
+	std::vector<Vector4> faceNormals(triangleCount);
+	std::vector<float> cornerWeights(triangleCount * 3);
+	ParallelForRange(jobSystem, triangleCount, [&](size_t begin, size_t end)
+		{
+			for (size_t triangle = begin; triangle < end; ++triangle)
+			{
+				const uint32_t* corner = indices.data() + triangle * 3;
+				__m128 p0 = LoadPosition(vertices[corner[0]]);
+				__m128 p1 = LoadPosition(vertices[corner[1]]);
+				__m128 p2 = LoadPosition(vertices[corner[2]]);
+				__m128 e1 = _mm_sub_ps(p1, p0);
+				__m128 e2 = _mm_sub_ps(p2, p0);
+				__m128 e3 = _mm_sub_ps(p2, p1);
+				__m128 normal = Cross3(e1, e2);
+				float length = std::sqrt(Dot3(normal, normal));
+				float* weights = cornerWeights.data() + triangle * 3;
+				if (length <= kMinLength)
+				{
+					// 潰れた三角形は寄与しない
+					faceNormals[triangle] = {};
+					weights[0] = weights[1] = weights[2] = 0.0f;
+					continue;
+				}
+				_mm_storeu_ps(&faceNormals[triangle].x, _mm_div_ps(normal, _mm_set1_ps(length)));
+				if (weighting == NormalWeighting::Area)
+				{
+					// 外積の長さは面積の2倍
+					weights[0] = weights[1] = weights[2] = length;
+				}
+				else
+				{
+					ComputeCornerAngles(e1, e2, e3, length, weights);
+				}
+			}
+		});
+
+	//3. 点ごとに、使っている角の重み付きの面の法線を足して正規化する
+	CornerAdjacency adjacency = BuildCornerAdjacency(indices, smoothingIds.data(), idCount);
+	std::vector<Vector3> idNormals(idCount);
+	ParallelForRange(jobSystem, idCount, [&](size_t begin, size_t end)
+		{
+			for (size_t id = begin; id < end; ++id)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (uint32_t i = adjacency.offsets[id]; i < adjacency.offsets[id + 1]; ++i)
+				{
+					uint32_t corner = adjacency.corners[i];
+					__m128 faceNormal = _mm_loadu_ps(&faceNormals[corner / 3].x);
+					sum = _mm_add_ps(sum, _mm_mul_ps(faceNormal, _mm_set1_ps(cornerWeights[corner])));
+				}
+				float length = std::sqrt(Dot3(sum, sum));
+				if (length <= kMinLength)
+				{
+					// 潰れた三角形にしか使われていない点は上向きにしておく
+					idNormals[id] = { 0.0f, 1.0f, 0.0f };
+					continue;
+				}
+				alignas(16) float normal[4];
+				_mm_store_ps(normal, _mm_div_ps(sum, _mm_set1_ps(length)));
+				idNormals[id] = { normal[0], normal[1], normal[2] };
+			}
+		});
+
+	//4. 頂点に書き戻す
+	ParallelForRange(jobSystem, vertices.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t vertex = begin; vertex < end; ++vertex)
+			{
+				if (smoothingIds[vertex] != kKeepVertexNormal)
+				{
+					vertices[vertex].normal = idNormals[smoothingIds[vertex]];
+				}
+			}
+		});
+}
+
+std::vector<Vector4> GenerateTangents(const std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices, JobSystem* jobSystem)
+{
+	//1. 三角形ごとにUのプラス方向(dP/du)と、UVの向きが面の向きと揃っているかを求める
+	size_t triangleCount = indices.size() / 3;
+	std::vector<Vector4> faceTangents(triangleCount);
+	std::vector<float> cornerAngles(triangleCount * 3);
+	ParallelForRange(jobSystem, triangleCount, [&](size_t begin, size_t end)
+		{
+			for (size_t triangle = begin; triangle < end; ++triangle)
+			{
+				const uint32_t* corner = indices.data() + triangle * 3;
+				const VertexData& v0 = vertices[corner[0]];
+				const VertexData& v1 = vertices[corner[1]];
+				const VertexData& v2 = vertices[corner[2]];
+				__m128 p0 = LoadPosition(v0);
+				__m128 e1 = _mm_sub_ps(LoadPosition(v1), p0);
+				__m128 e2 = _mm_sub_ps(LoadPosition(v2), p0);
+				__m128 e3 = _mm_sub_ps(e2, e1);
+				__m128 normal = Cross3(e1, e2);
+				ComputeCornerAngles(e1, e2, e3, std::sqrt(Dot3(normal, normal)), cornerAngles.data() + triangle * 3);
+
+				// e1 = du1 * T + dv1 * B, e2 = du2 * T + dv2 * B を解く。行列式の符号がwになる
+				float du1 = v1.texcoord.x - v0.texcoord.x;
+				float dv1 = v1.texcoord.y - v0.texcoord.y;
+				float du2 = v2.texcoord.x - v0.texcoord.x;
+				float dv2 = v2.texcoord.y - v0.texcoord.y;
+				float signedArea = du1 * dv2 - du2 * dv1;
+				__m128 tangent = _mm_sub_ps(_mm_mul_ps(e1, _mm_set1_ps(dv2)), _mm_mul_ps(e2, _mm_set1_ps(dv1)));
+				float length = std::sqrt(Dot3(tangent, tangent));
+				if (signedArea == 0.0f || length <= kMinLength)
+				{
+					// UVが潰れている三角形は寄与しない(wが0)
+					faceTangents[triangle] = {};
+					continue;
+				}
+				float handedness = signedArea > 0.0f ? 1.0f : -1.0f;
+				alignas(16) float direction[4];
+				_mm_store_ps(direction, _mm_mul_ps(tangent, _mm_set1_ps(handedness / length)));
+				faceTangents[triangle] = { direction[0], direction[1], direction[2], handedness };
+			}
+		});
+
+	//2. 頂点ごとに、面の接線を頂点の法線に直交するように射影して正規化し、角度で重み付けして足す
+	// MikkTSpaceは向きの揃っていない角を使う頂点を分けるが、頂点の数は変えずに重みの大きい方の向きにする
+	CornerAdjacency adjacency = BuildCornerAdjacency(indices, nullptr, vertices.size());
+	std::vector<Vector4> tangents(vertices.size());
+	ParallelForRange(jobSystem, vertices.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t vertex = begin; vertex < end; ++vertex)
+			{
+				Vector3 normal = vertices[vertex].normal;
+				float normalLength = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+				normal = normalLength > kMinLength ? Vector3{ normal.x / normalLength, normal.y / normalLength, normal.z / normalLength } : Vector3{ 0.0f, 1.0f, 0.0f };
+				__m128 n = _mm_set_ps(0.0f, normal.z, normal.y, normal.x);
+
+				__m128 sum = _mm_setzero_ps();
+				float handednessSum = 0.0f;
+				for (uint32_t i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; ++i)
+				{
+					uint32_t corner = adjacency.corners[i];
+					const Vector4& faceTangent = faceTangents[corner / 3];
+					if (faceTangent.w == 0.0f)
+					{
+						continue;
+					}
+					__m128 t = _mm_set_ps(0.0f, faceTangent.z, faceTangent.y, faceTangent.x);
+					t = _mm_sub_ps(t, _mm_mul_ps(n, _mm_set1_ps(Dot3(n, t))));
+					float length = std::sqrt(Dot3(t, t));
+					if (length <= kMinLength)
+					{
+						continue;
+					}
+					float weight = cornerAngles[corner];
+					sum = _mm_add_ps(sum, _mm_mul_ps(t, _mm_set1_ps(weight / length)));
+					handednessSum += weight * faceTangent.w;
+				}
+
+				float handedness = handednessSum < 0.0f ? -1.0f : 1.0f;
+				float length = std::sqrt(Dot3(sum, sum));
+				if (length <= kMinLength)
+				{
+					tangents[vertex] = MakePerpendicular(normal, handedness);
+					continue;
+				}
+				alignas(16) float tangent[4];
+				_mm_store_ps(tangent, _mm_div_ps(sum, _mm_set1_ps(length)));
+				tangents[vertex] = { tangent[0], tangent[1], tangent[2], handedness };
+			}
+		});
+	return tangents;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+#include "Vector4.h"
+#include "VertexData.h"
+
+// 法線を作らずにそのまま使う頂点の平滑化の番号
+const uint32_t kKeepVertexNormal = UINT32_MAX;
+
+// 頂点法線を求めるときの面の法線の重み付け
+enum class NormalWeighting
+{
+	Area,	// 面積で重み付けする。大きい面の向きに寄る
+	Angle,	// 頂点での角度で重み付けする。同じ形なら三角形の分け方によらず同じ法線になる
+};
+
+// 位置が同じ頂点に同じ平滑化の番号を振る。メッシュ全体を1つの平滑化グループとして法線を作り直すときに使う
+std::vector<uint32_t> WeldVertexPositions(const std::vector<VertexData>& vertices);
+
+// 平滑化の番号が同じ頂点を1つの点とみなし、その点を使う三角形の法線の重み付き平均を頂点の法線にする
+// smoothingIds[頂点]がkKeepVertexNormalの頂点は法線を変えない
+// 三角形ごとの計算と点ごとの集計をjobSystemで並列に行う。nullptrなら呼び出したスレッドだけで行う。結果はスレッド数によらず同じ
+void GenerateNormals(std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& smoothingIds,
+	NormalWeighting weighting, JobSystem* jobSystem);
+
+// MikkTSpaceの規約で頂点の接線を求める。xyzは法線に直交する単位ベクトルでUのプラス方向、wは従法線の向き(±1)
+// 従法線はw * cross(normal, tangent)で、補間後の法線と接線からピクセルごとに作り直す
+// UVが潰れていて決まらない頂点は、法線に直交する適当な向きにする
+std::vector<Vector4> GenerateTangents(const std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices, JobSystem* jobSystem);
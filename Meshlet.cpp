@@ -0,0 +1,293 @@
+#include "Meshlet.h"
+#include "BoundingVolume.h"
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace
+{
+	// 使っていない頂点の印
+	const uint8_t kUnusedSlot = 0xFF;
+
+	// 三角形の単位法線。潰れていれば0を返す
+	Vector3 TriangleUnitNormal(const Vector4& p0, const Vector4& p1, const Vector4& p2)
+	{
+		Vector3 e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+		Vector3 e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+		Vector3 normal = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+		float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		if (length <= 0.0f)
+		{
+			return { 0.0f, 0.0f, 0.0f };
+		}
+		return { normal.x / length, normal.y / length, normal.z / length };
+	}
+
+	// メッシュレットの境界球と法線の円錐を求める
+	void ComputeMeshletBounds(const std::vector<VertexData>& vertices, const MeshletData& meshletData, Meshlet& meshlet)
+	{
+		//1. 境界球
+		BoundingVolume bounds = ComputeBoundingVolume(vertices, meshletData.vertices.data() + meshlet.vertexOffset, meshlet.vertexCount);
+		meshlet.center = bounds.sphereCenter;
+		meshlet.radius = bounds.sphereRadius;
+
+		//2. 法線の円錐の軸は三角形の法線の平均にする
+		std::vector<Vector3> normals(meshlet.triangleCount);
+		Vector3 axis = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < meshlet.triangleCount; ++i)
+		{
+			const uint8_t* corner = meshletData.triangles.data() + meshlet.triangleOffset + size_t(i) * 3;
+			normals[i] = TriangleUnitNormal(
+				vertices[meshletData.vertices[meshlet.vertexOffset + corner[0]]].position,
+				vertices[meshletData.vertices[meshlet.vertexOffset + corner[1]]].position,
+				vertices[meshletData.vertices[meshlet.vertexOffset + corner[2]]].position);
+			axis = { axis.x + normals[i].x, axis.y + normals[i].y, axis.z + normals[i].z };
+		}
+		float axisLength = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+		meshlet.coneAxis = { 0.0f, 0.0f, 0.0f };
+		meshlet.coneCutoff = 1.0f;
+		if (axisLength <= 0.0f)
+		{
+			return;
+		}
+		meshlet.coneAxis = { axis.x / axisLength, axis.y / axisLength, axis.z / axisLength };
+
+		//3. 軸と一番離れた法線の角度から広がりを決める。半球以上に広がっていれば裏面では消せない
+		float minDot = 1.0f;
+		for (const Vector3& normal : normals)
+		{
+			minDot = std::fmin(minDot, normal.x * meshlet.coneAxis.x + normal.y * meshlet.coneAxis.y + normal.z * meshlet.coneAxis.z);
+		}
+		if (minDot > 0.0f)
+		{
+			meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+		}
+	}
+
+	// 境界球が視錐台の外にあるか
+	bool IsOutsideFrustum(const Vector4 planes[6], float x, float y, float z, float radius)
+	{
+		for (int32_t i = 0; i < 6; ++i)
+		{
+			if (planes[i].x * x + planes[i].y * y + planes[i].z * z + planes[i].w < -radius)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// 全ての三角形がカメラから見て裏を向いているか
+	bool IsBackfacing(const Vector3& cameraPosition, float x, float y, float z, float radius, float axisX, float axisY, float axisZ, float cutoff)
+	{
+		float dx = x - cameraPosition.x;
+		float dy = y - cameraPosition.y;
+		float dz = z - cameraPosition.z;
+		float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+		return dx * axisX + dy * axisY + dz * axisZ >= cutoff * distance + radius;
+	}
+}
+
+MeshletData BuildMeshlets(const std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices, const std::vector<MaterialBatch>& batches)
+{
+	MeshletData meshletData;
+	// 頂点ごとに今のメッシュレットの中での番号を覚えておく
+	std::vector<uint8_t> slots(vertices.size(), kUnusedSlot);
+	Meshlet current{};
+
+	// 今のメッシュレットを確定し、次のメッシュレットを始める
+	auto flush = [&]()
+		{
+			if (current.triangleCount != 0)
+			{
+				ComputeMeshletBounds(vertices, meshletData, current);
+				meshletData.meshlets.push_back(current);
+			}
+			for (uint32_t i = 0; i < current.vertexCount; ++i)
+			{
+				slots[meshletData.vertices[current.vertexOffset + i]] = kUnusedSlot;
+			}
+			current = {};
+			current.vertexOffset = static_cast<uint32_t>(meshletData.vertices.size());
+			current.triangleOffset = static_cast<uint32_t>(meshletData.triangles.size());
+		};
+
+	//1. 描画単位ごとに、頂点数か三角形数が上限を超えるまで三角形を順に詰める
+	for (const MaterialBatch& batch : batches)
+	{
+		flush();
+		current.materialIndex = batch.materialIndex;
+		for (uint32_t i = batch.indexStart; i + 2 < batch.indexStart + batch.indexCount; i += 3)
+		{
+			uint32_t newVertexCount = 0;
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				newVertexCount += slots[indices[i + corner]] == kUnusedSlot ? 1 : 0;
+			}
+			if (current.vertexCount + newVertexCount > kMeshletMaxVertices || current.triangleCount + 1 > kMeshletMaxTriangles)
+			{
+				uint32_t materialIndex = current.materialIndex;
+				flush();
+				current.materialIndex = materialIndex;
+			}
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vertex = indices[i + corner];
+				if (slots[vertex] == kUnusedSlot)
+				{
+					slots[vertex] = static_cast<uint8_t>(current.vertexCount++);
+					meshletData.vertices.push_back(vertex);
+				}
+				meshletData.triangles.push_back(slots[vertex]);
+			}
+			++current.triangleCount;
+		}
+	}
+	flush();
+
+	//2. カリング用に成分ごとに並べ直す。末尾を埋めた分も判定はするが結果は使わない
+	size_t paddedCount = (meshletData.meshlets.size() + 3) & ~size_t(3);
+	MeshletCullData& cullData = meshletData.cullData;
+	cullData.centerX.assign(paddedCount, 0.0f);
+	cullData.centerY.assign(paddedCount, 0.0f);
+	cullData.centerZ.assign(paddedCount, 0.0f);
+	cullData.radius.assign(paddedCount, 0.0f);
+	cullData.coneAxisX.assign(paddedCount, 0.0f);
+	cullData.coneAxisY.assign(paddedCount, 0.0f);
+	cullData.coneAxisZ.assign(paddedCount, 0.0f);
+	cullData.coneCutoff.assign(paddedCount, 1.0f);
+	for (size_t i = 0; i < meshletData.meshlets.size(); ++i)
+	{
+		const Meshlet& meshlet = meshletData.meshlets[i];
+		cullData.centerX[i] = meshlet.center.x;
+		cullData.centerY[i] = meshlet.center.y;
+		cullData.centerZ[i] = meshlet.center.z;
+		cullData.radius[i] = meshlet.radius;
+		cullData.coneAxisX[i] = meshlet.coneAxis.x;
+		cullData.coneAxisY[i] = meshlet.coneAxis.y;
+		cullData.coneAxisZ[i] = meshlet.coneAxis.z;
+		cullData.coneCutoff[i] = meshlet.coneCutoff;
+	}
+	return meshletData;
+}
+
+void CullMeshlets(const MeshletData& meshletData, const Vector4 planes[6], const Vector3& cameraPosition, MeshletCullMode mode, std::vector<uint32_t>& visibleMeshlets, MeshletCullStatistics& statistics)
+{
+	auto start = std::chrono::steady_clock::now();
+	const MeshletCullData& cullData = meshletData.cullData;
+	uint32_t meshletCount = static_cast<uint32_t>(meshletData.meshlets.size());
+	visibleMeshlets.clear();
+	visibleMeshlets.reserve(meshletCount);
+	statistics.meshletCount = meshletCount;
+	statistics.frustumCulledCount = 0;
+	statistics.coneCulledCount = 0;
+	statistics.visibleTriangleCount = 0;
+
+	if (mode == MeshletCullMode::Scalar)
+	{
+		for (uint32_t i = 0; i < meshletCount; ++i)
+		{
+			if (IsOutsideFrustum(planes, cullData.centerX[i], cullData.centerY[i], cullData.centerZ[i], cullData.radius[i]))
+			{
+				++statistics.frustumCulledCount;
+			}
+			else if (IsBackfacing(cameraPosition, cullData.centerX[i], cullData.centerY[i], cullData.centerZ[i], cullData.radius[i],
+				cullData.coneAxisX[i], cullData.coneAxisY[i], cullData.coneAxisZ[i], cullData.coneCutoff[i]))
+			{
+				++statistics.coneCulledCount;
+			}
+			else
+			{
+				visibleMeshlets.push_back(i);
+			}
+		}
+	}
+	else
+	{
+		// 平面とカメラの位置を4レーンに複製しておく
+		__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+		for (int32_t p = 0; p < 6; ++p)
+		{
+			planeX[p] = _mm_set1_ps(planes[p].x);
+			planeY[p] = _mm_set1_ps(planes[p].y);
+			planeZ[p] = _mm_set1_ps(planes[p].z);
+			planeW[p] = _mm_set1_ps(planes[p].w);
+		}
+		__m128 cameraX = _mm_set1_ps(cameraPosition.x);
+		__m128 cameraY = _mm_set1_ps(cameraPosition.y);
+		__m128 cameraZ = _mm_set1_ps(cameraPosition.z);
+
+		// Scalarと同じ順番で同じ演算をして、結果が一致するようにする
+		for (uint32_t i = 0; i < meshletCount; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(cullData.centerX.data() + i);
+			__m128 y = _mm_loadu_ps(cullData.centerY.data() + i);
+			__m128 z = _mm_loadu_ps(cullData.centerZ.data() + i);
+			__m128 radius = _mm_loadu_ps(cullData.radius.data() + i);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+			//1. どれか1つの平面の外にあれば視錐台の外
+			__m128 outside = _mm_setzero_ps();
+			for (int32_t p = 0; p < 6; ++p)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_mul_ps(planeZ[p], z)), planeW[p]);
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+			}
+
+			//2. 法線の円錐が全てカメラの反対を向いていれば裏面
+			__m128 dx = _mm_sub_ps(x, cameraX);
+			__m128 dy = _mm_sub_ps(y, cameraY);
+			__m128 dz = _mm_sub_ps(z, cameraZ);
+			__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+			__m128 facing = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(cullData.coneAxisX.data() + i)), _mm_mul_ps(dy, _mm_loadu_ps(cullData.coneAxisY.data() + i))), _mm_mul_ps(dz, _mm_loadu_ps(cullData.coneAxisZ.data() + i)));
+			__m128 backfacing = _mm_cmpge_ps(facing, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(cullData.coneCutoff.data() + i), distance), radius));
+
+			//3. 4つ分の結果をビットで受け取り、末尾の埋めた分は無視する
+			uint32_t laneMask = meshletCount - i < 4 ? (1u << (meshletCount - i)) - 1 : 0xFu;
+			uint32_t outsideMask = static_cast<uint32_t>(_mm_movemask_ps(outside)) & laneMask;
+			uint32_t backfacingMask = static_cast<uint32_t>(_mm_movemask_ps(backfacing)) & laneMask & ~outsideMask;
+			uint32_t visibleMask = laneMask & ~outsideMask & ~backfacingMask;
+			statistics.frustumCulledCount += std::popcount(outsideMask);
+			statistics.coneCulledCount += std::popcount(backfacingMask);
+			while (visibleMask != 0)
+			{
+				visibleMeshlets.push_back(i + std::countr_zero(visibleMask));
+				visibleMask &= visibleMask - 1;
+			}
+		}
+	}
+
+	for (uint32_t meshlet : visibleMeshlets)
+	{
+		statistics.visibleTriangleCount += meshletData.meshlets[meshlet].triangleCount;
+	}
+	statistics.visibleCount = static_cast<uint32_t>(visibleMeshlets.size());
+	statistics.cullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t CompactMeshletIndices(const MeshletData& meshletData, const std::vector<uint32_t>& visibleMeshlets, uint32_t* indices, std::vector<MaterialBatch>& batches, MeshletCullStatistics& statistics)
+{
+	auto start = std::chrono::steady_clock::now();
+	batches.clear();
+	size_t indexCount = 0;
+	for (uint32_t meshletIndex : visibleMeshlets)
+	{
+		const Meshlet& meshlet = meshletData.meshlets[meshletIndex];
+		// メッシュレットはマテリアルの順に並んでいるので、続いている間は同じ描画単位にまとめる
+		if (batches.empty() || batches.back().materialIndex != meshlet.materialIndex)
+		{
+			batches.push_back({ static_cast<uint32_t>(indexCount), 0, meshlet.materialIndex });
+		}
+		const uint32_t* meshletVertices = meshletData.vertices.data() + meshlet.vertexOffset;
+		const uint8_t* meshletTriangles = meshletData.triangles.data() + meshlet.triangleOffset;
+		for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i)
+		{
+			indices[indexCount++] = meshletVertices[meshletTriangles[i]];
+		}
+		batches.back().indexCount += meshlet.triangleCount * 3;
+	}
+	statistics.compactSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return indexCount;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Matrix4x4.h"
+#include "ModelData.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Visibility.h"
+
+// 1つのメッシュレットの最大頂点数と最大三角形数
+const uint32_t kMeshletMaxVertices = 64;
+const uint32_t kMeshletMaxTriangles = 124;
+
+///==========================================================
+/// メッシュレット。近くの三角形をまとめた小さな塊
+///==========================================================
+struct Meshlet
+{
+	uint32_t vertexOffset;		//!< MeshletData::verticesの先頭
+	uint32_t triangleOffset;	//!< MeshletData::triangles(3つで1三角形)の先頭
+	uint32_t vertexCount;		//!< 頂点数。kMeshletMaxVertices以下
+	uint32_t triangleCount;		//!< 三角形数。kMeshletMaxTriangles以下
+	uint32_t materialIndex;		//!< materialsの番号
+	Vector3 center;				//!< 境界球の中心(モデル空間)
+	float radius;				//!< 境界球の半径
+	Vector3 coneAxis;			//!< 法線の円錐の軸
+	float coneCutoff;			//!< 法線の円錐の広がり(sin)。1なら裏面では消せない
+};
+
+///==========================================================
+/// カリング用に境界球と法線の円錐を成分ごとに並べたもの。4個ずつ処理できるよう末尾を埋めてある
+///==========================================================
+struct MeshletCullData
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+	std::vector<float> coneAxisX;
+	std::vector<float> coneAxisY;
+	std::vector<float> coneAxisZ;
+	std::vector<float> coneCutoff;
+};
+
+///==========================================================
+/// メッシュレットの集まり
+///==========================================================
+struct MeshletData
+{
+	std::vector<Meshlet> meshlets;		//!< マテリアルの順に並ぶ
+	std::vector<uint32_t> vertices;		//!< 各メッシュレットが使う頂点の番号(ModelData::verticesを指す)
+	std::vector<uint8_t> triangles;		//!< メッシュレットの中での頂点番号。3つで1三角形
+	MeshletCullData cullData;			//!< meshletsの境界を成分ごとに並べたもの
+};
+
+// カリングの方式
+enum class MeshletCullMode
+{
+	Scalar,		// 1つずつ判定する
+	Simd,		// SSEで4つずつ判定する。結果はScalarと同じになる
+};
+
+///==========================================================
+/// カリングの統計
+///==========================================================
+struct MeshletCullStatistics
+{
+	uint32_t meshletCount;			//!< 判定したメッシュレットの数
+	uint32_t frustumCulledCount;	//!< 視錐台の外で消えた数
+	uint32_t coneCulledCount;		//!< 全ての三角形が裏を向いていて消えた数
+	uint32_t visibleCount;			//!< 残った数
+	uint32_t visibleTriangleCount;	//!< 残った三角形数
+	double cullSeconds;				//!< 判定にかかった時間
+	double compactSeconds;			//!< Indexを詰めるのにかかった時間
+};
+
+// batchesの範囲ごとに三角形を順番に詰めてメッシュレットを作る
+MeshletData BuildMeshlets(const std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices, const std::vector<MaterialBatch>& batches);
+
+// 視錐台とカメラの位置(モデル空間)でメッシュレットを判定し、残ったものの番号をvisibleMeshletsに入れる
+void CullMeshlets(const MeshletData& meshletData, const Vector4 planes[6], const Vector3& cameraPosition, MeshletCullMode mode, std::vector<uint32_t>& visibleMeshlets, MeshletCullStatistics& statistics);
+
+// 残ったメッシュレットの三角形をindicesに詰め、マテリアルごとの描画単位をbatchesに入れる。書いたIndex数を返す
+// indicesには元の三角形数分の領域が必要。かかった時間はstatistics.compactSecondsに入る
+size_t CompactMeshletIndices(const MeshletData& meshletData, const std::vector<uint32_t>& visibleMeshlets, uint32_t* indices, std::vector<MaterialBatch>& batches, MeshletCullStatistics& statistics);
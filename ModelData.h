@@ -1,4 +1,52 @@
 #pragma once
+#include <cstdint>
+#include <string>
 #include <vector>
+#include "BoundingVolume.h"
+#include "Vector4.h"
 #include "VertexData.h"
 
+///==========================================================
+/// マテリアルデータ
+///==========================================================
+struct MaterialData
+{
+	std::string name;				// newmtlの名前
+	std::string textureFilePath;	// map_Kdのパス。無ければ空
+};
+
+///==========================================================
+/// サブメッシュ。o/g/usemtlで区切られたIndexの範囲
+///==========================================================
+struct SubmeshData
+{
+	std::string name;				// o/gの名前
+	uint32_t indexStart;			// 最初のIndexの位置
+	uint32_t indexCount;			// Index数
+	uint32_t materialIndex;			// materialsの番号
+	BoundingVolume bounds;			// このサブメッシュの三角形が使う頂点の境界
+};
+
+///==========================================================
+/// 同じマテリアルのサブメッシュをまとめた描画単位
+///==========================================================
+struct MaterialBatch
+{
+	uint32_t indexStart;			// 最初のIndexの位置
+	uint32_t indexCount;			// Index数
+	uint32_t materialIndex;			// materialsの番号
+};
+
+///==========================================================
+/// モデルデータ
+///==========================================================
+struct ModelData
+{
+	std::vector<VertexData> vertices;	// 重複を除いた頂点
+	std::vector<Vector4> tangents;		// 頂点ごとの接線。xyzが接線、wが従法線の向き(±1)。verticesと同じ数
+	std::vector<uint32_t> indices;		// 三角形リストのIndex。同じマテリアルのサブメッシュが連続するように並ぶ
+	std::vector<SubmeshData> submeshes;	// サブメッシュ。同じマテリアルのものが隣り合う
+	std::vector<MaterialBatch> batches;	// マテリアルごとの描画単位。1マテリアルにつき1回の描画で済む
+	std::vector<MaterialData> materials;	// マテリアル。最低1つはある
+	BoundingVolume bounds;					// 全ての頂点の境界
+};
@@ -0,0 +1,1653 @@
+#include "ModelLoader.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshTangentSpace.h"
+#include "MonotonicArena.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+	// 並列読み込みで1チャンクあたりの最小サイズ(byte)
+	const size_t kMinParallelChunkSize = 1 << 20;
+	// vtが無い面の頂点のObjIndexTriple::texcoord
+	const uint32_t kObjMissingTexcoord = UINT32_MAX;
+	// vnが無い面の頂点のObjIndexTriple::normalに立てるbit。残りのbitには平滑化グループを入れる
+	const uint32_t kObjGeneratedNormalBit = 0x80000000u;
+	// s offの面に立てるbit。残りのbitには面の番号を入れ、他の面と頂点を共有しないようにする
+	const uint32_t kObjFlatNormalBit = 0x40000000u;
+	// sが出てくる前の平滑化グループ。法線が無ければ全体を滑らかにつなぐ
+	const uint32_t kObjDefaultSmoothingGroup = UINT32_MAX;
+
+	// 空白(改行以外)かどうか
+	bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// 空白を読み飛ばす
+	const char* SkipBlanks(const char* p, const char* end)
+	{
+		while (p < end && IsBlank(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	// 次の行の先頭を返す
+	const char* NextLine(const char* p, const char* end)
+	{
+		const char* newLine = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		return newLine ? newLine + 1 : end;
+	}
+
+	// 空白区切りのトークンを1つ切り出す。コピーはせずファイル上の範囲を指す
+	std::string_view ReadToken(const char*& p, const char* end)
+	{
+		p = SkipBlanks(p, end);
+		const char* begin = p;
+		while (p < end && !IsBlank(*p) && *p != '\n')
+		{
+			++p;
+		}
+		return std::string_view(begin, p - begin);
+	}
+
+	// 実数を1つ読む
+	float ReadFloat(const char*& p, const char* end)
+	{
+		p = SkipBlanks(p, end);
+		// from_charsは先頭の'+'を受け付けないので読み飛ばす
+		if (p < end && *p == '+')
+		{
+			++p;
+		}
+		float value = 0.0f;
+		auto [ptr, ec] = std::from_chars(p, end, value);
+		assert(ec == std::errc());
+		p = ptr;
+		return value;
+	}
+
+	// vnが無い面の頂点のObjIndexTriple::normalを作る。s off(0)なら面ごとに別の頂点になるよう面の番号を入れる
+	uint32_t EncodeGeneratedNormal(uint32_t smoothingGroup, size_t faceIndex)
+	{
+		const uint32_t kPayloadMask = ~(kObjGeneratedNormalBit | kObjFlatNormalBit);
+		if (smoothingGroup == 0)
+		{
+			return kObjGeneratedNormalBit | kObjFlatNormalBit | (static_cast<uint32_t>(faceIndex) & kPayloadMask);
+		}
+		return kObjGeneratedNormalBit | (smoothingGroup == kObjDefaultSmoothingGroup ? 0 : smoothingGroup & kPayloadMask);
+	}
+
+	// sの行の平滑化グループを読む。offは0
+	uint32_t ParseSmoothingGroup(std::string_view token)
+	{
+		uint32_t group = 0;
+		if (token != "off")
+		{
+			std::from_chars(token.data(), token.data() + token.size(), group);
+		}
+		return group;
+	}
+
+	// 頂点を構成する要素の番号(0始まり)
+	struct ObjIndexTriple
+	{
+		uint32_t position;
+		uint32_t texcoord;
+		uint32_t normal;
+		bool operator==(const ObjIndexTriple& other) const = default;
+	};
+
+	// ObjIndexTripleのハッシュ
+	struct ObjIndexTripleHash
+	{
+		size_t operator()(const ObjIndexTriple& triple) const
+		{
+			uint64_t hash = triple.position * 0x9E3779B97F4A7C15ull;
+			hash = (hash ^ (hash >> 29) ^ triple.texcoord) * 0xBF58476D1CE4E5B9ull;
+			hash = (hash ^ (hash >> 31) ^ triple.normal) * 0x94D049BB133111EBull;
+			return static_cast<size_t>(hash ^ (hash >> 32));
+		}
+	};
+
+	// 要素の組み合わせから、出力済みの頂点のIndexを引く表
+	using VertexIndexMap = std::unordered_map<ObjIndexTriple, uint32_t, ObjIndexTripleHash>;
+
+	// 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
+	// UVが無ければ(0,0)、法線が無ければ0にしておき、後で面から作る
+	VertexData MakeVertex(const ObjIndexTriple& triple, const Vector4* positions, const Vector2* texcoords, const Vector3* normals)
+	{
+		Vector4 position = positions[triple.position];
+		Vector2 texcoord = triple.texcoord != kObjMissingTexcoord ? texcoords[triple.texcoord] : Vector2{ 0.0f, 1.0f };
+		Vector3 normal = (triple.normal & kObjGeneratedNormalBit) == 0 ? normals[triple.normal] : Vector3{};
+		position.x *= -1;
+		texcoord.y = 1.0f - texcoord.y;
+		normal.x *= -1;
+		return { position,texcoord,normal };
+	}
+
+	// 面の頂点を1つ追加する。同じ要素の組み合わせの頂点が既にあればそれを参照する
+	void AddVertex(ModelData& modelData, VertexIndexMap& vertexIndices, const ObjIndexTriple& triple,
+		const std::vector<Vector4>& positions, const std::vector<Vector2>& texcoords, const std::vector<Vector3>& normals)
+	{
+		auto [it, inserted] = vertexIndices.try_emplace(triple, static_cast<uint32_t>(modelData.vertices.size()));
+		if (inserted)
+		{
+			modelData.vertices.push_back(MakeVertex(triple, positions.data(), texcoords.data(), normals.data()));
+		}
+		modelData.indices.push_back(it->second);
+	}
+
+	// 表から頂点ごとの要素の組み合わせを取り出す
+	std::vector<ObjIndexTriple> CollectVertexTriples(const VertexIndexMap& vertexIndices, size_t vertexCount)
+	{
+		std::vector<ObjIndexTriple> vertexTriples(vertexCount);
+		for (const auto& [triple, vertexIndex] : vertexIndices)
+		{
+			vertexTriples[vertexIndex] = triple;
+		}
+		return vertexTriples;
+	}
+
+	// 法線が無かった頂点に平滑化の番号を振る。元の位置と平滑化グループが同じ頂点は同じ番号になる
+	// 法線があった頂点はkKeepVertexNormal。法線が無い頂点が1つも無ければ空を返す
+	std::vector<uint32_t> AssignSmoothingIds(const ObjIndexTriple* vertexTriples, size_t vertexCount)
+	{
+		//1. 法線が無かった頂点を「平滑化グループ, 位置の番号」のキーで並べる
+		auto makeKey = [&](uint32_t vertex) { return (uint64_t(vertexTriples[vertex].normal) << 32) | vertexTriples[vertex].position; };
+		// 先に数えて1回で確保する。push_backで伸ばすと頂点数に応じて確保の回数が増える
+		size_t generatedCount = 0;
+		for (uint32_t i = 0; i < vertexCount; ++i)
+		{
+			generatedCount += (vertexTriples[i].normal & kObjGeneratedNormalBit) ? 1 : 0;
+		}
+		if (generatedCount == 0)
+		{
+			return {};
+		}
+		std::vector<uint32_t> order;
+		order.reserve(generatedCount);
+		for (uint32_t i = 0; i < vertexCount; ++i)
+		{
+			if (vertexTriples[i].normal & kObjGeneratedNormalBit)
+			{
+				order.push_back(i);
+			}
+		}
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+			{
+				uint64_t keyA = makeKey(a);
+				uint64_t keyB = makeKey(b);
+				return keyA != keyB ? keyA < keyB : a < b;
+			});
+
+		//2. キーが変わるたびに次の番号にする。表を使わないので頂点ごとの確保が起きない
+		std::vector<uint32_t> smoothingIds(vertexCount, kKeepVertexNormal);
+		uint32_t id = 0;
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			if (i != 0 && makeKey(order[i]) != makeKey(order[i - 1]))
+			{
+				++id;
+			}
+			smoothingIds[order[i]] = id;
+		}
+		return smoothingIds;
+	}
+
+	// 法線が無かった頂点の法線を作り、全ての頂点の接線を作る。vertexTriplesは頂点ごとの要素の組み合わせ
+	void GenerateVertexAttributes(ModelData& modelData, const ObjIndexTriple* vertexTriples, JobSystem* jobSystem)
+	{
+		std::vector<uint32_t> smoothingIds = AssignSmoothingIds(vertexTriples, modelData.vertices.size());
+		if (!smoothingIds.empty())
+		{
+			GenerateNormals(modelData.vertices, modelData.indices, smoothingIds, NormalWeighting::Angle, jobSystem);
+		}
+		modelData.tangents = GenerateTangents(modelData.vertices, modelData.indices, jobSystem);
+	}
+
+	// サブメッシュの区切り(o/g/usemtl)
+	struct ObjSubmeshMarker
+	{
+		size_t cornerStart;		// この区切り以降の面の頂点の位置
+		bool isMaterial;		// trueならusemtl、falseならo/g
+		std::string name;		// オブジェクト名かマテリアル名
+	};
+
+	// mtllibで指定されたファイルを順に読み、マテリアルを集める
+	void LoadMaterials(ModelData& modelData, const std::string& directoryPath, const std::vector<std::string>& materialLibraries)
+	{
+		for (const std::string& materialFilename : materialLibraries)
+		{
+			// 基本的にobjファイルと同一改装にmtlは存在させるので、ディレクトリ名とファイル名を渡す
+			std::vector<MaterialData> materials = LoadMaterialTemplateFile(directoryPath, materialFilename);
+			modelData.materials.insert(modelData.materials.end(), materials.begin(), materials.end());
+		}
+		// マテリアルが無い場合もサブメッシュが参照できるように空のものを1つ置く
+		if (modelData.materials.empty())
+		{
+			modelData.materials.push_back(MaterialData{});
+		}
+	}
+
+	// 区切りからサブメッシュを作り、同じマテリアルのサブメッシュが連続するようにIndexを並べ替える
+	void BuildSubmeshes(ModelData& modelData, const std::vector<ObjSubmeshMarker>& markers)
+	{
+		//1. マテリアル名から番号を引けるようにする
+		std::unordered_map<std::string, uint32_t> materialIndices;
+		for (uint32_t i = 0; i < modelData.materials.size(); ++i)
+		{
+			materialIndices.try_emplace(modelData.materials[i].name, i);
+		}
+
+		//2. 区切りごとにIndexの範囲を切り出す
+		std::vector<SubmeshData> submeshes;
+		std::string objectName;
+		uint32_t materialIndex = 0;
+		size_t start = 0;
+		auto closeSubmesh = [&](size_t end)
+			{
+				if (end > start)
+				{
+					submeshes.push_back({ objectName, static_cast<uint32_t>(start), static_cast<uint32_t>(end - start), materialIndex, {} });
+				}
+				start = end;
+			};
+		for (const ObjSubmeshMarker& marker : markers)
+		{
+			closeSubmesh(marker.cornerStart);
+			if (marker.isMaterial)
+			{
+				// 知らないマテリアルは先頭のものにしておく
+				auto it = materialIndices.find(marker.name);
+				materialIndex = it != materialIndices.end() ? it->second : 0;
+			}
+			else
+			{
+				objectName = marker.name;
+			}
+		}
+		closeSubmesh(modelData.indices.size());
+
+		//3. マテリアルが最初に出てきた順で、同じマテリアルのサブメッシュを隣り合わせる
+		std::vector<uint32_t> materialOrder(modelData.materials.size(), UINT32_MAX);
+		uint32_t nextOrder = 0;
+		for (const SubmeshData& submesh : submeshes)
+		{
+			if (materialOrder[submesh.materialIndex] == UINT32_MAX)
+			{
+				materialOrder[submesh.materialIndex] = nextOrder++;
+			}
+		}
+		std::stable_sort(submeshes.begin(), submeshes.end(), [&](const SubmeshData& a, const SubmeshData& b)
+			{
+				return materialOrder[a.materialIndex] < materialOrder[b.materialIndex];
+			});
+
+		//4. 並べ替えた順にIndexを詰め直す。ファイルの順のままならIndexはそのまま使えるので、コピーも確保もしない
+		bool inFileOrder = true;
+		for (size_t i = 1; i < submeshes.size(); ++i)
+		{
+			inFileOrder &= submeshes[i - 1].indexStart < submeshes[i].indexStart;
+		}
+		if (!inFileOrder)
+		{
+			std::vector<uint32_t> indices;
+			indices.reserve(modelData.indices.size());
+			for (SubmeshData& submesh : submeshes)
+			{
+				uint32_t newStart = static_cast<uint32_t>(indices.size());
+				indices.insert(indices.end(), modelData.indices.begin() + submesh.indexStart, modelData.indices.begin() + submesh.indexStart + submesh.indexCount);
+				submesh.indexStart = newStart;
+			}
+			modelData.indices = std::move(indices);
+		}
+		modelData.submeshes = std::move(submeshes);
+		BuildMaterialBatches(modelData);
+		ComputeModelBounds(modelData);
+	}
+
+	// 従来の方式でObjファイルを読み込む
+	ModelData LoadObjFileStream(const std::string& directoryPath, const std::string& filename)
+	{
+		//1. 中で必要なる変数の宣言
+		ModelData modelData;				// 構築するModelData
+		std::vector<Vector4> positions;		// 位置
+		std::vector<Vector3> normals;		// 法線
+		std::vector<Vector2> texcoords;		// テクスチャ座標
+		std::string line;					// ファイルから読んだ1行を格納するもの
+		VertexIndexMap vertexIndices;		// 出力済みの頂点
+		std::vector<ObjSubmeshMarker> markers;		// サブメッシュの区切り
+		std::vector<std::string> materialLibraries;	// mtlファイル名
+		uint32_t smoothingGroup = kObjDefaultSmoothingGroup;	// 今の平滑化グループ
+
+		//2. ファイルを開く
+		std::ifstream file(directoryPath + "/" + filename);		// ファイルを開く
+		assert(file.is_open());									// 開けなかったら止める
+
+		//3. 実際にファイルを読み、ModelDataを構築していく_頂点情報を読む
+		while (std::getline(file, line))
+		{
+			std::string identifier;
+			std::stringstream s(line);
+			s >> identifier;			// 先頭の識別子を読む
+
+			// identifierに応じた処理
+			if (identifier == "v")
+			{
+				Vector4 position{};
+				s >> position.x >> position.y >> position.z;
+				position.w = 1.0f;
+				positions.push_back(position);
+			}
+			else if (identifier == "vt")
+			{
+				Vector2 texcoord{};
+				s >> texcoord.x >> texcoord.y;
+				texcoords.push_back(texcoord);
+			}
+			else if (identifier == "vn")
+			{
+				Vector3 normal{};
+				s >> normal.x >> normal.y >> normal.z;
+				normals.push_back(normal);
+			}
+			else if (identifier == "f")
+			{
+				ObjIndexTriple triangle[3]{};
+				// 三角形限定。その他は未対応
+				for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex)
+				{
+					std::string vertexDefinition;
+					s >> vertexDefinition;
+					// 頂点の要素へのIndexは「位置/UV/法線」で格納されているので、分解してIndexを取得する
+					// UVと法線は省略されることがある(「位置」「位置/UV」「位置//法線」)。省略された要素は0のままにする
+					std::istringstream v(vertexDefinition);
+					uint32_t elementIndieces[3]{};
+					for (int32_t element = 0; element < 3; ++element)
+					{
+						std::string index;
+						std::getline(v, index, '/');	// 区切りでインデックスを読んでいく
+						elementIndieces[element] = index.empty() ? 0 : std::stoi(index);
+					}
+					size_t faceIndex = modelData.indices.size() / 3;
+					triangle[faceVertex] = { elementIndieces[0] - 1,
+						elementIndieces[1] != 0 ? elementIndieces[1] - 1 : kObjMissingTexcoord,
+						elementIndieces[2] != 0 ? elementIndieces[2] - 1 : EncodeGeneratedNormal(smoothingGroup, faceIndex) };
+				}
+				// 巻き順を反転して追加する
+				AddVertex(modelData, vertexIndices, triangle[2], positions, texcoords, normals);
+				AddVertex(modelData, vertexIndices, triangle[1], positions, texcoords, normals);
+				AddVertex(modelData, vertexIndices, triangle[0], positions, texcoords, normals);
+			}
+			else if (identifier == "s")
+			{
+				// 平滑化グループ。法線が無い面の法線を作るときに使う
+				std::string group;
+				s >> group;
+				smoothingGroup = ParseSmoothingGroup(group);
+			}
+			else if (identifier == "mtllib")
+			{
+				// materialTemplateLibraryファイル名を取得
+				std::string materialFilename;
+				s >> materialFilename;
+				materialLibraries.push_back(materialFilename);
+			}
+			else if (identifier == "o" || identifier == "g" || identifier == "usemtl")
+			{
+				// ここから新しいサブメッシュになる
+				std::string name;
+				s >> name;
+				markers.push_back({ modelData.indices.size(), identifier == "usemtl", name });
+			}
+		}
+
+		//4. 法線と接線を作り、マテリアルを読み、サブメッシュを作る
+		GenerateVertexAttributes(modelData, CollectVertexTriples(vertexIndices, modelData.vertices.size()).data(), nullptr);
+		LoadMaterials(modelData, directoryPath, materialLibraries);
+		BuildSubmeshes(modelData, markers);
+
+		//4. ModelDataを返す
+		return modelData;
+	}
+
+	///==========================================================
+	/// Objの要素の数
+	///==========================================================
+	struct ObjElementCounts
+	{
+		size_t positionCount;	//!< 位置(v)の数
+		size_t texcoordCount;	//!< UV(vt)の数
+		size_t normalCount;		//!< 法線(vn)の数
+		size_t cornerCount;		//!< 面の頂点の数(面の数 * 3)
+	};
+
+	// 面の頂点の要素番号を読み、全体での0始まりの番号にする
+	// 負の値は相対指定で、definedCount(その行までに出てきた要素の数)から数える。elementCountは範囲の確認に使う
+	uint32_t ReadFaceIndex(const char*& p, const char* end, size_t definedCount, size_t elementCount)
+	{
+		int32_t value = 0;
+		auto [ptr, ec] = std::from_chars(p, end, value);
+		assert(ec == std::errc());
+		assert(value != 0);
+		p = ptr;
+		int64_t resolved = value < 0 ? static_cast<int64_t>(definedCount) + value : static_cast<int64_t>(value) - 1;
+		assert(resolved >= 0 && static_cast<size_t>(resolved) < elementCount);
+		(void)elementCount;
+		return static_cast<uint32_t>(resolved);
+	}
+
+	// 面の頂点を1つ読む。「位置」「位置/UV」「位置//法線」「位置/UV/法線」のどれか
+	// 省略されたUVはkObjMissingTexcoord、法線は平滑化グループから作った印にする
+	ObjIndexTriple ReadFaceCorner(const char*& p, const char* end, const ObjElementCounts& defined, const ObjElementCounts& limit,
+		uint32_t smoothingGroup, size_t faceIndex)
+	{
+		p = SkipBlanks(p, end);
+		ObjIndexTriple triple{};
+		triple.position = ReadFaceIndex(p, end, defined.positionCount, limit.positionCount);
+		triple.texcoord = kObjMissingTexcoord;
+		triple.normal = EncodeGeneratedNormal(smoothingGroup, faceIndex);
+		if (p < end && *p == '/')
+		{
+			++p;
+			if (p < end && *p != '/')
+			{
+				triple.texcoord = ReadFaceIndex(p, end, defined.texcoordCount, limit.texcoordCount);
+			}
+			if (p < end && *p == '/')
+			{
+				++p;
+				triple.normal = ReadFaceIndex(p, end, defined.normalCount, limit.normalCount);
+			}
+		}
+		return triple;
+	}
+
+	///==========================================================
+	/// ファイルの一部分。1回目の走査で要素を数え、2回目の走査で全体の配列の自分の位置に書き込む
+	///==========================================================
+	struct ObjChunk
+	{
+		const char* begin;				//!< 担当する範囲の先頭(行の先頭)
+		const char* end;				//!< 担当する範囲の終わり
+		ObjElementCounts counts;		//!< このチャンクの要素の数
+		ObjElementCounts offsets;		//!< 前のチャンクまでの要素の数。書き込む位置と相対指定の基準になる
+		uint32_t smoothingGroup;		//!< このチャンクの先頭での平滑化グループ
+		uint32_t lastSmoothingGroup;	//!< このチャンクで最後に出てきたsの平滑化グループ
+		bool hasSmoothingGroup;			//!< このチャンクにsがあったか
+		std::vector<ObjSubmeshMarker> markers;				//!< サブメッシュの区切り。cornerStartは全体での位置
+		std::vector<std::string_view> materialLibraries;	//!< mtllibで指定されたファイル名
+	};
+
+	///==========================================================
+	/// 全体の要素の配列。アリーナから切り出す
+	///==========================================================
+	struct ObjElements
+	{
+		Vector4* positions;			//!< 位置
+		Vector2* texcoords;			//!< テクスチャ座標
+		Vector3* normals;			//!< 法線
+		ObjIndexTriple* corners;	//!< 面の頂点。巻き順を反転した順に3つずつ並ぶ
+		ObjElementCounts counts;	//!< 全体の要素の数
+	};
+
+	// 1回目の走査。chunkの行を種類ごとに数えるだけで、値は読まない
+	void CountObjChunk(ObjChunk& chunk)
+	{
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+		while (p < end)
+		{
+			std::string_view identifier = ReadToken(p, end);
+			if (identifier == "v")
+			{
+				++chunk.counts.positionCount;
+			}
+			else if (identifier == "vt")
+			{
+				++chunk.counts.texcoordCount;
+			}
+			else if (identifier == "vn")
+			{
+				++chunk.counts.normalCount;
+			}
+			else if (identifier == "f")
+			{
+				chunk.counts.cornerCount += 3;
+			}
+			else if (identifier == "s")
+			{
+				// 次のチャンクの先頭での平滑化グループを決めるのに使う
+				chunk.lastSmoothingGroup = ParseSmoothingGroup(ReadToken(p, end));
+				chunk.hasSmoothingGroup = true;
+			}
+			p = NextLine(p, end);
+		}
+	}
+
+	// 2回目の走査。chunkの行を字句解析してelementsの自分の位置に書き込む。行ごとのヒープ確保はしない
+	void ParseObjChunk(ObjChunk& chunk, ObjElements& elements)
+	{
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+		ObjElementCounts defined = chunk.offsets;	// この行までに出てきた要素の数
+		uint32_t smoothingGroup = chunk.smoothingGroup;
+		while (p < end)
+		{
+			std::string_view identifier = ReadToken(p, end);
+
+			if (identifier == "v")
+			{
+				Vector4& position = elements.positions[defined.positionCount++];
+				position.x = ReadFloat(p, end);
+				position.y = ReadFloat(p, end);
+				position.z = ReadFloat(p, end);
+				position.w = 1.0f;
+			}
+			else if (identifier == "vt")
+			{
+				Vector2& texcoord = elements.texcoords[defined.texcoordCount++];
+				texcoord.x = ReadFloat(p, end);
+				texcoord.y = ReadFloat(p, end);
+			}
+			else if (identifier == "vn")
+			{
+				Vector3& normal = elements.normals[defined.normalCount++];
+				normal.x = ReadFloat(p, end);
+				normal.y = ReadFloat(p, end);
+				normal.z = ReadFloat(p, end);
+			}
+			else if (identifier == "f")
+			{
+				// 三角形限定。その他は未対応
+				ObjIndexTriple triangle[3];
+				size_t faceIndex = defined.cornerCount / 3;
+				for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex)
+				{
+					triangle[faceVertex] = ReadFaceCorner(p, end, defined, elements.counts, smoothingGroup, faceIndex);
+				}
+				// 巻き順を反転して書き込む
+				elements.corners[defined.cornerCount++] = triangle[2];
+				elements.corners[defined.cornerCount++] = triangle[1];
+				elements.corners[defined.cornerCount++] = triangle[0];
+			}
+			else if (identifier == "s")
+			{
+				smoothingGroup = ParseSmoothingGroup(ReadToken(p, end));
+			}
+			else if (identifier == "mtllib")
+			{
+				chunk.materialLibraries.push_back(ReadToken(p, end));
+			}
+			else if (identifier == "o" || identifier == "g" || identifier == "usemtl")
+			{
+				// ここから新しいサブメッシュになる。行数が少ないので名前はコピーしてしまう
+				chunk.markers.push_back({ defined.cornerCount, identifier == "usemtl", std::string(ReadToken(p, end)) });
+			}
+
+			// 残りは読み飛ばして次の行へ
+			p = NextLine(p, end);
+		}
+		assert(defined.positionCount == chunk.offsets.positionCount + chunk.counts.positionCount);
+		assert(defined.cornerCount == chunk.offsets.cornerCount + chunk.counts.cornerCount);
+	}
+
+	// [0, chunkCount)のチャンクにfuncを実行する。jobSystemがあれば並列に実行する
+	template <typename Func>
+	void ForEachChunk(JobSystem* jobSystem, size_t chunkCount, const Func& func)
+	{
+		if (jobSystem)
+		{
+			jobSystem->ParallelFor(chunkCount, chunkCount, [&](size_t chunkIndex, size_t, size_t) { func(chunkIndex); });
+			return;
+		}
+		for (size_t i = 0; i < chunkCount; ++i)
+		{
+			func(i);
+		}
+	}
+
+	// 分割したチャンクを2回走査してModelDataを構築する
+	// 1回目で要素を数えてから全体の配列をまとめて確保し、2回目で各チャンクが自分の位置に直接書き込むので、
+	// 要素の配列が伸びるときのコピーもチャンクの結果を連結するコピーも起きない。分割の仕方によらず結果は同じになる
+	ModelData BuildModelData(const std::string& directoryPath, std::vector<ObjChunk>& chunks, JobSystem* jobSystem)
+	{
+		ModelData modelData;
+		size_t chunkCount = chunks.size();
+
+		//1. 各チャンクの要素を数える
+		ForEachChunk(jobSystem, chunkCount, [&](size_t chunkIndex) { CountObjChunk(chunks[chunkIndex]); });
+
+		//2. 要素数のprefix sumで書き込む位置を決め、各チャンクの先頭での平滑化グループを前のチャンクから引き継ぐ
+		ObjElementCounts total{};
+		uint32_t smoothingGroup = kObjDefaultSmoothingGroup;
+		for (ObjChunk& chunk : chunks)
+		{
+			chunk.offsets = total;
+			chunk.smoothingGroup = smoothingGroup;
+			total.positionCount += chunk.counts.positionCount;
+			total.texcoordCount += chunk.counts.texcoordCount;
+			total.normalCount += chunk.counts.normalCount;
+			total.cornerCount += chunk.counts.cornerCount;
+			smoothingGroup = chunk.hasSmoothingGroup ? chunk.lastSmoothingGroup : smoothingGroup;
+		}
+
+		//3. 読み込み中だけ使う配列を1つのアリーナにまとめて確保する。数え終わっているので必要な量がちょうどわかる
+		// 重複除去の表は面の頂点の数の2倍以上の2の累乗にして、全ての頂点が別々でも半分までしか埋まらないようにする
+		size_t tableSize = 16;
+		while (tableSize < total.cornerCount * 2)
+		{
+			tableSize *= 2;
+		}
+		size_t arenaSize = sizeof(Vector4) * total.positionCount + sizeof(Vector2) * total.texcoordCount + sizeof(Vector3) * total.normalCount
+			+ sizeof(ObjIndexTriple) * total.cornerCount * 2 + sizeof(uint32_t) * tableSize + alignof(std::max_align_t) * 6;
+		MonotonicArena arena(arenaSize);
+		ObjElements elements{};
+		elements.positions = arena.AllocateArray<Vector4>(total.positionCount);
+		elements.texcoords = arena.AllocateArray<Vector2>(total.texcoordCount);
+		elements.normals = arena.AllocateArray<Vector3>(total.normalCount);
+		elements.corners = arena.AllocateArray<ObjIndexTriple>(total.cornerCount);
+		elements.counts = total;
+
+		//4. 各チャンクを読む
+		ForEachChunk(jobSystem, chunkCount, [&](size_t chunkIndex) { ParseObjChunk(chunks[chunkIndex], elements); });
+
+		//5. 同じ要素の組み合わせの頂点をまとめてIndexを振る。出現順に振るので分割の仕方によらず結果は同じになる
+		// 表には頂点の番号だけを入れ、要素の組み合わせはvertexTriplesから引く(線形探索のオープンアドレス)
+		uint32_t* table = arena.AllocateArray<uint32_t>(tableSize);
+		std::fill(table, table + tableSize, UINT32_MAX);
+		ObjIndexTriple* vertexTriples = arena.AllocateArray<ObjIndexTriple>(total.cornerCount);
+		uint32_t vertexCount = 0;
+		size_t tableMask = tableSize - 1;
+		ObjIndexTripleHash hash;
+		modelData.indices.resize(total.cornerCount);
+		for (size_t corner = 0; corner < total.cornerCount; ++corner)
+		{
+			const ObjIndexTriple& triple = elements.corners[corner];
+			size_t slot = hash(triple) & tableMask;
+			while (table[slot] != UINT32_MAX && !(vertexTriples[table[slot]] == triple))
+			{
+				slot = (slot + 1) & tableMask;
+			}
+			if (table[slot] == UINT32_MAX)
+			{
+				table[slot] = vertexCount;
+				vertexTriples[vertexCount++] = triple;
+			}
+			modelData.indices[corner] = table[slot];
+		}
+
+		//6. 頂点の数がわかったので出力を1回で確保し、要素の値から頂点を作る。その後で法線と接線を作る
+		modelData.vertices.resize(vertexCount);
+		auto makeVertices = [&](size_t, size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					modelData.vertices[i] = MakeVertex(vertexTriples[i], elements.positions, elements.texcoords, elements.normals);
+				}
+			};
+		if (jobSystem)
+		{
+			jobSystem->ParallelFor(vertexCount, (jobSystem->GetThreadCount() + 1) * 4, makeVertices);
+		}
+		else
+		{
+			makeVertices(0, 0, vertexCount);
+		}
+		GenerateVertexAttributes(modelData, vertexTriples, jobSystem);
+
+		//7. 区切りを集め、マテリアルを読んでサブメッシュを作る
+		std::vector<ObjSubmeshMarker> markers;
+		std::vector<std::string> materialLibraries;
+		for (ObjChunk& chunk : chunks)
+		{
+			for (ObjSubmeshMarker& marker : chunk.markers)
+			{
+				markers.push_back(std::move(marker));
+			}
+			materialLibraries.insert(materialLibraries.end(), chunk.materialLibraries.begin(), chunk.materialLibraries.end());
+		}
+		LoadMaterials(modelData, directoryPath, materialLibraries);
+		BuildSubmeshes(modelData, markers);
+		return modelData;
+	}
+
+	// ファイルをメモリマップし、行ごとのヒープ確保をせずにその場で字句解析して読み込む
+	ModelData LoadObjFileMapped(const std::string& directoryPath, const std::string& filename)
+	{
+		MappedFile file(directoryPath + "/" + filename);
+		assert(file.IsOpen());				// 開けなかったら止める
+
+		std::vector<ObjChunk> chunks(1);
+		chunks[0].begin = file.GetData();
+		chunks[0].end = file.GetData() + file.GetSize();
+		return BuildModelData(directoryPath, chunks, nullptr);
+	}
+
+	// ファイルを行の境界で分割し、ワーカースレッドで並列に読み込む
+	ModelData LoadObjFileParallel(const std::string& directoryPath, const std::string& filename)
+	{
+		MappedFile file(directoryPath + "/" + filename);
+		assert(file.IsOpen());				// 開けなかったら止める
+		const char* data = file.GetData();
+		size_t size = file.GetSize();
+
+		//1. スレッド数の数倍に分割して、偏りが出てもワーカーが遊ばないようにする
+		JobSystem* jobSystem = JobSystem::GetInstance();
+		size_t chunkCount = std::min<size_t>((jobSystem->GetThreadCount() + 1) * 4, size / kMinParallelChunkSize + 1);
+
+		//2. 分割位置を次の行の先頭まで進める
+		std::vector<ObjChunk> chunks(chunkCount);
+		chunks[0].begin = data;
+		chunks[chunkCount - 1].end = data + size;
+		for (size_t i = 1; i < chunkCount; ++i)
+		{
+			const char* split = data + size * i / chunkCount;
+			split = split < chunks[i - 1].begin ? chunks[i - 1].begin : split;
+			chunks[i].begin = split == data ? data : NextLine(split - 1, data + size);
+			chunks[i - 1].end = chunks[i].begin;
+		}
+
+		//3. 各チャンクを並列に2回走査して連結する
+		return BuildModelData(directoryPath, chunks, jobSystem);
+	}
+
+	// ストリーミング読み込みで1回に読む窓の最小・最大サイズ(byte)
+	const size_t kMinStreamWindowSize = 64 * 1024;
+	const size_t kMaxStreamWindowSize = 4 * 1024 * 1024;
+	// 一時ファイルを読み書きするブロックの最小・最大サイズ(byte)。その間はメモリの上限に比例させる
+	const size_t kMinSpillBlockSize = 4 * 1024;
+	const size_t kMaxSpillBlockSize = 4 * 1024 * 1024;
+	// メモリの上限のうち、読み込みのバッファ以外に取っておく分(byte)
+	// ファイルのバッファ、一時ファイルの名前、マテリアル、初めて動かすコードのページなど、上限に比例しない分をまとめて見込む
+	const size_t kStreamReservedMemorySize = 256 * 1024;
+	// シンクに渡すまとまりの頂点の最大数。16bitのIndexに収まるようにする
+	const size_t kMaxStreamChunkVertices = 0xFFFF;
+	// 一時ファイルの面の並びでマテリアルの切り替えを表す印。positionにこの値、texcoordにマテリアルの番号を入れる
+	const uint32_t kObjMaterialMarker = UINT32_MAX;
+	// これより短い法線は向きが決まらないものとして扱う。MeshTangentSpaceと同じ値
+	const float kMinNormalLength = 1e-12f;
+
+	// 面の頂点の法線を、平滑化グループに従って周りの面から作るか。s offの面とvnのある面は作らない
+	bool IsSmoothGeneratedNormal(uint32_t normal)
+	{
+		return (normal & kObjGeneratedNormalBit) != 0 && (normal & kObjFlatNormalBit) == 0;
+	}
+
+	// 三角形の単位法線と3つの角の大きさを求める。潰れた三角形ならfalseを返す
+	// 式はGenerateNormals(NormalWeighting::Angle)と同じにして、LoadObjFileと同じ法線になるようにする
+	bool ComputeFaceNormal(const Vector3& p0, const Vector3& p1, const Vector3& p2, Vector3& normal, float* angles)
+	{
+		Vector3 e1 = Subtract(p1, p0);
+		Vector3 e2 = Subtract(p2, p0);
+		Vector3 e3 = Subtract(p2, p1);
+		Vector3 cross = Cross(e1, e2);
+		float length = std::sqrt(Dot(cross, cross));
+		if (length <= kMinNormalLength)
+		{
+			return false;
+		}
+		normal = { cross.x / length, cross.y / length, cross.z / length };
+		angles[0] = std::atan2(length, Dot(e1, e2));
+		angles[1] = std::atan2(length, -Dot(e1, e3));
+		angles[2] = std::atan2(length, Dot(e2, e3));
+		return true;
+	}
+
+	// 重み付きの法線の合計を正規化する。長さが無ければ上向きにする
+	Vector3 NormalizeNormalSum(const Vector3& sum)
+	{
+		float length = std::sqrt(Dot(sum, sum));
+		if (length <= kMinNormalLength)
+		{
+			return { 0.0f, 1.0f, 0.0f };
+		}
+		return { sum.x / length, sum.y / length, sum.z / length };
+	}
+
+	// 一時ファイルのパスを作る。同時に複数の読み込みがあっても重ならないよう、時刻と通し番号を入れる
+	std::filesystem::path MakeSpillPath(const char* name)
+	{
+		static std::atomic<uint32_t> serial = 0;
+		std::string filename = "cg_obj_stream_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_"
+			+ std::to_string(serial.fetch_add(1)) + "_" + name + ".bin";
+		return std::filesystem::temp_directory_path() / filename;
+	}
+
+	// ストリーミング読み込みで要素を書き出す一時ファイル。寿命が尽きたら削除する
+	// 読み書きは呼び出し側のブロック単位で行うので、ファイル側のバッファは使わない
+	class SpillFile
+	{
+	public:
+		explicit SpillFile(const char* name) : path_(MakeSpillPath(name))
+		{
+			file_.rdbuf()->pubsetbuf(nullptr, 0);
+			file_.open(path_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+			assert(file_.is_open());// とりあえず作れなかったら止める
+		}
+		~SpillFile()
+		{
+			file_.close();
+			std::error_code error;
+			std::filesystem::remove(path_, error);
+		}
+		SpillFile(const SpillFile&) = delete;
+		SpillFile& operator=(const SpillFile&) = delete;
+
+		// offset(byte)からsizeだけ書く
+		void Write(uint64_t offset, const void* data, size_t size)
+		{
+			file_.seekp(static_cast<std::streamoff>(offset));
+			file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			assert(file_.good());
+			size_ = std::max(size_, offset + size);
+		}
+
+		// offset(byte)からsizeだけ読む。まだ書いていないファイルの終わりより先は0で埋める
+		void Read(uint64_t offset, void* data, size_t size)
+		{
+			size_t readSize = offset < size_ ? static_cast<size_t>(std::min<uint64_t>(size, size_ - offset)) : 0;
+			if (readSize != 0)
+			{
+				file_.seekg(static_cast<std::streamoff>(offset));
+				file_.read(static_cast<char*>(data), static_cast<std::streamsize>(readSize));
+				assert(static_cast<size_t>(file_.gcount()) == readSize);
+			}
+			std::memset(static_cast<char*>(data) + readSize, 0, size - readSize);
+		}
+
+		// 書いたサイズ(byte)
+		uint64_t GetSize() const { return size_; }
+	private:
+		std::filesystem::path path_;
+		std::fstream file_;
+		uint64_t size_ = 0;
+	};
+
+	// 一時ファイルの末尾に要素を足していく。バッファがいっぱいになるたびに書き出す
+	template <typename T>
+	class SpillWriter
+	{
+	public:
+		SpillWriter(SpillFile& file, size_t bufferSize) : file_(file), buffer_(bufferSize / sizeof(T))
+		{
+			assert(!buffer_.empty() && file.GetSize() == 0);
+		}
+
+		void PushBack(const T& value)
+		{
+			if (bufferCount_ == buffer_.size())
+			{
+				Flush();
+			}
+			buffer_[bufferCount_++] = value;
+		}
+
+		// たまっている分を書き出す
+		void Flush()
+		{
+			file_.Write(writtenCount_ * sizeof(T), buffer_.data(), bufferCount_ * sizeof(T));
+			writtenCount_ += bufferCount_;
+			bufferCount_ = 0;
+		}
+
+		// 足した要素の数
+		uint64_t GetCount() const { return writtenCount_ + bufferCount_; }
+		// バッファのサイズ(byte)
+		size_t GetMemorySize() const { return buffer_.size() * sizeof(T); }
+	private:
+		SpillFile& file_;
+		std::vector<T> buffer_;
+		size_t bufferCount_ = 0;
+		uint64_t writtenCount_ = 0;
+	};
+
+	// 一時ファイルの要素の番号と、読んだ値を渡す先の番号の組
+	struct SpillRequest
+	{
+		uint32_t element;
+		uint32_t target;
+	};
+
+	// requestsを要素の番号の順に並べ、一時ファイルからblockの大きさずつ読んでfunc(target, 値)を呼ぶ
+	// 近い番号の要素は1回の読み込みでまとめて読めるので、要素ごとに読むよりずっと少ない回数で済む
+	template <typename T, typename Func>
+	void GatherSpilled(SpillFile& file, std::span<SpillRequest> requests, std::vector<char>& block, const Func& func)
+	{
+		std::sort(requests.begin(), requests.end(), [](const SpillRequest& a, const SpillRequest& b) { return a.element < b.element; });
+		const uint64_t blockElementCount = block.size() / sizeof(T);
+		uint64_t blockBegin = 0;
+		uint64_t blockEnd = 0;
+		for (const SpillRequest& request : requests)
+		{
+			if (request.element < blockBegin || request.element >= blockEnd)
+			{
+				blockBegin = request.element;
+				blockEnd = blockBegin + blockElementCount;
+				file.Read(blockBegin * sizeof(T), block.data(), blockElementCount * sizeof(T));
+			}
+			T value;
+			std::memcpy(&value, block.data() + (request.element - blockBegin) * sizeof(T), sizeof(T));
+			func(request.target, value);
+		}
+	}
+
+	///==========================================================
+	/// 法線を作るための位置ごとの集計。一時ファイルに位置の番号の順に並べる
+	///==========================================================
+	struct ObjNormalSlot
+	{
+		Vector3 sum;	//!< 角の大きさで重み付けした面の法線の合計
+		uint32_t tag;	//!< 集計している平滑化グループ(ObjIndexTriple::normal)。0ならまだ空
+	};
+
+	///==========================================================
+	/// 面の角から位置への法線の寄与
+	///==========================================================
+	struct ObjNormalContribution
+	{
+		uint32_t position;	//!< 位置の番号
+		uint32_t tag;		//!< 角の平滑化グループ(ObjIndexTriple::normal)
+		Vector3 normal;		//!< 角の大きさで重み付けした面の法線
+		uint32_t order;		//!< 並べ替えた後も同じ位置の寄与を元の順に足すための番号
+	};
+
+	// 寄与を位置の順に並べ、集計のファイルにブロックごとに読んで足して書き戻す
+	// 集計しているグループと違うグループの寄与はoverflowに回し、次の段の集計で足す
+	// 同じ位置の寄与は面の順に足すので、LoadObjFileと同じ順番で合計する
+	void AccumulateNormals(SpillFile& slots, uint64_t positionCount, std::span<ObjNormalContribution> contributions, std::vector<char>& block,
+		SpillWriter<ObjNormalContribution>& overflow)
+	{
+		for (size_t i = 0; i < contributions.size(); ++i)
+		{
+			contributions[i].order = static_cast<uint32_t>(i);
+		}
+		std::sort(contributions.begin(), contributions.end(), [](const ObjNormalContribution& a, const ObjNormalContribution& b)
+			{
+				return a.position != b.position ? a.position < b.position : a.order < b.order;
+			});
+
+		const uint64_t blockSlotCount = block.size() / sizeof(ObjNormalSlot);
+		uint64_t blockBegin = 0;
+		uint64_t blockCount = 0;
+		auto writeBack = [&]()
+			{
+				if (blockCount != 0)
+				{
+					slots.Write(blockBegin * sizeof(ObjNormalSlot), block.data(), blockCount * sizeof(ObjNormalSlot));
+				}
+			};
+		for (const ObjNormalContribution& contribution : contributions)
+		{
+			if (contribution.position < blockBegin || contribution.position >= blockBegin + blockCount)
+			{
+				writeBack();
+				blockBegin = contribution.position;
+				blockCount = std::min(blockSlotCount, positionCount - blockBegin);
+				slots.Read(blockBegin * sizeof(ObjNormalSlot), block.data(), blockCount * sizeof(ObjNormalSlot));
+			}
+			char* slotData = block.data() + (contribution.position - blockBegin) * sizeof(ObjNormalSlot);
+			ObjNormalSlot slot;
+			std::memcpy(&slot, slotData, sizeof(slot));
+			if (slot.tag == 0)
+			{
+				slot.tag = contribution.tag;
+			}
+			if (slot.tag != contribution.tag)
+			{
+				overflow.PushBack(contribution);
+				continue;
+			}
+			slot.sum = Add(slot.sum, contribution.normal);
+			std::memcpy(slotData, &slot, sizeof(slot));
+		}
+		writeBack();
+	}
+
+	///==========================================================
+	/// ストリーミング読み込み。3段階に分けて読む
+	/// 1. Objを窓ごとに読み、位置/UV/法線と面の頂点の組み合わせを一時ファイルに書き出す
+	/// 2. vnが無い面があれば、面の法線を位置ごとの集計のファイルに足し込む
+	/// 3. 面を順に読んでまとまりを作り、まとまりが使う要素だけを一時ファイルから読んでシンクに渡す
+	/// 各段階の領域は段階の初めに確保しきる。その合計がメモリの上限に収まるように窓やブロックの大きさを決める
+	///==========================================================
+	class ObjStreamReader
+	{
+	public:
+		ObjStreamReader(const std::string& directoryPath, size_t memoryBudget, const ObjStreamSink& sink)
+			: directoryPath_(directoryPath), sink_(sink)
+		{
+			result_.memoryBudget = memoryBudget;
+			bufferBudget_ = memoryBudget > kStreamReservedMemorySize ? memoryBudget - kStreamReservedMemorySize : 0;
+			blockSize_ = std::clamp(bufferBudget_ / 16, kMinSpillBlockSize, kMaxSpillBlockSize);
+		}
+
+		// 3段階を順に行って結果を返す。どこかで上限に収まらなければ、そこで打ち切る
+		ObjStreamResult Read(std::ifstream& file)
+		{
+			result_.completed = SpillElements(file) && AccumulateSmoothNormals() && EmitChunks();
+			if (result_.materials.empty())
+			{
+				result_.materials.push_back(MaterialData{});
+			}
+			result_.spillSize = positionFile_.GetSize() + texcoordFile_.GetSize() + normalFile_.GetSize() + cornerFile_.GetSize();
+			for (const std::unique_ptr<SpillFile>& level : normalLevels_)
+			{
+				result_.spillSize += level->GetSize();
+			}
+			assert(!result_.completed || result_.peakMemorySize <= result_.memoryBudget);
+			return std::move(result_);
+		}
+
+	private:
+		///==========================================================
+		/// 1段階目で要素を書き出す先
+		///==========================================================
+		struct ElementWriters
+		{
+			SpillWriter<Vector3> positions;			//!< 位置。左手系に直したもの
+			SpillWriter<Vector2> texcoords;			//!< UV。上下を反転したもの
+			SpillWriter<Vector3> normals;			//!< 法線。左手系に直したもの
+			SpillWriter<ObjIndexTriple> corners;	//!< 面の頂点の組み合わせ。面ごとに3つ、ファイルの順
+		};
+
+		// この段階で確保する領域のサイズを、取っておく分と合わせて記録する。上限を超えるならfalseを返し、確保はしない
+		bool UseMemory(size_t memorySize)
+		{
+			result_.peakMemorySize = std::max(result_.peakMemorySize, memorySize + kStreamReservedMemorySize);
+			return memorySize <= bufferBudget_;
+		}
+
+		// 1段階目。窓ごとに字句解析して要素と面を一時ファイルに書き出す
+		bool SpillElements(std::ifstream& file)
+		{
+			//1. 窓と書き出しのバッファを確保する
+			size_t windowSize = std::clamp(bufferBudget_ / 4, kMinStreamWindowSize, kMaxStreamWindowSize);
+			size_t writerSize = blockSize_ * 4;
+			if (!UseMemory(windowSize + writerSize))
+			{
+				return false;
+			}
+			std::vector<char> window(windowSize);
+			ElementWriters writers{ { positionFile_, blockSize_ }, { texcoordFile_, blockSize_ }, { normalFile_, blockSize_ }, { cornerFile_, blockSize_ } };
+
+			//2. 窓に読み込み、最後の改行までを字句解析する。行の途中の残りは次の窓の先頭に回す
+			size_t carry = 0;
+			while (true)
+			{
+				file.read(window.data() + carry, static_cast<std::streamsize>(window.size() - carry));
+				size_t readSize = static_cast<size_t>(file.gcount());
+				size_t filled = carry + readSize;
+				bool isEnd = readSize < window.size() - carry;
+				const char* begin = window.data();
+				const char* end = begin + filled;
+
+				// 行の終わりを探す。ファイルの終わりなら全部
+				const char* parseEnd = end;
+				if (!isEnd)
+				{
+					while (parseEnd > begin && parseEnd[-1] != '\n')
+					{
+						--parseEnd;
+					}
+					if (parseEnd == begin)
+					{
+						// 1行が窓に収まらないので窓を広げて読み直す。広げる間は古い窓と新しい窓が同時にある
+						if (!UseMemory(window.size() * 3 + writerSize))
+						{
+							return false;
+						}
+						std::vector<char> grownWindow(window.size() * 2);
+						std::memcpy(grownWindow.data(), window.data(), filled);
+						window.swap(grownWindow);
+						carry = filled;
+						continue;
+					}
+				}
+				ParseLines(begin, parseEnd, writers);
+				if (isEnd)
+				{
+					break;
+				}
+				carry = static_cast<size_t>(end - parseEnd);
+				std::memmove(window.data(), parseEnd, carry);
+			}
+
+			//3. 残りを書き出し、要素の数を覚えておく
+			writers.positions.Flush();
+			writers.texcoords.Flush();
+			writers.normals.Flush();
+			writers.corners.Flush();
+			positionCount_ = writers.positions.GetCount();
+			texcoordCount_ = writers.texcoords.GetCount();
+			normalCount_ = writers.normals.GetCount();
+			faceRecordCount_ = writers.corners.GetCount() / 3;
+			assert(positionCount_ < kObjMaterialMarker);
+			return true;
+		}
+
+		// [begin, end)の行を字句解析して書き出す。endは行の終わりであること
+		void ParseLines(const char* begin, const char* end, ElementWriters& writers)
+		{
+			// 相対指定はその行までの数から解決し、範囲は全て読んでから3段階目で確かめる
+			const ObjElementCounts unlimited{ kObjMaterialMarker, kObjMissingTexcoord, kObjFlatNormalBit, 0 };
+			const char* p = begin;
+			while (p < end)
+			{
+				std::string_view identifier = ReadToken(p, end);
+
+				if (identifier == "v")
+				{
+					// 位置は左手系に直して書き出す
+					Vector3 position{};
+					position.x = -ReadFloat(p, end);
+					position.y = ReadFloat(p, end);
+					position.z = ReadFloat(p, end);
+					writers.positions.PushBack(position);
+				}
+				else if (identifier == "vt")
+				{
+					Vector2 texcoord{};
+					texcoord.x = ReadFloat(p, end);
+					texcoord.y = 1.0f - ReadFloat(p, end);
+					writers.texcoords.PushBack(texcoord);
+				}
+				else if (identifier == "vn")
+				{
+					Vector3 normal{};
+					normal.x = -ReadFloat(p, end);
+					normal.y = ReadFloat(p, end);
+					normal.z = ReadFloat(p, end);
+					writers.normals.PushBack(normal);
+				}
+				else if (identifier == "f")
+				{
+					// 三角形限定。その他は未対応
+					ObjElementCounts defined{ writers.positions.GetCount(), writers.texcoords.GetCount(), writers.normals.GetCount(), 0 };
+					for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex)
+					{
+						ObjIndexTriple corner = ReadFaceCorner(p, end, defined, unlimited, smoothingGroup_, triangleCount_);
+						hasSmoothNormals_ |= IsSmoothGeneratedNormal(corner.normal);
+						writers.corners.PushBack(corner);
+					}
+					++triangleCount_;
+				}
+				else if (identifier == "s")
+				{
+					smoothingGroup_ = ParseSmoothingGroup(ReadToken(p, end));
+				}
+				else if (identifier == "mtllib")
+				{
+					// 基本的にobjファイルと同一改装にmtlは存在させるので、ディレクトリ名とファイル名を渡す
+					std::vector<MaterialData> materials = LoadMaterialTemplateFile(directoryPath_, std::string(ReadToken(p, end)));
+					result_.materials.insert(result_.materials.end(), materials.begin(), materials.end());
+				}
+				else if (identifier == "usemtl")
+				{
+					// マテリアルが変わったら、面の並びに切り替えの印を入れる
+					std::string_view name = ReadToken(p, end);
+					uint32_t materialIndex = 0;
+					for (uint32_t i = 0; i < result_.materials.size(); ++i)
+					{
+						if (result_.materials[i].name == name)
+						{
+							materialIndex = i;
+							break;
+						}
+					}
+					if (materialIndex != parsedMaterialIndex_)
+					{
+						ObjIndexTriple marker{ kObjMaterialMarker, materialIndex, 0 };
+						writers.corners.PushBack(marker);
+						writers.corners.PushBack(marker);
+						writers.corners.PushBack(marker);
+						parsedMaterialIndex_ = materialIndex;
+					}
+				}
+
+				// 残りは読み飛ばして次の行へ
+				p = NextLine(p, end);
+			}
+		}
+
+		// 2段階目。滑らかにつなぐ法線を作る面があれば、角ごとの寄与を位置ごとの集計に足し込む
+		// 集計は位置ごとに1つの平滑化グループしか持てないので、別のグループの寄与は次の段の集計に回す。段の数は1つの位置を使うグループの数になる
+		bool AccumulateSmoothNormals()
+		{
+			if (!hasSmoothNormals_)
+			{
+				return true;
+			}
+
+			//1. 一度に扱う面の数を決めて確保する
+			// 1面あたり、面の頂点、位置、読み込みの要求、寄与を3つずつ。他に位置と集計で共用する読み込みのブロックと、次の段に回す寄与の書き出しのバッファ
+			const size_t faceSize = (sizeof(ObjIndexTriple) + sizeof(Vector3) + sizeof(SpillRequest) + sizeof(ObjNormalContribution)) * 3;
+			size_t fixedSize = blockSize_ * 2;
+			if (bufferBudget_ < fixedSize + faceSize)
+			{
+				UseMemory(fixedSize + faceSize);
+				return false;
+			}
+			size_t windowFaceCount = static_cast<size_t>(std::min<uint64_t>((bufferBudget_ - fixedSize) / faceSize, std::max<uint64_t>(faceRecordCount_, 1)));
+			UseMemory(fixedSize + windowFaceCount * faceSize);
+			std::vector<ObjIndexTriple> corners(windowFaceCount * 3);
+			std::vector<Vector3> positions(windowFaceCount * 3);
+			std::vector<SpillRequest> requests(windowFaceCount * 3);
+			std::vector<ObjNormalContribution> contributions(windowFaceCount * 3);
+			std::vector<char> block(blockSize_);
+
+			//2. 面を順に読み、角ごとの寄与を1段目の集計に足し込む
+			normalLevels_.push_back(std::make_unique<SpillFile>("normals"));
+			auto overflowFile = std::make_unique<SpillFile>("overflow");
+			{
+				SpillWriter<ObjNormalContribution> overflow(*overflowFile, blockSize_);
+				for (uint64_t faceBegin = 0; faceBegin < faceRecordCount_; faceBegin += windowFaceCount)
+				{
+					size_t faceCount = static_cast<size_t>(std::min<uint64_t>(windowFaceCount, faceRecordCount_ - faceBegin));
+					cornerFile_.Read(faceBegin * 3 * sizeof(ObjIndexTriple), corners.data(), faceCount * 3 * sizeof(ObjIndexTriple));
+
+					// 寄与する角のある面の位置を読む
+					size_t requestCount = 0;
+					for (size_t face = 0; face < faceCount; ++face)
+					{
+						const ObjIndexTriple* corner = corners.data() + face * 3;
+						if (IsSmoothGeneratedNormal(corner[0].normal) || IsSmoothGeneratedNormal(corner[1].normal) || IsSmoothGeneratedNormal(corner[2].normal))
+						{
+							for (uint32_t i = 0; i < 3; ++i)
+							{
+								assert(corner[i].position < positionCount_);
+								requests[requestCount++] = { corner[i].position, static_cast<uint32_t>(face * 3 + i) };
+							}
+						}
+					}
+					GatherSpilled<Vector3>(positionFile_, std::span(requests.data(), requestCount), block,
+						[&](uint32_t target, const Vector3& position) { positions[target] = position; });
+
+					// 巻き順を反転した後の順(2, 1, 0)で面の法線と角の大きさを求める。潰れた三角形は寄与しない
+					size_t contributionCount = 0;
+					for (size_t face = 0; face < faceCount; ++face)
+					{
+						const ObjIndexTriple* corner = corners.data() + face * 3;
+						const Vector3* position = positions.data() + face * 3;
+						if (!IsSmoothGeneratedNormal(corner[0].normal) && !IsSmoothGeneratedNormal(corner[1].normal) && !IsSmoothGeneratedNormal(corner[2].normal))
+						{
+							continue;
+						}
+						Vector3 faceNormal{};
+						float angles[3]{};
+						if (!ComputeFaceNormal(position[2], position[1], position[0], faceNormal, angles))
+						{
+							continue;
+						}
+						for (uint32_t i = 0; i < 3; ++i)
+						{
+							const ObjIndexTriple& reversed = corner[2 - i];
+							if (IsSmoothGeneratedNormal(reversed.normal))
+							{
+								contributions[contributionCount++] = { reversed.position, reversed.normal, Multiply(angles[i], faceNormal), 0 };
+							}
+						}
+					}
+					AccumulateNormals(*normalLevels_[0], positionCount_, std::span(contributions.data(), contributionCount), block, overflow);
+				}
+				overflow.Flush();
+			}
+
+			//3. 回した寄与が無くなるまで、次の段の集計に足し込む
+			while (overflowFile->GetSize() != 0)
+			{
+				normalLevels_.push_back(std::make_unique<SpillFile>("normals"));
+				auto nextOverflowFile = std::make_unique<SpillFile>("overflow");
+				SpillWriter<ObjNormalContribution> overflow(*nextOverflowFile, blockSize_);
+				uint64_t overflowCount = overflowFile->GetSize() / sizeof(ObjNormalContribution);
+				for (uint64_t begin = 0; begin < overflowCount; begin += contributions.size())
+				{
+					size_t count = static_cast<size_t>(std::min<uint64_t>(contributions.size(), overflowCount - begin));
+					overflowFile->Read(begin * sizeof(ObjNormalContribution), contributions.data(), count * sizeof(ObjNormalContribution));
+					AccumulateNormals(*normalLevels_.back(), positionCount_, std::span(contributions.data(), count), block, overflow);
+				}
+				overflow.Flush();
+				overflowFile = std::move(nextOverflowFile);
+			}
+			return true;
+		}
+
+		// 3段階目。面を順に読んでまとまりを作り、シンクに渡していく
+		bool EmitChunks()
+		{
+			//1. まとまりの大きさを決めて確保する
+			// 1頂点あたり、頂点、要素の組み合わせ、読み込みの要求、重複除去の表(2の累乗に切り上げるので最大4要素)、Index6個(一般的な三角形メッシュの目安)
+			// 他に面を読むブロックと要素を読むブロック
+			const size_t vertexSize = sizeof(VertexData) + sizeof(ObjIndexTriple) + sizeof(SpillRequest) + sizeof(uint32_t) * 4 + sizeof(uint32_t) * 6;
+			size_t fixedSize = blockSize_ * 2;
+			if (bufferBudget_ < fixedSize + vertexSize * 3)
+			{
+				UseMemory(fixedSize + vertexSize * 3);
+				return false;
+			}
+			size_t maxChunkVertices = std::min((bufferBudget_ - fixedSize) / vertexSize, kMaxStreamChunkVertices);
+			maxChunkIndices_ = maxChunkVertices * 6;
+			size_t tableSize = 1;
+			while (tableSize < maxChunkVertices * 2)
+			{
+				tableSize *= 2;
+			}
+			maxChunkVertices_ = maxChunkVertices;
+			vertices_.reserve(maxChunkVertices);
+			vertexTriples_.reserve(maxChunkVertices);
+			requests_.resize(maxChunkVertices);
+			vertexTable_.assign(tableSize, 0);
+			indices_.reserve(maxChunkIndices_);
+			block_.resize(blockSize_);
+			std::vector<ObjIndexTriple> corners(blockSize_ / (sizeof(ObjIndexTriple) * 3) * 3);
+			UseMemory(vertices_.capacity() * sizeof(VertexData) + vertexTriples_.capacity() * sizeof(ObjIndexTriple) + requests_.size() * sizeof(SpillRequest)
+				+ vertexTable_.size() * sizeof(uint32_t) + indices_.capacity() * sizeof(uint32_t) + block_.size() + corners.size() * sizeof(ObjIndexTriple));
+
+			//2. 面を順に読み、入りきらなくなるかマテリアルが変わるたびにまとまりを渡す
+			uint64_t blockFaceCount = corners.size() / 3;
+			for (uint64_t faceBegin = 0; faceBegin < faceRecordCount_; faceBegin += blockFaceCount)
+			{
+				size_t faceCount = static_cast<size_t>(std::min(blockFaceCount, faceRecordCount_ - faceBegin));
+				cornerFile_.Read(faceBegin * 3 * sizeof(ObjIndexTriple), corners.data(), faceCount * 3 * sizeof(ObjIndexTriple));
+				for (size_t face = 0; face < faceCount; ++face)
+				{
+					const ObjIndexTriple* corner = corners.data() + face * 3;
+					if (corner[0].position == kObjMaterialMarker)
+					{
+						Flush();
+						materialIndex_ = corner[0].texcoord;
+						continue;
+					}
+					if (vertexTriples_.size() + 3 > maxChunkVertices_ || indices_.size() + 3 > maxChunkIndices_)
+					{
+						Flush();
+					}
+					// 巻き順を反転して追加する
+					AddCorner(corner[2]);
+					AddCorner(corner[1]);
+					AddCorner(corner[0]);
+				}
+			}
+			Flush();
+			return true;
+		}
+
+		// 面の頂点を1つ追加する。重複はまとまりの中だけで除く。要素の値はまとまりを渡すときにまとめて読む
+		void AddCorner(const ObjIndexTriple& triple)
+		{
+			assert(triple.position < positionCount_);
+			assert(triple.texcoord == kObjMissingTexcoord || triple.texcoord < texcoordCount_);
+			assert((triple.normal & kObjGeneratedNormalBit) != 0 || triple.normal < normalCount_);
+			size_t mask = vertexTable_.size() - 1;
+			for (size_t slot = ObjIndexTripleHash{}(triple) & mask; ; slot = (slot + 1) & mask)
+			{
+				// 表には頂点の番号+1を入れる。0は空き
+				uint32_t entry = vertexTable_[slot];
+				if (entry == 0)
+				{
+					vertexTable_[slot] = static_cast<uint32_t>(vertexTriples_.size()) + 1;
+					indices_.push_back(static_cast<uint32_t>(vertexTriples_.size()));
+					vertexTriples_.push_back(triple);
+					return;
+				}
+				if (vertexTriples_[entry - 1] == triple)
+				{
+					indices_.push_back(entry - 1);
+					return;
+				}
+			}
+		}
+
+		// 今のまとまりの頂点を作ってシンクに渡し、空にする
+		void Flush()
+		{
+			if (indices_.empty())
+			{
+				return;
+			}
+			// まとまりの領域は最初に確保した分から伸びていないこと。伸びると上限を超える
+			assert(vertexTriples_.size() <= maxChunkVertices_ && indices_.size() <= maxChunkIndices_);
+			uint32_t vertexCount = static_cast<uint32_t>(vertexTriples_.size());
+			vertices_.resize(vertexCount);
+
+			//1. 位置、UV、ファイルにある法線を、使う要素だけ読む
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				requests_[i] = { vertexTriples_[i].position, i };
+			}
+			GatherSpilled<Vector3>(positionFile_, std::span(requests_.data(), vertexCount), block_,
+				[&](uint32_t vertex, const Vector3& position) { vertices_[vertex].position = { position.x, position.y, position.z, 1.0f }; });
+			uint32_t requestCount = 0;
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				// UVが無ければ(0,0)
+				vertices_[i].texcoord = {};
+				if (vertexTriples_[i].texcoord != kObjMissingTexcoord)
+				{
+					requests_[requestCount++] = { vertexTriples_[i].texcoord, i };
+				}
+			}
+			GatherSpilled<Vector2>(texcoordFile_, std::span(requests_.data(), requestCount), block_,
+				[&](uint32_t vertex, const Vector2& texcoord) { vertices_[vertex].texcoord = texcoord; });
+			requestCount = 0;
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				// 作る法線は、どの面からも寄与が無ければ上向きのままになる
+				vertices_[i].normal = { 0.0f, 1.0f, 0.0f };
+				if ((vertexTriples_[i].normal & kObjGeneratedNormalBit) == 0)
+				{
+					requests_[requestCount++] = { vertexTriples_[i].normal, i };
+				}
+			}
+			GatherSpilled<Vector3>(normalFile_, std::span(requests_.data(), requestCount), block_,
+				[&](uint32_t vertex, const Vector3& normal) { vertices_[vertex].normal = normal; });
+
+			//2. 滑らかにつなぐ法線は、集計の段を順に見て平滑化グループが一致した段の合計を正規化する
+			requestCount = 0;
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				if (IsSmoothGeneratedNormal(vertexTriples_[i].normal))
+				{
+					requests_[requestCount++] = { vertexTriples_[i].position, i };
+				}
+			}
+			for (const std::unique_ptr<SpillFile>& level : normalLevels_)
+			{
+				if (requestCount == 0)
+				{
+					break;
+				}
+				GatherSpilled<ObjNormalSlot>(*level, std::span(requests_.data(), requestCount), block_, [&](uint32_t vertex, const ObjNormalSlot& slot)
+					{
+						if (slot.tag == vertexTriples_[vertex].normal)
+						{
+							vertices_[vertex].normal = NormalizeNormalSum(slot.sum);
+							// 見つかった頂点は印を消して、次の段では探さない
+							vertexTriples_[vertex].normal = 0;
+						}
+					});
+				requestCount = static_cast<uint32_t>(std::remove_if(requests_.begin(), requests_.begin() + requestCount,
+					[&](const SpillRequest& request) { return !IsSmoothGeneratedNormal(vertexTriples_[request.target].normal); }) - requests_.begin());
+			}
+
+			//3. s offの面の頂点は、その面の法線にする
+			for (size_t corner = 0; corner < indices_.size(); corner += 3)
+			{
+				const uint32_t* triangle = indices_.data() + corner;
+				uint32_t normalBits = vertexTriples_[triangle[0]].normal | vertexTriples_[triangle[1]].normal | vertexTriples_[triangle[2]].normal;
+				if ((normalBits & kObjFlatNormalBit) == 0)
+				{
+					continue;
+				}
+				const Vector4& p0 = vertices_[triangle[0]].position;
+				const Vector4& p1 = vertices_[triangle[1]].position;
+				const Vector4& p2 = vertices_[triangle[2]].position;
+				Vector3 faceNormal{ 0.0f, 1.0f, 0.0f };
+				float angles[3]{};
+				ComputeFaceNormal({ p0.x, p0.y, p0.z }, { p1.x, p1.y, p1.z }, { p2.x, p2.y, p2.z }, faceNormal, angles);
+				for (uint32_t i = 0; i < 3; ++i)
+				{
+					if (vertexTriples_[triangle[i]].normal & kObjFlatNormalBit)
+					{
+						vertices_[triangle[i]].normal = faceNormal;
+					}
+				}
+			}
+
+			//4. シンクに渡して空にする
+			sink_({ vertices_, indices_, materialIndex_ });
+			++result_.chunkCount;
+			result_.vertexCount += vertices_.size();
+			result_.indexCount += indices_.size();
+			vertices_.clear();
+			indices_.clear();
+			vertexTriples_.clear();
+			std::fill(vertexTable_.begin(), vertexTable_.end(), 0u);
+		}
+
+		const std::string& directoryPath_;
+		const ObjStreamSink& sink_;
+		size_t bufferBudget_ = 0;				// 上限から取っておく分を引いた、読み込みのバッファに使える分(byte)
+		size_t blockSize_ = 0;					// 一時ファイルを読み書きする単位(byte)
+		SpillFile positionFile_{ "positions" };
+		SpillFile texcoordFile_{ "texcoords" };
+		SpillFile normalFile_{ "normals" };
+		SpillFile cornerFile_{ "corners" };
+		std::vector<std::unique_ptr<SpillFile>> normalLevels_;	// 法線を作るための位置ごとの集計。平滑化グループが重なる分だけ段がある
+		uint64_t positionCount_ = 0;
+		uint64_t texcoordCount_ = 0;
+		uint64_t normalCount_ = 0;
+		uint64_t faceRecordCount_ = 0;			// 一時ファイルの面の数。マテリアルの切り替えの印を含む
+		size_t triangleCount_ = 0;
+		bool hasSmoothNormals_ = false;
+		uint32_t smoothingGroup_ = kObjDefaultSmoothingGroup;
+		uint32_t parsedMaterialIndex_ = 0;
+		size_t maxChunkVertices_ = 0;
+		size_t maxChunkIndices_ = 0;
+		std::vector<VertexData> vertices_;
+		std::vector<uint32_t> indices_;
+		std::vector<ObjIndexTriple> vertexTriples_;
+		std::vector<uint32_t> vertexTable_;
+		std::vector<SpillRequest> requests_;
+		std::vector<char> block_;
+		uint32_t materialIndex_ = 0;
+		ObjStreamResult result_{};
+	};
+}
+
+std::vector<MaterialData> LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
+{
+	//1. 中で必要なる変数の宣言
+	std::vector<MaterialData> materials;
+	std::string line;
+
+	//2. ファイルを開く
+	std::ifstream file(directoryPath + "/" + filename); //ファイルを開く
+	assert(file.is_open());// とりあえず開けなかったら止める
+
+	//3. 実際にファイルを読み、マテリアルを構築していく
+	while (std::getline(file, line))
+	{
+		std::string identifire;
+		std::istringstream s(line);
+		s >> identifire;
+
+		// identifireに応じた処理
+		if (identifire == "newmtl")
+		{
+			// ここから新しいマテリアルになる
+			MaterialData materialData;
+			s >> materialData.name;
+			materials.push_back(materialData);
+		}
+		else if (identifire == "map_Kd")
+		{
+			std::string textureFilename;
+			s >> textureFilename;
+			// newmtlより前に書かれていた場合は名前無しのマテリアルにする
+			if (materials.empty())
+			{
+				materials.push_back(MaterialData{});
+			}
+			//連結してファイルパスにする
+			materials.back().textureFilePath = directoryPath + "/" + textureFilename;
+		}
+	}
+
+	//4. MaterialDataを返す
+	return materials;
+}
+
+void BuildMaterialBatches(ModelData& modelData)
+{
+	modelData.batches.clear();
+	for (const SubmeshData& submesh : modelData.submeshes)
+	{
+		// 直前と同じマテリアルで範囲が続いていればまとめる
+		if (!modelData.batches.empty())
+		{
+			MaterialBatch& last = modelData.batches.back();
+			if (last.materialIndex == submesh.materialIndex && last.indexStart + last.indexCount == submesh.indexStart)
+			{
+				last.indexCount += submesh.indexCount;
+				continue;
+			}
+		}
+		modelData.batches.push_back({ submesh.indexStart, submesh.indexCount, submesh.materialIndex });
+	}
+}
+
+void ComputeModelBounds(ModelData& modelData)
+{
+	modelData.bounds = ComputeBoundingVolume(modelData.vertices);
+	for (SubmeshData& submesh : modelData.submeshes)
+	{
+		submesh.bounds = ComputeBoundingVolume(modelData.vertices, modelData.indices.data() + submesh.indexStart, submesh.indexCount);
+	}
+}
+
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, ObjParseMode mode)
+{
+	switch (mode)
+	{
+	case ObjParseMode::Stream:
+		return LoadObjFileStream(directoryPath, filename);
+	case ObjParseMode::Parallel:
+		return LoadObjFileParallel(directoryPath, filename);
+	case ObjParseMode::Mapped:
+	default:
+		return LoadObjFileMapped(directoryPath, filename);
+	}
+}
+
+ObjStreamResult StreamObjFile(const std::string& directoryPath, const std::string& filename, size_t memoryBudget, const ObjStreamSink& sink)
+{
+	//1. ファイルを開く
+	// 窓にまとめて読むので、ファイル側のバッファは持たない
+	std::ifstream file;
+	file.rdbuf()->pubsetbuf(nullptr, 0);
+	file.open(directoryPath + "/" + filename, std::ios::binary);
+	assert(file.is_open());// とりあえず開けなかったら止める
+
+	//2. 要素を書き出し、法線を集計し、まとまりを渡す
+	ObjStreamReader reader(directoryPath, memoryBudget, sink);
+	return reader.Read(file);
+}
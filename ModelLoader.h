@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include "ModelData.h"
+
+// Objファイルの読み込み方式
+enum class ObjParseMode
+{
+	Stream,		// std::getlineとstringstreamで1行ずつ読む(従来の方式)
+	Mapped,		// ファイルをメモリマップしてstd::from_charsでその場で字句解析する。要素を数えてから一時領域をまとめて確保するので、確保回数がファイルの大きさによらない
+	Parallel,	// Mappedを行の境界で分割し、JobSystemで並列に読み込む。結果はMappedと同じになる
+};
+
+// mtlファイルを読み込む。newmtlごとに1つのMaterialDataを返す
+std::vector<MaterialData> LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename);
+
+// submeshesからマテリアルごとの描画単位(batches)を作る。submeshesは同じマテリアルのものが隣り合っていること
+void BuildMaterialBatches(ModelData& modelData);
+
+// モデル全体と各サブメッシュの境界ボリュームを求める
+void ComputeModelBounds(ModelData& modelData);
+
+// Objファイルを読み込む。vnが無い面は平滑化グループ(s)に従って法線を作り、全ての頂点の接線を作る
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, ObjParseMode mode = ObjParseMode::Mapped);
+
+///==========================================================
+/// ストリーミング読み込みでシンクに渡す頂点とIndexのまとまり
+///==========================================================
+struct ObjStreamChunk
+{
+	std::span<const VertexData> vertices;	// このまとまりの中で重複を除いた頂点。最大0xFFFF個
+	std::span<const uint32_t> indices;		// verticesを指すIndex(まとまりの中での番号)
+	uint32_t materialIndex;					// ObjStreamResult::materialsの番号
+};
+
+// まとまりを受け取る関数。渡した領域は呼び出しの間だけ有効
+using ObjStreamSink = std::function<void(const ObjStreamChunk&)>;
+
+///==========================================================
+/// ストリーミング読み込みの結果
+///==========================================================
+struct ObjStreamResult
+{
+	std::vector<MaterialData> materials;	// マテリアル。最低1つはある
+	size_t chunkCount;						// シンクに渡したまとまりの数
+	size_t vertexCount;						// シンクに渡した頂点の合計
+	size_t indexCount;						// シンクに渡したIndexの合計
+	size_t peakMemorySize;					// 作業用に見込んだメモリの最大(byte)。段階ごとに最初に確保する窓とバッファに、ファイルのバッファなどに取っておく分を足したもので、memoryBudgetを超えることはない
+	size_t memoryBudget;					// 指定されたメモリの上限(byte)
+	uint64_t spillSize;						// 一時ファイルに書き出したサイズの合計(byte)
+	bool completed;							// 最後まで読めたか。falseになるのは、memoryBudgetが窓とバッファにも足りないか、1行が上限で広げられる窓に収まらない場合だけ
+};
+
+// Objファイルを一定サイズの窓ごとに読み、頂点とIndexのまとまりをシンクに渡していく
+// 位置/UV/法線と面は一時フォルダのファイルに書き出し、まとまりを作るときにそのまとまりが使う要素だけをブロック単位で読み戻す
+// メモリに置くのは最初に確保する窓とバッファだけなので、ファイルの大きさによらず作業メモリはmemoryBudgetを超えない
+// memoryBudgetのうち256KBはファイルのバッファなど上限に比例しない分に取っておくので、それより小さい上限では読めない
+// 窓と一時ファイルを読み書きするブロックはmemoryBudgetに比例させる。ディスクはObjと同じくらいの大きさを一時的に使う
+// vnが無い面の法線はファイル全体の面から平滑化グループに従って作るので、まとまりの境目でもLoadObjFileと同じ法線になる。接線は作らない
+ObjStreamResult StreamObjFile(const std::string& directoryPath, const std::string& filename, size_t memoryBudget, const ObjStreamSink& sink);
@@ -0,0 +1,60 @@
+#include "MonotonicArena.h"
+#include <cassert>
+
+namespace
+{
+	// 追加のブロックの最小サイズ(byte)
+	const size_t kMinArenaBlockSize = 64 * 1024;
+}
+
+MonotonicArena::MonotonicArena(size_t capacity)
+{
+	blocks_.reserve(4);
+	AddBlock(capacity);
+}
+
+void* MonotonicArena::Allocate(size_t size, size_t alignment)
+{
+	// ブロックの先頭はnew[]でmax_align_tに揃っているので、ブロック内の位置だけ揃えればよい
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && alignment <= alignof(std::max_align_t));
+	size_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+	if (offset + size > blocks_.back().size)
+	{
+		// 収まらなければブロックを追加する。倍々にして、見積もりが大きく外れても確保の回数が増えすぎないようにする
+		size_t blockSize = blocks_.back().size * 2;
+		AddBlock(blockSize > size ? blockSize : size);
+		offset = 0;
+	}
+	void* result = blocks_.back().data.get() + offset;
+	offset_ = offset + size;
+	return result;
+}
+
+void MonotonicArena::Reset()
+{
+	blocks_.resize(1);
+	offset_ = 0;
+	usedSize_ = 0;
+}
+
+size_t MonotonicArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const Block& block : blocks_)
+	{
+		capacity += block.size;
+	}
+	return capacity;
+}
+
+void MonotonicArena::AddBlock(size_t size)
+{
+	if (!blocks_.empty())
+	{
+		usedSize_ += offset_;
+	}
+	size = size > kMinArenaBlockSize ? size : kMinArenaBlockSize;
+	// 中身を0で埋めないようにnew[]で確保する
+	blocks_.push_back({ std::unique_ptr<std::byte[]>(new std::byte[size]), size });
+	offset_ = 0;
+}
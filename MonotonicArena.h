@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// 確保したメモリを個別には解放せず、アリーナごとまとめて捨てるアロケータ
+// 最初に見積もった容量を1回で確保して前から切り出していき、足りなくなったときだけ追加のブロックを確保する
+class MonotonicArena
+{
+public:
+	// capacityバイトのブロックを1つ確保しておく
+	explicit MonotonicArena(size_t capacity);
+	MonotonicArena(const MonotonicArena&) = delete;
+	MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+	// sizeバイトをalignmentの倍数の位置から切り出す。中身は初期化しない
+	void* Allocate(size_t size, size_t alignment);
+
+	// T型の配列をcount個分切り出す。デストラクタは呼ばないので、Tはトリビアルに破棄できる型に限る
+	template <typename T>
+	T* AllocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "MonotonicArena does not call destructors");
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// 切り出した領域を全て捨てる。最初のブロックは残して使い回す
+	void Reset();
+
+	// 切り出した合計(byte)。位置を揃えるための隙間を含む
+	size_t GetUsedSize() const { return usedSize_ + offset_; }
+	// 確保しているブロックの合計(byte)
+	size_t GetCapacity() const;
+	// 確保しているブロックの数。見積もりが足りていれば1
+	size_t GetBlockCount() const { return blocks_.size(); }
+
+private:
+	struct Block
+	{
+		std::unique_ptr<std::byte[]> data;
+		size_t size;
+	};
+
+	// 最低sizeバイトのブロックを追加する
+	void AddBlock(size_t size);
+
+	std::vector<Block> blocks_;
+	size_t offset_ = 0;		// 最後のブロックで使った量
+	size_t usedSize_ = 0;	// 最後のブロックより前のブロックで使った量
+};
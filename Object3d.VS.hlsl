@@ -5,8 +5,41 @@ struct TransformationMatrix
     float4x4 WVP;
     float4x4 World;
 };
+#ifdef INSTANCED
+//オブジェクトごとの行列。インスタンスの番号で引く
+StructuredBuffer<TransformationMatrix> gTransformationMatrices : register(t1);
+#else
 ConstantBuffer<TransformationMatrix> gTransformationMatrix : register(b0);
+#endif
 
+#ifdef QUANTIZED_VERTEX
+//量子化した頂点を元に戻すためのパラメータ
+struct VertexQuantization
+{
+    float4 positionMin;         //位置の最小値
+    float4 positionExtent;      //位置の範囲
+    float4 texcoordMinExtent;   //xy:UVの最小値 zw:UVの範囲
+};
+ConstantBuffer<VertexQuantization> gVertexQuantization : register(b1);
+
+//量子化した頂点の入力。unorm/snormは入力アセンブラで0～1/-1～1に変換される
+struct VertexShaderInput
+{
+    float4 position : POSITION0;    //R16G16B16A16_UNORM
+    float2 texcoord : TEXCOORD0;    //R16G16_UNORM
+    float2 normal : NORMAL0;        //R16G16_SNORM。八面体マッピング
+};
+
+//八面体マッピングした法線を戻す
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-normal.z);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+    return normalize(normal);
+}
+#else
 //頂点シェーダーへの入力頂点構造
 struct VertexShaderInput
 {
@@ -15,15 +48,32 @@ struct VertexShaderInput
     float2 texcoord : TEXCOORD0;
     float3 normal : NORMAL0;
 };
+#endif
 
 //頂点シェーダー
-VertexShaderOutput main(VertexShaderInput input)
+VertexShaderOutput main(VertexShaderInput input, uint instanceId : SV_InstanceID)
 {
     VertexShaderOutput output;
+#ifdef INSTANCED
+    TransformationMatrix transformationMatrix = gTransformationMatrices[instanceId];
+#else
+    TransformationMatrix transformationMatrix = gTransformationMatrix;
+#endif
+    
+#ifdef QUANTIZED_VERTEX
+    //範囲内の割合から元の値に戻す
+    float4 position = float4(gVertexQuantization.positionMin.xyz + input.position.xyz * gVertexQuantization.positionExtent.xyz, 1.0f);
+    float2 texcoord = gVertexQuantization.texcoordMinExtent.xy + input.texcoord * gVertexQuantization.texcoordMinExtent.zw;
+    float3 normal = DecodeOctahedralNormal(input.normal);
+#else
+    float4 position = input.position;
+    float2 texcoord = input.texcoord;
+    float3 normal = input.normal;
+#endif
     
     //入力された頂点座標を出職データに代入
-    output.position = mul(input.position, gTransformationMatrix.WVP);
-    output.texcoord = input.texcoord;
-    output.normal = normalize(mul(input.normal, (float3x3) gTransformationMatrix.World));
+    output.position = mul(position, transformationMatrix.WVP);
+    output.texcoord = texcoord;
+    output.normal = normalize(mul(normal, (float3x3) transformationMatrix.World));
     return output;
 }
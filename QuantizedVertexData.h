@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include "Vector4.h"
+
+///==========================================================
+/// 量子化した頂点データ。VertexData(36byte)の代わりに16byteで持つ
+///==========================================================
+struct QuantizedVertexData
+{
+	uint16_t position[4];	// メッシュのAABB内の位置をunorm16にしたもの。wは使わない
+	uint16_t texcoord[2];	// メッシュのUVの範囲内の位置をunorm16にしたもの
+	int16_t normal[2];		// 八面体マッピングした法線をsnorm16にしたもの
+};
+static_assert(sizeof(QuantizedVertexData) == 16, "QuantizedVertexData must be 16 bytes");
+
+///==========================================================
+/// 量子化した頂点を元に戻すためのパラメータ。頂点シェーダーの定数バッファと同じ並び
+///==========================================================
+struct VertexQuantization
+{
+	Vector4 positionMin;		// 位置の最小値。wは使わない
+	Vector4 positionExtent;		// 位置の範囲(最大-最小)。wは使わない
+	Vector4 texcoordMinExtent;	// xy:UVの最小値 zw:UVの範囲
+};
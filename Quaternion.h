@@ -0,0 +1,11 @@
+#pragma once
+
+/// <summary>
+/// クォータニオン。(x, y, z)が虚部、wが実部
+/// </summary>
+struct Quaternion final {
+	float x;
+	float y;
+	float z;
+	float w;
+};
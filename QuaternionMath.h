@@ -0,0 +1,260 @@
+#pragma once
+
+#include "ConstexprMath.h"
+#include "MatrixMath.h"
+#include "Quaternion.h"
+#include "Transform.h"
+#include "Vector3.h"
+#include "VectorMath.h"
+#include <cmath>
+#include <type_traits>
+
+// 回転の向きはMakeRotateX/Y/ZMatrixと同じ(右手系で軸の正の向きから見て反時計回り)
+// Multiply(q1, q2)はハミルトン積で、q2で回してからq1で回す回転になる
+
+//単位クォータニオン
+static constexpr Quaternion MakeIdentityQuaternion()
+{
+	return { 0.0f, 0.0f, 0.0f, 1.0f };
+}
+
+//クォータニオンの積(スカラー版)
+static constexpr Quaternion MultiplyScalar(const Quaternion& q1, const Quaternion& q2)
+{
+	Quaternion result{};
+	result.x = q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y;
+	result.y = q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x;
+	result.z = q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w;
+	result.w = q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z;
+	return result;
+}
+
+//クォータニオンの積
+//q1の各成分でq2を並べ替えて符号を付けたものを重み付けして足す
+static constexpr Quaternion Multiply(const Quaternion& q1, const Quaternion& q2)
+{
+	if (std::is_constant_evaluated())
+	{
+		return MultiplyScalar(q1, q2);
+	}
+#if defined(MATRIX_MATH_SSE)
+	__m128 a = _mm_loadu_ps(&q1.x);
+	__m128 b = _mm_loadu_ps(&q2.x);
+	const __m128 signWZYX = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+	const __m128 signZWXY = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+	const __m128 signYXWZ = _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+	__m128 result = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)), signWZYX)));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2)), signZWXY)));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)), signYXWZ)));
+	Quaternion quaternion;
+	_mm_storeu_ps(&quaternion.x, result);
+	return quaternion;
+#else
+	return MultiplyScalar(q1, q2);
+#endif
+}
+
+//共役クォータニオン
+static constexpr Quaternion Conjugate(const Quaternion& quaternion)
+{
+	return { -quaternion.x, -quaternion.y, -quaternion.z, quaternion.w };
+}
+
+//内積
+static constexpr float Dot(const Quaternion& q1, const Quaternion& q2)
+{
+	return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+//ノルム
+static constexpr float Norm(const Quaternion& quaternion)
+{
+	return Sqrt(Dot(quaternion, quaternion));
+}
+
+//正規化。長さ0なら単位クォータニオンにする
+static constexpr Quaternion Normalize(const Quaternion& quaternion)
+{
+	float norm = Norm(quaternion);
+	if (norm == 0.0f)
+	{
+		return MakeIdentityQuaternion();
+	}
+	return { quaternion.x / norm, quaternion.y / norm, quaternion.z / norm, quaternion.w / norm };
+}
+
+//逆クォータニオン
+static constexpr Quaternion Inverse(const Quaternion& quaternion)
+{
+	float normSquared = Dot(quaternion, quaternion);
+	Quaternion conjugate = Conjugate(quaternion);
+	return { conjugate.x / normSquared, conjugate.y / normSquared, conjugate.z / normSquared, conjugate.w / normSquared };
+}
+
+//任意軸回転を表すクォータニオン。axisは正規化しておく
+static constexpr Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle)
+{
+	float sinHalf = Sin(angle * 0.5f);
+	return { axis.x * sinHalf, axis.y * sinHalf, axis.z * sinHalf, Cos(angle * 0.5f) };
+}
+
+//オイラー角からクォータニオンを作る。MakeAffineMatrixと同じくX, Y, Zの順に回す
+//読み込み時や編集時に1回だけ変換しておけば、毎フレームの三角関数は要らなくなる
+static constexpr Quaternion MakeQuaternionFromEuler(const Vector3& radian)
+{
+	float sinX = Sin(radian.x * 0.5f);
+	float cosX = Cos(radian.x * 0.5f);
+	float sinY = Sin(radian.y * 0.5f);
+	float cosY = Cos(radian.y * 0.5f);
+	float sinZ = Sin(radian.z * 0.5f);
+	float cosZ = Cos(radian.z * 0.5f);
+
+	// qZ * qY * qXを展開したもの
+	Quaternion result{};
+	result.x = sinX * cosY * cosZ - cosX * sinY * sinZ;
+	result.y = cosX * sinY * cosZ + sinX * cosY * sinZ;
+	result.z = cosX * cosY * sinZ - sinX * sinY * cosZ;
+	result.w = cosX * cosY * cosZ + sinX * sinY * sinZ;
+	return result;
+}
+
+//ベクトルを回転させる。quaternionは正規化しておく
+static constexpr Vector3 RotateVector(const Vector3& vector, const Quaternion& quaternion)
+{
+	// v + 2w(q×v) + 2q×(q×v)
+	Vector3 axis = { quaternion.x, quaternion.y, quaternion.z };
+	Vector3 t = {
+		2.0f * (axis.y * vector.z - axis.z * vector.y),
+		2.0f * (axis.z * vector.x - axis.x * vector.z),
+		2.0f * (axis.x * vector.y - axis.y * vector.x) };
+	return {
+		vector.x + quaternion.w * t.x + (axis.y * t.z - axis.z * t.y),
+		vector.y + quaternion.w * t.y + (axis.z * t.x - axis.x * t.z),
+		vector.z + quaternion.w * t.z + (axis.x * t.y - axis.y * t.x) };
+}
+
+//クォータニオンから回転行列を作る。quaternionは正規化しておく。三角関数は使わない
+static constexpr Matrix4x4 MakeRotateMatrix(const Quaternion& quaternion)
+{
+	float x2 = quaternion.x + quaternion.x;
+	float y2 = quaternion.y + quaternion.y;
+	float z2 = quaternion.z + quaternion.z;
+	float xx = quaternion.x * x2;
+	float yy = quaternion.y * y2;
+	float zz = quaternion.z * z2;
+	float xy = quaternion.x * y2;
+	float xz = quaternion.x * z2;
+	float yz = quaternion.y * z2;
+	float wx = quaternion.w * x2;
+	float wy = quaternion.w * y2;
+	float wz = quaternion.w * z2;
+
+	Matrix4x4 result{};
+	result.m[0][0] = 1.0f - (yy + zz);
+	result.m[0][1] = xy + wz;
+	result.m[0][2] = xz - wy;
+	result.m[1][0] = xy - wz;
+	result.m[1][1] = 1.0f - (xx + zz);
+	result.m[1][2] = yz + wx;
+	result.m[2][0] = xz + wy;
+	result.m[2][1] = yz - wx;
+	result.m[2][2] = 1.0f - (xx + yy);
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+//三次元アフィン変換行列(回転をクォータニオンで渡す版)。拡大縮小 * 回転 * 平行移動を直接求める
+static constexpr Matrix4x4 MakeAffineMatrixQuaternion(const Vector3& scale, const Quaternion& rotate, const Vector3& translate)
+{
+	Matrix4x4 result = MakeRotateMatrix(rotate);
+	for (int j = 0; j < 3; j++)
+	{
+		result.m[0][j] *= scale.x;
+		result.m[1][j] *= scale.y;
+		result.m[2][j] *= scale.z;
+	}
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	return result;
+}
+
+//Transformからワールド行列を作る。useQuaternionならrotationを、そうでなければオイラー角を使う
+static constexpr Matrix4x4 MakeWorldMatrix(const Transform& transform)
+{
+	if (transform.useQuaternion)
+	{
+		return MakeAffineMatrixQuaternion(transform.scale, transform.rotation, transform.translate);
+	}
+	return MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
+}
+
+//正規化線形補間。tが0ならq1、1ならq2。短い方の経路で補間する
+//角速度は一定にならないが、三角関数を使わないのでアニメーションのキーの間の補間に向く
+static constexpr Quaternion Nlerp(const Quaternion& q1, const Quaternion& q2, float t)
+{
+	float sign = Dot(q1, q2) < 0.0f ? -1.0f : 1.0f;
+	Quaternion result = {
+		q1.x + (q2.x * sign - q1.x) * t,
+		q1.y + (q2.y * sign - q1.y) * t,
+		q1.z + (q2.z * sign - q1.z) * t,
+		q1.w + (q2.w * sign - q1.w) * t };
+	return Normalize(result);
+}
+
+//球面線形補間。tが0ならq1、1ならq2。短い方の経路を一定の角速度で補間する
+inline Quaternion Slerp(const Quaternion& q1, const Quaternion& q2, float t)
+{
+	//1. 内積が負なら片方を反転して短い方の経路にする
+	float dot = Dot(q1, q2);
+	Quaternion end = q2;
+	if (dot < 0.0f)
+	{
+		end = { -q2.x, -q2.y, -q2.z, -q2.w };
+		dot = -dot;
+	}
+
+	//2. ほぼ同じ向きならsinθが0に近く割り算が不安定になるので、正規化線形補間にする
+	const float kSlerpThreshold = 0.9995f;
+	if (dot > kSlerpThreshold)
+	{
+		return Nlerp(q1, end, t);
+	}
+
+	//3. q1とendのなす角θで重み付けする
+	float theta = std::acos(dot);
+	float inverseSinTheta = 1.0f / std::sin(theta);
+	float scale1 = std::sin((1.0f - t) * theta) * inverseSinTheta;
+	float scale2 = std::sin(t * theta) * inverseSinTheta;
+	return {
+		q1.x * scale1 + end.x * scale2,
+		q1.y * scale1 + end.y * scale2,
+		q1.z * scale1 + end.z * scale2,
+		q1.w * scale1 + end.w * scale2 };
+}
+
+//各成分の差がtolerance以下ならtrue
+static constexpr bool NearlyEqual(const Quaternion& q1, const Quaternion& q2, float tolerance)
+{
+	return NearlyEqual(q1.x, q2.x, tolerance) && NearlyEqual(q1.y, q2.y, tolerance) && NearlyEqual(q1.z, q2.z, tolerance) && NearlyEqual(q1.w, q2.w, tolerance);
+}
+
+// コンパイル時の確認
+namespace QuaternionMathStaticTest
+{
+	constexpr Vector3 kScale = { 1.5f, 0.5f, 2.0f };
+	constexpr Vector3 kEuler = { 0.3f, -1.2f, 2.5f };
+	constexpr Vector3 kTranslate = { 4.0f, -5.0f, 6.0f };
+	constexpr Quaternion kRotation = MakeQuaternionFromEuler(kEuler);
+
+	static_assert(NearlyEqual(MakeAffineMatrixQuaternion(kScale, kRotation, kTranslate), MakeAffineMatrix(kScale, kEuler, kTranslate), 1.0e-6f));
+	static_assert(NearlyEqual(MakeRotateMatrix(MakeRotateAxisAngleQuaternion({ 0.0f, 0.0f, 1.0f }, 0.7f)), MakeRotateZMatrix(0.7f), 1.0e-6f));
+	static_assert(NearlyEqual(Multiply(kRotation, Inverse(kRotation)), MakeIdentityQuaternion(), 1.0e-6f));
+	static_assert(NearlyEqual(Norm(kRotation), 1.0f, 1.0e-6f));
+	static_assert(NearlyEqual(
+		MakeRotateMatrix(Multiply(MakeRotateAxisAngleQuaternion({ 0.0f, 1.0f, 0.0f }, -1.2f), MakeRotateAxisAngleQuaternion({ 1.0f, 0.0f, 0.0f }, 0.3f))),
+		Multiply(MakeRotateXMatrix(0.3f), MakeRotateYMatrix(-1.2f)), 1.0e-6f));
+	static_assert(NearlyEqual(RotateVector({ 1.0f, 0.0f, 0.0f }, MakeRotateAxisAngleQuaternion({ 0.0f, 0.0f, 1.0f }, 1.5707963f)), { 0.0f, 1.0f, 0.0f }, 1.0e-6f));
+	static_assert(NearlyEqual(Nlerp(MakeIdentityQuaternion(), kRotation, 1.0f), kRotation, 1.0e-6f));
+}
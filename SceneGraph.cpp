@@ -0,0 +1,90 @@
+#include "SceneGraph.h"
+#include "MatrixMath.h"
+#include "QuaternionMath.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace
+{
+	// ローカルの回転をクォータニオンにする
+	Quaternion GetLocalRotation(const Transform& local)
+	{
+		return local.useQuaternion ? local.rotation : MakeQuaternionFromEuler(local.rotate);
+	}
+
+	// 1つのノードのワールド行列を求める。親は求め終わっていること
+	void UpdateWorldMatrix(SceneGraph& sceneGraph, uint32_t node)
+	{
+		Matrix4x4 localMatrix = MakeAffineMatrixQuaternion(sceneGraph.scales[node], sceneGraph.rotations[node], sceneGraph.translates[node]);
+		uint32_t parent = sceneGraph.parents[node];
+		sceneGraph.worldMatrices[node] = parent == kSceneNodeNoParent ? localMatrix : Multiply(localMatrix, sceneGraph.worldMatrices[parent]);
+	}
+}
+
+uint32_t AddSceneNode(SceneGraph& sceneGraph, uint32_t parent, const Transform& local)
+{
+	uint32_t node = static_cast<uint32_t>(sceneGraph.parents.size());
+	assert(parent == kSceneNodeNoParent || parent < node);
+	sceneGraph.parents.push_back(parent);
+	sceneGraph.scales.push_back(local.scale);
+	sceneGraph.rotations.push_back(GetLocalRotation(local));
+	sceneGraph.translates.push_back(local.translate);
+	sceneGraph.worldMatrices.push_back(MakeIdentity());
+	sceneGraph.dirty.push_back(1);
+	sceneGraph.firstDirty = std::min(sceneGraph.firstDirty, node);
+	return node;
+}
+
+void SetLocalTransform(SceneGraph& sceneGraph, uint32_t node, const Transform& local)
+{
+	assert(node < sceneGraph.parents.size());
+	sceneGraph.scales[node] = local.scale;
+	sceneGraph.rotations[node] = GetLocalRotation(local);
+	sceneGraph.translates[node] = local.translate;
+	sceneGraph.dirty[node] = 1;
+	sceneGraph.firstDirty = std::min(sceneGraph.firstDirty, node);
+}
+
+void UpdateSceneGraph(SceneGraph& sceneGraph, SceneGraphUpdateMode mode, SceneGraphStatistics& statistics)
+{
+	auto start = std::chrono::steady_clock::now();
+	uint32_t nodeCount = static_cast<uint32_t>(sceneGraph.parents.size());
+	statistics.nodeCount = nodeCount;
+	statistics.visitedCount = 0;
+	statistics.updatedCount = 0;
+
+	if (mode == SceneGraphUpdateMode::Full)
+	{
+		for (uint32_t node = 0; node < nodeCount; ++node)
+		{
+			UpdateWorldMatrix(sceneGraph, node);
+		}
+		statistics.visitedCount = nodeCount;
+		statistics.updatedCount = nodeCount;
+		std::fill(sceneGraph.dirty.begin(), sceneGraph.dirty.end(), uint8_t(0));
+	}
+	else if (sceneGraph.firstDirty < nodeCount)
+	{
+		//1. 一番前の変わったノードから順に、親が変わっていれば自分も変わったことにして求め直す
+		// 親は必ず前にあるので、親の印はこのフレームの分まで伝わっている
+		const uint32_t* parents = sceneGraph.parents.data();
+		uint8_t* dirty = sceneGraph.dirty.data();
+		for (uint32_t node = sceneGraph.firstDirty; node < nodeCount; ++node)
+		{
+			uint32_t parent = parents[node];
+			dirty[node] |= parent != kSceneNodeNoParent ? dirty[parent] : uint8_t(0);
+			if (dirty[node])
+			{
+				UpdateWorldMatrix(sceneGraph, node);
+				++statistics.updatedCount;
+			}
+		}
+		statistics.visitedCount = nodeCount - sceneGraph.firstDirty;
+
+		//2. 子が親の印を見終わってから消す
+		std::fill(sceneGraph.dirty.begin() + sceneGraph.firstDirty, sceneGraph.dirty.end(), uint8_t(0));
+	}
+	sceneGraph.firstDirty = UINT32_MAX;
+	statistics.updateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Matrix4x4.h"
+#include "Quaternion.h"
+#include "Transform.h"
+#include "Vector3.h"
+
+// 親の無いノードの親の番号
+const uint32_t kSceneNodeNoParent = UINT32_MAX;
+
+///==========================================================
+/// ノードを親が子より前に来る順で並べたシーングラフ。各要素はノードの番号で引く
+/// 前から順に処理すれば親のワールド行列が先に求まっている
+///==========================================================
+struct SceneGraph
+{
+	std::vector<uint32_t> parents;			//!< 親の番号。必ず自分より小さい。根はkSceneNodeNoParent
+	std::vector<Vector3> scales;			//!< ローカルの拡大縮小
+	std::vector<Quaternion> rotations;		//!< ローカルの回転
+	std::vector<Vector3> translates;		//!< ローカルの平行移動
+	std::vector<Matrix4x4> worldMatrices;	//!< ワールド行列
+	std::vector<uint8_t> dirty;				//!< ローカルが変わり、ワールド行列を求め直す必要があるか
+	uint32_t firstDirty = UINT32_MAX;		//!< 変わったノードの中で一番小さい番号。これより前は見なくてよい
+};
+
+// 更新の方式
+enum class SceneGraphUpdateMode
+{
+	Dirty,		// 変わったノードとその子孫だけを求め直す
+	Full,		// 全てのノードを求め直す(比較用)
+};
+
+///==========================================================
+/// 更新の統計
+///==========================================================
+struct SceneGraphStatistics
+{
+	uint32_t nodeCount;			//!< ノード数
+	uint32_t visitedCount;		//!< 変わったかを調べたノード数
+	uint32_t updatedCount;		//!< ワールド行列を求め直したノード数
+	double updateSeconds;		//!< 更新にかかった時間
+};
+
+// ノードを末尾に追加して番号を返す。parentは追加済みのノードかkSceneNodeNoParent
+// 回転はuseQuaternionならrotationを、そうでなければオイラー角をクォータニオンにして持つ
+uint32_t AddSceneNode(SceneGraph& sceneGraph, uint32_t parent, const Transform& local);
+
+// ローカルのTransformを書き換え、次の更新でそのノードと子孫を求め直すようにする
+void SetLocalTransform(SceneGraph& sceneGraph, uint32_t node, const Transform& local);
+
+// 変わったノードのワールド行列を前から順に求め直し、印を消す
+void UpdateSceneGraph(SceneGraph& sceneGraph, SceneGraphUpdateMode mode, SceneGraphStatistics& statistics);
@@ -0,0 +1,55 @@
+#include "StartupTimeline.h"
+#include <algorithm>
+
+StartupTimeline* StartupTimeline::GetInstance()
+{
+	static StartupTimeline instance;
+	return &instance;
+}
+
+void StartupTimeline::Reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	start_ = std::chrono::steady_clock::now();
+	entries_.clear();
+	threadIds_.clear();
+	threadIds_.push_back(std::this_thread::get_id());
+}
+
+double StartupTimeline::GetSeconds() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+}
+
+void StartupTimeline::Record(const std::string& name, double beginSeconds, double endSeconds)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_.push_back({ name, GetThreadIndex(std::this_thread::get_id()), beginSeconds, endSeconds });
+}
+
+std::vector<StartupTimelineEntry> StartupTimeline::GetEntries() const
+{
+	std::vector<StartupTimelineEntry> entries;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		entries = entries_;
+	}
+	std::stable_sort(entries.begin(), entries.end(), [](const StartupTimelineEntry& a, const StartupTimelineEntry& b)
+		{
+			return a.beginSeconds < b.beginSeconds;
+		});
+	return entries;
+}
+
+uint32_t StartupTimeline::GetThreadIndex(std::thread::id id)
+{
+	// スレッドは数個なので線形探索で十分
+	auto it = std::find(threadIds_.begin(), threadIds_.end(), id);
+	if (it != threadIds_.end())
+	{
+		return static_cast<uint32_t>(it - threadIds_.begin());
+	}
+	threadIds_.push_back(id);
+	return static_cast<uint32_t>(threadIds_.size() - 1);
+}
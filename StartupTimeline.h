@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+///==========================================================
+/// 起動時の処理の1区間
+///==========================================================
+struct StartupTimelineEntry
+{
+	std::string name;		//!< 処理の名前
+	uint32_t threadIndex;	//!< 記録したスレッドの番号。0はReset()を呼んだスレッド
+	double beginSeconds;	//!< 開始時刻(Reset()からの秒)
+	double endSeconds;		//!< 終了時刻(Reset()からの秒)
+};
+
+// 起動時にどの処理がどのスレッドでいつ動いたかを記録する。複数のスレッドから記録できる
+class StartupTimeline
+{
+public:
+	// プロセス全体で共有するインスタンスを取得する
+	static StartupTimeline* GetInstance();
+
+	// 記録を消し、今を基準時刻にする。呼んだスレッドが0番になる
+	void Reset();
+	// 基準時刻からの経過時間(秒)
+	double GetSeconds() const;
+	// 区間を記録する
+	void Record(const std::string& name, double beginSeconds, double endSeconds);
+	// 記録した区間を開始時刻順に取得する
+	std::vector<StartupTimelineEntry> GetEntries() const;
+
+private:
+	// スレッドの番号を引く。mutex_を取ってから呼ぶ
+	uint32_t GetThreadIndex(std::thread::id id);
+
+	std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+	std::vector<StartupTimelineEntry> entries_;
+	std::vector<std::thread::id> threadIds_;
+	mutable std::mutex mutex_;
+};
+
+// 生存している間を1区間として記録する
+class StartupTimelineScope
+{
+public:
+	explicit StartupTimelineScope(const std::string& name)
+		: name_(name), beginSeconds_(StartupTimeline::GetInstance()->GetSeconds())
+	{
+	}
+	~StartupTimelineScope()
+	{
+		StartupTimeline* timeline = StartupTimeline::GetInstance();
+		timeline->Record(name_, beginSeconds_, timeline->GetSeconds());
+	}
+	StartupTimelineScope(const StartupTimelineScope&) = delete;
+	StartupTimelineScope& operator=(const StartupTimelineScope&) = delete;
+
+private:
+	std::string name_;
+	double beginSeconds_;
+};
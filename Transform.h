@@ -1,4 +1,5 @@
 #pragma once
+#include "Quaternion.h"
 #include "Vector3.h"
 
 ///==========================================================
@@ -7,8 +8,10 @@
 struct Transform
 {
 	Vector3 scale;
-	Vector3 rotate;
+	Vector3 rotate;										//!< オイラー角(ラジアン)。X, Y, Zの順に回す
 	Vector3 translate;
+	Quaternion rotation = { 0.0f, 0.0f, 0.0f, 1.0f };	//!< useQuaternionがtrueのときにrotateの代わりに使う回転
+	bool useQuaternion = false;							//!< trueなら回転をrotationから作る。三角関数を使わずに済む
 };
 ///==========================================================
 /// Transform情報を作る
@@ -0,0 +1,143 @@
+#include "TransformBatch.h"
+#include "MatrixMath.h"
+#include <cassert>
+
+namespace
+{
+#if defined(MATRIX_MATH_SSE)
+	// 4つの角度のsinとcosを同時に求める。誤差はstd::sin/std::cosと数ulp程度
+	// π/2の倍数を引いて[-π/4, π/4]に縮め、その範囲のsinとcosの多項式から象限に応じて選ぶ
+	void SinCos(__m128 radian, __m128& sinResult, __m128& cosResult)
+	{
+		//1. 一番近いπ/2の倍数を求め、3つに分けたπ/2を順に引いて桁落ちを抑える
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(radian, _mm_set1_ps(0.636619772f)));
+		__m128 quadrantFloat = _mm_cvtepi32_ps(quadrant);
+		__m128 x = _mm_sub_ps(radian, _mm_mul_ps(quadrantFloat, _mm_set1_ps(1.5703125f)));
+		x = _mm_sub_ps(x, _mm_mul_ps(quadrantFloat, _mm_set1_ps(4.83751297e-4f)));
+		x = _mm_sub_ps(x, _mm_mul_ps(quadrantFloat, _mm_set1_ps(7.54978995e-8f)));
+
+		//2. [-π/4, π/4]でのsinとcosの多項式
+		__m128 x2 = _mm_mul_ps(x, x);
+		__m128 sinPolynomial = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), x2), _mm_set1_ps(8.3321608736e-3f));
+		sinPolynomial = _mm_add_ps(_mm_mul_ps(sinPolynomial, x2), _mm_set1_ps(-1.6666654611e-1f));
+		sinPolynomial = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPolynomial, x2), x), x);
+		__m128 cosPolynomial = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), x2), _mm_set1_ps(-1.388731625493765e-3f));
+		cosPolynomial = _mm_add_ps(_mm_mul_ps(cosPolynomial, x2), _mm_set1_ps(4.166664568298827e-2f));
+		cosPolynomial = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cosPolynomial, x2), x2), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), x2)));
+
+		//3. 奇数の象限ではsinとcosを入れ替え、象限に応じて符号を反転する
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		__m128 sinValue = _mm_or_ps(_mm_and_ps(swap, cosPolynomial), _mm_andnot_ps(swap, sinPolynomial));
+		__m128 cosValue = _mm_or_ps(_mm_and_ps(swap, sinPolynomial), _mm_andnot_ps(swap, cosPolynomial));
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+		sinResult = _mm_xor_ps(sinValue, sinSign);
+		cosResult = _mm_xor_ps(cosValue, cosSign);
+	}
+#endif
+
+	// index番目のTransformを取り出す
+	Transform GetTransform(const TransformSoA& transforms, size_t index)
+	{
+		return {
+			{ transforms.scaleX[index], transforms.scaleY[index], transforms.scaleZ[index] },
+			{ transforms.rotateX[index], transforms.rotateY[index], transforms.rotateZ[index] },
+			{ transforms.translateX[index], transforms.translateY[index], transforms.translateZ[index] } };
+	}
+}
+
+void ResizeTransforms(TransformSoA& transforms, size_t count)
+{
+	transforms.scaleX.resize(count);
+	transforms.scaleY.resize(count);
+	transforms.scaleZ.resize(count);
+	transforms.rotateX.resize(count);
+	transforms.rotateY.resize(count);
+	transforms.rotateZ.resize(count);
+	transforms.translateX.resize(count);
+	transforms.translateY.resize(count);
+	transforms.translateZ.resize(count);
+}
+
+void SetTransform(TransformSoA& transforms, size_t index, const Transform& transform)
+{
+	transforms.scaleX[index] = transform.scale.x;
+	transforms.scaleY[index] = transform.scale.y;
+	transforms.scaleZ[index] = transform.scale.z;
+	transforms.rotateX[index] = transform.rotate.x;
+	transforms.rotateY[index] = transform.rotate.y;
+	transforms.rotateZ[index] = transform.rotate.z;
+	transforms.translateX[index] = transform.translate.x;
+	transforms.translateY[index] = transform.translate.y;
+	transforms.translateZ[index] = transform.translate.z;
+}
+
+void MakeAffineMatrices(const TransformSoA& transforms, size_t begin, size_t end, Matrix4x4* matrices)
+{
+	assert(end <= transforms.scaleX.size());
+	size_t i = begin;
+#if defined(MATRIX_MATH_SSE)
+	// MakeAffineMatrixと同じ式を4個分同時に計算し、転置して行列ごとの行にする
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 sinX, cosX, sinY, cosY, sinZ, cosZ;
+		SinCos(_mm_loadu_ps(transforms.rotateX.data() + i), sinX, cosX);
+		SinCos(_mm_loadu_ps(transforms.rotateY.data() + i), sinY, cosY);
+		SinCos(_mm_loadu_ps(transforms.rotateZ.data() + i), sinZ, cosZ);
+		__m128 scaleX = _mm_loadu_ps(transforms.scaleX.data() + i);
+		__m128 scaleY = _mm_loadu_ps(transforms.scaleY.data() + i);
+		__m128 scaleZ = _mm_loadu_ps(transforms.scaleZ.data() + i);
+
+		__m128 sinXsinY = _mm_mul_ps(sinX, sinY);
+		__m128 cosXsinY = _mm_mul_ps(cosX, sinY);
+		__m128 rows[3][4] = {
+			{
+				_mm_mul_ps(scaleX, _mm_mul_ps(cosY, cosZ)),
+				_mm_mul_ps(scaleX, _mm_mul_ps(cosY, sinZ)),
+				_mm_sub_ps(zero, _mm_mul_ps(scaleX, sinY)),
+				zero,
+			},
+			{
+				_mm_mul_ps(scaleY, _mm_sub_ps(_mm_mul_ps(sinXsinY, cosZ), _mm_mul_ps(cosX, sinZ))),
+				_mm_mul_ps(scaleY, _mm_add_ps(_mm_mul_ps(sinXsinY, sinZ), _mm_mul_ps(cosX, cosZ))),
+				_mm_mul_ps(scaleY, _mm_mul_ps(sinX, cosY)),
+				zero,
+			},
+			{
+				_mm_mul_ps(scaleZ, _mm_add_ps(_mm_mul_ps(cosXsinY, cosZ), _mm_mul_ps(sinX, sinZ))),
+				_mm_mul_ps(scaleZ, _mm_sub_ps(_mm_mul_ps(cosXsinY, sinZ), _mm_mul_ps(sinX, cosZ))),
+				_mm_mul_ps(scaleZ, _mm_mul_ps(cosX, cosY)),
+				zero,
+			},
+		};
+		for (int row = 0; row < 3; row++)
+		{
+			_MM_TRANSPOSE4_PS(rows[row][0], rows[row][1], rows[row][2], rows[row][3]);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				_mm_store_ps(matrices[i + lane].m[row], rows[row][lane]);
+			}
+		}
+
+		// 平行移動の行。4列目は1
+		__m128 translate[4] = {
+			_mm_loadu_ps(transforms.translateX.data() + i),
+			_mm_loadu_ps(transforms.translateY.data() + i),
+			_mm_loadu_ps(transforms.translateZ.data() + i),
+			_mm_set1_ps(1.0f),
+		};
+		_MM_TRANSPOSE4_PS(translate[0], translate[1], translate[2], translate[3]);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			_mm_store_ps(matrices[i + lane].m[3], translate[lane]);
+		}
+	}
+#endif
+	// 端数は1個ずつ作る
+	for (; i < end; ++i)
+	{
+		Transform transform = GetTransform(transforms, i);
+		matrices[i] = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
+	}
+}
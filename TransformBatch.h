@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Matrix4x4.h"
+#include "Transform.h"
+
+///==========================================================
+/// 多数のTransformを成分ごとに並べたもの。4個ずつまとめてSIMDで処理できる
+///==========================================================
+struct TransformSoA
+{
+	std::vector<float> scaleX;
+	std::vector<float> scaleY;
+	std::vector<float> scaleZ;
+	std::vector<float> rotateX;
+	std::vector<float> rotateY;
+	std::vector<float> rotateZ;
+	std::vector<float> translateX;
+	std::vector<float> translateY;
+	std::vector<float> translateZ;
+};
+
+// TransformSoAの要素数をcountにする
+void ResizeTransforms(TransformSoA& transforms, size_t count);
+
+// index番目にtransformを書き込む
+void SetTransform(TransformSoA& transforms, size_t index, const Transform& transform);
+
+// [begin, end)番目のTransformのワールド行列をmatrices[begin, end)に書き込む。結果はMakeAffineMatrixと誤差の範囲で一致する
+// sin/cosを4個ずつまとめて多項式で求めるので、ジョブに分けるときはbeginを4の倍数にすると端数の処理が減る
+void MakeAffineMatrices(const TransformSoA& transforms, size_t begin, size_t end, Matrix4x4* matrices);
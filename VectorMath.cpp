@@ -0,0 +1,400 @@
+#include "VectorMath.h"
+#include "MatrixMath.h"
+
+namespace
+{
+	// 4列目が(0,0,0,1)ならwで割らなくてよい
+	bool IsAffineMatrix(const Matrix4x4& matrix)
+	{
+		return matrix.m[0][3] == 0.0f && matrix.m[1][3] == 0.0f && matrix.m[2][3] == 0.0f && matrix.m[3][3] == 1.0f;
+	}
+
+	// 1点をクリップ空間に変換する
+	Vector4 ProjectPoint(float x, float y, float z, const Matrix4x4& matrix)
+	{
+		return {
+			x * matrix.m[0][0] + y * matrix.m[1][0] + z * matrix.m[2][0] + matrix.m[3][0],
+			x * matrix.m[0][1] + y * matrix.m[1][1] + z * matrix.m[2][1] + matrix.m[3][1],
+			x * matrix.m[0][2] + y * matrix.m[1][2] + z * matrix.m[2][2] + matrix.m[3][2],
+			x * matrix.m[0][3] + y * matrix.m[1][3] + z * matrix.m[2][3] + matrix.m[3][3] };
+	}
+
+	// 1点を変換する。affineならwで割らない
+	Vector3 TransformPoint(float x, float y, float z, const Matrix4x4& matrix, bool affine)
+	{
+		Vector4 clip = ProjectPoint(x, y, z, matrix);
+		if (affine)
+		{
+			return { clip.x, clip.y, clip.z };
+		}
+		return { clip.x / clip.w, clip.y / clip.w, clip.z / clip.w };
+	}
+
+	// 1つの方向ベクトルを変換する
+	Vector3 TransformVector(float x, float y, float z, const Matrix4x4& matrix)
+	{
+		return {
+			x * matrix.m[0][0] + y * matrix.m[1][0] + z * matrix.m[2][0],
+			x * matrix.m[0][1] + y * matrix.m[1][1] + z * matrix.m[2][1],
+			x * matrix.m[0][2] + y * matrix.m[1][2] + z * matrix.m[2][2] };
+	}
+
+	// 1つのベクトルを正規化する。長さ0なら0のまま
+	Vector3 NormalizeVector(float x, float y, float z)
+	{
+		float length = std::sqrt(x * x + y * y + z * z);
+		if (length == 0.0f)
+		{
+			return { 0.0f, 0.0f, 0.0f };
+		}
+		return { x / length, y / length, z / length };
+	}
+
+#if defined(MATRIX_MATH_SSE)
+	// 4点分のAoS(x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3)を成分ごとのレジスタにする
+	void LoadVector3x4(const Vector3* vectors, __m128& x, __m128& y, __m128& z)
+	{
+		const float* data = &vectors->x;
+		__m128 a = _mm_loadu_ps(data);
+		__m128 b = _mm_loadu_ps(data + 4);
+		__m128 c = _mm_loadu_ps(data + 8);
+		__m128 xy = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));	// b2 b3 c1 c2
+		__m128 yz = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));	// a1 a2 b0 b1
+		x = _mm_shuffle_ps(a, xy, _MM_SHUFFLE(2, 0, 3, 0));
+		y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+		z = _mm_shuffle_ps(yz, c, _MM_SHUFFLE(3, 0, 3, 1));
+	}
+
+	// 成分ごとのレジスタを4点分のAoSに戻して書き込む
+	void StoreVector3x4(Vector3* vectors, __m128 x, __m128 y, __m128 z)
+	{
+		float* data = &vectors->x;
+		__m128 xyLow = _mm_unpacklo_ps(x, y);	// x0 y0 x1 y1
+		__m128 xyHigh = _mm_unpackhi_ps(x, y);	// x2 y2 x3 y3
+		__m128 zx = _mm_shuffle_ps(z, xyLow, _MM_SHUFFLE(2, 2, 0, 0));		// z0 z0 x1 x1
+		__m128 yz = _mm_shuffle_ps(xyLow, z, _MM_SHUFFLE(1, 1, 3, 3));		// y1 y1 z1 z1
+		__m128 zxy = _mm_shuffle_ps(z, xyHigh, _MM_SHUFFLE(3, 2, 3, 2));	// z2 z3 x3 y3
+		_mm_storeu_ps(data, _mm_shuffle_ps(xyLow, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+		_mm_storeu_ps(data + 4, _mm_shuffle_ps(yz, xyHigh, _MM_SHUFFLE(1, 0, 2, 0)));
+		_mm_storeu_ps(data + 8, _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(1, 3, 2, 0)));
+	}
+
+	// 成分ごとのレジスタを4点分のVector4にして書き込む
+	void StoreVector4x4(Vector4* vectors, __m128 x, __m128 y, __m128 z, __m128 w)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&vectors[0].x, x);
+		_mm_storeu_ps(&vectors[1].x, y);
+		_mm_storeu_ps(&vectors[2].x, z);
+		_mm_storeu_ps(&vectors[3].x, w);
+	}
+
+	///==========================================================
+	/// SSEで4個ずつ処理する命令
+	///==========================================================
+	struct SseOps
+	{
+		using Register = __m128;
+		static constexpr size_t kWidth = 4;
+		static Register Set(float value) { return _mm_set1_ps(value); }
+		static Register Load(const float* data) { return _mm_loadu_ps(data); }
+		static void Store(float* data, Register value) { _mm_storeu_ps(data, value); }
+		static Register Add(Register a, Register b) { return _mm_add_ps(a, b); }
+		static Register Mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+		static Register MulAdd(Register a, Register b, Register c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+		static Register Div(Register a, Register b) { return _mm_div_ps(a, b); }
+		static Register Sqrt(Register a) { return _mm_sqrt_ps(a); }
+		static Register MaskNonZero(Register value, Register condition) { return _mm_and_ps(value, _mm_cmpneq_ps(condition, _mm_setzero_ps())); }
+		static void LoadVector3(const Vector3* vectors, Register& x, Register& y, Register& z) { LoadVector3x4(vectors, x, y, z); }
+		static void StoreVector3(Vector3* vectors, Register x, Register y, Register z) { StoreVector3x4(vectors, x, y, z); }
+		static void StoreVector4(Vector4* vectors, Register x, Register y, Register z, Register w) { StoreVector4x4(vectors, x, y, z, w); }
+	};
+
+#if defined(__AVX2__)
+	///==========================================================
+	/// AVX2とFMAで8個ずつ処理する命令。AoSは4個ずつ並べ替えてから2つをつなげる
+	///==========================================================
+	struct Avx2Ops
+	{
+		using Register = __m256;
+		static constexpr size_t kWidth = 8;
+		static Register Set(float value) { return _mm256_set1_ps(value); }
+		static Register Load(const float* data) { return _mm256_loadu_ps(data); }
+		static void Store(float* data, Register value) { _mm256_storeu_ps(data, value); }
+		static Register Add(Register a, Register b) { return _mm256_add_ps(a, b); }
+		static Register Mul(Register a, Register b) { return _mm256_mul_ps(a, b); }
+		static Register MulAdd(Register a, Register b, Register c) { return _mm256_fmadd_ps(a, b, c); }
+		static Register Div(Register a, Register b) { return _mm256_div_ps(a, b); }
+		static Register Sqrt(Register a) { return _mm256_sqrt_ps(a); }
+		static Register MaskNonZero(Register value, Register condition) { return _mm256_and_ps(value, _mm256_cmp_ps(condition, _mm256_setzero_ps(), _CMP_NEQ_OQ)); }
+		static void LoadVector3(const Vector3* vectors, Register& x, Register& y, Register& z)
+		{
+			__m128 x0, y0, z0, x1, y1, z1;
+			LoadVector3x4(vectors, x0, y0, z0);
+			LoadVector3x4(vectors + 4, x1, y1, z1);
+			x = _mm256_set_m128(x1, x0);
+			y = _mm256_set_m128(y1, y0);
+			z = _mm256_set_m128(z1, z0);
+		}
+		static void StoreVector3(Vector3* vectors, Register x, Register y, Register z)
+		{
+			StoreVector3x4(vectors, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+			StoreVector3x4(vectors + 4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+		}
+		static void StoreVector4(Vector4* vectors, Register x, Register y, Register z, Register w)
+		{
+			StoreVector4x4(vectors, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z), _mm256_castps256_ps128(w));
+			StoreVector4x4(vectors + 4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1));
+		}
+	};
+	using BatchOps = Avx2Ops;
+#else
+	using BatchOps = SseOps;
+#endif
+
+	///==========================================================
+	/// 行列の各要素をレジスタの全レーンに並べたもの
+	///==========================================================
+	template <typename Ops>
+	struct MatrixLanes
+	{
+		typename Ops::Register m[4][4];
+
+		explicit MatrixLanes(const Matrix4x4& matrix)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					m[i][j] = Ops::Set(matrix.m[i][j]);
+				}
+			}
+		}
+
+		// 行ベクトル(x, y, z, 1)との積のcolumn列目
+		typename Ops::Register Point(typename Ops::Register x, typename Ops::Register y, typename Ops::Register z, int column) const
+		{
+			return Ops::MulAdd(x, m[0][column], Ops::MulAdd(y, m[1][column], Ops::MulAdd(z, m[2][column], m[3][column])));
+		}
+
+		// 行ベクトル(x, y, z, 0)との積のcolumn列目
+		typename Ops::Register Vector(typename Ops::Register x, typename Ops::Register y, typename Ops::Register z, int column) const
+		{
+			return Ops::MulAdd(x, m[0][column], Ops::MulAdd(y, m[1][column], Ops::Mul(z, m[2][column])));
+		}
+	};
+
+	// 点を変換する。affineならwで割らない
+	template <typename Ops>
+	void TransformPointLanes(const MatrixLanes<Ops>& lanes, bool affine, typename Ops::Register& x, typename Ops::Register& y, typename Ops::Register& z)
+	{
+		typename Ops::Register resultX = lanes.Point(x, y, z, 0);
+		typename Ops::Register resultY = lanes.Point(x, y, z, 1);
+		typename Ops::Register resultZ = lanes.Point(x, y, z, 2);
+		if (!affine)
+		{
+			typename Ops::Register w = lanes.Point(x, y, z, 3);
+			resultX = Ops::Div(resultX, w);
+			resultY = Ops::Div(resultY, w);
+			resultZ = Ops::Div(resultZ, w);
+		}
+		x = resultX;
+		y = resultY;
+		z = resultZ;
+	}
+
+	// ベクトルを正規化する。長さ0なら0のまま
+	template <typename Ops>
+	void NormalizeLanes(typename Ops::Register& x, typename Ops::Register& y, typename Ops::Register& z)
+	{
+		typename Ops::Register lengthSquared = Ops::MulAdd(x, x, Ops::MulAdd(y, y, Ops::Mul(z, z)));
+		typename Ops::Register length = Ops::Sqrt(lengthSquared);
+		x = Ops::MaskNonZero(Ops::Div(x, length), lengthSquared);
+		y = Ops::MaskNonZero(Ops::Div(y, length), lengthSquared);
+		z = Ops::MaskNonZero(Ops::Div(z, length), lengthSquared);
+	}
+#endif
+}
+
+void TransformPoints(std::span<const Vector3> points, const Matrix4x4& matrix, std::span<Vector3> results)
+{
+	assert(points.size() == results.size());
+	bool affine = IsAffineMatrix(matrix);
+	size_t i = 0;
+#if defined(MATRIX_MATH_SSE)
+	MatrixLanes<BatchOps> lanes(matrix);
+	for (; i + BatchOps::kWidth <= points.size(); i += BatchOps::kWidth)
+	{
+		BatchOps::Register x, y, z;
+		BatchOps::LoadVector3(&points[i], x, y, z);
+		TransformPointLanes(lanes, affine, x, y, z);
+		BatchOps::StoreVector3(&results[i], x, y, z);
+	}
+#endif
+	for (; i < points.size(); ++i)
+	{
+		results[i] = TransformPoint(points[i].x, points[i].y, points[i].z, matrix, affine);
+	}
+}
+
+void TransformPoints(const ConstVector3SoASpan& points, const Matrix4x4& matrix, const Vector3SoASpan& results)
+{
+	size_t count = points.x.size();
+	assert(points.y.size() == count && points.z.size() == count);
+	assert(results.x.size() == count && results.y.size() == count && results.z.size() == count);
+	bool affine = IsAffineMatrix(matrix);
+	size_t i = 0;
+#if defined(MATRIX_MATH_SSE)
+	MatrixLanes<BatchOps> lanes(matrix);
+	for (; i + BatchOps::kWidth <= count; i += BatchOps::kWidth)
+	{
+		BatchOps::Register x = BatchOps::Load(&points.x[i]);
+		BatchOps::Register y = BatchOps::Load(&points.y[i]);
+		BatchOps::Register z = BatchOps::Load(&points.z[i]);
+		TransformPointLanes(lanes, affine, x, y, z);
+		BatchOps::Store(&results.x[i], x);
+		BatchOps::Store(&results.y[i], y);
+		BatchOps::Store(&results.z[i], z);
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		Vector3 result = TransformPoint(points.x[i], points.y[i], points.z[i], matrix, affine);
+		results.x[i] = result.x;
+		results.y[i] = result.y;
+		results.z[i] = result.z;
+	}
+}
+
+void TransformVectors(std::span<const Vector3> vectors, const Matrix4x4& matrix, std::span<Vector3> results)
+{
+	assert(vectors.size() == results.size());
+	size_t i = 0;
+#if defined(MATRIX_MATH_SSE)
+	MatrixLanes<BatchOps> lanes(matrix);
+	for (; i + BatchOps::kWidth <= vectors.size(); i += BatchOps::kWidth)
+	{
+		BatchOps::Register x, y, z;
+		BatchOps::LoadVector3(&vectors[i], x, y, z);
+		BatchOps::StoreVector3(&results[i], lanes.Vector(x, y, z, 0), lanes.Vector(x, y, z, 1), lanes.Vector(x, y, z, 2));
+	}
+#endif
+	for (; i < vectors.size(); ++i)
+	{
+		results[i] = TransformVector(vectors[i].x, vectors[i].y, vectors[i].z, matrix);
+	}
+}
+
+void TransformVectors(const ConstVector3SoASpan& vectors, const Matrix4x4& matrix, const Vector3SoASpan& results)
+{
+	size_t count = vectors.x.size();
+	assert(vectors.y.size() == count && vectors.z.size() == count);
+	assert(results.x.size() == count && results.y.size() == count && results.z.size() == count);
+	size_t i = 0;
+#if defined(MATRIX_MATH_SSE)
+	MatrixLanes<BatchOps> lanes(matrix);
+	for (; i + BatchOps::kWidth <= count; i += BatchOps::kWidth)
+	{
+		BatchOps::Register x = BatchOps::Load(&vectors.x[i]);
+		BatchOps::Register y = BatchOps::Load(&vectors.y[i]);
+		BatchOps::Register z = BatchOps::Load(&vectors.z[i]);
+		BatchOps::Register resultX = lanes.Vector(x, y, z, 0);
+		BatchOps::Register resultY = lanes.Vector(x, y, z, 1);
+		BatchOps::Register resultZ = lanes.Vector(x, y, z, 2);
+		BatchOps::Store(&results.x[i], resultX);
+		BatchOps::Store(&results.y[i], resultY);
+		BatchOps::Store(&results.z[i], resultZ);
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		Vector3 result = TransformVector(vectors.x[i], vectors.y[i], vectors.z[i], matrix);
+		results.x[i] = result.x;
+		results.y[i] = result.y;
+		results.z[i] = result.z;
+	}
+}
+
+void ProjectPoints(std::span<const Vector3> points, const Matrix4x4& viewProjection, std::span<Vector4> results)
+{
+	assert(points.size() == results.size());
+	size_t i = 0;
+#if defined(MATRIX_MATH_SSE)
+	MatrixLanes<BatchOps> lanes(viewProjection);
+	for (; i + BatchOps::kWidth <= points.size(); i += BatchOps::kWidth)
+	{
+		BatchOps::Register x, y, z;
+		BatchOps::LoadVector3(&points[i], x, y, z);
+		BatchOps::StoreVector4(&results[i], lanes.Point(x, y, z, 0), lanes.Point(x, y, z, 1), lanes.Point(x, y, z, 2), lanes.Point(x, y, z, 3));
+	}
+#endif
+	for (; i < points.size(); ++i)
+	{
+		results[i] = ProjectPoint(points[i].x, points[i].y, points[i].z, viewProjection);
+	}
+}
+
+void ProjectPoints(const ConstVector3SoASpan& points, const Matrix4x4& viewProjection, std::span<Vector4> results)
+{
+	size_t count = points.x.size();
+	assert(points.y.size() == count && points.z.size() == count && results.size() == count);
+	size_t i = 0;
+#if defined(MATRIX_MATH_SSE)
+	MatrixLanes<BatchOps> lanes(viewProjection);
+	for (; i + BatchOps::kWidth <= count; i += BatchOps::kWidth)
+	{
+		BatchOps::Register x = BatchOps::Load(&points.x[i]);
+		BatchOps::Register y = BatchOps::Load(&points.y[i]);
+		BatchOps::Register z = BatchOps::Load(&points.z[i]);
+		BatchOps::StoreVector4(&results[i], lanes.Point(x, y, z, 0), lanes.Point(x, y, z, 1), lanes.Point(x, y, z, 2), lanes.Point(x, y, z, 3));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		results[i] = ProjectPoint(points.x[i], points.y[i], points.z[i], viewProjection);
+	}
+}
+
+void NormalizeMany(std::span<Vector3> vectors)
+{
+	size_t i = 0;
+#if defined(MATRIX_MATH_SSE)
+	for (; i + BatchOps::kWidth <= vectors.size(); i += BatchOps::kWidth)
+	{
+		BatchOps::Register x, y, z;
+		BatchOps::LoadVector3(&vectors[i], x, y, z);
+		NormalizeLanes<BatchOps>(x, y, z);
+		BatchOps::StoreVector3(&vectors[i], x, y, z);
+	}
+#endif
+	for (; i < vectors.size(); ++i)
+	{
+		vectors[i] = NormalizeVector(vectors[i].x, vectors[i].y, vectors[i].z);
+	}
+}
+
+void NormalizeMany(const Vector3SoASpan& vectors)
+{
+	size_t count = vectors.x.size();
+	assert(vectors.y.size() == count && vectors.z.size() == count);
+	size_t i = 0;
+#if defined(MATRIX_MATH_SSE)
+	for (; i + BatchOps::kWidth <= count; i += BatchOps::kWidth)
+	{
+		BatchOps::Register x = BatchOps::Load(&vectors.x[i]);
+		BatchOps::Register y = BatchOps::Load(&vectors.y[i]);
+		BatchOps::Register z = BatchOps::Load(&vectors.z[i]);
+		NormalizeLanes<BatchOps>(x, y, z);
+		BatchOps::Store(&vectors.x[i], x);
+		BatchOps::Store(&vectors.y[i], y);
+		BatchOps::Store(&vectors.z[i], z);
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		Vector3 result = NormalizeVector(vectors.x[i], vectors.y[i], vectors.z[i]);
+		vectors.x[i] = result.x;
+		vectors.y[i] = result.y;
+		vectors.z[i] = result.z;
+	}
+}
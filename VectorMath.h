@@ -1,12 +1,15 @@
 #pragma once
 
+#include "ConstexprMath.h"
 #include "Vector3.h"
+#include "Vector4.h"
 #include "Matrix4x4.h"
 #include <cmath>
+#include <span>
 #include <assert.h>
 
 //加算
-static Vector3 Add(const Vector3& v1, const Vector3& v2)
+static constexpr Vector3 Add(const Vector3& v1, const Vector3& v2)
 {
 	Vector3 result{};
 	result.x = v1.x + v2.x;
@@ -16,7 +19,7 @@ static Vector3 Add(const Vector3& v1, const Vector3& v2)
 }
 
 //減算
-static Vector3 Subtract(const Vector3& v1, const Vector3& v2)
+static constexpr Vector3 Subtract(const Vector3& v1, const Vector3& v2)
 {
 	Vector3 result{};
 	result.x = v1.x - v2.x;
@@ -26,7 +29,7 @@ static Vector3 Subtract(const Vector3& v1, const Vector3& v2)
 }
 
 //スカラー倍
-static Vector3 Multiply(float scalar, const Vector3& v)
+static constexpr Vector3 Multiply(float scalar, const Vector3& v)
 {
 	Vector3 result{};
 	result.x = scalar * v.x;
@@ -36,19 +39,19 @@ static Vector3 Multiply(float scalar, const Vector3& v)
 }
 
 //内積
-static float Dot(const Vector3& v1, const Vector3& v2)
+static constexpr float Dot(const Vector3& v1, const Vector3& v2)
 {
 	return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
 }
 
 //長さ（ノルム）
-static float Length(const Vector3& v)
+static constexpr float Length(const Vector3& v)
 {
-	return sqrtf(powf(v.x, 2) + powf(v.y, 2) + powf(v.z, 2));
+	return Sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
 }
 
 //正規化
-static Vector3 Nomalize(const Vector3& v)
+static constexpr Vector3 Nomalize(const Vector3& v)
 {
 	float length = Length(v);
 	Vector3 result{};
@@ -62,7 +65,7 @@ static Vector3 Nomalize(const Vector3& v)
 }
 
 //座標変換
-static Vector3 Transforms(const Vector3& vector, const Matrix4x4& matrix)
+static constexpr Vector3 Transforms(const Vector3& vector, const Matrix4x4& matrix)
 {
 	Vector3 result{};
 	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + 1.0f * matrix.m[3][0];
@@ -77,7 +80,7 @@ static Vector3 Transforms(const Vector3& vector, const Matrix4x4& matrix)
 }
 
 //クロス積
-static Vector3 Cross(const Vector3& v1, const Vector3& v2)
+static constexpr Vector3 Cross(const Vector3& v1, const Vector3& v2)
 {
 	Vector3 result{};
 	result.x = v1.y * v2.z - v1.z * v2.y;
@@ -85,3 +88,71 @@ static Vector3 Cross(const Vector3& v1, const Vector3& v2)
 	result.z = v1.x * v2.y - v1.y * v2.x;
 	return result;
 }
+
+//各成分の差がtolerance以下ならtrue
+static constexpr bool NearlyEqual(const Vector3& v1, const Vector3& v2, float tolerance)
+{
+	return NearlyEqual(v1.x, v2.x, tolerance) && NearlyEqual(v1.y, v2.y, tolerance) && NearlyEqual(v1.z, v2.z, tolerance);
+}
+
+// コンパイル時の確認
+namespace VectorMathStaticTest
+{
+	constexpr Matrix4x4 kTranslate = { {
+		{ 1.0f, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f, 0.0f },
+		{ 1.0f, 2.0f, 3.0f, 1.0f } } };
+
+	constexpr Vector3 kOne = { 1.0f, 1.0f, 1.0f };
+	constexpr Vector3 kPoint = { 1.0f, 2.0f, 3.0f };
+	constexpr Vector3 kZero = { 0.0f, 0.0f, 0.0f };
+
+	static_assert(Length(Vector3{ 3.0f, 4.0f, 0.0f }) == 5.0f);
+	static_assert(NearlyEqual(Nomalize(Vector3{ 0.0f, 3.0f, 4.0f }), Vector3{ 0.0f, 0.6f, 0.8f }, 1.0e-6f));
+	static_assert(NearlyEqual(Nomalize(kZero), kZero, 0.0f));
+	static_assert(NearlyEqual(Cross(Vector3{ 1.0f, 0.0f, 0.0f }, Vector3{ 0.0f, 1.0f, 0.0f }), Vector3{ 0.0f, 0.0f, 1.0f }, 0.0f));
+	static_assert(Dot(Add(kPoint, Multiply(2.0f, kOne)), kOne) == 12.0f);
+	static_assert(NearlyEqual(Subtract(kPoint, kPoint), kZero, 0.0f));
+	static_assert(NearlyEqual(Transforms(kOne, kTranslate), Vector3{ 2.0f, 3.0f, 4.0f }, 0.0f));
+}
+
+///==========================================================
+/// 成分ごとに並べた3次元ベクトルの列。x, y, zは同じ長さにする
+///==========================================================
+struct Vector3SoASpan
+{
+	std::span<float> x;
+	std::span<float> y;
+	std::span<float> z;
+};
+
+///==========================================================
+/// 成分ごとに並べた3次元ベクトルの列(読み取り専用)
+///==========================================================
+struct ConstVector3SoASpan
+{
+	std::span<const float> x;
+	std::span<const float> y;
+	std::span<const float> z;
+};
+
+// 以下はまとめて処理する版。SIMDで4個(AVX2が使えるときは8個)ずつ処理する
+// 入力と出力は同じ長さにする。入力と出力に同じ配列を渡してもよい
+// 行列の4列目が(0,0,0,1)ならwで割る計算を省く
+
+//座標変換(まとめて処理する版)。wが0になる点の結果は無限大になる
+void TransformPoints(std::span<const Vector3> points, const Matrix4x4& matrix, std::span<Vector3> results);
+void TransformPoints(const ConstVector3SoASpan& points, const Matrix4x4& matrix, const Vector3SoASpan& results);
+
+//方向ベクトルの変換(まとめて処理する版)。平行移動とwを無視して左上3x3だけを掛ける
+void TransformVectors(std::span<const Vector3> vectors, const Matrix4x4& matrix, std::span<Vector3> results);
+void TransformVectors(const ConstVector3SoASpan& vectors, const Matrix4x4& matrix, const Vector3SoASpan& results);
+
+//クリップ空間への変換(まとめて処理する版)。wで割らずに(x, y, z, w)を返すので、視錐台の判定は-w <= x <= wのように行う
+void ProjectPoints(std::span<const Vector3> points, const Matrix4x4& viewProjection, std::span<Vector4> results);
+void ProjectPoints(const ConstVector3SoASpan& points, const Matrix4x4& viewProjection, std::span<Vector4> results);
+
+//正規化(まとめて処理する版)。その場で書き換え、長さ0のベクトルは0のままにする
+void NormalizeMany(std::span<Vector3> vectors);
+void NormalizeMany(const Vector3SoASpan& vectors);
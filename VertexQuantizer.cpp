@@ -0,0 +1,169 @@
+#include "VertexQuantizer.h"
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	const float kUnorm16Max = 65535.0f;
+	const float kSnorm16Max = 32767.0f;
+	const double kRadianToDegree = 57.29577951308232;
+
+	// [0, 1]をunorm16にする
+	uint16_t EncodeUnorm16(float value)
+	{
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		return static_cast<uint16_t>(std::lround(value * kUnorm16Max));
+	}
+
+	// [-1, 1]をsnorm16にする
+	int16_t EncodeSnorm16(float value)
+	{
+		value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+		return static_cast<int16_t>(std::lround(value * kSnorm16Max));
+	}
+
+	// snorm16を[-1, 1]に戻す。GPUと同じく-32768は-1にする
+	float DecodeSnorm16(int16_t value)
+	{
+		float result = float(value) / kSnorm16Max;
+		return result < -1.0f ? -1.0f : result;
+	}
+
+	// 範囲内の位置を[0, 1]にする。範囲が0の軸は0にする
+	float Normalize(float value, float minimum, float extent)
+	{
+		return extent > 0.0f ? (value - minimum) / extent : 0.0f;
+	}
+
+	float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+VertexQuantization ComputeVertexQuantization(const std::vector<VertexData>& vertices)
+{
+	VertexQuantization quantization{};
+	if (vertices.empty())
+	{
+		return quantization;
+	}
+
+	Vector3 positionMin = { vertices[0].position.x, vertices[0].position.y, vertices[0].position.z };
+	Vector3 positionMax = positionMin;
+	Vector2 texcoordMin = vertices[0].texcoord;
+	Vector2 texcoordMax = texcoordMin;
+	for (const VertexData& vertex : vertices)
+	{
+		positionMin.x = vertex.position.x < positionMin.x ? vertex.position.x : positionMin.x;
+		positionMin.y = vertex.position.y < positionMin.y ? vertex.position.y : positionMin.y;
+		positionMin.z = vertex.position.z < positionMin.z ? vertex.position.z : positionMin.z;
+		positionMax.x = vertex.position.x > positionMax.x ? vertex.position.x : positionMax.x;
+		positionMax.y = vertex.position.y > positionMax.y ? vertex.position.y : positionMax.y;
+		positionMax.z = vertex.position.z > positionMax.z ? vertex.position.z : positionMax.z;
+		texcoordMin.x = vertex.texcoord.x < texcoordMin.x ? vertex.texcoord.x : texcoordMin.x;
+		texcoordMin.y = vertex.texcoord.y < texcoordMin.y ? vertex.texcoord.y : texcoordMin.y;
+		texcoordMax.x = vertex.texcoord.x > texcoordMax.x ? vertex.texcoord.x : texcoordMax.x;
+		texcoordMax.y = vertex.texcoord.y > texcoordMax.y ? vertex.texcoord.y : texcoordMax.y;
+	}
+
+	quantization.positionMin = { positionMin.x, positionMin.y, positionMin.z, 0.0f };
+	quantization.positionExtent = { positionMax.x - positionMin.x, positionMax.y - positionMin.y, positionMax.z - positionMin.z, 0.0f };
+	quantization.texcoordMinExtent = { texcoordMin.x, texcoordMin.y, texcoordMax.x - texcoordMin.x, texcoordMax.y - texcoordMin.y };
+	return quantization;
+}
+
+QuantizedVertexData QuantizeVertex(const VertexData& vertex, const VertexQuantization& quantization)
+{
+	QuantizedVertexData result{};
+
+	//1. 位置とUVは範囲内の割合にしてunorm16にする
+	result.position[0] = EncodeUnorm16(Normalize(vertex.position.x, quantization.positionMin.x, quantization.positionExtent.x));
+	result.position[1] = EncodeUnorm16(Normalize(vertex.position.y, quantization.positionMin.y, quantization.positionExtent.y));
+	result.position[2] = EncodeUnorm16(Normalize(vertex.position.z, quantization.positionMin.z, quantization.positionExtent.z));
+	result.position[3] = 0;
+	result.texcoord[0] = EncodeUnorm16(Normalize(vertex.texcoord.x, quantization.texcoordMinExtent.x, quantization.texcoordMinExtent.z));
+	result.texcoord[1] = EncodeUnorm16(Normalize(vertex.texcoord.y, quantization.texcoordMinExtent.y, quantization.texcoordMinExtent.w));
+
+	//2. 法線は八面体に投影して2成分にする。下半分は折り返して正方形に収める
+	Vector3 normal = vertex.normal;
+	float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (length > 0.0f)
+	{
+		normal = { normal.x / length, normal.y / length, normal.z / length };
+	}
+	else
+	{
+		normal = { 0.0f, 0.0f, 1.0f };
+	}
+	float x = normal.x;
+	float y = normal.y;
+	if (normal.z < 0.0f)
+	{
+		x = (1.0f - std::fabs(normal.y)) * SignNotZero(normal.x);
+		y = (1.0f - std::fabs(normal.x)) * SignNotZero(normal.y);
+	}
+	result.normal[0] = EncodeSnorm16(x);
+	result.normal[1] = EncodeSnorm16(y);
+	return result;
+}
+
+VertexData DequantizeVertex(const QuantizedVertexData& vertex, const VertexQuantization& quantization)
+{
+	VertexData result{};
+	result.position.x = quantization.positionMin.x + float(vertex.position[0]) / kUnorm16Max * quantization.positionExtent.x;
+	result.position.y = quantization.positionMin.y + float(vertex.position[1]) / kUnorm16Max * quantization.positionExtent.y;
+	result.position.z = quantization.positionMin.z + float(vertex.position[2]) / kUnorm16Max * quantization.positionExtent.z;
+	result.position.w = 1.0f;
+	result.texcoord.x = quantization.texcoordMinExtent.x + float(vertex.texcoord[0]) / kUnorm16Max * quantization.texcoordMinExtent.z;
+	result.texcoord.y = quantization.texcoordMinExtent.y + float(vertex.texcoord[1]) / kUnorm16Max * quantization.texcoordMinExtent.w;
+
+	// 八面体から法線に戻す
+	float x = DecodeSnorm16(vertex.normal[0]);
+	float y = DecodeSnorm16(vertex.normal[1]);
+	float z = 1.0f - std::fabs(x) - std::fabs(y);
+	float t = z < 0.0f ? -z : 0.0f;
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+	float length = std::sqrt(x * x + y * y + z * z);
+	result.normal = { x / length, y / length, z / length };
+	return result;
+}
+
+std::vector<QuantizedVertexData> QuantizeVertices(const std::vector<VertexData>& vertices, const VertexQuantization& quantization)
+{
+	std::vector<QuantizedVertexData> result;
+	result.reserve(vertices.size());
+	for (const VertexData& vertex : vertices)
+	{
+		result.push_back(QuantizeVertex(vertex, quantization));
+	}
+	return result;
+}
+
+VertexQuantizationError MeasureQuantizationError(const std::vector<VertexData>& vertices, const std::vector<QuantizedVertexData>& quantizedVertices, const VertexQuantization& quantization)
+{
+	assert(vertices.size() == quantizedVertices.size());
+	VertexQuantizationError error{};
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		const VertexData& original = vertices[i];
+		VertexData decoded = DequantizeVertex(quantizedVertices[i], quantization);
+		error.position = std::fmax(error.position, std::fabs(decoded.position.x - original.position.x));
+		error.position = std::fmax(error.position, std::fabs(decoded.position.y - original.position.y));
+		error.position = std::fmax(error.position, std::fabs(decoded.position.z - original.position.z));
+		error.texcoord = std::fmax(error.texcoord, std::fabs(decoded.texcoord.x - original.texcoord.x));
+		error.texcoord = std::fmax(error.texcoord, std::fabs(decoded.texcoord.y - original.texcoord.y));
+
+		// 誤差の角度は小さいのでacos(内積)では精度が足りない。doubleで外積と内積からatan2で求める
+		// 元の法線は正規化されていない場合もあるが、atan2は長さによらない
+		double ax = original.normal.x, ay = original.normal.y, az = original.normal.z;
+		double bx = decoded.normal.x, by = decoded.normal.y, bz = decoded.normal.z;
+		double cx = ay * bz - az * by;
+		double cy = az * bx - ax * bz;
+		double cz = ax * by - ay * bx;
+		double angle = std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz);
+		error.normalDegrees = std::fmax(error.normalDegrees, static_cast<float>(angle * kRadianToDegree));
+	}
+	return error;
+}
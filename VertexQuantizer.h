@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include "QuantizedVertexData.h"
+#include "VertexData.h"
+
+///==========================================================
+/// 量子化で生じた誤差の最大値
+///==========================================================
+struct VertexQuantizationError
+{
+	float position;			//!< 位置の誤差(各軸の絶対値の最大)
+	float texcoord;			//!< UVの誤差(各軸の絶対値の最大)
+	float normalDegrees;	//!< 法線の角度の誤差(度)
+};
+
+// 頂点の位置とUVの範囲から量子化のパラメータを求める
+VertexQuantization ComputeVertexQuantization(const std::vector<VertexData>& vertices);
+
+// 頂点を1つ量子化する
+QuantizedVertexData QuantizeVertex(const VertexData& vertex, const VertexQuantization& quantization);
+
+// 量子化した頂点を元に戻す。頂点シェーダーのデコードと同じ計算をする
+VertexData DequantizeVertex(const QuantizedVertexData& vertex, const VertexQuantization& quantization);
+
+// 頂点をまとめて量子化する
+std::vector<QuantizedVertexData> QuantizeVertices(const std::vector<VertexData>& vertices, const VertexQuantization& quantization);
+
+// 量子化して戻したときの誤差の最大値を求める
+VertexQuantizationError MeasureQuantizationError(const std::vector<VertexData>& vertices, const std::vector<QuantizedVertexData>& quantizedVertices, const VertexQuantization& quantization);
@@ -0,0 +1,254 @@
+#include "Visibility.h"
+#include "MatrixMath.h"
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	// 1つの境界球が視錐台の外にあるか。どれかの平面の外に出た時点で打ち切る
+	bool IsSphereOutside(const Vector4 planes[6], float x, float y, float z, float radius)
+	{
+		for (int32_t i = 0; i < 6; ++i)
+		{
+			if (planes[i].x * x + planes[i].y * y + planes[i].z * z + planes[i].w < -radius)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// 1つのAABBが視錐台の外にあるか。平面の法線の向きに一番進んだ頂点が平面の裏にあれば外
+	bool IsAabbOutside(const Vector4 planes[6], float x, float y, float z, float extentX, float extentY, float extentZ)
+	{
+		for (int32_t i = 0; i < 6; ++i)
+		{
+			float distance = planes[i].x * x + planes[i].y * y + planes[i].z * z + planes[i].w;
+			float reach = std::fabs(planes[i].x) * extentX + std::fabs(planes[i].y) * extentY + std::fabs(planes[i].z) * extentZ;
+			if (distance + reach < 0.0f)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// 埋めた分を含めた要素数
+	size_t PaddedCount(uint32_t count)
+	{
+		return (static_cast<size_t>(count) + kCullLaneCount - 1) / kCullLaneCount * kCullLaneCount;
+	}
+
+	uint32_t CullScalar(const Vector4 planes[6], const CullBoundsSoA& bounds, CullShape shape, uint32_t* visibleIndices)
+	{
+		uint32_t visibleCount = 0;
+		for (uint32_t i = 0; i < bounds.count; ++i)
+		{
+			bool outside = shape == CullShape::Sphere
+				? IsSphereOutside(planes, bounds.sphereX[i], bounds.sphereY[i], bounds.sphereZ[i], bounds.radius[i])
+				: IsAabbOutside(planes, bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i], bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+			if (!outside)
+			{
+				visibleIndices[visibleCount++] = i;
+			}
+		}
+		return visibleCount;
+	}
+
+#if defined(MATRIX_MATH_SSE)
+	///==========================================================
+	/// SSEで4個ずつ判定する命令
+	///==========================================================
+	struct SseOps
+	{
+		using Register = __m128;
+		static constexpr uint32_t kWidth = 4;
+		static Register Set(float value) { return _mm_set1_ps(value); }
+		static Register Load(const float* data) { return _mm_loadu_ps(data); }
+		static Register Zero() { return _mm_setzero_ps(); }
+		static Register Add(Register a, Register b) { return _mm_add_ps(a, b); }
+		static Register Sub(Register a, Register b) { return _mm_sub_ps(a, b); }
+		static Register Mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+		static Register Or(Register a, Register b) { return _mm_or_ps(a, b); }
+		static Register Less(Register a, Register b) { return _mm_cmplt_ps(a, b); }
+		static uint32_t MoveMask(Register a) { return static_cast<uint32_t>(_mm_movemask_ps(a)); }
+	};
+
+#if defined(__AVX__)
+	///==========================================================
+	/// AVXで8個ずつ判定する命令
+	///==========================================================
+	struct AvxOps
+	{
+		using Register = __m256;
+		static constexpr uint32_t kWidth = 8;
+		static Register Set(float value) { return _mm256_set1_ps(value); }
+		static Register Load(const float* data) { return _mm256_loadu_ps(data); }
+		static Register Zero() { return _mm256_setzero_ps(); }
+		static Register Add(Register a, Register b) { return _mm256_add_ps(a, b); }
+		static Register Sub(Register a, Register b) { return _mm256_sub_ps(a, b); }
+		static Register Mul(Register a, Register b) { return _mm256_mul_ps(a, b); }
+		static Register Or(Register a, Register b) { return _mm256_or_ps(a, b); }
+		static Register Less(Register a, Register b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static uint32_t MoveMask(Register a) { return static_cast<uint32_t>(_mm256_movemask_ps(a)); }
+	};
+#else
+	using AvxOps = SseOps;
+#endif
+
+	// 平面の各成分と法線の絶対値をレジスタの全レーンに並べて判定する
+	// Scalarと同じ順番で同じ演算をして、結果が一致するようにする
+	template <typename Ops, CullShape shape>
+	uint32_t CullSimd(const Vector4 planes[6], const CullBoundsSoA& bounds, uint32_t* visibleIndices)
+	{
+		using Register = typename Ops::Register;
+		Register planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+		for (int32_t p = 0; p < 6; ++p)
+		{
+			planeX[p] = Ops::Set(planes[p].x);
+			planeY[p] = Ops::Set(planes[p].y);
+			planeZ[p] = Ops::Set(planes[p].z);
+			planeW[p] = Ops::Set(planes[p].w);
+			absX[p] = Ops::Set(std::fabs(planes[p].x));
+			absY[p] = Ops::Set(std::fabs(planes[p].y));
+			absZ[p] = Ops::Set(std::fabs(planes[p].z));
+		}
+
+		const float* x = shape == CullShape::Sphere ? bounds.sphereX.data() : bounds.centerX.data();
+		const float* y = shape == CullShape::Sphere ? bounds.sphereY.data() : bounds.centerY.data();
+		const float* z = shape == CullShape::Sphere ? bounds.sphereZ.data() : bounds.centerZ.data();
+		uint32_t visibleCount = 0;
+		for (uint32_t i = 0; i < bounds.count; i += Ops::kWidth)
+		{
+			//1. どれか1つの平面の外にあれば視錐台の外
+			Register centerX = Ops::Load(x + i);
+			Register centerY = Ops::Load(y + i);
+			Register centerZ = Ops::Load(z + i);
+			Register outside = Ops::Zero();
+			if constexpr (shape == CullShape::Sphere)
+			{
+				Register negativeRadius = Ops::Sub(Ops::Zero(), Ops::Load(bounds.radius.data() + i));
+				for (int32_t p = 0; p < 6; ++p)
+				{
+					Register distance = Ops::Add(Ops::Add(Ops::Add(Ops::Mul(planeX[p], centerX), Ops::Mul(planeY[p], centerY)), Ops::Mul(planeZ[p], centerZ)), planeW[p]);
+					outside = Ops::Or(outside, Ops::Less(distance, negativeRadius));
+				}
+			}
+			else
+			{
+				Register extentX = Ops::Load(bounds.extentX.data() + i);
+				Register extentY = Ops::Load(bounds.extentY.data() + i);
+				Register extentZ = Ops::Load(bounds.extentZ.data() + i);
+				for (int32_t p = 0; p < 6; ++p)
+				{
+					Register distance = Ops::Add(Ops::Add(Ops::Add(Ops::Mul(planeX[p], centerX), Ops::Mul(planeY[p], centerY)), Ops::Mul(planeZ[p], centerZ)), planeW[p]);
+					Register reach = Ops::Add(Ops::Add(Ops::Mul(absX[p], extentX), Ops::Mul(absY[p], extentY)), Ops::Mul(absZ[p], extentZ));
+					outside = Ops::Or(outside, Ops::Less(Ops::Add(distance, reach), Ops::Zero()));
+				}
+			}
+
+			//2. 残ったレーンの番号を分岐なしで詰める。外なら同じ場所に次の番号が上書きされる
+			// visibleIndicesは埋めた分まであるので、末尾のレーンも書き込んでよい
+			uint32_t laneMask = bounds.count - i < Ops::kWidth ? (1u << (bounds.count - i)) - 1 : (1u << Ops::kWidth) - 1;
+			uint32_t visibleMask = ~Ops::MoveMask(outside) & laneMask;
+			for (uint32_t lane = 0; lane < Ops::kWidth; ++lane)
+			{
+				visibleIndices[visibleCount] = i + lane;
+				visibleCount += (visibleMask >> lane) & 1u;
+			}
+		}
+		return visibleCount;
+	}
+
+	template <typename Ops>
+	uint32_t CullSimd(const Vector4 planes[6], const CullBoundsSoA& bounds, CullShape shape, uint32_t* visibleIndices)
+	{
+		return shape == CullShape::Sphere
+			? CullSimd<Ops, CullShape::Sphere>(planes, bounds, visibleIndices)
+			: CullSimd<Ops, CullShape::Aabb>(planes, bounds, visibleIndices);
+	}
+#endif
+}
+
+void ExtractFrustumPlanes(const Matrix4x4& worldViewProjection, Vector4 planes[6])
+{
+	// 行ベクトルに掛けるので、クリップ座標の各成分は列との内積になる
+	const Matrix4x4& m = worldViewProjection;
+	auto column = [&](int32_t j) { return Vector4{ m.m[0][j], m.m[1][j], m.m[2][j], m.m[3][j] }; };
+	Vector4 x = column(0);
+	Vector4 y = column(1);
+	Vector4 z = column(2);
+	Vector4 w = column(3);
+	planes[0] = { w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w };	// 左
+	planes[1] = { w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w };	// 右
+	planes[2] = { w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w };	// 下
+	planes[3] = { w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w };	// 上
+	planes[4] = z;													// 近(DirectXはzが0～w)
+	planes[5] = { w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w };	// 遠
+	// 距離で比べられるように法線を正規化する
+	for (int32_t i = 0; i < 6; ++i)
+	{
+		float length = std::sqrt(planes[i].x * planes[i].x + planes[i].y * planes[i].y + planes[i].z * planes[i].z);
+		assert(length > 0.0f);
+		planes[i] = { planes[i].x / length, planes[i].y / length, planes[i].z / length, planes[i].w / length };
+	}
+}
+
+void ResizeCullBounds(CullBoundsSoA& bounds, uint32_t count)
+{
+	// 埋めた分は読まれても結果に使わないので、0のままでよい
+	size_t paddedCount = PaddedCount(count);
+	bounds.count = count;
+	for (std::vector<float>* component : { &bounds.sphereX, &bounds.sphereY, &bounds.sphereZ, &bounds.radius,
+		&bounds.centerX, &bounds.centerY, &bounds.centerZ, &bounds.extentX, &bounds.extentY, &bounds.extentZ })
+	{
+		component->resize(paddedCount, 0.0f);
+	}
+}
+
+void SetCullBounds(CullBoundsSoA& bounds, uint32_t index, const BoundingVolume& volume, const Matrix4x4& worldMatrix)
+{
+	assert(index < bounds.count);
+	const Matrix4x4& m = worldMatrix;
+
+	//1. 境界球の中心を移し、半径は一番長い軸の長さで広げる
+	const Vector3& sphere = volume.sphereCenter;
+	bounds.sphereX[index] = sphere.x * m.m[0][0] + sphere.y * m.m[1][0] + sphere.z * m.m[2][0] + m.m[3][0];
+	bounds.sphereY[index] = sphere.x * m.m[0][1] + sphere.y * m.m[1][1] + sphere.z * m.m[2][1] + m.m[3][1];
+	bounds.sphereZ[index] = sphere.x * m.m[0][2] + sphere.y * m.m[1][2] + sphere.z * m.m[2][2] + m.m[3][2];
+	float maxAxisSquared = 0.0f;
+	for (int32_t row = 0; row < 3; ++row)
+	{
+		float axisSquared = m.m[row][0] * m.m[row][0] + m.m[row][1] * m.m[row][1] + m.m[row][2] * m.m[row][2];
+		maxAxisSquared = axisSquared > maxAxisSquared ? axisSquared : maxAxisSquared;
+	}
+	bounds.radius[index] = volume.sphereRadius * std::sqrt(maxAxisSquared);
+
+	//2. AABBは中心を移し、広がりは行列の各要素の絶対値を掛けて囲い直す
+	Vector3 center = { (volume.boundsMin.x + volume.boundsMax.x) * 0.5f, (volume.boundsMin.y + volume.boundsMax.y) * 0.5f, (volume.boundsMin.z + volume.boundsMax.z) * 0.5f };
+	Vector3 extent = { (volume.boundsMax.x - volume.boundsMin.x) * 0.5f, (volume.boundsMax.y - volume.boundsMin.y) * 0.5f, (volume.boundsMax.z - volume.boundsMin.z) * 0.5f };
+	bounds.centerX[index] = center.x * m.m[0][0] + center.y * m.m[1][0] + center.z * m.m[2][0] + m.m[3][0];
+	bounds.centerY[index] = center.x * m.m[0][1] + center.y * m.m[1][1] + center.z * m.m[2][1] + m.m[3][1];
+	bounds.centerZ[index] = center.x * m.m[0][2] + center.y * m.m[1][2] + center.z * m.m[2][2] + m.m[3][2];
+	bounds.extentX[index] = extent.x * std::fabs(m.m[0][0]) + extent.y * std::fabs(m.m[1][0]) + extent.z * std::fabs(m.m[2][0]);
+	bounds.extentY[index] = extent.x * std::fabs(m.m[0][1]) + extent.y * std::fabs(m.m[1][1]) + extent.z * std::fabs(m.m[2][1]);
+	bounds.extentZ[index] = extent.x * std::fabs(m.m[0][2]) + extent.y * std::fabs(m.m[1][2]) + extent.z * std::fabs(m.m[2][2]);
+}
+
+uint32_t CullVisible(const Vector4 planes[6], const CullBoundsSoA& bounds, CullShape shape, VisibilityCullMode mode, uint32_t* visibleIndices)
+{
+	assert(bounds.sphereX.size() == PaddedCount(bounds.count));
+#if defined(MATRIX_MATH_SSE)
+	if (mode == VisibilityCullMode::Avx)
+	{
+		return CullSimd<AvxOps>(planes, bounds, shape, visibleIndices);
+	}
+	if (mode == VisibilityCullMode::Sse)
+	{
+		return CullSimd<SseOps>(planes, bounds, shape, visibleIndices);
+	}
+#else
+	(void)mode;
+#endif
+	return CullScalar(planes, bounds, shape, visibleIndices);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BoundingVolume.h"
+#include "Matrix4x4.h"
+#include "Vector4.h"
+
+// 何個ずつまとめて判定するか。CullBoundsSoAの末尾はこの倍数まで埋める
+const uint32_t kCullLaneCount = 8;
+
+///==========================================================
+/// カリングする境界をワールド空間で成分ごとに並べたもの。kCullLaneCount個ずつ読めるよう末尾を埋めてある
+///==========================================================
+struct CullBoundsSoA
+{
+	uint32_t count = 0;				//!< 境界の数(埋めた分は含まない)
+	std::vector<float> sphereX;		//!< 境界球の中心
+	std::vector<float> sphereY;
+	std::vector<float> sphereZ;
+	std::vector<float> radius;		//!< 境界球の半径
+	std::vector<float> centerX;		//!< AABBの中心
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;		//!< AABBの中心から面までの距離
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+};
+
+// 境界の形
+enum class CullShape
+{
+	Sphere,		// 境界球で判定する。速いが大きめに残る
+	Aabb,		// AABBで判定する
+};
+
+// 判定の方式。どれでも結果は同じになる
+enum class VisibilityCullMode
+{
+	Scalar,		// 1つずつ判定し、どれかの平面の外に出た時点で打ち切る
+	Sse,		// SSEで4つずつ判定する
+	Avx,		// AVXで8つずつ判定する。AVXを使わないビルドではSseと同じ
+};
+
+// 行列から視錐台の6平面(内側が正、法線は正規化済み)を取り出す
+// ビュープロジェクション行列ならワールド空間、ワールドビュープロジェクション行列ならモデル空間の平面になる
+void ExtractFrustumPlanes(const Matrix4x4& worldViewProjection, Vector4 planes[6]);
+
+// CullBoundsSoAの要素数をcountにする
+void ResizeCullBounds(CullBoundsSoA& bounds, uint32_t count);
+
+// index番目に、モデル空間の境界ボリュームをworldMatrixで移したものを書き込む
+// 境界球の半径は一番大きい軸の拡大率で広げ、AABBは移した後の各軸の広がりで囲い直す
+void SetCullBounds(CullBoundsSoA& bounds, uint32_t index, const BoundingVolume& volume, const Matrix4x4& worldMatrix);
+
+// 視錐台に入っている境界の番号を小さい順にvisibleIndicesへ詰め、その数を返す
+// visibleIndicesにはbounds.sphereX.size()個分(埋めた分を含む)の領域が必要
+uint32_t CullVisible(const Vector4 planes[6], const CullBoundsSoA& bounds, CullShape shape, VisibilityCullMode mode, uint32_t* visibleIndices);
@@ -4,10 +4,9 @@
 #include <format>
 #include <dxgi1_6.h>
 #include <cassert>
+#include <chrono>
 #include <dxgidebug.h>
 #include <dxcapi.h>
-#include <fstream>
-#include <sstream>
 #include <wrl.h>
 
 #include "externals/DirectXTex/DirectXTex.h"
@@ -29,6 +28,20 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg
 #include "Material.h"
 #include "TransformationMatrix.h"
 #include "DirectionalLight.h"
+#include "ModelData.h"
+#include "ModelLoader.h"
+#include "MeshCache.h"
+#include "SceneGraph.h"
+#include "EntityWorld.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "Visibility.h"
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "AssetRegistry.h"
+#include "StartupTimeline.h"
+#include "QuantizedVertexData.h"
+#include "VertexQuantizer.h"
 
 #pragma comment(lib,"dxgi.lib")
 #pragma comment(lib,"dxguid.lib")
@@ -39,6 +52,18 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg
 //クライアント領域サイズ
 const int32_t kClientWidth = 1280;
 const int32_t kClientHeight = 720;
+// 縦の画角。射影行列とLODの選択で同じ値を使う
+constexpr float kFovY = 0.45f;
+
+// 行列をまとめて求めて描画するオブジェクトの最大数
+const uint32_t kMaxSceneObjectCount = 65536;
+
+// SRVディスクリプタヒープに作るディスクリプタの数。0番はImGui、2番はuvChecker、kFirstMaterialSrvIndex番以降にマテリアルのテクスチャを並べる
+const uint32_t kSrvDescriptorCount = 128;
+const uint32_t kFirstMaterialSrvIndex = 3;
+
+// trueなら起動時のアセット読み込みをワーカースレッドで並行して行う。falseにすると従来通りメインスレッドで順番に読む(比較用)
+const bool kAsyncAssetLoading = true;
 
 // comptrの構造体
 struct D3DResourceLeakChecker
@@ -59,19 +84,6 @@ struct D3DResourceLeakChecker
 	}
 };
 
-// MaterialDataの構造体
-struct MaterialData
-{
-	std::string textureFilePath;
-};
-
-// ModelData構造体
-struct ModelData
-{
-	std::vector<VertexData> vertices;
-	MaterialData material;
-};
-
 //ウィンドウプロシージャ
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
@@ -188,7 +200,9 @@ IDxcBlob* CompilerShader(
 	//初期化で生成したものを3つ
 	IDxcUtils* dxcUtils,
 	IDxcCompiler3* dxcCompiler,
-	IDxcIncludeHandler* includeHandler)
+	IDxcIncludeHandler* includeHandler,
+	//パーミュテーションを切り替えるマクロ。無ければnullptr
+	const wchar_t* define = nullptr)
 {
 	//これからシェーダーをコンパイルする旨をログに出す
 	Log(ConvertString(std::format(L"Begin CompileShader, path:{}, profile:{}\n", filePath, profile)));
@@ -204,7 +218,7 @@ IDxcBlob* CompilerShader(
 	shaderSourceBuffer.Encoding = DXC_CP_UTF8;	//UTF8の文字コードであることを通知
 
 	/// 2.Compileする
-	LPCWSTR arguments[] =
+	std::vector<LPCWSTR> arguments =
 	{
 		filePath.c_str(),			//コンパイル対象のhlslファイル名
 		L"-E",L"main",				//エントリーポイントの指定。基本的にmain以外にはしない
@@ -213,12 +227,17 @@ IDxcBlob* CompilerShader(
 		L"-Od",						//最適化を外しておく
 		L"-Zpr",					//メモリレイアウトは行優先
 	};
+	if (define != nullptr)
+	{
+		arguments.push_back(L"-D");	//パーミュテーションのマクロを定義する
+		arguments.push_back(define);
+	}
 	//実際にSahaderをコンパイルする
 	IDxcResult* shaderResult = nullptr;
 	hr = dxcCompiler->Compile(
 		&shaderSourceBuffer,		//読み込んだファイル
-		arguments,					//コンパイルオプション
-		_countof(arguments),		//コンパイルオプションの数
+		arguments.data(),			//コンパイルオプション
+		UINT32(arguments.size()),	//コンパイルオプションの数
 		includeHandler,				//includeが服待てた諸々
 		IID_PPV_ARGS(&shaderResult)	//コンパイル結果
 	);
@@ -270,6 +289,113 @@ DirectX::ScratchImage LoadTexture(const std::string& filePath)
 	return mipImages;
 }
 
+// アセットの読み込みを投げる。kAsyncAssetLoadingがfalseの場合はget()したときにその場で実行する
+template <typename Func>
+auto SubmitAssetLoad(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>>
+{
+	if (kAsyncAssetLoading)
+	{
+		return JobSystem::GetInstance()->Submit(std::forward<Func>(func));
+	}
+	return std::async(std::launch::deferred, std::forward<Func>(func));
+}
+
+// どのスレッドからでも呼べるシェーダーのコンパイル。dxcのインスタンスはスレッド間で共有しないように呼び出しごとに作る
+Microsoft::WRL::ComPtr <IDxcBlob> CompileShaderAsset(const std::wstring& filePath, const wchar_t* profile, const wchar_t* define = nullptr)
+{
+	StartupTimelineScope scope("Compile " + ConvertString(filePath) + (define != nullptr ? " " + ConvertString(define) : ""));
+	Microsoft::WRL::ComPtr <IDxcUtils> dxcUtils = nullptr;
+	Microsoft::WRL::ComPtr <IDxcCompiler3> dxcCompiler = nullptr;
+	HRESULT hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils));
+	assert(SUCCEEDED(hr));
+	hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler));
+	assert(SUCCEEDED(hr));
+
+	//現時点でincludeはしないが、includeに対応するための設定を行っておく
+	Microsoft::WRL::ComPtr <IDxcIncludeHandler> includeHandler = nullptr;
+	hr = dxcUtils->CreateDefaultIncludeHandler(&includeHandler);
+	assert(SUCCEEDED(hr));
+
+	//CompilerShaderは参照を1つ持った状態で返すので、そのまま引き取る
+	Microsoft::WRL::ComPtr <IDxcBlob> shaderBlob;
+	shaderBlob.Attach(CompilerShader(filePath, profile, dxcUtils.Get(), dxcCompiler.Get(), includeHandler.Get(), define));
+	return shaderBlob;
+}
+
+// どのスレッドからでも呼べるTextureの読み込み。GPUのリソースは作らず、デコードとミップマップの作成まで行う
+DirectX::ScratchImage LoadTextureAsset(const std::string& filePath)
+{
+	StartupTimelineScope scope("Decode " + filePath);
+	//WICを使うのでワーカースレッドでもCOMを初期化しておく
+	HRESULT hr = CoInitializeEx(0, COINIT_MULTITHREADED);
+	DirectX::ScratchImage mipImages = LoadTexture(filePath);
+	if (SUCCEEDED(hr))
+	{
+		CoUninitialize();
+	}
+	return mipImages;
+}
+
+// Textureのデコード結果を共有する。同じファイルは読み込み中のものも含めて1回だけデコードする
+std::shared_ptr<DirectX::ScratchImage> AcquireTextureImage(const std::string& filePath)
+{
+	return AssetRegistry::GetInstance()->Acquire<DirectX::ScratchImage>(filePath, [&]() { return LoadTextureAsset(filePath); });
+}
+
+///==========================================================
+/// 同じモデルの配置で共有するメッシュのデータ
+///==========================================================
+struct MeshAsset
+{
+	ModelData modelData;
+	MeshLodChain lodChain;									// modelDataの頂点を共有するLODの列
+	std::vector<MeshletData> lodMeshlets;					// lodChainの各LODのメッシュレット
+};
+
+///==========================================================
+/// 非同期に読み込んだモデルとそのマテリアルのTexture
+///==========================================================
+struct ModelAsset
+{
+	std::shared_ptr<const MeshAsset> mesh;
+	std::vector<std::string> materialTextureFilePaths;										// materialsと同じ順
+	std::vector<std::future<std::shared_ptr<DirectX::ScratchImage>>> materialTextures;		// materialsと同じ順
+};
+
+// モデルを読み込み、続けてマテリアルのTextureの読み込みを投げる。読み込み済みのモデルとTextureは共有する
+ModelAsset LoadModelAsset(const std::string& directoryPath, const std::string& filename)
+{
+	ModelAsset asset;
+	asset.mesh = AssetRegistry::GetInstance()->Acquire<MeshAsset>(directoryPath + "/" + filename, [&]()
+		{
+			MeshAsset mesh;
+			{
+				StartupTimelineScope scope("Load " + filename);
+				mesh.modelData = LoadModel(directoryPath, filename);
+			}
+			{
+				StartupTimelineScope scope("Build LOD " + filename);
+				mesh.lodChain = BuildMeshLodChain(mesh.modelData);
+			}
+			{
+				StartupTimelineScope scope("Build meshlets " + filename);
+				for (const MeshLod& lod : mesh.lodChain.lods)
+				{
+					mesh.lodMeshlets.push_back(BuildMeshlets(mesh.modelData.vertices, mesh.lodChain.indices, lod.batches));
+				}
+			}
+			return mesh;
+		});
+	for (const MaterialData& material : asset.mesh->modelData.materials)
+	{
+		// テクスチャの無いマテリアルはuvCheckerで代用する
+		std::string textureFilePath = material.textureFilePath.empty() ? "resources/uvChecker.png" : material.textureFilePath;
+		asset.materialTextureFilePaths.push_back(textureFilePath);
+		asset.materialTextures.push_back(SubmitAssetLoad([textureFilePath]() { return AcquireTextureImage(textureFilePath); }));
+	}
+	return asset;
+}
+
 // DirectX12のTextureResourceを作る
 Microsoft::WRL::ComPtr <ID3D12Resource> CreateTextureResource(Microsoft::WRL::ComPtr <ID3D12Device> device, const DirectX::TexMetadata& metadata)
 {
@@ -324,6 +450,30 @@ void UploadTextureData(ID3D12Resource* texture, const DirectX::ScratchImage& mip
 	}
 }
 
+///==========================================================
+/// GPUに転送したTexture
+///==========================================================
+struct TextureResource
+{
+	Microsoft::WRL::ComPtr <ID3D12Resource> resource;
+	DirectX::TexMetadata metadata;
+};
+
+// 転送したTextureを共有する。同じファイルが転送済みならimageを待たずにそれを返す
+std::shared_ptr<TextureResource> AcquireTextureResource(Microsoft::WRL::ComPtr <ID3D12Device> device, const std::string& filePath, std::future<std::shared_ptr<DirectX::ScratchImage>>& image)
+{
+	std::shared_ptr<TextureResource> texture = AssetRegistry::GetInstance()->Acquire<TextureResource>(filePath, [&]()
+		{
+			std::shared_ptr<DirectX::ScratchImage> mipImages = image.get();
+			TextureResource loaded{ CreateTextureResource(device, mipImages->GetMetadata()), mipImages->GetMetadata() };
+			UploadTextureData(loaded.resource.Get(), *mipImages);
+			return loaded;
+		});
+	// 転送済みだった場合はデコード結果を待たずに手放す
+	image = {};
+	return texture;
+}
+
 // DepthStencilTextureを作る
 Microsoft::WRL::ComPtr <ID3D12Resource> CreateDepthStencilTextureResource(Microsoft::WRL::ComPtr <ID3D12Device> device, int32_t width, int32_t height)
 {
@@ -376,124 +526,6 @@ D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandle(ID3D12DescriptorHeap* descrip
 	return handleGPU;
 }
 
-MaterialData LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
-{
-	//1. 中で必要なる変数の宣言
-	MaterialData materialData;
-	std::string line;
-
-	//2. ファイルを開く
-	std::ifstream file(directoryPath + "/" + filename); //ファイルを開く
-	assert(file.is_open());// とりあえず開けなかったら止める
-
-	//3. 実際にファイルを読み、ModelDataを構築していく_頂点情報を読む
-	while (std::getline(file, line))
-	{
-		std::string identifire;
-		std::istringstream s(line);
-		s >> identifire;
-
-		// identifireに応じた処理
-		if (identifire == "map_Kd")
-		{
-			std::string textureFilename;
-			s >> textureFilename;
-			//連結してファイルパスにする
-			materialData.textureFilePath = directoryPath + "/" + textureFilename;
-		}
-	}
-
-	//4. MaterialDataを返す
-	return materialData;
-}
-
-// Objファイルを読み込む関数
-ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename)
-{
-	//1. 中で必要なる変数の宣言
-	ModelData modelData;				// 構築するModelData
-	std::vector<Vector4> positions;		// 位置
-	std::vector<Vector3> normals;		// 法線
-	std::vector<Vector2> texcoords;		// テクスチャ座標
-	std::string line;					// ファイルから読んだ1行を格納するもの
-
-	//2. ファイルを開く
-	std::ifstream file(directoryPath + "/" + filename);		// ファイルを開く
-	assert(file.is_open());									// 開けなかったら止める
-
-	//3. 実際にファイルを読み、ModelDataを構築していく_頂点情報を読む
-	while (std::getline(file, line))
-	{
-		std::string identifier;
-		std::stringstream s(line);
-		s >> identifier;			// 先頭の識別子を読む
-
-		// identifierに応じた処理
-		if (identifier == "v")
-		{
-			Vector4 position{};
-			s >> position.x >> position.y >> position.z;
-			position.w = 1.0f;
-			positions.push_back(position);
-		}
-		else if (identifier == "vt")
-		{
-			Vector2 texcoord{};
-			s >> texcoord.x >> texcoord.y;
-			texcoords.push_back(texcoord);
-		}
-		else if (identifier == "vn")
-		{
-			Vector3 normal{};
-			s >> normal.x >> normal.y >> normal.z;
-			normals.push_back(normal);
-		}
-		else if (identifier == "f")
-		{
-			VertexData triangle[3];
-			// 三角形限定。その他は未対応
-			for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex)
-			{
-				std::string vertexDefinition;
-				s >> vertexDefinition;
-				// 頂点の要素へのIndexは「位置/UV/法線」で格納されているので、分解してIndexを取得する
-				std::istringstream v(vertexDefinition);
-				uint32_t elementIndieces[3]{};
-				for (int32_t element = 0; element < 3; ++element)
-				{
-					std::string index;
-					std::getline(v, index, '/');	// 区切りでインデックスを読んでいく
-					elementIndieces[element] = std::stoi(index);
-				}
-				// 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
-				Vector4 position = positions[static_cast<std::vector<Vector4, std::allocator<Vector4>>::size_type>(elementIndieces[0]) - 1];
-				Vector2 texcoord = texcoords[static_cast<std::vector<Vector2, std::allocator<Vector2>>::size_type>(elementIndieces[1]) - 1];
-				Vector3 normal = normals[static_cast<std::vector<Vector3, std::allocator<Vector3>>::size_type>(elementIndieces[2]) - 1];
-				position.x *= -1;
-				texcoord.y = 1.0f - texcoord.y;
-				normal.x *= -1;
-				/*VertexData vertex = { position,texcoord,normal };
-				modelData.vertices.push_back(vertex);*/
-				triangle[faceVertex] = { position,texcoord,normal };
-			}
-			modelData.vertices.push_back(triangle[2]);
-			modelData.vertices.push_back(triangle[1]);
-			modelData.vertices.push_back(triangle[0]);
-		}
-		else if (identifier == "mtllib")
-		{
-			// materialTemplateLibraryファイル名を取得
-			std::string materialFilename;
-			s >> materialFilename;
-			// 基本的にobjファイルと同一改装にmtlは存在させるので、ディレクトリ名とファイル名を渡す
-			modelData.material = LoadMaterialTemplateFile(directoryPath, materialFilename);
-		}
-	}
-
-	//4. ModelDataを返す
-	return modelData;
-}
-
 
 // Windowsアプリでのエントリーポイント(main関数)
 int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
@@ -503,6 +535,19 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
 	D3DResourceLeakChecker leakCheck;
 
+#pragma region アセットの読み込みを投げる
+	//ウィンドウやデバイスの初期化と並行して、CPUだけで済む読み込みをワーカースレッドで進める
+	//GPUのリソースの作成はメインスレッドで、結果が必要になったところで行う
+	StartupTimeline::GetInstance()->Reset();
+	std::future<Microsoft::WRL::ComPtr <IDxcBlob>> vertexShaderFuture = SubmitAssetLoad([]() { return CompileShaderAsset(L"Object3D.VS.hlsl", L"vs_6_0"); });
+	std::future<Microsoft::WRL::ComPtr <IDxcBlob>> quantizedVertexShaderFuture = SubmitAssetLoad([]() { return CompileShaderAsset(L"Object3D.VS.hlsl", L"vs_6_0", L"QUANTIZED_VERTEX"); });
+	std::future<Microsoft::WRL::ComPtr <IDxcBlob>> instancedVertexShaderFuture = SubmitAssetLoad([]() { return CompileShaderAsset(L"Object3D.VS.hlsl", L"vs_6_0", L"INSTANCED"); });
+	std::future<Microsoft::WRL::ComPtr <IDxcBlob>> pixelShaderFuture = SubmitAssetLoad([]() { return CompileShaderAsset(L"Object3D.PS.hlsl", L"ps_6_0"); });
+	std::future<std::shared_ptr<DirectX::ScratchImage>> uvCheckerFuture = SubmitAssetLoad([]() { return AcquireTextureImage("resources/uvChecker.png"); });
+	std::future<ModelAsset> modelFuture = SubmitAssetLoad([]() { return LoadModelAsset("resources", "axis.obj"); });
+	double initializeBeginSeconds = StartupTimeline::GetInstance()->GetSeconds();
+#pragma endregion
+
 #pragma region Window
 	// ウィンドウクラスを登録する
 	WNDCLASS wc{};
@@ -701,7 +746,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	//RTVディスクイリプタヒープの生成
 	Microsoft::WRL::ComPtr <ID3D12DescriptorHeap> rtvDescriptorHeap = CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 2, false);
 	//SRVディスクイリプタヒープの生成
-	Microsoft::WRL::ComPtr <ID3D12DescriptorHeap> srvDescriptorHeap = CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128, true);
+	Microsoft::WRL::ComPtr <ID3D12DescriptorHeap> srvDescriptorHeap = CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kSrvDescriptorCount, true);
 	//DSV用のヒープでディスクリプタの数は１。DSVはShader内で触れるものではないので、ShaderVisibleはfalse
 	Microsoft::WRL::ComPtr <ID3D12DescriptorHeap> dsvDescriptorHeap = CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1, false);
 #pragma endregion
@@ -770,22 +815,6 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 #pragma endregion
 
 
-#pragma region DXC_Initialization
-	//dxcCompilerを初期化
-	Microsoft::WRL::ComPtr <IDxcUtils> dxcUtils = nullptr;
-	IDxcCompiler3* dxcCompiler = nullptr;
-	hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils));
-	assert(SUCCEEDED(hr));
-	hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler));
-	assert(SUCCEEDED(hr));
-
-	//現時点でincludeはしないが、includeに対応するための設定を行っておく
-	Microsoft::WRL::ComPtr <IDxcIncludeHandler> includeHandler = nullptr;
-	hr = dxcUtils->CreateDefaultIncludeHandler(&includeHandler);
-	assert(SUCCEEDED(hr));
-#pragma endregion
-
-
 #pragma region PSO(Pipeline State Object)
 	//RootSignature作成
 	D3D12_ROOT_SIGNATURE_DESC descriptionRootSignature{};
@@ -799,7 +828,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	descriptorRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;	//Offsetを自動計算
 
 	//RootParameter作成。複数設定できるので配列。今回は1つだけなので長さ１の配列
-	D3D12_ROOT_PARAMETER rootParameters[4] = {};
+	D3D12_ROOT_PARAMETER rootParameters[6] = {};
 	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;								//CBVを使う
 	rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;								//PixelShaderを使う
 	rootParameters[0].Descriptor.ShaderRegister = 0;												//レジスタ番号０とバインド
@@ -816,6 +845,14 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;								//CBVを使う
 	rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;								//PixelShaderを使う
 	rootParameters[3].Descriptor.ShaderRegister = 1;												//レジスタ番号1を使う
+
+	rootParameters[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;								//CBVを使う
+	rootParameters[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;							//VertexShaderを使う
+	rootParameters[4].Descriptor.ShaderRegister = 1;												//レジスタ番号1を使う。量子化した頂点のデコード用
+
+	rootParameters[5].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;								//SRVを使う
+	rootParameters[5].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;							//VertexShaderを使う
+	rootParameters[5].Descriptor.ShaderRegister = 1;												//レジスタ番号1を使う。オブジェクトごとの行列のStructuredBuffer
 	descriptionRootSignature.pParameters = rootParameters;											//ルートパラメータ配列へのポインタ
 	descriptionRootSignature.NumParameters = _countof(rootParameters);								//配列の長さ
 #pragma endregion
@@ -872,6 +909,26 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	D3D12_INPUT_LAYOUT_DESC inputLayoutDesc{};
 	inputLayoutDesc.pInputElementDescs = inputElementDescs;
 	inputLayoutDesc.NumElements = _countof(inputElementDescs);
+
+	//量子化した頂点(QuantizedVertexData)用のInputLayout
+	D3D12_INPUT_ELEMENT_DESC quantizedInputElementDescs[3] = {};
+	quantizedInputElementDescs[0].SemanticName = "POSITION";
+	quantizedInputElementDescs[0].SemanticIndex = 0;
+	quantizedInputElementDescs[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+	quantizedInputElementDescs[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+
+	quantizedInputElementDescs[1].SemanticName = "TEXCOORD";
+	quantizedInputElementDescs[1].SemanticIndex = 0;
+	quantizedInputElementDescs[1].Format = DXGI_FORMAT_R16G16_UNORM;
+	quantizedInputElementDescs[1].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+
+	quantizedInputElementDescs[2].SemanticName = "NORMAL";
+	quantizedInputElementDescs[2].SemanticIndex = 0;
+	quantizedInputElementDescs[2].Format = DXGI_FORMAT_R16G16_SNORM;
+	quantizedInputElementDescs[2].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+	D3D12_INPUT_LAYOUT_DESC quantizedInputLayoutDesc{};
+	quantizedInputLayoutDesc.pInputElementDescs = quantizedInputElementDescs;
+	quantizedInputLayoutDesc.NumElements = _countof(quantizedInputElementDescs);
 #pragma endregion
 
 
@@ -894,12 +951,21 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
 
 #pragma region ShaderをCompileする
-	//Shaderをコンパイルする
-	Microsoft::WRL::ComPtr <IDxcBlob> vertexShaderBlob = CompilerShader(L"Object3D.VS.hlsl", L"vs_6_0", dxcUtils.Get(), dxcCompiler, includeHandler.Get());
+	//ワーカースレッドでコンパイルしたShaderを受け取る
+	Microsoft::WRL::ComPtr <IDxcBlob> vertexShaderBlob = nullptr;
+	Microsoft::WRL::ComPtr <IDxcBlob> quantizedVertexShaderBlob = nullptr;
+	Microsoft::WRL::ComPtr <IDxcBlob> instancedVertexShaderBlob = nullptr;
+	Microsoft::WRL::ComPtr <IDxcBlob> pixelShaderBlob = nullptr;
+	{
+		StartupTimelineScope waitScope("Wait shaders");
+		vertexShaderBlob = vertexShaderFuture.get();
+		quantizedVertexShaderBlob = quantizedVertexShaderFuture.get();
+		instancedVertexShaderBlob = instancedVertexShaderFuture.get();
+		pixelShaderBlob = pixelShaderFuture.get();
+	}
 	assert(vertexShaderBlob != nullptr);
-
-	//Pixelをコンパイルする
-	Microsoft::WRL::ComPtr <IDxcBlob> pixelShaderBlob = CompilerShader(L"Object3D.PS.hlsl", L"ps_6_0", dxcUtils.Get(), dxcCompiler, includeHandler.Get());
+	assert(quantizedVertexShaderBlob != nullptr);
+	assert(instancedVertexShaderBlob != nullptr);
 	assert(pixelShaderBlob != nullptr);
 #pragma endregion
 
@@ -943,6 +1009,21 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	Microsoft::WRL::ComPtr <ID3D12PipelineState> graphicsPipelineState = nullptr;
 	hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDesc, IID_PPV_ARGS(&graphicsPipelineState));
 	assert(SUCCEEDED(hr));
+
+	// 量子化した頂点用のパイプラインステート。InputLayoutとVertexShaderだけ差し替える
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC quantizedPipelineStateDesc = graphicsPipelineStateDesc;
+	quantizedPipelineStateDesc.InputLayout = quantizedInputLayoutDesc;
+	quantizedPipelineStateDesc.VS = { quantizedVertexShaderBlob->GetBufferPointer(),quantizedVertexShaderBlob->GetBufferSize() };
+	Microsoft::WRL::ComPtr <ID3D12PipelineState> quantizedPipelineState = nullptr;
+	hr = device->CreateGraphicsPipelineState(&quantizedPipelineStateDesc, IID_PPV_ARGS(&quantizedPipelineState));
+	assert(SUCCEEDED(hr));
+
+	// オブジェクトごとの行列をStructuredBufferから読むパイプラインステート。VertexShaderだけ差し替える
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedPipelineStateDesc = graphicsPipelineStateDesc;
+	instancedPipelineStateDesc.VS = { instancedVertexShaderBlob->GetBufferPointer(),instancedVertexShaderBlob->GetBufferSize() };
+	Microsoft::WRL::ComPtr <ID3D12PipelineState> instancedPipelineState = nullptr;
+	hr = device->CreateGraphicsPipelineState(&instancedPipelineStateDesc, IID_PPV_ARGS(&instancedPipelineState));
+	assert(SUCCEEDED(hr));
 #pragma endregion
 
 
@@ -1001,6 +1082,14 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 #pragma endregion
 
 
+#pragma region オブジェクトごとの行列を格納するStructuredBufferを生成
+	//最大数分のTransfomationMatrixを並べる。Mapしたまま毎フレームExtractDrawPacketsで直接書き込む
+	Microsoft::WRL::ComPtr <ID3D12Resource> matrixPaletteResource = CreateBufferResource(device.Get(), sizeof(TransfomationMatrix) * kMaxSceneObjectCount);
+	TransfomationMatrix* matrixPaletteData = nullptr;
+	matrixPaletteResource->Map(0, nullptr, reinterpret_cast<void**>(&matrixPaletteData));
+#pragma endregion
+
+
 #pragma region スプライトの頂点バッファリソースと変換行列リソースを生成
 	//Sprite用の頂点リソースを作る
 	Microsoft::WRL::ComPtr <ID3D12Resource> vertexResourceSprite = CreateBufferResource(device.Get(), sizeof(VertexData) * 6);
@@ -1067,20 +1156,20 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
 
 #pragma region テクスチャファイルを読み込みテクスチャリソースを作成しそれに対してSRVを設定してこれらをデスクリプタヒープにバインド
-	// モデルの読み込み
-	ModelData modelData = LoadObjFile("resources", "axis.obj");
-
-	//Textureを読んで転送する
-	DirectX::ScratchImage mipImages = LoadTexture("resources/uvChecker.png");
-	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
-	Microsoft::WRL::ComPtr <ID3D12Resource> textureResource = CreateTextureResource(device.Get(), metadata);
-	UploadTextureData(textureResource.Get(), mipImages);
+	// ワーカースレッドで読み込んだモデルとTextureを受け取る
+	// Textureは転送まで共有するので、同じファイルを何度使っても転送は1回になる
+	ModelAsset modelAsset;
+	std::shared_ptr<TextureResource> uvCheckerTexture;
+	{
+		StartupTimelineScope waitScope("Wait model / textures");
+		modelAsset = modelFuture.get();
+		uvCheckerTexture = AcquireTextureResource(device, "resources/uvChecker.png", uvCheckerFuture);
+	}
+	const ModelData& modelData = modelAsset.mesh->modelData;
+	const MeshLodChain& lodChain = modelAsset.mesh->lodChain;
+	const std::vector<MeshletData>& lodMeshlets = modelAsset.mesh->lodMeshlets;
 
-	//2枚目のTextureを読んで転送する
-	DirectX::ScratchImage mipImages2 = LoadTexture(modelData.material.textureFilePath);
-	const DirectX::TexMetadata& metadata2 = mipImages2.GetMetadata();
-	Microsoft::WRL::ComPtr <ID3D12Resource> textureResource2 = CreateTextureResource(device.Get(), metadata2);
-	UploadTextureData(textureResource2.Get(), mipImages2);
+	const DirectX::TexMetadata& metadata = uvCheckerTexture->metadata;
 
 	// 1つ目のテクスチャのSRV設定
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
@@ -1089,26 +1178,38 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;				//2Dテクスチャ
 	srvDesc.Texture2D.MipLevels = UINT(metadata.mipLevels);
 
-	// 2つ目のテクスチャのSRV設定
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc2{};
-	srvDesc2.Format = metadata2.format;
-	srvDesc2.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc2.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;				//2Dテクスチャ
-	srvDesc2.Texture2D.MipLevels = UINT(metadata2.mipLevels);
-
 	// 1つ目のテクスチャのSRVのデスクリプタヒープへのバインド
 	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU = GetCPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 1);
 	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU = GetGPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 1);
 	textureSrvHandleCPU.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 	textureSrvHandleGPU.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	device->CreateShaderResourceView(textureResource.Get(), &srvDesc, textureSrvHandleCPU);
-
-	// 2つ目のテクスチャのSRVのデスクリプタヒープへのバインド
-	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU2 = GetCPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 2);
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU2 = GetGPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, 2);
-	textureSrvHandleCPU2.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	textureSrvHandleGPU2.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	device->CreateShaderResourceView(textureResource2.Get(), &srvDesc2, textureSrvHandleCPU2);
+	device->CreateShaderResourceView(uvCheckerTexture->resource.Get(), &srvDesc, textureSrvHandleCPU);
+
+	// モデルのマテリアルごとにTextureを受け取って転送し、SRVを3番目以降に並べる
+	std::vector<std::shared_ptr<TextureResource>> materialTextureResources;
+	std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> materialSrvHandlesGPU;
+	// ヒープに入りきらないほどマテリアルがあれば止める
+	assert(kFirstMaterialSrvIndex + modelData.materials.size() <= kSrvDescriptorCount);
+	for (uint32_t i = 0; i < modelData.materials.size(); ++i)
+	{
+		std::shared_ptr<TextureResource> materialTexture;
+		{
+			StartupTimelineScope waitScope("Wait material textures");
+			materialTexture = AcquireTextureResource(device, modelAsset.materialTextureFilePaths[i], modelAsset.materialTextures[i]);
+		}
+		const DirectX::TexMetadata& materialMetadata = materialTexture->metadata;
+
+		D3D12_SHADER_RESOURCE_VIEW_DESC materialSrvDesc{};
+		materialSrvDesc.Format = materialMetadata.format;
+		materialSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		materialSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;		//2Dテクスチャ
+		materialSrvDesc.Texture2D.MipLevels = UINT(materialMetadata.mipLevels);
+
+		D3D12_CPU_DESCRIPTOR_HANDLE materialSrvHandleCPU = GetCPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, kFirstMaterialSrvIndex + i);
+		device->CreateShaderResourceView(materialTexture->resource.Get(), &materialSrvDesc, materialSrvHandleCPU);
+		materialTextureResources.push_back(materialTexture);
+		materialSrvHandlesGPU.push_back(GetGPUDescriptorHandle(srvDescriptorHeap.Get(), descriptorSizeSRV, kFirstMaterialSrvIndex + i));
+	}
 #pragma endregion
 
 
@@ -1134,6 +1235,71 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 #pragma endregion
 
 
+#pragma region モデルのインデックスバッファを作成および設定する
+	// 全LODのIndexを1つのバッファに並べ、描画時に範囲を選ぶ
+	// 頂点数が16bitに収まる場合はインデックスを16bitにしてメモリと帯域を減らす
+	bool useIndex16 = modelData.vertices.size() <= 0xFFFF;
+	size_t indexStride = useIndex16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	Microsoft::WRL::ComPtr <ID3D12Resource> indexResource = CreateBufferResource(device.Get(), indexStride * lodChain.indices.size());
+	D3D12_INDEX_BUFFER_VIEW indexBufferView{};
+	indexBufferView.BufferLocation = indexResource->GetGPUVirtualAddress();			// リソースの先頭のアドレスから使う
+	indexBufferView.SizeInBytes = UINT(indexStride * lodChain.indices.size());		// 使用するリソースのサイズ
+	indexBufferView.Format = useIndex16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+	void* indexData = nullptr;
+	indexResource->Map(0, nullptr, &indexData);
+	if (useIndex16)
+	{
+		uint16_t* indexData16 = static_cast<uint16_t*>(indexData);
+		for (size_t i = 0; i < lodChain.indices.size(); ++i)
+		{
+			indexData16[i] = uint16_t(lodChain.indices[i]);
+		}
+	}
+	else
+	{
+		std::memcpy(indexData, lodChain.indices.data(), sizeof(uint32_t) * lodChain.indices.size());
+	}
+	indexResource->Unmap(0, nullptr);
+#pragma endregion
+
+
+#pragma region カリングで残ったメッシュレットのインデックスバッファを作成する
+	// 毎フレームCPUで詰め直すので、Mapしたままにしておく。大きさは一番細かいLODの全三角形分
+	Microsoft::WRL::ComPtr <ID3D12Resource> meshletIndexResource = CreateBufferResource(device.Get(), sizeof(uint32_t) * lodChain.lods[0].triangleCount * 3);
+	D3D12_INDEX_BUFFER_VIEW meshletIndexBufferView{};
+	meshletIndexBufferView.BufferLocation = meshletIndexResource->GetGPUVirtualAddress();			// リソースの先頭のアドレスから使う
+	meshletIndexBufferView.SizeInBytes = UINT(sizeof(uint32_t) * lodChain.lods[0].triangleCount * 3);	// 使用するリソースのサイズ
+	meshletIndexBufferView.Format = DXGI_FORMAT_R32_UINT;
+
+	uint32_t* meshletIndexData = nullptr;
+	meshletIndexResource->Map(0, nullptr, reinterpret_cast<void**>(&meshletIndexData));
+#pragma endregion
+
+
+#pragma region モデルの量子化した頂点バッファとデコード用の定数バッファを作成する
+	// 位置とUVはメッシュの範囲内でunorm16、法線は八面体のsnorm16にして36byteを16byteにする
+	VertexQuantization vertexQuantization = ComputeVertexQuantization(modelData.vertices);
+	std::vector<QuantizedVertexData> quantizedVertices = QuantizeVertices(modelData.vertices, vertexQuantization);
+	Microsoft::WRL::ComPtr <ID3D12Resource> quantizedVertexResource = CreateBufferResource(device.Get(), sizeof(QuantizedVertexData) * quantizedVertices.size());
+	D3D12_VERTEX_BUFFER_VIEW quantizedVertexBufferView{};
+	quantizedVertexBufferView.BufferLocation = quantizedVertexResource->GetGPUVirtualAddress();			// リソースの先頭のアドレスから使う
+	quantizedVertexBufferView.SizeInBytes = UINT(sizeof(QuantizedVertexData) * quantizedVertices.size());	// 使用するリソースのサイズ
+	quantizedVertexBufferView.StrideInBytes = sizeof(QuantizedVertexData);								// 1頂点あたりのサイズ
+
+	QuantizedVertexData* quantizedVertexData = nullptr;
+	quantizedVertexResource->Map(0, nullptr, reinterpret_cast<void**>(&quantizedVertexData));
+	std::memcpy(quantizedVertexData, quantizedVertices.data(), sizeof(QuantizedVertexData) * quantizedVertices.size());
+	quantizedVertexResource->Unmap(0, nullptr);
+
+	Microsoft::WRL::ComPtr <ID3D12Resource> vertexQuantizationResource = CreateBufferResource(device.Get(), sizeof(VertexQuantization));
+	VertexQuantization* vertexQuantizationData = nullptr;
+	vertexQuantizationResource->Map(0, nullptr, reinterpret_cast<void**>(&vertexQuantizationData));
+	*vertexQuantizationData = vertexQuantization;
+	vertexQuantizationResource->Unmap(0, nullptr);
+#pragma endregion
+
+
 #pragma region 球体の頂点位置テクスチャ座標および法線ベクトルを計算し頂点バッファに書き込む
 	VertexData* vertexData = nullptr;																			 // 頂点リソースにデータを書き込む
 	vertexResource->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));										 // 書き込むためのアドレスを取得
@@ -1248,7 +1414,77 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	//UVTransform用の変数を用意
 	Transform uvTransformSprite{ {1.0f,1.0f,1.0f}, {0.0f,0.0f,0.0f}, {0.0f,0.0f,0.0f}, };
 
+	//モデルとまとめて描画するオブジェクトをシーングラフに置く。ワールド行列は変わったノードとその子孫だけ求め直す
+	SceneGraph sceneGraph;
+	SceneGraphStatistics sceneGraphStatistics{};
+	uint32_t modelNode = AddSceneNode(sceneGraph, kSceneNodeNoParent, transform);
+	//まとめて描画するオブジェクトは1つの親の子にし、親を動かすと全体が付いてくる
+	Transform sceneObjectsTransform{ {1.0f,1.0f,1.0f},{0.0f,0.0f,0.0f},{0.0f,0.0f,0.0f} };
+	uint32_t sceneObjectsNode = AddSceneNode(sceneGraph, kSceneNodeNoParent, sceneObjectsTransform);
+	//子はモデルの周りの格子に並べる。続けて追加するので番号が連続し、ワールド行列をそのまま読める
+	uint32_t firstSceneObjectNode = sceneObjectsNode + 1;
+	for (uint32_t i = 0; i < kMaxSceneObjectCount; ++i)
+	{
+		const uint32_t kGridWidth = 256;
+		float x = float(i % kGridWidth) - float(kGridWidth) * 0.5f;
+		float z = float(i / kGridWidth);
+		AddSceneNode(sceneGraph, sceneObjectsNode, { {0.3f,0.3f,0.3f},{0.0f,float(i) * 0.1f,0.0f},{x * 1.5f,-3.0f,z * 1.5f + 5.0f} });
+	}
+	int sceneObjectCount = 0;
+	bool useParallelMatrixPalette = true;
+	double matrixPaletteSeconds = 0.0;
+
+	//まとめて描画するオブジェクトは、描画に要るものをエンティティのコンポーネントとして持つ
+	//ワールド行列はシーングラフから写し、描画の取り出しで視錐台に入ったものをLODとマテリアルごとにまとめる
+	EntityWorld entityWorld;
+	RenderExtraction renderExtraction{};
+	std::vector<uint32_t> sceneObjectEntities;
+	const uint32_t kSceneObjectComponents = kComponentSceneNode | kComponentWorldMatrix | kComponentMesh | kComponentMaterial | kComponentBounds;
+
 	bool useMonsterBall = true;
+	bool useQuantizedVertex = false;
+	bool useAutoLod = true;
+	int forcedLod = 0;
+	float lodErrorPixels = kDefaultLodErrorPixels;
+	uint32_t currentLod = 0;
+	float projectedRadius = 0.0f;
+	// 単体で描画するモデルのワールド空間の境界と、視錐台に入ったかどうか。まとめて描画するオブジェクトの境界はentityWorldが持つ
+	CullBoundsSoA sceneCullBounds;
+	ResizeCullBounds(sceneCullBounds, 1);
+	std::vector<uint32_t> visibleObjects(sceneCullBounds.sphereX.size());
+	uint32_t visibleObjectCount = 0;
+	bool useMeshletCulling = false;
+	bool useSimdMeshletCulling = true;
+	std::vector<uint32_t> visibleMeshlets;
+	std::vector<MaterialBatch> meshletBatches;
+	MeshletCullStatistics meshletCullStatistics{};
+
+	//ベンチマーク用の変数
+	int benchmarkTriangleCount = 2000000;
+	ObjParseBenchmarkResult objParseBenchmark{};
+	ModelStartupBenchmarkResult modelStartupBenchmark{};
+	int benchmarkMemoryBudgetMB = 64;
+	ObjStreamBenchmarkResult objStreamBenchmark{};
+	MeshOptimizeBenchmarkResult meshOptimizeBenchmark{};
+	VertexQuantizeBenchmarkResult vertexQuantizeBenchmark{};
+	MeshSimplifyBenchmarkResult meshSimplifyBenchmark{};
+	MeshletCullBenchmarkResult meshletCullBenchmark{};
+	TangentSpaceBenchmarkResult tangentSpaceBenchmark{};
+	ObjAllocationBenchmarkResult objAllocationBenchmark{};
+	MatrixMathBenchmarkResult matrixMathBenchmark{};
+	AffineMatrixBenchmarkResult affineMatrixBenchmark{};
+	VectorBatchBenchmarkResult vectorBatchBenchmark{};
+	QuaternionBenchmarkResult quaternionBenchmark{};
+	VisibilityBenchmarkResult visibilityBenchmark{};
+	MatrixPaletteBenchmarkResult matrixPaletteBenchmark{};
+	SceneGraphBenchmarkResult sceneGraphBenchmark{};
+	EntityWorldBenchmarkResult entityWorldBenchmark{};
+	VertexQuantizationError modelQuantizationError = MeasureQuantizationError(modelData.vertices, quantizedVertices, vertexQuantization);
+	VertexCacheStatistics modelVertexCache = AnalyzeVertexCache(modelData.indices, modelData.vertices.size());
+
+	//起動のタイムライン。最初のフレームを出したところで確定する
+	StartupTimeline::GetInstance()->Record("Initialize", initializeBeginSeconds, StartupTimeline::GetInstance()->GetSeconds());
+	std::vector<StartupTimelineEntry> startupTimeline;
 
 	//ウィンドウのｘボタンが押されるまでループ
 	while (msg.message != WM_QUIT)
@@ -1278,16 +1514,278 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 				ImGui::SliderAngle("CameraRotateZ", &cameraTransform.rotate.z);
 
 				ImGui::DragFloat3("transformSprite", &transformSprite.translate.x, 1.0f);
-				ImGui::DragFloat3("scale", &transform.scale.x, 0.01f);
-				ImGui::DragFloat3("rotate", &transform.rotate.x, 0.01f);
-				ImGui::DragFloat3("translate", &transform.translate.x, 0.01f);
+				// 触ったときだけシーングラフに渡し、そのノードを求め直す
+				bool transformChanged = ImGui::DragFloat3("scale", &transform.scale.x, 0.01f);
+				transformChanged |= ImGui::DragFloat3("rotate", &transform.rotate.x, 0.01f);
+				transformChanged |= ImGui::DragFloat3("translate", &transform.translate.x, 0.01f);
+				if (transformChanged)
+				{
+					SetLocalTransform(sceneGraph, modelNode, transform);
+				}
 				ImGui::Checkbox("useMonsterBall", &useMonsterBall);
+				ImGui::Checkbox("useQuantizedVertex", &useQuantizedVertex);
+				ImGui::Checkbox("useAutoLod", &useAutoLod);
+				ImGui::SliderInt("forcedLod", &forcedLod, 0, int(lodChain.lods.size()) - 1);
+				ImGui::DragFloat("lodErrorPixels", &lodErrorPixels, 0.1f, 0.1f, 64.0f);
+				ImGui::Text("LOD %u / %zu : %u triangles (projected radius %.1f px)", currentLod, lodChain.lods.size(), lodChain.lods[currentLod].triangleCount, projectedRadius);
+				ImGui::Text("model bounds : (%.2f, %.2f, %.2f) - (%.2f, %.2f, %.2f) / sphere r %.2f", modelData.bounds.boundsMin.x, modelData.bounds.boundsMin.y, modelData.bounds.boundsMin.z,
+					modelData.bounds.boundsMax.x, modelData.bounds.boundsMax.y, modelData.bounds.boundsMax.z, modelData.bounds.sphereRadius);
+				ImGui::Text("model visible : %u / %u", visibleObjectCount, sceneCullBounds.count);
+				ImGui::SliderInt("sceneObjectCount", &sceneObjectCount, 0, int(kMaxSceneObjectCount));
+				bool sceneObjectsChanged = ImGui::DragFloat3("sceneObjectsRotate", &sceneObjectsTransform.rotate.x, 0.01f);
+				sceneObjectsChanged |= ImGui::DragFloat3("sceneObjectsTranslate", &sceneObjectsTransform.translate.x, 0.01f);
+				if (sceneObjectsChanged)
+				{
+					SetLocalTransform(sceneGraph, sceneObjectsNode, sceneObjectsTransform);
+				}
+				ImGui::Text("scene graph : %u / %u nodes updated (%.3f ms)", sceneGraphStatistics.updatedCount, sceneGraphStatistics.nodeCount, sceneGraphStatistics.updateSeconds * 1000.0);
+				ImGui::Checkbox("useParallelMatrixPalette", &useParallelMatrixPalette);
+				ImGui::Text("render extraction : %u / %u visible, %zu batches (%.3f ms)", renderExtraction.visibleCount, renderExtraction.entityCount, renderExtraction.batches.size(), matrixPaletteSeconds * 1000.0);
+				ImGui::Checkbox("useMeshletCulling", &useMeshletCulling);
+				ImGui::Checkbox("useSimdMeshletCulling", &useSimdMeshletCulling);
+				if (useMeshletCulling && meshletCullStatistics.meshletCount != 0)
+				{
+					float meshletCount = float(meshletCullStatistics.meshletCount);
+					ImGui::Text("meshlets : %u visible / %u", meshletCullStatistics.visibleCount, meshletCullStatistics.meshletCount);
+					ImGui::Text("culled : frustum %.1f%% / cone %.1f%%", meshletCullStatistics.frustumCulledCount / meshletCount * 100.0f, meshletCullStatistics.coneCulledCount / meshletCount * 100.0f);
+					ImGui::Text("triangles : %u / %u", meshletCullStatistics.visibleTriangleCount, lodChain.lods[currentLod].triangleCount);
+					ImGui::Text("cull : %.1f us / compact : %.1f us", meshletCullStatistics.cullSeconds * 1000000.0, meshletCullStatistics.compactSeconds * 1000000.0);
+				}
 				ImGui::DragFloat3("directionalLight", &directionalLightData->direction.x, 0.01f);
 				ImGui::DragFloat2("UVTranslete", &uvTransformSprite.translate.x, 0.01f, -10.0f, 10.0f);
 				ImGui::DragFloat2("UVScale", &uvTransformSprite.scale.x, 0.01f, -10.0f, 10.0f);
 				ImGui::SliderAngle("UVRotate", &uvTransformSprite.rotate.z);
 				ImGui::End();
 			}
+
+			// ベンチマーク
+			{
+				ImGui::Begin("Startup");
+				ImGui::Text("async asset loading : %s", kAsyncAssetLoading ? "on" : "off");
+				AssetRegistryStatistics assetStatistics = AssetRegistry::GetInstance()->GetStatistics();
+				ImGui::Text("assets : hit %llu / miss %llu", (unsigned long long)assetStatistics.hitCount, (unsigned long long)assetStatistics.missCount);
+				ImGui::Text("assets : live %u / pending release %u / released %llu", assetStatistics.liveCount, assetStatistics.pendingReleaseCount, (unsigned long long)assetStatistics.releasedCount);
+				for (const StartupTimelineEntry& entry : startupTimeline)
+				{
+					ImGui::Text("T%u %8.1f - %8.1f ms (%7.1f ms) %s", entry.threadIndex, entry.beginSeconds * 1000.0, entry.endSeconds * 1000.0, (entry.endSeconds - entry.beginSeconds) * 1000.0, entry.name.c_str());
+				}
+				ImGui::End();
+
+				ImGui::Begin("Benchmark");
+				ImGui::InputInt("triangleCount", &benchmarkTriangleCount, 100000, 1000000);
+				if (ImGui::Button("ObjParse"))
+				{
+					objParseBenchmark = BenchmarkObjParse(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (objParseBenchmark.fileSize != 0)
+				{
+					ImGui::Text("file : %.1f MB, %u triangles", double(objParseBenchmark.fileSize) / (1024.0 * 1024.0), objParseBenchmark.triangleCount);
+					ImGui::Text("Stream : %.3f s (%.1f MB/s)", objParseBenchmark.streamSeconds, objParseBenchmark.streamMBPerSecond);
+					ImGui::Text("Mapped : %.3f s (%.1f MB/s)", objParseBenchmark.mappedSeconds, objParseBenchmark.mappedMBPerSecond);
+					ImGui::Text("Parallel : %.3f s (%.1f MB/s, %u threads)", objParseBenchmark.parallelSeconds, objParseBenchmark.parallelMBPerSecond, objParseBenchmark.threadCount);
+					ImGui::Text("identical : %s", objParseBenchmark.identical ? "true" : "false");
+					ImGui::Text("vertices : %zu / indices : %zu", objParseBenchmark.vertexCount, objParseBenchmark.indexCount);
+				}
+				if (ImGui::Button("ModelStartup"))
+				{
+					modelStartupBenchmark = BenchmarkModelStartup(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (modelStartupBenchmark.fileSize != 0)
+				{
+					ImGui::Text("obj : %.1f MB / cache : %.1f MB", double(modelStartupBenchmark.fileSize) / (1024.0 * 1024.0), double(modelStartupBenchmark.cacheSize) / (1024.0 * 1024.0));
+					ImGui::Text("Obj : %.3f s", modelStartupBenchmark.objSeconds);
+					ImGui::Text("Cache cold : %.3f s", modelStartupBenchmark.cacheColdSeconds);
+					ImGui::Text("Cache warm : %.3f s", modelStartupBenchmark.cacheWarmSeconds);
+					ImGui::Text("identical : %s", modelStartupBenchmark.identical ? "true" : "false");
+				}
+				ImGui::InputInt("memoryBudget (MB)", &benchmarkMemoryBudgetMB, 16, 256);
+				if (ImGui::Button("ObjStream"))
+				{
+					size_t memoryBudget = size_t(benchmarkMemoryBudgetMB > 1 ? benchmarkMemoryBudgetMB : 1) * 1024 * 1024;
+					objStreamBenchmark = BenchmarkObjStream(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1), memoryBudget);
+				}
+				if (objStreamBenchmark.fileSize != 0)
+				{
+					ImGui::Text("file : %.1f MB", double(objStreamBenchmark.fileSize) / (1024.0 * 1024.0));
+					ImGui::Text("Stream : %.3f s (%.1f MB/s, %zu chunks)", objStreamBenchmark.seconds, objStreamBenchmark.MBPerSecond, objStreamBenchmark.chunkCount);
+					ImGui::Text("peak : %.1f MB / budget : %.1f MB (%s)", double(objStreamBenchmark.peakMemorySize) / (1024.0 * 1024.0), double(objStreamBenchmark.memoryBudget) / (1024.0 * 1024.0), objStreamBenchmark.completed ? "completed" : "stopped at budget");
+					ImGui::Text("vertices : %zu / indices : %zu", objStreamBenchmark.vertexCount, objStreamBenchmark.indexCount);
+					ImGui::Text("valid : %s", objStreamBenchmark.valid ? "true" : "false");
+				}
+				ImGui::Text("model ACMR : %.3f / ATVR : %.3f", modelVertexCache.acmr, modelVertexCache.atvr);
+				if (ImGui::Button("MeshOptimize"))
+				{
+					meshOptimizeBenchmark = BenchmarkMeshOptimize(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (meshOptimizeBenchmark.triangleCount != 0)
+				{
+					ImGui::Text("Optimize : %.3f s", meshOptimizeBenchmark.seconds);
+					ImGui::Text("ACMR : %.3f -> %.3f", meshOptimizeBenchmark.report.before.acmr, meshOptimizeBenchmark.report.after.acmr);
+					ImGui::Text("ATVR : %.3f -> %.3f", meshOptimizeBenchmark.report.before.atvr, meshOptimizeBenchmark.report.after.atvr);
+					ImGui::Text("same triangles : %s", meshOptimizeBenchmark.sameTriangles ? "true" : "false");
+				}
+				ImGui::Text("model quantize error : pos %.6f / uv %.6f / normal %.4f deg", modelQuantizationError.position, modelQuantizationError.texcoord, modelQuantizationError.normalDegrees);
+				if (ImGui::Button("VertexQuantize"))
+				{
+					vertexQuantizeBenchmark = BenchmarkVertexQuantize(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (vertexQuantizeBenchmark.vertexCount != 0)
+				{
+					ImGui::Text("Quantize : %.3f s (%zu vertices)", vertexQuantizeBenchmark.seconds, vertexQuantizeBenchmark.vertexCount);
+					ImGui::Text("error pos : %.6f (<= %.6f)", vertexQuantizeBenchmark.error.position, vertexQuantizeBenchmark.tolerance.position);
+					ImGui::Text("error uv : %.6f (<= %.6f)", vertexQuantizeBenchmark.error.texcoord, vertexQuantizeBenchmark.tolerance.texcoord);
+					ImGui::Text("error normal : %.4f deg (<= %.4f)", vertexQuantizeBenchmark.error.normalDegrees, vertexQuantizeBenchmark.tolerance.normalDegrees);
+					ImGui::Text("within tolerance : %s", vertexQuantizeBenchmark.withinTolerance ? "true" : "false");
+					ImGui::Text("buffer : %.1f MB -> %.1f MB", double(vertexQuantizeBenchmark.vertexBufferSize) / (1024.0 * 1024.0), double(vertexQuantizeBenchmark.quantizedBufferSize) / (1024.0 * 1024.0));
+					ImGui::Text("fetch / draw : %.1f MB -> %.1f MB", double(vertexQuantizeBenchmark.fetchedBytes) / (1024.0 * 1024.0), double(vertexQuantizeBenchmark.quantizedFetchedBytes) / (1024.0 * 1024.0));
+				}
+				if (ImGui::Button("MeshSimplify"))
+				{
+					meshSimplifyBenchmark = BenchmarkMeshSimplify(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (meshSimplifyBenchmark.triangleCount != 0)
+				{
+					ImGui::Text("Simplify : %.3f s (%.2f MTris/s)", meshSimplifyBenchmark.seconds, meshSimplifyBenchmark.MTrianglesPerSecond);
+					for (size_t lod = 0; lod < meshSimplifyBenchmark.lods.size(); ++lod)
+					{
+						ImGui::Text("LOD%zu : %u triangles (error %.6f)", lod, meshSimplifyBenchmark.lods[lod].triangleCount, meshSimplifyBenchmark.lods[lod].error);
+					}
+					ImGui::Text("valid : %s", meshSimplifyBenchmark.valid ? "true" : "false");
+				}
+				if (ImGui::Button("MeshletCull"))
+				{
+					meshletCullBenchmark = BenchmarkMeshletCull(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (meshletCullBenchmark.meshletCount != 0)
+				{
+					ImGui::Text("Build : %.3f s (%zu meshlets / %zu triangles)", meshletCullBenchmark.buildSeconds, meshletCullBenchmark.meshletCount, meshletCullBenchmark.triangleCount);
+					ImGui::Text("Cull scalar : %.1f us / simd : %.1f us", meshletCullBenchmark.scalarSeconds * 1000000.0, meshletCullBenchmark.simdSeconds * 1000000.0);
+					ImGui::Text("culled : frustum %u / cone %u / visible %u", meshletCullBenchmark.statistics.frustumCulledCount, meshletCullBenchmark.statistics.coneCulledCount, meshletCullBenchmark.statistics.visibleCount);
+					ImGui::Text("Compact : %.1f us", meshletCullBenchmark.statistics.compactSeconds * 1000000.0);
+					ImGui::Text("identical : %s", meshletCullBenchmark.identical ? "true" : "false");
+				}
+				if (ImGui::Button("TangentSpace"))
+				{
+					tangentSpaceBenchmark = BenchmarkTangentSpace(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (tangentSpaceBenchmark.triangleCount != 0)
+				{
+					ImGui::Text("triangles : %zu / vertices : %zu", tangentSpaceBenchmark.triangleCount, tangentSpaceBenchmark.vertexCount);
+					ImGui::Text("Normal : %.3f s -> %.3f s (%u threads)", tangentSpaceBenchmark.normalSerialSeconds, tangentSpaceBenchmark.normalParallelSeconds, tangentSpaceBenchmark.threadCount);
+					ImGui::Text("Tangent : %.3f s -> %.3f s", tangentSpaceBenchmark.tangentSerialSeconds, tangentSpaceBenchmark.tangentParallelSeconds);
+					ImGui::Text("%.1f MTriangles/s", tangentSpaceBenchmark.MTrianglesPerSecond);
+					ImGui::Text("error : normal %.4f deg / tangent %.4f deg", tangentSpaceBenchmark.maxNormalErrorDegrees, tangentSpaceBenchmark.maxTangentErrorDegrees);
+					ImGui::Text("handedness : %s / identical : %s", tangentSpaceBenchmark.consistentHandedness ? "ok" : "mixed", tangentSpaceBenchmark.identical ? "true" : "false");
+				}
+				if (ImGui::Button("ObjAllocation"))
+				{
+					objAllocationBenchmark = BenchmarkObjAllocation(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (objAllocationBenchmark.triangleCount != 0)
+				{
+					if (!objAllocationBenchmark.counted)
+					{
+						ImGui::Text("allocation counting is disabled (define CG_COUNT_ALLOCATIONS)");
+					}
+					ImGui::Text("Stream : %llu allocs / %.1f MB / %.3f s", (unsigned long long)objAllocationBenchmark.streamAllocations, double(objAllocationBenchmark.streamBytes) / (1024.0 * 1024.0), objAllocationBenchmark.streamSeconds);
+					ImGui::Text("Mapped : %llu allocs / %.1f MB / %.3f s", (unsigned long long)objAllocationBenchmark.mappedAllocations, double(objAllocationBenchmark.mappedBytes) / (1024.0 * 1024.0), objAllocationBenchmark.mappedSeconds);
+					ImGui::Text("Parallel : %llu allocs", (unsigned long long)objAllocationBenchmark.parallelAllocations);
+					ImGui::Text("Mapped x2 : %llu allocs (%s)", (unsigned long long)objAllocationBenchmark.mappedDoubleAllocations, objAllocationBenchmark.independentOfSize ? "constant" : "grows");
+					ImGui::Text("identical : %s", objAllocationBenchmark.identical ? "true" : "false");
+				}
+				if (ImGui::Button("MatrixMath"))
+				{
+					matrixMathBenchmark = BenchmarkMatrixMath(1 << 16);
+				}
+				if (matrixMathBenchmark.matrixCount != 0)
+				{
+					ImGui::Text("Multiply : %.1f us -> %.1f us", matrixMathBenchmark.multiplyScalarSeconds * 1000000.0, matrixMathBenchmark.multiplySeconds * 1000000.0);
+					ImGui::Text("Inverse : %.1f us -> %.1f us / affine %.1f us", matrixMathBenchmark.inverseScalarSeconds * 1000000.0, matrixMathBenchmark.inverseSeconds * 1000000.0, matrixMathBenchmark.inverseAffineSeconds * 1000000.0);
+					ImGui::Text("error(eps) : multiply %.1f / %.1f", matrixMathBenchmark.multiplyScalarError, matrixMathBenchmark.multiplyError);
+					ImGui::Text("error(eps) : inverse %.1f / %.1f / affine %.1f", matrixMathBenchmark.inverseScalarError, matrixMathBenchmark.inverseError, matrixMathBenchmark.inverseAffineError);
+					ImGui::Text("within tolerance : %s", matrixMathBenchmark.withinTolerance ? "true" : "false");
+				}
+				if (ImGui::Button("AffineMatrix"))
+				{
+					affineMatrixBenchmark = BenchmarkAffineMatrix(100000);
+				}
+				if (affineMatrixBenchmark.transformCount != 0)
+				{
+					ImGui::Text("%u transforms", affineMatrixBenchmark.transformCount);
+					ImGui::Text("chained : %.3f ms / closed form : %.3f ms / batch : %.3f ms", affineMatrixBenchmark.chainedSeconds * 1000.0, affineMatrixBenchmark.closedFormSeconds * 1000.0, affineMatrixBenchmark.batchSeconds * 1000.0);
+					ImGui::Text("error(eps) : closed form %.2f / batch %.2f", affineMatrixBenchmark.closedFormError, affineMatrixBenchmark.batchError);
+					ImGui::Text("within tolerance : %s", affineMatrixBenchmark.withinTolerance ? "true" : "false");
+				}
+				if (ImGui::Button("VectorBatch"))
+				{
+					vectorBatchBenchmark = BenchmarkVectorBatch(uint32_t(benchmarkTriangleCount > 0 ? benchmarkTriangleCount : 1));
+				}
+				if (vectorBatchBenchmark.pointCount != 0)
+				{
+					ImGui::Text("%u points (MPoints/s)", vectorBatchBenchmark.pointCount);
+					ImGui::Text("Transforms : %.1f / batch affine : %.1f / perspective : %.1f / SoA : %.1f", vectorBatchBenchmark.scalarMPointsPerSecond, vectorBatchBenchmark.affineMPointsPerSecond, vectorBatchBenchmark.perspectiveMPointsPerSecond, vectorBatchBenchmark.soaMPointsPerSecond);
+					ImGui::Text("Project : %.1f / Vectors : %.1f", vectorBatchBenchmark.projectMPointsPerSecond, vectorBatchBenchmark.vectorMPointsPerSecond);
+					ImGui::Text("Normalize : %.1f -> %.1f", vectorBatchBenchmark.normalizeScalarMPointsPerSecond, vectorBatchBenchmark.normalizeMPointsPerSecond);
+					ImGui::Text("error : %.2e (%s)", vectorBatchBenchmark.maxRelativeError, vectorBatchBenchmark.withinTolerance ? "ok" : "over");
+				}
+				if (ImGui::Button("Quaternion"))
+				{
+					quaternionBenchmark = BenchmarkQuaternion(100000);
+				}
+				if (quaternionBenchmark.objectCount != 0)
+				{
+					ImGui::Text("%u objects", quaternionBenchmark.objectCount);
+					ImGui::Text("world matrix : euler %.3f ms / quaternion %.3f ms", quaternionBenchmark.eulerMatrixSeconds * 1000.0, quaternionBenchmark.quaternionMatrixSeconds * 1000.0);
+					ImGui::Text("sample : euler %.3f ms / nlerp %.3f ms / slerp %.3f ms", quaternionBenchmark.eulerSampleSeconds * 1000.0, quaternionBenchmark.nlerpSampleSeconds * 1000.0, quaternionBenchmark.slerpSampleSeconds * 1000.0);
+					ImGui::Text("Multiply : %.3f ms -> %.3f ms", quaternionBenchmark.multiplyScalarSeconds * 1000.0, quaternionBenchmark.multiplySeconds * 1000.0);
+					ImGui::Text("error : matrix %.2e / slerp angle %.2e (%s)", quaternionBenchmark.maxMatrixError, quaternionBenchmark.maxSlerpAngleError, quaternionBenchmark.withinTolerance ? "ok" : "over");
+				}
+				if (ImGui::Button("Visibility"))
+				{
+					visibilityBenchmark = BenchmarkVisibility(1000000);
+				}
+				if (visibilityBenchmark.boundsCount != 0)
+				{
+					ImGui::Text("%u bounds / frame (update %.3f ms)", visibilityBenchmark.boundsCount, visibilityBenchmark.updateSeconds * 1000.0);
+					ImGui::Text("sphere : %.3f / %.3f / %.3f ms (%u visible)", visibilityBenchmark.sphereSeconds[0] * 1000.0, visibilityBenchmark.sphereSeconds[1] * 1000.0, visibilityBenchmark.sphereSeconds[2] * 1000.0, visibilityBenchmark.sphereVisibleCount);
+					ImGui::Text("AABB : %.3f / %.3f / %.3f ms (%u visible)", visibilityBenchmark.aabbSeconds[0] * 1000.0, visibilityBenchmark.aabbSeconds[1] * 1000.0, visibilityBenchmark.aabbSeconds[2] * 1000.0, visibilityBenchmark.aabbVisibleCount);
+					ImGui::Text("identical : %s", visibilityBenchmark.identical ? "true" : "false");
+				}
+				if (ImGui::Button("MatrixPalette"))
+				{
+					matrixPaletteBenchmark = BenchmarkMatrixPalette(kMaxSceneObjectCount);
+				}
+				if (matrixPaletteBenchmark.objectCount != 0)
+				{
+					ImGui::Text("%u objects / %u threads", matrixPaletteBenchmark.objectCount, matrixPaletteBenchmark.threadCount);
+					ImGui::Text("chain : %.3f ms / serial : %.3f ms / parallel : %.3f ms", matrixPaletteBenchmark.chainSeconds * 1000.0, matrixPaletteBenchmark.serialSeconds * 1000.0, matrixPaletteBenchmark.parallelSeconds * 1000.0);
+					ImGui::Text("error : %.2e / identical : %s", matrixPaletteBenchmark.maxError, matrixPaletteBenchmark.identical ? "true" : "false");
+				}
+				if (ImGui::Button("SceneGraph"))
+				{
+					sceneGraphBenchmark = BenchmarkSceneGraph(100000, 60);
+				}
+				if (sceneGraphBenchmark.nodeCount != 0)
+				{
+					ImGui::Text("%u nodes / %u changed per frame (%u frames)", sceneGraphBenchmark.nodeCount, sceneGraphBenchmark.changedCount, sceneGraphBenchmark.frameCount);
+					ImGui::Text("updated : %.0f nodes / visited : %.0f nodes", sceneGraphBenchmark.averageUpdatedCount, sceneGraphBenchmark.averageVisitedCount);
+					ImGui::Text("dirty : %.3f ms / full : %.3f ms", sceneGraphBenchmark.dirtySeconds * 1000.0, sceneGraphBenchmark.fullSeconds * 1000.0);
+					ImGui::Text("identical : %s", sceneGraphBenchmark.identical ? "true" : "false");
+				}
+				if (ImGui::Button("EntityWorld"))
+				{
+					entityWorldBenchmark = BenchmarkEntityWorld(1000000, 3);
+				}
+				if (entityWorldBenchmark.entityCount != 0)
+				{
+					ImGui::Text("%u entities / %u visible / %u batches", entityWorldBenchmark.entityCount, entityWorldBenchmark.visibleCount, entityWorldBenchmark.batchCount);
+					ImGui::Text("update : archetype %.3f ms / scattered %.3f ms", entityWorldBenchmark.archetypeUpdateSeconds * 1000.0, entityWorldBenchmark.scatteredUpdateSeconds * 1000.0);
+					ImGui::Text("extract : archetype %.3f ms / scattered %.3f ms", entityWorldBenchmark.archetypeExtractSeconds * 1000.0, entityWorldBenchmark.scatteredExtractSeconds * 1000.0);
+					ImGui::Text("cache misses / entity : archetype %.2f / scattered %.2f", entityWorldBenchmark.archetypeMissesPerEntity, entityWorldBenchmark.scatteredMissesPerEntity);
+					ImGui::Text("identical : %s", entityWorldBenchmark.identical ? "true" : "false");
+				}
+				ImGui::End();
+			}
 			//ImGuiの内部コマンドを生成する
 			ImGui::Render();
 
@@ -1296,20 +1794,86 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 			//transform.rotate.y += 0.03f;
 
 			/*-----Transform情報を作る-----*/
-			Matrix4x4 worldMatrix = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
+			UpdateSceneGraph(sceneGraph, SceneGraphUpdateMode::Dirty, sceneGraphStatistics);
+			Matrix4x4 worldMatrix = sceneGraph.worldMatrices[modelNode];
 			Matrix4x4 camraMatrix = MakeAffineMatrix(cameraTransform.scale, cameraTransform.rotate, cameraTransform.translate);
-			Matrix4x4 viewMatrix = Inverse(camraMatrix);
-			Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, float(kClientWidth) / float(kClientHeight), 0.1f, 100.0f);
-			Matrix4x4 worldViewProjectionMatrix = Multiply(worldMatrix, Multiply(viewMatrix, projectionMatrix));
+			Matrix4x4 viewMatrix = InverseAffine(camraMatrix);
+			// 画角と画面サイズは固定なので射影行列はコンパイル時に求まる
+			constexpr Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(kFovY, float(kClientWidth) / float(kClientHeight), 0.1f, 100.0f);
+			// ビュー * 射影は全てのオブジェクトで共通なので1回だけ求める
+			Matrix4x4 viewProjectionMatrix = Multiply(viewMatrix, projectionMatrix);
+			Matrix4x4 worldViewProjectionMatrix = Multiply(worldMatrix, viewProjectionMatrix);
+
+			/*-----まとめて描画するオブジェクトのエンティティを数に合わせ、視錐台に入ったものの行列をStructuredBufferに直接書き込む-----*/
+			// 後から作ったものから消すので、行は格子の順に並んだまま
+			while (sceneObjectEntities.size() < size_t(sceneObjectCount))
+			{
+				uint32_t index = uint32_t(sceneObjectEntities.size());
+				uint32_t entity = CreateEntity(entityWorld, kSceneObjectComponents);
+				uint32_t lodCount = uint32_t(lodChain.lods.size());
+				GetSceneNode(entityWorld, entity).node = firstSceneObjectNode + index;
+				GetMesh(entityWorld, entity).lodLevel = lodCount - 1 - (index % 2 < lodCount - 1 ? index % 2 : lodCount - 1);	// 粗い方から2段を交互に使う
+				GetMaterial(entityWorld, entity).useModelMaterial = (index / 16) % 2;												// 16個ごとにuvCheckerとモデルのマテリアルを切り替える
+				GetBounds(entityWorld, entity) = modelData.bounds;
+				sceneObjectEntities.push_back(entity);
+			}
+			while (sceneObjectEntities.size() > size_t(sceneObjectCount))
+			{
+				DestroyEntity(entityWorld, sceneObjectEntities.back());
+				sceneObjectEntities.pop_back();
+			}
+			auto matrixPaletteStart = std::chrono::steady_clock::now();
+			CopySceneGraphWorldMatrices(entityWorld, sceneGraph);
+			ExtractDrawPackets(entityWorld, viewProjectionMatrix, renderExtraction, matrixPaletteData, kMaxSceneObjectCount, useParallelMatrixPalette ? JobSystem::GetInstance() : nullptr);
+			matrixPaletteSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - matrixPaletteStart).count();
+
+			/*-----オブジェクトの境界が視錐台に入っているかを調べ、描画するものの番号を詰める-----*/
+			// 境界はワールド空間に移し、平面はビュープロジェクション行列から取る
+			Vector4 viewFrustumPlanes[6];
+			ExtractFrustumPlanes(viewProjectionMatrix, viewFrustumPlanes);
+			SetCullBounds(sceneCullBounds, 0, modelData.bounds, worldMatrix);
+			visibleObjectCount = CullVisible(viewFrustumPlanes, sceneCullBounds, CullShape::Sphere, VisibilityCullMode::Avx, visibleObjects.data());
+
+			// メッシュレットはモデル空間で判定するので、平面はワールドビュープロジェクション行列から取る
+			Vector4 frustumPlanes[6];
+			ExtractFrustumPlanes(worldViewProjectionMatrix, frustumPlanes);
+
+			/*-----カメラからの距離で描画するLODを選ぶ-----*/
+			// 境界球の中心をワールドに移し、拡大率は一番大きい軸のものを使う
+			const Vector3& boundingCenter = lodChain.boundingCenter;
+			float centerX = boundingCenter.x * worldMatrix.m[0][0] + boundingCenter.y * worldMatrix.m[1][0] + boundingCenter.z * worldMatrix.m[2][0] + worldMatrix.m[3][0];
+			float centerY = boundingCenter.x * worldMatrix.m[0][1] + boundingCenter.y * worldMatrix.m[1][1] + boundingCenter.z * worldMatrix.m[2][1] + worldMatrix.m[3][1];
+			float centerZ = boundingCenter.x * worldMatrix.m[0][2] + boundingCenter.y * worldMatrix.m[1][2] + boundingCenter.z * worldMatrix.m[2][2] + worldMatrix.m[3][2];
+			float lodDistance = sqrt((centerX - cameraTransform.translate.x) * (centerX - cameraTransform.translate.x)
+				+ (centerY - cameraTransform.translate.y) * (centerY - cameraTransform.translate.y)
+				+ (centerZ - cameraTransform.translate.z) * (centerZ - cameraTransform.translate.z));
+			float lodScale = fabs(transform.scale.x);
+			lodScale = fabs(transform.scale.y) > lodScale ? fabs(transform.scale.y) : lodScale;
+			lodScale = fabs(transform.scale.z) > lodScale ? fabs(transform.scale.z) : lodScale;
+			projectedRadius = ComputeProjectedRadius(lodChain.boundingRadius * lodScale, lodDistance, kFovY, float(kClientHeight));
+			currentLod = useAutoLod ? SelectMeshLod(lodChain, lodDistance, lodScale, kFovY, float(kClientHeight), lodErrorPixels) : uint32_t(forcedLod < 0 ? 0 : (forcedLod < int(lodChain.lods.size()) ? forcedLod : int(lodChain.lods.size()) - 1));
+
+			/*-----選んだLODのメッシュレットをカリングし、残った三角形だけのIndexを作る-----*/
+			if (useMeshletCulling && visibleObjectCount != 0)
+			{
+				// カメラの位置をモデル空間に移して判定する
+				Matrix4x4 inverseWorldMatrix = InverseAffine(worldMatrix);
+				const Vector3& cameraPosition = cameraTransform.translate;
+				Vector3 localCameraPosition = {
+					cameraPosition.x * inverseWorldMatrix.m[0][0] + cameraPosition.y * inverseWorldMatrix.m[1][0] + cameraPosition.z * inverseWorldMatrix.m[2][0] + inverseWorldMatrix.m[3][0],
+					cameraPosition.x * inverseWorldMatrix.m[0][1] + cameraPosition.y * inverseWorldMatrix.m[1][1] + cameraPosition.z * inverseWorldMatrix.m[2][1] + inverseWorldMatrix.m[3][1],
+					cameraPosition.x * inverseWorldMatrix.m[0][2] + cameraPosition.y * inverseWorldMatrix.m[1][2] + cameraPosition.z * inverseWorldMatrix.m[2][2] + inverseWorldMatrix.m[3][2] };
+				CullMeshlets(lodMeshlets[currentLod], frustumPlanes, localCameraPosition, useSimdMeshletCulling ? MeshletCullMode::Simd : MeshletCullMode::Scalar, visibleMeshlets, meshletCullStatistics);
+				CompactMeshletIndices(lodMeshlets[currentLod], visibleMeshlets, meshletIndexData, meshletBatches, meshletCullStatistics);
+			}
 
 			wvpData->WVP = worldViewProjectionMatrix;
 			wvpData->World = worldMatrix;
 
 			//Sprite用のWorldViewProjectionMatrixを作る
 			Matrix4x4 worldMatrixSprite = MakeAffineMatrix(transformSprite.scale, transformSprite.rotate, transformSprite.translate);
-			Matrix4x4 viewMatrixSprite = MakeIdentity();
-			Matrix4x4 projectionMatrixSprite = MakeOrthographicMatrix(0.0f, 0.0f, float(kClientWidth), float(kClientHeight), 0.0f, 100.0f);
-			Matrix4x4 worldViewProjectionMatrixSprite = Multiply(worldMatrixSprite, Multiply(viewMatrixSprite, projectionMatrixSprite));
+			constexpr Matrix4x4 viewProjectionMatrixSprite = Multiply(MakeIdentity(), MakeOrthographicMatrix(0.0f, 0.0f, float(kClientWidth), float(kClientHeight), 0.0f, 100.0f));
+			Matrix4x4 worldViewProjectionMatrixSprite = Multiply(worldMatrixSprite, viewProjectionMatrixSprite);
 
 			transfomationMatrixDataSprite->WVP = worldViewProjectionMatrixSprite;
 			transfomationMatrixDataSprite->World = worldMatrix;
@@ -1372,13 +1936,53 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 			//マテリアルCBufferの場所を設定
 			commandList->SetGraphicsRootConstantBufferView(0, materialResource->GetGPUVirtualAddress());					// マテリアルCBVを設定
 			commandList->SetGraphicsRootConstantBufferView(1, wvpResource->GetGPUVirtualAddress());							// WVP用CBVを設定
-			commandList->SetGraphicsRootDescriptorTable(2, useMonsterBall ? textureSrvHandleGPU2 : textureSrvHandleGPU);	// SRVのディスクリプタテーブルを設定
 			commandList->SetGraphicsRootConstantBufferView(3, directionalLightResource->GetGPUVirtualAddress());			// ライトのCBVを設定
-			commandList->DrawInstanced(UINT(modelData.vertices.size()), 1, 0, 0);											// 描画コール。三角形を描画(頂点数を変えれば球体が出るようになる「TotalVertexCount」)
+			commandList->IASetIndexBuffer(&indexBufferView);																// モデルのIBVを設定
+			if (useQuantizedVertex)
+			{
+				// 量子化した頂点に切り替える
+				commandList->SetPipelineState(quantizedPipelineState.Get());
+				commandList->IASetVertexBuffers(0, 1, &quantizedVertexBufferView);
+				commandList->SetGraphicsRootConstantBufferView(4, vertexQuantizationResource->GetGPUVirtualAddress());	// デコード用のCBVを設定
+			}
+			// 同じマテリアルのサブメッシュはまとめてあるので、マテリアルごとに1回だけSRVを切り替えて描画する
+			// メッシュレットのカリングを使う場合は、詰め直したIndexで残った分だけ描画する
+			if (useMeshletCulling)
+			{
+				commandList->IASetIndexBuffer(&meshletIndexBufferView);														// 詰め直したIBVを設定
+			}
+			// 単体で描画するモデルは視錐台に入っているときだけ描画する。まとめて描画するオブジェクトはExtractDrawPacketsの中でカリングしている
+			if (visibleObjectCount != 0)
+			{
+				for (const MaterialBatch& batch : useMeshletCulling ? meshletBatches : lodChain.lods[currentLod].batches)
+				{
+					commandList->SetGraphicsRootDescriptorTable(2, useMonsterBall ? materialSrvHandlesGPU[batch.materialIndex] : textureSrvHandleGPU);	// SRVのディスクリプタテーブルを設定
+					commandList->DrawIndexedInstanced(batch.indexCount, 1, batch.indexStart, 0, 0);							// 描画コール
+				}
+			}
+
+			// まとめて描画するオブジェクトは、取り出した描画の単位ごとに行列をStructuredBufferからインスタンスの番号で読んで描画する
+			// SV_InstanceIDはStartInstanceLocationを含まないので、単位ごとにSRVの先頭をずらす
+			if (!renderExtraction.batches.empty())
+			{
+				commandList->SetPipelineState(instancedPipelineState.Get());												// StructuredBufferを読むパイプラインに切り替える
+				commandList->IASetVertexBuffers(0, 1, &vertexBufferView);													// 量子化していないVBVを設定
+				commandList->IASetIndexBuffer(&indexBufferView);																// モデルのIBVを設定
+				for (const DrawBatch& drawBatch : renderExtraction.batches)
+				{
+					commandList->SetGraphicsRootShaderResourceView(5, matrixPaletteResource->GetGPUVirtualAddress() + sizeof(TransfomationMatrix) * drawBatch.firstInstance);	// 行列のSRVを設定
+					for (const MaterialBatch& batch : lodChain.lods[drawBatch.lodLevel].batches)
+					{
+						commandList->SetGraphicsRootDescriptorTable(2, drawBatch.useModelMaterial != 0 ? materialSrvHandlesGPU[batch.materialIndex] : textureSrvHandleGPU);	// SRVのディスクリプタテーブルを設定
+						commandList->DrawIndexedInstanced(batch.indexCount, drawBatch.instanceCount, batch.indexStart, 0, 0);	// 描画コール
+					}
+				}
+			}
 
 			commandList->SetGraphicsRootDescriptorTable(2, textureSrvHandleGPU);
 
 			//スプライトの描画設定
+			commandList->SetPipelineState(graphicsPipelineState.Get());													// 通常のパイプラインに戻す
 			commandList->IASetVertexBuffers(0, 1, &vertexBufferViewSprite);													// スプライトの頂点バッファビューを設定
 			commandList->IASetIndexBuffer(&indexBufferViewSprite);															// IBVの設定
 			commandList->SetGraphicsRootConstantBufferView(0, materialResourceSprite->GetGPUVirtualAddress());				// スプライトのマテリアルCBVを設定
@@ -1413,6 +2017,18 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 			commandQueue->ExecuteCommandLists(1, commandLists);
 			//GPUとOSに画面の交換を行うよう通知する
 			swapChain->Present(1, 0);
+
+			//最初のフレームまでの時間を記録してタイムラインを確定する
+			if (startupTimeline.empty())
+			{
+				StartupTimeline* timeline = StartupTimeline::GetInstance();
+				timeline->Record("First frame", 0.0, timeline->GetSeconds());
+				startupTimeline = timeline->GetEntries();
+				for (const StartupTimelineEntry& entry : startupTimeline)
+				{
+					Log(std::format("[Startup] T{} {:8.1f} - {:8.1f} ms : {}\n", entry.threadIndex, entry.beginSeconds * 1000.0, entry.endSeconds * 1000.0, entry.name));
+				}
+			}
 #pragma endregion
 
 
@@ -1432,6 +2048,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 				WaitForSingleObject(fenceEvent, INFINITE);
 			}
 
+			//GPUが使い終わったので、誰も使わなくなったアセットを解放する
+			AssetRegistry::GetInstance()->AdvanceFrame();
+
 			//次のフレーム用のコマンドリストを準備（コマンドリストのリセット）
 			hr = commandAllocator->Reset();
 			assert(SUCCEEDED(hr));
@@ -1442,6 +2061,10 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	}
 
 #pragma region メモリリークしないための解放処理
+	//共有しているアセットのハンドルを手放し、リークチェックの前に解放を済ませる
+	uvCheckerTexture.reset();
+	materialTextureResources.clear();
+	AssetRegistry::GetInstance()->ReleaseAll();
 	CloseHandle(fenceEvent);
 	CloseWindow(hwnd);
 #pragma endregion